@@ -0,0 +1,387 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : main.cpp
+ *
+ * Author/Date : C.B. Lirakis / 17-Oct-26
+ *
+ * Description : Loopback test and benchmark for NavCast.
+ *
+ * Canned GGA and RMC sentences are decoded with libNMEA once. A
+ * publisher thread then sends them alternately as NavCast records,
+ * each stamped with the time of sending, at a fixed rate. Several
+ * subscriber threads join the group on the loopback interface; each
+ * copies every payload back into a GGA or RMC, checks it against
+ * the original and the sequence, and keeps the latency from publish
+ * to kernel receive and to the return of Receive.
+ *
+ *     castbench [-n records] [-r rate] [-s subscribers]
+ *               [-g group] [-p port]
+ *
+ * Reported: publish rate and CPU per record, and per subscriber
+ * records, lost, stale, corrupt and latency mean, median, 99% and
+ * maximum. Exit status is 0 only if every subscriber got every
+ * record intact.
+ *
+ * Restrictions/Limitations : Loopback only, TTL 0.
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ *******************************************************************
+ */
+// System includes.
+#include <iostream>
+using namespace std;
+#include <iomanip>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/resource.h>
+
+/// Local Includes.
+#include "debug.h"
+#include "NavCast.hh"
+#include "GGA.hh"
+#include "RMC.hh"
+
+static size_t         NRecords     = 20000;
+static double         Rate         = 1000.0;
+static int            NSubscribers = 4;
+static const char    *Group        = kNAVCAST_GROUP;
+static unsigned short Port         = kNAVCAST_PORT;
+
+static GGA            CannedGGA;
+static RMC            CannedRMC;
+static pthread_barrier_t Ready;
+
+/**
+ * What one subscriber saw.
+ */
+struct Listener {
+    pthread_t      Thread;
+    bool           Joined;
+    size_t         NGot;
+    size_t         NCorrupt;
+    uint64_t       Lost;
+    uint64_t       Stale;
+    vector<double> Kernel;    // publish to kernel receive, s
+    vector<double> Return;    // publish to Receive returning, s
+};
+
+/**
+ ******************************************************************
+ *
+ * Function Name : Help
+ *
+ * Description : provides user with help if needed.
+ *
+ * Inputs : none
+ *
+ * Returns : none
+ *
+ * Error Conditions : none
+ *
+ *******************************************************************
+ */
+static void Help(void)
+{
+    SET_DEBUG_STACK;
+    cout << "********************************************" << endl;
+    cout << "* NavCast loopback benchmark.              *" << endl;
+    cout << "* Built on "<< __DATE__ << " " << __TIME__ << "*" << endl;
+    cout << "* castbench [options]                      *" << endl;
+    cout << "* Available options are :                  *" << endl;
+    cout << "*     -n records (20000)                   *" << endl;
+    cout << "*     -r records/s, 0 unthrottled (1000)   *" << endl;
+    cout << "*     -s subscribers (4)                   *" << endl;
+    cout << "*     -g multicast group                   *" << endl;
+    cout << "*     -p port                              *" << endl;
+    cout << "*                                          *" << endl;
+    cout << "********************************************" << endl;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name :  ProcessCommandLineArgs
+ *
+ * Description : Loop over all command line arguments
+ *               and parse them into useful data.
+ *
+ * Inputs : command line arguments.
+ *
+ * Returns : none
+ *
+ * Error Conditions : none
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+static void ProcessCommandLineArgs(int argc, char **argv)
+{
+    int option;
+    SET_DEBUG_STACK;
+    do
+    {
+        option = getopt( argc, argv, "g:hHn:p:r:s:");
+        switch(option)
+        {
+	case 'g':
+	    Group = optarg;
+	    break;
+        case 'h':
+        case 'H':
+            Help();
+	    exit(0);
+	    break;
+	case 'n':
+	    NRecords = atol(optarg);
+	    break;
+	case 'p':
+	    Port = atoi(optarg);
+	    break;
+	case 'r':
+	    Rate = atof(optarg);
+	    break;
+	case 's':
+	    NSubscribers = atoi(optarg);
+	    break;
+        }
+    } while(option != -1);
+}
+static double Seconds(const struct timespec &t)
+{
+    return t.tv_sec + 1.0e-9*t.tv_nsec;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Subscribe
+ *
+ * Description : Thread, receive until the last record or a second
+ *               of silence. Every payload is decoded into a fresh
+ *               GGA or RMC and compared with the canned one.
+ *
+ * Inputs : arg - Listener
+ *
+ * Returns : NULL
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+static void *Subscribe(void *arg)
+{
+    Listener         *L = (Listener *) arg;
+    NavCastSubscriber sub(Group, Port);
+    NavCastRecord     rec;
+    struct timespec   now;
+    GGA               gga;
+    RMC               rmc;
+
+    L->Joined = (sub.Error() == CObject::ENONE);
+    pthread_barrier_wait(&Ready);
+    if (!L->Joined)
+    {
+	return NULL;
+    }
+    while (sub.Receive(rec, 1.0))
+    {
+	clock_gettime(CLOCK_REALTIME, &now);
+	double sent = 1.0e-9*rec.SendTime;
+	L->Kernel.push_back(Seconds(rec.Received) - sent);
+	L->Return.push_back(Seconds(now) - sent);
+	L->NGot++;
+
+	bool ok = false;
+	if ((rec.Type == kNAVCAST_GGA) && (rec.Length == GGA::DataSize()))
+	{
+	    memcpy(gga.DataPointer(), rec.Data, rec.Length);
+	    ok = (gga.Latitude()  == CannedGGA.Latitude()) &&
+		(gga.Longitude()  == CannedGGA.Longitude()) &&
+		(gga.Altitude()   == CannedGGA.Altitude()) &&
+		(gga.Satellites() == CannedGGA.Satellites());
+	}
+	else if ((rec.Type == kNAVCAST_RMC) && (rec.Length == RMC::DataSize()))
+	{
+	    memcpy(rmc.DataPointer(), rec.Data, rec.Length);
+	    ok = (rmc.Latitude() == CannedRMC.Latitude()) &&
+		(rmc.Speed()     == CannedRMC.Speed()) &&
+		(rmc.Mode()      == CannedRMC.Mode());
+	}
+	/* Even sequence numbers are GGA. */
+	ok = ok && ((rec.Sequence & 1) == (rec.Type == kNAVCAST_RMC));
+	if (!ok)
+	{
+	    L->NCorrupt++;
+	}
+	if (rec.Sequence == NRecords-1)
+	{
+	    break;
+	}
+    }
+    L->Lost  = sub.Lost();
+    L->Stale = sub.Stale();
+    return NULL;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Percentile
+ *
+ * Description : p'th value of a sorted vector, in microseconds.
+ *
+ * Inputs : v - sorted seconds
+ *          p - 0 to 1
+ *
+ * Returns : microseconds, 0 if empty
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+static double Percentile(const vector<double> &v, double p)
+{
+    if (v.empty())
+    {
+	return 0.0;
+    }
+    size_t i = (size_t) (p*(v.size()-1));
+    return 1.0e6*v[i];
+}
+static double Mean(const vector<double> &v)
+{
+    double sum = 0.0;
+    for (size_t i=0; i<v.size(); i++)
+    {
+	sum += v[i];
+    }
+    return v.empty() ? 0.0 : 1.0e6*sum/v.size();
+}
+int main(int argc, char **argv)
+{
+    SET_DEBUG_STACK;
+    const char *gga = "$GPGGA,123519.00,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*4F";
+    const char *rmc = "$GPRMC,123519.00,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W*6A";
+    struct timespec start, due, now, end;
+    struct rusage   ru0, ru1;
+    bool   ok = true;
+
+    ProcessCommandLineArgs(argc, argv);
+    CannedGGA.Decode(gga);
+    CannedRMC.Decode(rmc);
+
+    NavCastPublisher pub(Group, Port);
+    if (pub.Error() != CObject::ENONE)
+    {
+	cerr << "castbench: publisher error " << pub.Error() << endl;
+	return 1;
+    }
+
+    vector<Listener> L(NSubscribers);
+    pthread_barrier_init(&Ready, NULL, NSubscribers+1);
+    for (int i=0; i<NSubscribers; i++)
+    {
+	L[i].Joined   = false;
+	L[i].NGot     = 0;
+	L[i].NCorrupt = 0;
+	L[i].Lost     = 0;
+	L[i].Stale    = 0;
+	L[i].Kernel.reserve(NRecords);
+	L[i].Return.reserve(NRecords);
+	pthread_create(&L[i].Thread, NULL, Subscribe, &L[i]);
+    }
+    pthread_barrier_wait(&Ready);
+
+    getrusage(RUSAGE_THREAD, &ru0);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t i=0; i<NRecords; i++)
+    {
+	if (Rate > 0.0)
+	{
+	    double t = Seconds(start) + i/Rate;
+	    due.tv_sec  = (time_t) t;
+	    due.tv_nsec = (long) ((t - due.tv_sec)*1.0e9);
+	    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL);
+	}
+	clock_gettime(CLOCK_REALTIME, &now);
+	if (i & 1)
+	{
+	    CannedRMC.SetPCTime(now);
+	    pub.Publish(kNAVCAST_RMC, CannedRMC.DataPointer(), RMC::DataSize());
+	}
+	else
+	{
+	    CannedGGA.SetPCTime(now);
+	    pub.Publish(kNAVCAST_GGA, CannedGGA.DataPointer(), GGA::DataSize());
+	}
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    getrusage(RUSAGE_THREAD, &ru1);
+
+    double elapsed = Seconds(end) - Seconds(start);
+    double cpu = (ru1.ru_utime.tv_sec - ru0.ru_utime.tv_sec) +
+	1.0e-6*(ru1.ru_utime.tv_usec - ru0.ru_utime.tv_usec) +
+	(ru1.ru_stime.tv_sec - ru0.ru_stime.tv_sec) +
+	1.0e-6*(ru1.ru_stime.tv_usec - ru0.ru_stime.tv_usec);
+    cout << "published " << pub.Sent() << " records in " << fixed
+	 << setprecision(3) << elapsed << " s, "
+	 << setprecision(0) << pub.Sent()/elapsed << " records/s, "
+	 << setprecision(2) << 1.0e6*cpu/pub.Sent() << " us CPU/record"
+	 << endl;
+    cout << "  sub   records  lost stale corrupt"
+	 << "   kernel us: mean    p50    p99    max"
+	 << "   return us: mean    p50    p99    max" << endl;
+
+    for (int i=0; i<NSubscribers; i++)
+    {
+	pthread_join(L[i].Thread, NULL);
+	if (!L[i].Joined)
+	{
+	    cout << setw(5) << i << "  could not join " << Group << endl;
+	    ok = false;
+	    continue;
+	}
+	sort(L[i].Kernel.begin(), L[i].Kernel.end());
+	sort(L[i].Return.begin(), L[i].Return.end());
+	cout << setw(5)  << i
+	     << setw(10) << L[i].NGot
+	     << setw(6)  << L[i].Lost
+	     << setw(6)  << L[i].Stale
+	     << setw(8)  << L[i].NCorrupt
+	     << setprecision(1)
+	     << setw(18) << Mean(L[i].Kernel)
+	     << setw(7)  << Percentile(L[i].Kernel, 0.5)
+	     << setw(7)  << Percentile(L[i].Kernel, 0.99)
+	     << setw(7)  << Percentile(L[i].Kernel, 1.0)
+	     << setw(18) << Mean(L[i].Return)
+	     << setw(7)  << Percentile(L[i].Return, 0.5)
+	     << setw(7)  << Percentile(L[i].Return, 0.99)
+	     << setw(7)  << Percentile(L[i].Return, 1.0)
+	     << endl;
+	ok = ok && (L[i].NGot == NRecords) && (L[i].NCorrupt == 0);
+    }
+    pthread_barrier_destroy(&Ready);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,173 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : main.cpp
+ *
+ * Author/Date : C.B. Lirakis / 17-Oct-26
+ *
+ * Description : Render a binary CLogger file back to the text
+ *               CLogger would have written. 
+ *
+ *               logformat [-o output] [-t] [-s] file
+ *                  -o  write to output rather than stdout
+ *                  -t  prefix every record with its time, ns
+ *                  -s  print record and format counts on stderr
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References : utility/CLogBinary.hh
+ *
+ *******************************************************************
+ */
+// System includes.
+#include <iostream>
+using namespace std;
+#include <fstream>
+#include <cstdlib>
+#include <cstdio>
+#include <unistd.h>
+
+/// Local Includes.
+#include "debug.h"
+#include "CLogReader.hh"
+
+static const char *OutputName = NULL;
+static bool       TimeStamps  = false;
+static bool       Statistics  = false;
+
+/**
+ ******************************************************************
+ *
+ * Function Name : Help
+ *
+ * Description : provides user with help if needed.
+ *
+ * Inputs : none
+ *
+ * Returns : none
+ *
+ * Error Conditions : none
+ *
+ *******************************************************************
+ */
+static void Help(void)
+{
+    SET_DEBUG_STACK;
+    cout << "********************************************" << endl;
+    cout << "* Render a binary CLogger file as text.    *" << endl;
+    cout << "* Built on "<< __DATE__ << " " << __TIME__ << "*" << endl;
+    cout << "* logformat [options] file                 *" << endl;
+    cout << "* Available options are :                  *" << endl;
+    cout << "*     -o output file, default stdout       *" << endl;
+    cout << "*     -t prefix records with time in ns    *" << endl;
+    cout << "*     -s record counts on stderr           *" << endl;
+    cout << "*                                          *" << endl;
+    cout << "********************************************" << endl;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name :  ProcessCommandLineArgs
+ *
+ * Description : Loop over all command line arguments
+ *               and parse them into useful data.
+ *
+ * Inputs : command line arguments. 
+ *
+ * Returns : index of the first file argument
+ *
+ * Error Conditions : none
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+static int ProcessCommandLineArgs(int argc, char **argv)
+{
+    int option;
+    SET_DEBUG_STACK;
+    do
+    {
+        option = getopt( argc, argv, "hHo:st");
+        switch(option)
+        {
+        case 'h':
+        case 'H':
+            Help();
+	    exit(0);
+	    break;
+	case 'o':
+	    OutputName = optarg;
+	    break;
+	case 's':
+	    Statistics = true;
+	    break;
+	case 't':
+	    TimeStamps = true;
+	    break;
+        }
+    } while(option != -1);
+    return optind;
+}
+int main(int argc, char **argv)
+{
+    int first = ProcessCommandLineArgs(argc, argv);
+    if (first >= argc)
+    {
+	Help();
+	return 1;
+    }
+
+    CLogReader reader(argv[first]);
+    if (reader.Error() != CObject::ENONE)
+    {
+	cerr << "logformat: can't read " << argv[first] 
+	     << " error " << reader.Error() << endl;
+	return 1;
+    }
+
+    ofstream file;
+    ostream  *out = &cout;
+    if (OutputName)
+    {
+	file.open(OutputName);
+	if (!file.is_open())
+	{
+	    cerr << "logformat: can't open " << OutputName << endl;
+	    return 1;
+	}
+	out = &file;
+    }
+
+    string text;
+    while (reader.Next(text))
+    {
+	if (TimeStamps)
+	{
+	    *out << reader.Time() << " ";
+	}
+	*out << text;
+    }
+    out->flush();
+
+    if (Statistics)
+    {
+	cerr << "records " << reader.NRecords() 
+	     << " formats " << reader.NFormats() << endl;
+    }
+    if (reader.Error() != CObject::ENONE)
+    {
+	cerr << "logformat: damaged record after " << reader.NRecords() 
+	     << " records, error " << reader.Error() 
+	     << " line " << reader.ErrorLine() << endl;
+	return 1;
+    }
+    return 0;
+}
@@ -10,6 +10,7 @@
  * Restrictions/Limitations :
  *
  * Change Descriptions :
+ * 17-Oct-26 CBL Read the columns in bulk rather than row by row. 
  *
  * Classification : Unclassified
  *
@@ -120,26 +121,41 @@ Bool_t H5read::FormatFile(H5Logger *pH5)
 
     fTrackTitle = new TString(pH5->HeaderInfo(H5Logger::kFILENAME));
     char msg[32];
-    const double *vals; // Data in Row.
     double lat, lon; //, z;
     time_t t;
 
-    for (uint32_t i=0;i<pH5->NEntries();i++)
+    /*
+     * Read in blocks of whole chunks. Once this block's columns are 
+     * in memory the next block is started in the background. 
+     */
+    const size_t kBlock = 64*pH5->ChunkSize();
+    size_t       NRows;
+    for (size_t row=0; row<pH5->NEntries(); row+=kBlock)
     {
-	pH5->DatasetReadRow(i);
-	vals = pH5->RowData();
-	lon  = vals[lon_index];
-	lat  = vals[lat_index];
-	//z    = vals[z_index];
-	t    = (time_t)vals[time_index];
-	/*
-	 * Do some simple checks here to make sure in bounds. *
-	 */
-	if ((fabs(lat)<=90.0) && (fabs(lon)<=180.0) && (t<UINT_MAX))
+	H5Span Time = pH5->Column(time_index, row, kBlock);
+	H5Span Lat  = pH5->Column(lat_index,  row, kBlock);
+	H5Span Lon  = pH5->Column(lon_index,  row, kBlock);
+	H5Span Z    = pH5->Column(z_index,    row, kBlock);
+	NRows = Time.size();
+	if (row+kBlock < pH5->NEntries())
 	{
-	    ptm = localtime(&t);
-	    strftime( msg, sizeof(msg), "%H:%M:%S", ptm);
-	    Add( vals[lon_index], vals[lat_index], vals[z_index], 0.0, msg);
+	    pH5->Prefetch(row+kBlock, kBlock);
+	}
+
+	for (uint32_t i=0;i<NRows;i++)
+	{
+	    lon  = Lon[i];
+	    lat  = Lat[i];
+	    t    = (time_t)Time[i];
+	    /*
+	     * Do some simple checks here to make sure in bounds. *
+	     */
+	    if ((fabs(lat)<=90.0) && (fabs(lon)<=180.0) && (t<UINT_MAX))
+	    {
+		ptm = localtime(&t);
+		strftime( msg, sizeof(msg), "%H:%M:%S", ptm);
+		Add( lon, lat, Z[i], 0.0, msg);
+	    }
 	}
     }
     SET_DEBUG_STACK;
@@ -0,0 +1,556 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : ClockTracker.cpp
+ *
+ * Author/Date : C.B. Lirakis / 17-Oct-26
+ *
+ * Description : Poll time servers, fit offset and drift, publish the
+ *               fit in shared memory for every process on the host.
+ *
+ * Restrictions/Limitations : NONE
+ *
+ * Change Descriptions :
+ * 17-Oct-26 CBL Publish and Model use the SharedMem2 seqlock. 
+ *
+ * Classification : Unclassified
+ *
+ * References : RFC 5905
+ *
+ *******************************************************************
+ */
+// System includes.
+#include <iostream>
+using namespace std;
+#include <cstring>
+#include <cmath>
+#include <errno.h>
+
+// Local Includes.
+#include "debug.h"
+#include "ClockTracker.hh"
+
+static int64_t NowNS(clockid_t Clock)
+{
+    struct timespec t;
+    clock_gettime(Clock, &t);
+    return (int64_t) t.tv_sec*1000000000LL + t.tv_nsec;
+}
+
+/**
+ ******************************************************************
+ *
+ * Function Name : ClockTracker Constructor
+ *
+ * Description : Map the model segment. The server owns it in seqlock
+ *               mode and starts it out empty, a client only attaches.
+ *
+ * Inputs : Server   - true to create the segment and poll
+ *          Name     - shared memory name
+ *          Interval - seconds between polls
+ *          Window   - samples in the fit, at least 2
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NO_MODEL
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+ClockTracker::ClockTracker(bool Server, const char *Name, double Interval,
+			   int Window) :
+    SharedMem2(Name, sizeof(struct ClockModel), Server, 0, Server),
+    fQuery(false)
+{
+    SET_DEBUG_STACK;
+    SetName("ClockTracker");
+    fServer   = Server;
+    fInterval = (Interval > 0.0) ? Interval : 64.0;
+    fWindow   = (Window > 1) ? Window : 2;
+    fX        = new int64_t[fWindow];
+    fY        = new double[fWindow];
+    fN        = 0;
+    fNext     = 0;
+    fStarted  = false;
+    fRun      = false;
+    memset(&fFit, 0, sizeof(fFit));
+    pthread_mutex_init(&fMutex, NULL);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&fCond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    fModel = (struct ClockModel *) GetROSharedMemoryAddress();
+    if ((Error() != NO_ERROR) || (fModel == NULL))
+    {
+	fModel = NULL;
+	SetError(NO_MODEL, __LINE__);
+	return;
+    }
+    ClearError(__LINE__);
+    if (fServer)
+    {
+	// Whatever a previous server left there is stale.
+	Publish();
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : ClockTracker Destructor
+ *
+ * Description : Stop polling and free the sample ring. The segment
+ *               is released by SharedMem2.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+ClockTracker::~ClockTracker(void)
+{
+    SET_DEBUG_STACK;
+    Stop();
+    pthread_cond_destroy(&fCond);
+    pthread_mutex_destroy(&fMutex);
+    delete [] fX;
+    delete [] fY;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : AddServer
+ *
+ * Description : Add a time server to poll.
+ *
+ * Inputs : Name    - host name or dot address
+ *          Timeout - seconds to wait for its reply
+ *          Port    - UDP port
+ *
+ * Returns : index of the server, -1 on failure
+ *
+ * Error Conditions : NOT_SERVER
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+int ClockTracker::AddServer(const char *Name, double Timeout,
+			    unsigned short Port)
+{
+    SET_DEBUG_STACK;
+    if (!fServer)
+    {
+	SetError(NOT_SERVER, __LINE__);
+	return -1;
+    }
+    return fQuery.AddServer(Name, Timeout, Port);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Start
+ *
+ * Description : Start the polling thread.
+ *
+ * Inputs : NONE
+ *
+ * Returns : true if the thread is running
+ *
+ * Error Conditions : NOT_SERVER, NO_THREAD
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool ClockTracker::Start(void)
+{
+    SET_DEBUG_STACK;
+    ClearError(__LINE__);
+    if (fStarted)
+    {
+	return true;
+    }
+    if (!fServer)
+    {
+	SetError(NOT_SERVER, __LINE__);
+	return false;
+    }
+    fRun = true;
+    if (pthread_create(&fThread, NULL, Thread, this) != 0)
+    {
+	fRun = false;
+	SetError(NO_THREAD, __LINE__);
+	return false;
+    }
+    fStarted = true;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Stop
+ *
+ * Description : Wake the thread out of its wait and join it.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void ClockTracker::Stop(void)
+{
+    SET_DEBUG_STACK;
+    if (!fStarted)
+    {
+	return;
+    }
+    pthread_mutex_lock(&fMutex);
+    fRun = false;
+    pthread_cond_signal(&fCond);
+    pthread_mutex_unlock(&fMutex);
+    pthread_join(fThread, NULL);
+    fStarted = false;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Thread
+ *
+ * Description : Poll on a fixed schedule, the time spent in Update
+ *               does not push the next poll back.
+ *
+ * Inputs : arg - this
+ *
+ * Returns : NULL
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void *ClockTracker::Thread(void *arg)
+{
+    ClockTracker   *p = (ClockTracker *) arg;
+    struct timespec next;
+    int64_t         step = (int64_t) (p->fInterval*1.0e9);
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    pthread_mutex_lock(&p->fMutex);
+    while (p->fRun)
+    {
+	pthread_mutex_unlock(&p->fMutex);
+	p->Update();
+	pthread_mutex_lock(&p->fMutex);
+
+	next.tv_sec  += step / 1000000000LL;
+	next.tv_nsec += step % 1000000000LL;
+	if (next.tv_nsec >= 1000000000L)
+	{
+	    next.tv_sec++;
+	    next.tv_nsec -= 1000000000L;
+	}
+	while (p->fRun &&
+	       (pthread_cond_timedwait(&p->fCond, &p->fMutex, &next) !=
+		ETIMEDOUT))
+	{
+	}
+    }
+    pthread_mutex_unlock(&p->fMutex);
+    return NULL;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Update
+ *
+ * Description : Query the servers, add the offset to the ring, refit
+ *               and publish. The offset is dated by when the
+ *               replies behind it arrived, the clock filter may
+ *               hand back one from an earlier round, in which
+ *               case there is nothing new to add.
+ *
+ * Inputs : NONE
+ *
+ * Returns : true if the model was updated
+ *
+ * Error Conditions : NOT_SERVER, NO_SAMPLE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool ClockTracker::Update(void)
+{
+    SET_DEBUG_STACK;
+    int64_t when;
+
+    if (!fServer)
+    {
+	SetError(NOT_SERVER, __LINE__);
+	return false;
+    }
+    if (!fQuery.Sample())
+    {
+	SetError(NO_SAMPLE, __LINE__);
+	return false;
+    }
+
+    when = NowNS(CLOCK_REALTIME) - (int64_t) (fQuery.Age()*1.0e9);
+    if ((fN > 0) &&
+	(when - fX[(fNext + fWindow - 1) % fWindow] < fInterval*0.5e9))
+    {
+	// The filter kept the sample we already have.
+	ClearError(__LINE__);
+	return true;
+    }
+    fX[fNext] = when;
+    fY[fNext] = fQuery.Correction();
+    fNext     = (fNext + 1) % fWindow;
+    if (fN < fWindow)
+    {
+	fN++;
+    }
+    Fit();
+    Publish();
+    ClearError(__LINE__);
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Fit
+ *
+ * Description : Least squares line through the ring, offset against
+ *               host time, referenced to the newest sample so the
+ *               intercept is the current offset. One sample gives
+ *               an offset and no drift.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE, result in fFit
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void ClockTracker::Fit(void)
+{
+    SET_DEBUG_STACK;
+    int64_t epoch = fX[(fNext + fWindow - 1) % fWindow];
+    double  su = 0.0, sy = 0.0, suu = 0.0, suy = 0.0, srr = 0.0;
+    double  u, ubar, ybar, a, b, r;
+    int     i;
+
+    for (i=0; i<fN; i++)
+    {
+	u = (fX[i] - epoch)*1.0e-9;
+	su += u;
+	sy += fY[i];
+    }
+    ubar = su/fN;
+    ybar = sy/fN;
+    for (i=0; i<fN; i++)
+    {
+	u    = (fX[i] - epoch)*1.0e-9 - ubar;
+	suu += u*u;
+	suy += u*(fY[i] - ybar);
+    }
+    b = (suu > 1.0e-12) ? suy/suu : 0.0;
+    a = ybar - b*ubar;
+    for (i=0; i<fN; i++)
+    {
+	r    = fY[i] - (a + b*(fX[i] - epoch)*1.0e-9);
+	srr += r*r;
+    }
+
+    fFit.NSamples = fN;
+    fFit.Epoch    = epoch;
+    fFit.Offset   = (int64_t) llround(a*1.0e9);
+    fFit.Drift    = b;
+    fFit.Residual = sqrt(srr/fN);
+    fFit.Updated  = epoch;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Publish
+ *
+ * Description : Copy fFit into the segment. PutData holds the
+ *               semaphore, which keeps writers apart, and brackets
+ *               the copy with the seqlock CorrectedNow checks. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void ClockTracker::Publish(void)
+{
+    SET_DEBUG_STACK;
+    if (fModel)
+    {
+	PutData(&fFit);
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Model
+ *
+ * Description : Consistent copy of the published model.
+ *
+ * Inputs : M - filled in
+ *
+ * Returns : true if there is a model
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool ClockTracker::Model(struct ClockModel &M) const
+{
+    uint32_t seq;
+
+    memset(&M, 0, sizeof(M));
+    if (!fModel)
+    {
+	return false;
+    }
+    do
+    {
+	seq = ReadBegin();
+	memcpy(&M, fModel, sizeof(M));
+    } while (ReadRetry(seq));
+    return (M.NSamples > 0);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : CorrectedTime
+ *
+ * Description : Corrected CLOCK_REALTIME as a timespec.
+ *
+ * Inputs : Out - filled in
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void ClockTracker::CorrectedTime(struct timespec &Out) const
+{
+    int64_t ns = CorrectedNow();
+    Out.tv_sec  = ns / 1000000000LL;
+    Out.tv_nsec = ns % 1000000000LL;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : DriftPPM
+ *
+ * Description : Drift of the published fit.
+ *
+ * Inputs : NONE
+ *
+ * Returns : parts per million, 0 without a model
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+double ClockTracker::DriftPPM(void) const
+{
+    struct ClockModel m;
+    return Model(m) ? m.Drift*1.0e6 : 0.0;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Offset
+ *
+ * Description : The correction the model gives right now.
+ *
+ * Inputs : NONE
+ *
+ * Returns : seconds
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+double ClockTracker::Offset(void) const
+{
+    struct timespec t;
+    clock_gettime(CLOCK_REALTIME, &t);
+    return (CorrectedNow(t) - ((int64_t) t.tv_sec*1000000000LL +
+			       t.tv_nsec))*1.0e-9;
+}
@@ -0,0 +1,204 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : ClockTracker.hh
+ *
+ * Author/Date : C.B. Lirakis / 17-Oct-26
+ *
+ * Description : Continuous clock offset tracking.
+ *
+ * A one shot QueryTS tells you the offset at the moment you asked,
+ * after that the host oscillator walks away from it at its own
+ * rate. The server side of this class polls the time servers from
+ * a thread every Interval seconds and keeps the last Window offsets
+ * against the host CLOCK_REALTIME. A straight line fitted through
+ * them by least squares gives the offset at the newest sample and
+ * the drift, so the correction keeps moving between polls instead
+ * of jumping at each one.
+ *
+ * The fit is published in a SharedMem2 segment so every process on
+ * the host reads the same model rather than each hammering the
+ * servers. CorrectedNow takes no lock and makes no system call
+ * besides the clock read; it copies the model out of the segment
+ * under the SharedMem2 seqlock and applies it, a few ns.
+ *
+ * Restrictions/Limitations : One server process per segment name.
+ * The host clock must not be stepped while tracking, a step shows
+ * up as an offset jump and spoils the fit until it ages out of the
+ * window.
+ *
+ * Change Descriptions :
+ * 17-Oct-26 CBL Dropped the model's own sequence counter, the 
+ *               segment is published in seqlock mode already. 
+ *
+ * Classification : Unclassified
+ *
+ * References : RFC 5905
+ *
+ *******************************************************************
+ */
+#ifndef __CLOCKTRACKER_hh_
+#  define __CLOCKTRACKER_hh_
+#  include <stdint.h>
+#  include <time.h>
+#  include <pthread.h>
+#  include "SharedMem2.hh"
+#  include "MultiQueryTS.hh"
+
+/*!
+ * The model as it sits in shared memory.
+ * Corrected = Raw + Offset + Drift*(Raw - Epoch), all ns.
+ */
+struct ClockModel
+{
+    uint32_t NSamples;  // samples in the fit, 0 no model yet
+    int64_t  Epoch;     // CLOCK_REALTIME ns the fit is referenced to
+    int64_t  Offset;    // correction at Epoch, ns
+    double   Drift;     // correction change per ns of host time
+    double   Residual;  // RMS of the fit, seconds
+    int64_t  Updated;   // CLOCK_REALTIME ns of the last good poll
+};
+
+class ClockTracker : public SharedMem2
+{
+public:
+    /*!
+     * Description:
+     *   Create (Server) or attach to the shared model.
+     *
+     * Arguments:
+     *   Server   - true to own the segment and do the polling
+     *   Name     - shared memory name
+     *   Interval - seconds between polls, server only
+     *   Window   - samples kept for the fit, server only
+     *
+     * Errors:
+     *   NO_MODEL if the segment could not be created or found,
+     *   CorrectedNow then returns the raw time.
+     */
+    ClockTracker(bool Server = false, const char *Name = "ClockTracker",
+		 double Interval = 64.0, int Window = 16);
+    /// Stops the thread if it is running.
+    ~ClockTracker(void);
+
+    /// Server side, passed to MultiQueryTS::AddServer.
+    int  AddServer(const char *Name, double Timeout = 1.0,
+		   unsigned short Port = 123);
+
+    /*!
+     * Description:
+     *   Start polling in the background, the first poll is at once.
+     *
+     * Returns:
+     *   true if the thread is running.
+     *
+     * Errors:
+     *   NOT_SERVER, NO_THREAD
+     */
+    bool Start(void);
+    /// Stop the thread, the last model stays published.
+    void Stop(void);
+
+    /*!
+     * Description:
+     *   One poll, fit and publish. What the thread calls, it may
+     *   also be called directly without Start.
+     *
+     * Returns:
+     *   true if the servers answered and the model was updated.
+     *
+     * Errors:
+     *   NOT_SERVER, NO_SAMPLE
+     */
+    bool Update(void);
+
+    /*!
+     * Description:
+     *   Convert a raw CLOCK_REALTIME reading to corrected time.
+     *   Lock free, safe from any thread or process.
+     *
+     * Arguments:
+     *   Raw - from clock_gettime(CLOCK_REALTIME)
+     *
+     * Returns:
+     *   corrected ns since the epoch, Raw itself if there is no
+     *   model yet.
+     */
+    inline int64_t CorrectedNow(const struct timespec &Raw) const
+	{
+	    int64_t  raw = (int64_t) Raw.tv_sec*1000000000LL + Raw.tv_nsec;
+	    int64_t  epoch, offset;
+	    double   drift;
+	    uint32_t seq, n;
+
+	    if (!fModel)
+	    {
+		return raw;
+	    }
+	    do
+	    {
+		seq    = ReadBegin();
+		n      = fModel->NSamples;
+		epoch  = fModel->Epoch;
+		offset = fModel->Offset;
+		drift  = fModel->Drift;
+	    } while (ReadRetry(seq));
+	    if (n == 0)
+	    {
+		return raw;
+	    }
+	    return raw + offset + (int64_t) (drift*(double)(raw - epoch));
+	};
+    /// Read CLOCK_REALTIME and correct it.
+    inline int64_t CorrectedNow(void) const
+	{
+	    struct timespec t;
+	    clock_gettime(CLOCK_REALTIME, &t);
+	    return CorrectedNow(t);
+	};
+    /// Corrected CLOCK_REALTIME as a timespec.
+    void CorrectedTime(struct timespec &Out) const;
+
+    /// Consistent copy of the published model, false if none yet.
+    bool Model(struct ClockModel &M) const;
+    /// Drift of the last fit, parts per million.
+    double DriftPPM(void) const;
+    /// Correction right now, seconds.
+    double Offset(void) const;
+
+    inline bool   Server(void)   const {return fServer;};
+    inline double Interval(void) const {return fInterval;};
+    inline int    Window(void)   const {return fWindow;};
+    /// The selection engine, for its per server statistics.
+    inline const MultiQueryTS &Query(void) const {return fQuery;};
+
+    enum CLOCKTRACKER_ERRORS {NO_MODEL=100, NOT_SERVER, NO_THREAD,
+			      NO_SAMPLE};
+
+private:
+    static void *Thread(void *arg);
+    void         Fit(void);
+    void         Publish(void);
+
+    /// Points into the segment, NULL if it couldn't be mapped.
+    struct ClockModel *fModel;
+    bool               fServer;
+    double             fInterval;
+    int                fWindow;
+    MultiQueryTS       fQuery;
+
+    /* Server side sample ring, host ns and offset seconds. */
+    int64_t           *fX;
+    double            *fY;
+    int                fN;
+    int                fNext;
+    /* Result of the last fit, published by Publish. */
+    struct ClockModel  fFit;
+
+    pthread_t          fThread;
+    pthread_mutex_t    fMutex;
+    pthread_cond_t     fCond;
+    bool               fStarted;
+    bool               fRun;
+};
+#endif
@@ -0,0 +1,749 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : MultiQueryTS.cpp
+ *
+ * Author/Date : C.B. Lirakis / 17-Oct-26
+ *
+ * Description : Concurrent NTP queries, clock filter, intersection
+ *               and combine.
+ *
+ * Time stamps are kept as 64 bit NTP fixed point, seconds since 1900
+ * in the top 32 bits. Differences are taken in two's complement so
+ * they survive the 2036 era rollover. T4 is the kernel receive time
+ * of the reply when the socket gives it.
+ *
+ * Restrictions/Limitations : IPv4.
+ *
+ * Change Descriptions :
+ * 17-Oct-26 CBL Age of the combined offset.
+ *
+ * Classification : Unclassified
+ *
+ * References : RFC 5905
+ *
+ *******************************************************************
+ */
+// System includes.
+#include <iostream>
+using namespace std;
+#include <iomanip>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+
+// Local Includes.
+#include "debug.h"
+#include "CLogger.hh"
+#include "queryTimeServer.hh"
+#include "MultiQueryTS.hh"
+
+/* Frequency tolerance, s/s, dispersion growth with age (RFC 5905). */
+static const double kPHI     = 15.0e-6;
+/* Least round trip assumed in the root distance, s (RFC 5905). */
+static const double kMINDISP = 0.01;
+/* NTP packet without extensions. */
+static const size_t kNTP_LEN = 48;
+
+static double Monotonic(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + 1.0e-9*t.tv_nsec;
+}
+/* timespec (UNIX epoch) to NTP fixed point. */
+static uint64_t NTPTime(const struct timespec &t)
+{
+    uint64_t frac = ((uint64_t) t.tv_nsec << 32)/1000000000ULL;
+    return ((uint64_t) (t.tv_sec + kNTPOffset) << 32) | frac;
+}
+/* a - b in seconds. */
+static double NTPDiff(uint64_t a, uint64_t b)
+{
+    return (double) (int64_t) (a - b) / 4294967296.0;
+}
+static uint32_t Get32(const unsigned char *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return ntohl(v);
+}
+static uint64_t Get64(const unsigned char *p)
+{
+    return ((uint64_t) Get32(p) << 32) | Get32(p+4);
+}
+static void Put64(unsigned char *p, uint64_t v)
+{
+    uint32_t w[2] = {htonl(v >> 32), htonl(v & 0xFFFFFFFF)};
+    memcpy(p, w, sizeof(w));
+}
+
+/**
+ ******************************************************************
+ *
+ * Function Name : MultiQueryTS Constructor
+ *
+ * Description : Open the one socket all the queries share.
+ *
+ * Inputs : verbose - log each round
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NO_SOCKET
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+MultiQueryTS::MultiQueryTS(bool verbose) : CObject()
+{
+    SET_DEBUG_STACK;
+    int on = 1;
+
+    SetName("MultiQueryTS");
+    SetVersion(1,0);
+    ClearError(__LINE__);
+    fVerbose   = verbose;
+    fOffset    = 0.0;
+    fAge       = 0.0;
+    fLow       = 0.0;
+    fHigh      = 0.0;
+    fSurvivors = 0;
+    fSocket    = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fSocket < 0)
+    {
+	SetError(NO_SOCKET, __LINE__);
+	return;
+    }
+    /* Not fatal, T4 is read after recvmsg without it. */
+    setsockopt(fSocket, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on));
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : MultiQueryTS Destructor
+ *
+ * Description :
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+MultiQueryTS::~MultiQueryTS(void)
+{
+    if (fSocket >= 0)
+    {
+	close(fSocket);
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : AddServer
+ *
+ * Description : Resolve and add a server. Resolution is done once
+ *               here so a round never waits on DNS.
+ *
+ * Inputs : Name    - host name or dot address
+ *          Timeout - seconds to wait for this server
+ *          Port    - UDP port
+ *
+ * Returns : index, -1 on error
+ *
+ * Error Conditions : BAD_SERVER
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+int MultiQueryTS::AddServer(const char *Name, double Timeout,
+			    unsigned short Port)
+{
+    SET_DEBUG_STACK;
+    struct addrinfo hints, *res = NULL;
+    Server s;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family   = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    if ((Name == NULL) || (getaddrinfo(Name, NULL, &hints, &res) != 0) ||
+	(res == NULL))
+    {
+	CLogger *pLog = CLogger::GetThis();
+	if (pLog)
+	{
+	    pLog->LogTime("MultiQueryTS: can't resolve %s\n",
+			  Name ? Name : "(null)");
+	}
+	SetError(BAD_SERVER, __LINE__);
+	return -1;
+    }
+    memset(&s.Address, 0, sizeof(s.Address));
+    memcpy(&s.Address, res->ai_addr, sizeof(s.Address));
+    s.Address.sin_port = htons(Port);
+    freeaddrinfo(res);
+
+    s.Name           = Name;
+    if (Port != 123)
+    {
+	s.Name += ":" + to_string(Port);
+    }
+    s.Timeout        = Timeout;
+    s.T1             = 0;
+    s.Deadline       = 0.0;
+    s.Pending        = false;
+    s.Replied        = false;
+    s.Truechimer     = false;
+    s.RootDelay      = 0.0;
+    s.RootDispersion = 0.0;
+    s.NFilter        = 0;
+    s.Next           = 0;
+    s.Offset         = 0.0;
+    s.Delay          = 0.0;
+    s.Dispersion     = 0.0;
+    s.Jitter         = 0.0;
+    s.Distance       = 0.0;
+    s.When           = 0.0;
+    fServers.push_back(s);
+    return fServers.size()-1;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Send
+ *
+ * Description : One client request to every server, back to back.
+ *               Our transmit time goes in the transmit field; the
+ *               server must echo it as originate, which is how a
+ *               reply is matched to its request.
+ *
+ * Inputs : NONE
+ *
+ * Returns : true if any request went out
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool MultiQueryTS::Send(void)
+{
+    SET_DEBUG_STACK;
+    unsigned char   request[kNTP_LEN];
+    struct timespec now;
+    bool            any = false;
+
+    for (size_t i=0; i<fServers.size(); i++)
+    {
+	Server &s = fServers[i];
+	memset(request, 0, sizeof(request));
+	request[0] = (0 << 6) | (4 << 3) | 3;   // LI 0, version 4, client
+	clock_gettime(CLOCK_REALTIME, &now);
+	s.T1 = NTPTime(now);
+	Put64(request+40, s.T1);
+	s.Replied  = false;
+	s.Deadline = Monotonic() + s.Timeout;
+	s.Pending  = (sendto(fSocket, request, sizeof(request), 0,
+			     (struct sockaddr *) &s.Address,
+			     sizeof(s.Address)) == (ssize_t) sizeof(request));
+	any = any || s.Pending;
+    }
+    return any;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Accept
+ *
+ * Description : Check a reply and add it to its server's filter.
+ *
+ * Inputs : Reply - datagram
+ *          n     - its length
+ *          From  - sender
+ *          T4    - NTP time it arrived
+ *
+ * Returns : true if it was a good reply to a pending request
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool MultiQueryTS::Accept(const unsigned char *Reply, ssize_t n,
+			  const struct sockaddr_in &From, uint64_t T4)
+{
+    if (n < (ssize_t) kNTP_LEN)
+    {
+	return false;
+    }
+    for (size_t i=0; i<fServers.size(); i++)
+    {
+	Server &s = fServers[i];
+	if (!s.Pending ||
+	    (s.Address.sin_addr.s_addr != From.sin_addr.s_addr) ||
+	    (s.Address.sin_port != From.sin_port) ||
+	    (Get64(Reply+24) != s.T1))
+	{
+	    continue;
+	}
+	s.Pending = false;
+
+	int     leap    = Reply[0] >> 6;
+	int     mode    = Reply[0] & 0x7;
+	int     stratum = Reply[1];
+	uint64_t T2     = Get64(Reply+32);
+	uint64_t T3     = Get64(Reply+40);
+	if ((mode != 4) || (leap == 3) || (stratum == 0) || (stratum > 15) ||
+	    (T3 == 0))
+	{
+	    /* Unsynchronized, or a kiss of death. */
+	    return false;
+	}
+	double precision = ldexp(1.0, (int8_t) Reply[3]);
+	double delay     = NTPDiff(T4, s.T1) - NTPDiff(T3, T2);
+
+	Measurement &m = s.Filter[s.Next];
+	m.Offset     = 0.5*(NTPDiff(T2, s.T1) + NTPDiff(T3, T4));
+	m.Delay      = (delay > precision) ? delay : precision;
+	m.Dispersion = precision + kPHI*NTPDiff(T4, s.T1);
+	m.When       = Monotonic();
+	s.Next       = (s.Next + 1) % kNTP_FILTER;
+	if (s.NFilter < kNTP_FILTER)
+	{
+	    s.NFilter++;
+	}
+	/* NTP short format, 16.16. */
+	s.RootDelay      = Get32(Reply+4)/65536.0;
+	s.RootDispersion = Get32(Reply+8)/65536.0;
+	s.Replied        = true;
+	return true;
+    }
+    return false;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Collect
+ *
+ * Description : Take replies until every server has answered or
+ *               reached its deadline. Each wait is to the nearest
+ *               deadline still pending.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void MultiQueryTS::Collect(void)
+{
+    SET_DEBUG_STACK;
+    unsigned char      reply[kNTP_LEN + 64];
+    char               control[CMSG_SPACE(sizeof(struct timespec))];
+    struct sockaddr_in from;
+    struct pollfd      pfd;
+    struct iovec       iov;
+    struct msghdr      msg;
+    struct cmsghdr    *cm;
+    struct timespec    arrival;
+    ssize_t            n;
+
+    while (true)
+    {
+	double now  = Monotonic();
+	double next = -1.0;
+	for (size_t i=0; i<fServers.size(); i++)
+	{
+	    Server &s = fServers[i];
+	    if (s.Pending && (s.Deadline <= now))
+	    {
+		s.Pending = false;
+	    }
+	    if (s.Pending && ((next < 0.0) || (s.Deadline < next)))
+	    {
+		next = s.Deadline;
+	    }
+	}
+	if (next < 0.0)
+	{
+	    return;
+	}
+	pfd.fd     = fSocket;
+	pfd.events = POLLIN;
+	if (poll(&pfd, 1, (int) ceil(1000.0*(next - now))) <= 0)
+	{
+	    continue;
+	}
+
+	while (true)
+	{
+	    iov.iov_base = reply;
+	    iov.iov_len  = sizeof(reply);
+	    memset(&msg, 0, sizeof(msg));
+	    msg.msg_name       = &from;
+	    msg.msg_namelen    = sizeof(from);
+	    msg.msg_iov        = &iov;
+	    msg.msg_iovlen     = 1;
+	    msg.msg_control    = control;
+	    msg.msg_controllen = sizeof(control);
+	    n = recvmsg(fSocket, &msg, 0);
+	    if (n < 0)
+	    {
+		break;
+	    }
+	    clock_gettime(CLOCK_REALTIME, &arrival);
+	    for (cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm))
+	    {
+		if ((cm->cmsg_level == SOL_SOCKET) &&
+		    (cm->cmsg_type  == SCM_TIMESTAMPNS))
+		{
+		    memcpy(&arrival, CMSG_DATA(cm), sizeof(arrival));
+		}
+	    }
+	    Accept(reply, n, from, NTPTime(arrival));
+	}
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : ClockFilter
+ *
+ * Description : RFC 5905 clock filter. Samples are aged, sorted by
+ *               delay, the least delay sample gives the offset; the
+ *               dispersion is the sum of the sorted dispersions
+ *               weighted 1/2, 1/4, ... and the jitter is the RMS of
+ *               the other offsets about the chosen one. The root
+ *               distance then bounds the server's error.
+ *
+ * Inputs : S   - server
+ *          Now - monotonic seconds
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void MultiQueryTS::ClockFilter(Server &S, double Now)
+{
+    Measurement sorted[kNTP_FILTER];
+    double      weight = 0.5;
+    double      sum    = 0.0;
+
+    for (int i=0; i<S.NFilter; i++)
+    {
+	sorted[i] = S.Filter[i];
+	sorted[i].Dispersion += kPHI*(Now - sorted[i].When);
+    }
+    sort(sorted, sorted+S.NFilter,
+	 [](const Measurement &a, const Measurement &b)
+	 {return a.Delay < b.Delay;});
+
+    S.Offset     = sorted[0].Offset;
+    S.Delay      = sorted[0].Delay;
+    S.When       = sorted[0].When;
+    S.Dispersion = 0.0;
+    for (int i=0; i<S.NFilter; i++)
+    {
+	S.Dispersion += weight*sorted[i].Dispersion;
+	weight       *= 0.5;
+	if (i > 0)
+	{
+	    double d = sorted[i].Offset - S.Offset;
+	    sum += d*d;
+	}
+    }
+    S.Jitter   = (S.NFilter > 1) ? sqrt(sum/(S.NFilter-1)) : 0.0;
+    S.Distance = max(kMINDISP, S.RootDelay + S.Delay)/2.0 +
+	S.RootDispersion + S.Dispersion + S.Jitter;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Select
+ *
+ * Description : Marzullo's algorithm over the servers that replied
+ *               this round. Each gives [Offset-Distance,
+ *               Offset+Distance]; the endpoints are swept in order,
+ *               lower ends before upper ends at the same value, to
+ *               find the region inside the most intervals. It must
+ *               be inside more than half of them. Servers that
+ *               overlap it are combined weighted by 1/Distance.
+ *
+ * Inputs : NONE
+ *
+ * Returns : true if there was a majority
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool MultiQueryTS::Select(void)
+{
+    vector< pair<double,int> > edge;   // value, -1 lower +1 upper
+    int    count = 0, best = 0, n = 0;
+    double low = 0.0, high = 0.0;
+
+    for (size_t i=0; i<fServers.size(); i++)
+    {
+	Server &s = fServers[i];
+	s.Truechimer = false;
+	if (s.Replied)
+	{
+	    edge.push_back(make_pair(s.Offset - s.Distance, -1));
+	    edge.push_back(make_pair(s.Offset + s.Distance,  1));
+	    n++;
+	}
+    }
+    sort(edge.begin(), edge.end());
+    for (size_t i=0; i<edge.size(); i++)
+    {
+	count -= edge[i].second;
+	if ((edge[i].second < 0) && (count > best))
+	{
+	    best = count;
+	    low  = edge[i].first;
+	    high = edge[i+1].first;   // an upper end always follows
+	}
+    }
+    if (2*best <= n)
+    {
+	return false;
+    }
+
+    double sum = 0.0, norm = 0.0, age = 0.0, now = Monotonic();
+    fSurvivors = 0;
+    for (size_t i=0; i<fServers.size(); i++)
+    {
+	Server &s = fServers[i];
+	if (s.Replied && (s.Offset - s.Distance <= high) &&
+	    (s.Offset + s.Distance >= low))
+	{
+	    s.Truechimer = true;
+	    sum  += s.Offset/s.Distance;
+	    norm += 1.0/s.Distance;
+	    age  += (now - s.When)/s.Distance;
+	    fSurvivors++;
+	}
+    }
+    fOffset = sum/norm;
+    fAge    = age/norm;
+    fLow    = low;
+    fHigh   = high;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Sample
+ *
+ * Description : One round over all the servers.
+ *
+ * Inputs : NONE
+ *
+ * Returns : true if Correction was updated
+ *
+ * Error Conditions : NO_SOCKET, NO_REPLIES, NO_MAJORITY
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool MultiQueryTS::Sample(void)
+{
+    SET_DEBUG_STACK;
+    CLogger *pLog = CLogger::GetThis();
+    int      replies = 0;
+
+    ClearError(__LINE__);
+    if (fSocket < 0)
+    {
+	SetError(NO_SOCKET, __LINE__);
+	return false;
+    }
+    if (!Send())
+    {
+	SetError(NO_REPLIES, __LINE__);
+	return false;
+    }
+    Collect();
+
+    double now = Monotonic();
+    for (size_t i=0; i<fServers.size(); i++)
+    {
+	if (fServers[i].Replied)
+	{
+	    ClockFilter(fServers[i], now);
+	    replies++;
+	}
+    }
+    if (replies == 0)
+    {
+	SetError(NO_REPLIES, __LINE__);
+	return false;
+    }
+    if (!Select())
+    {
+	if (pLog)
+	{
+	    pLog->LogTime("MultiQueryTS: no majority among %d servers.\n",
+			  replies);
+	}
+	SetError(NO_MAJORITY, __LINE__);
+	return false;
+    }
+    if (fVerbose)
+    {
+	cout << *this;
+    }
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Name, Replied, Truechimer, Offset, Delay,
+ *                 Distance, Jitter
+ *
+ * Description : Per server results.
+ *
+ * Inputs : i - index from AddServer
+ *
+ * Returns : as named, NULL/false/0 for a bad index
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+const char* MultiQueryTS::Name(size_t i) const
+{
+    return (i < fServers.size()) ? fServers[i].Name.c_str() : NULL;
+}
+bool MultiQueryTS::Replied(size_t i) const
+{
+    return (i < fServers.size()) && fServers[i].Replied;
+}
+bool MultiQueryTS::Truechimer(size_t i) const
+{
+    return (i < fServers.size()) && fServers[i].Truechimer;
+}
+double MultiQueryTS::Offset(size_t i) const
+{
+    return (i < fServers.size()) ? fServers[i].Offset : 0.0;
+}
+double MultiQueryTS::Delay(size_t i) const
+{
+    return (i < fServers.size()) ? fServers[i].Delay : 0.0;
+}
+double MultiQueryTS::Distance(size_t i) const
+{
+    return (i < fServers.size()) ? fServers[i].Distance : 0.0;
+}
+double MultiQueryTS::Jitter(size_t i) const
+{
+    return (i < fServers.size()) ? fServers[i].Jitter : 0.0;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : operator <<
+ *
+ * Description : One line per server and the combined result, times
+ *               in milliseconds.
+ *
+ * Inputs : ostream and MultiQueryTS
+ *
+ * Returns : populated ostream
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+ostream& operator<<(ostream& output, const MultiQueryTS &n)
+{
+    output << "  server                 offset    delay     dist   jitter"
+	   << endl;
+    for (size_t i=0; i<n.fServers.size(); i++)
+    {
+	const MultiQueryTS::Server &s = n.fServers[i];
+	output << (s.Truechimer ? "* " : (s.Replied ? "x " : "- "))
+	       << left << setw(20) << s.Name.substr(0,20) << right;
+	if (s.Replied)
+	{
+	    output << fixed << setprecision(3)
+		   << setw(9) << 1.0e3*s.Offset
+		   << setw(9) << 1.0e3*s.Delay
+		   << setw(9) << 1.0e3*s.Distance
+		   << setw(9) << 1.0e3*s.Jitter;
+	}
+	else
+	{
+	    output << "  no reply";
+	}
+	output << endl;
+    }
+    output << "  correction " << fixed << setprecision(3)
+	   << 1.0e3*n.fOffset << " ms from " << n.fSurvivors
+	   << " servers, intersection [" << 1.0e3*n.fLow << ", "
+	   << 1.0e3*n.fHigh << "] ms" << endl;
+    return output;
+}
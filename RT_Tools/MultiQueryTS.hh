@@ -0,0 +1,165 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : MultiQueryTS.hh
+ *
+ * Author/Date : C.B. Lirakis / 17-Oct-26
+ *
+ * Description : Query several NTP servers at once and combine them.
+ *
+ * QueryTS asks one server and waits, so N servers take N round
+ * trips and one bad server is believed. Here every server gets its
+ * request from one non-blocking socket at the same moment, and the
+ * replies are taken as they come until each has answered or passed
+ * its own timeout. A round costs the slowest round trip.
+ *
+ * Each server keeps the last kNTP_FILTER samples; the one with the
+ * least delay is used (NTP clock filter), older samples counting
+ * for less as their dispersion grows. Every server then gives an
+ * interval, offset plus or minus its root distance, and the
+ * intersection (Marzullo) algorithm finds the region most of them
+ * agree on. Servers whose interval misses it are falsetickers and
+ * are ignored; the rest are averaged weighted by 1/distance.
+ *
+ * Restrictions/Limitations : IPv4. SNTP client requests, version 4.
+ * The result is a measured offset, the clock is not touched.
+ *
+ * Change Descriptions :
+ * 17-Oct-26 CBL Age, how old the measurements behind Correction are.
+ *
+ * Classification : Unclassified
+ *
+ * References : RFC 5905 sections 10 and 11.2.1.
+ *     K. Marzullo, Maintaining the Time in a Distributed System, 1984.
+ *
+ *******************************************************************
+ */
+#ifndef __MULTIQUERYTS_hh_
+#  define __MULTIQUERYTS_hh_
+#  include <stdint.h>
+#  include <vector>
+#  include <string>
+#  include <netinet/in.h>
+#  include <CObject.hh>
+
+/// Samples kept per server by the clock filter.
+const int kNTP_FILTER = 8;
+
+class MultiQueryTS : public CObject
+{
+public:
+    MultiQueryTS(bool verbose=false);
+    ~MultiQueryTS(void);
+
+    /*!
+     * Description:
+     *   Add a server, resolved now.
+     *
+     * Arguments:
+     *   Name    - host name or dot address
+     *   Timeout - seconds to wait for this server's reply
+     *   Port    - UDP port, 123 unless testing
+     *
+     * Returns:
+     *   index of the server, -1 if it can't be resolved.
+     *
+     * Errors:
+     *   BAD_SERVER
+     */
+    int  AddServer(const char *Name, double Timeout = 1.0,
+		   unsigned short Port = 123);
+
+    /*!
+     * Description:
+     *   One round: query every server, filter, select, combine.
+     *
+     * Arguments:
+     *   NONE
+     *
+     * Returns:
+     *   true if a majority of the servers agreed and Correction
+     *   was updated.
+     *
+     * Errors:
+     *   NO_SOCKET, NO_REPLIES, NO_MAJORITY
+     */
+    bool Sample(void);
+
+    /// Combined offset, server minus host, seconds.
+    inline double Correction(void) const {return fOffset;};
+    /// Intersection found by the last Sample, seconds.
+    inline double Low(void)        const {return fLow;};
+    inline double High(void)       const {return fHigh;};
+    /// Servers used in the last combination.
+    inline int    Survivors(void)  const {return fSurvivors;};
+    /*!
+     * Seconds between the replies the clock filter chose and the end
+     * of the last Sample, weighted as Correction is. The filter may
+     * keep a low delay sample from several rounds back, anything
+     * tracking the offset over time should date it by this.
+     */
+    inline double Age(void)        const {return fAge;};
+
+    /* Per server, by the index AddServer returned. ----------- */
+    inline size_t      Servers(void) const {return fServers.size();};
+    const char*        Name(size_t i)       const;
+    /// Answered in the last Sample.
+    bool               Replied(size_t i)    const;
+    /// Inside the intersection in the last Sample.
+    bool               Truechimer(size_t i) const;
+    /// Filtered offset, delay and root distance, seconds.
+    double             Offset(size_t i)     const;
+    double             Delay(size_t i)      const;
+    double             Distance(size_t i)   const;
+    /// RMS offset difference across the filter.
+    double             Jitter(size_t i)     const;
+
+    friend std::ostream& operator<<(std::ostream& output,
+				    const MultiQueryTS &n);
+
+    enum MULTIQUERYTS_ERRORS {NO_SOCKET=1, BAD_SERVER, NO_REPLIES,
+			      NO_MAJORITY};
+
+private:
+    /*! One measurement. */
+    struct Measurement {
+	double Offset;
+	double Delay;
+	double Dispersion;
+	double When;        // CLOCK_MONOTONIC seconds
+    };
+    struct Server {
+	std::string        Name;
+	struct sockaddr_in Address;
+	double             Timeout;
+	uint64_t           T1;          // NTP time of our request
+	double             Deadline;    // monotonic
+	bool               Pending;
+	bool               Replied;
+	bool               Truechimer;
+	double             RootDelay;
+	double             RootDispersion;
+	Measurement        Filter[kNTP_FILTER];
+	int                NFilter;
+	int                Next;
+	/* Result of the clock filter. */
+	double             Offset, Delay, Dispersion, Jitter, Distance;
+	double             When;
+    };
+
+    bool   Send(void);
+    void   Collect(void);
+    bool   Accept(const unsigned char *Reply, ssize_t n,
+		  const struct sockaddr_in &From, uint64_t T4);
+    void   ClockFilter(Server &S, double Now);
+    bool   Select(void);
+
+    std::vector<Server> fServers;
+    int                 fSocket;
+    bool                fVerbose;
+    double              fOffset;
+    double              fAge;
+    double              fLow, fHigh;
+    int                 fSurvivors;
+};
+#endif
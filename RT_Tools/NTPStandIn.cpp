@@ -0,0 +1,236 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : NTPStandIn.cpp
+ *
+ * Author/Date : C.B. Lirakis / 17-Oct-26
+ *
+ * Description : Loopback NTP server for tests.
+ *
+ * Restrictions/Limitations : NONE
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References : RFC 5905
+ *
+ *******************************************************************
+ */
+// System includes.
+#include <iostream>
+using namespace std;
+#include <cstring>
+#include <cmath>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+
+// Local Includes.
+#include "debug.h"
+#include "queryTimeServer.hh"
+#include "NTPStandIn.hh"
+
+static const size_t kNTP_LEN = 48;
+
+/* Host clock plus Offset seconds, NTP fixed point, big endian. */
+static void Stamp(unsigned char *p, double Offset)
+{
+    struct timespec t;
+    double   whole, frac;
+    uint32_t w[2];
+
+    clock_gettime(CLOCK_REALTIME, &t);
+    frac  = modf(t.tv_nsec*1.0e-9 + Offset, &whole);
+    if (frac < 0.0)
+    {
+	frac  += 1.0;
+	whole -= 1.0;
+    }
+    w[0] = htonl((uint32_t) (t.tv_sec + kNTPOffset + (int64_t) whole));
+    w[1] = htonl((uint32_t) (frac*4294967296.0));
+    memcpy(p, w, sizeof(w));
+}
+static void Sleep(double s)
+{
+    struct timespec t;
+    if (s <= 0.0)
+    {
+	return;
+    }
+    t.tv_sec  = (time_t) s;
+    t.tv_nsec = (long) ((s - t.tv_sec)*1.0e9);
+    nanosleep(&t, NULL);
+}
+
+/**
+ ******************************************************************
+ *
+ * Function Name : NTPStandIn Constructor
+ *
+ * Description : Bind the loopback port and start the thread.
+ *
+ * Inputs : Port    - UDP port
+ *          Offset  - seconds added to the host clock
+ *          Delay   - round trip seconds
+ *          Stratum - claimed stratum, 0 is a kiss of death
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NO_SOCKET, ERROR_BIND, NO_THREAD
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+NTPStandIn::NTPStandIn(unsigned short Port, double Offset, double Delay,
+		       int Stratum) : CObject()
+{
+    SET_DEBUG_STACK;
+    struct sockaddr_in local;
+    int    on = 1;
+
+    SetName("NTPStandIn");
+    ClearError(__LINE__);
+    fOffset         = Offset;
+    fDelay          = Delay;
+    fStratum        = Stratum;
+    fRootDispersion = 0.001;
+    fSilent         = false;
+    fAnswered       = 0;
+    fStarted        = false;
+    fRun            = true;
+
+    fSocket = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if ((fSocket < 0) ||
+	(setsockopt(fSocket, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) < 0))
+    {
+	SetError(NO_SOCKET, __LINE__);
+	return;
+    }
+    memset(&local, 0, sizeof(local));
+    local.sin_family      = AF_INET;
+    local.sin_port        = htons(Port);
+    local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fSocket, (struct sockaddr *) &local, sizeof(local)) < 0)
+    {
+	SetError(ERROR_BIND, __LINE__);
+	return;
+    }
+    if (pthread_create(&fThread, NULL, Thread, this) != 0)
+    {
+	SetError(NO_THREAD, __LINE__);
+	return;
+    }
+    fStarted = true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : NTPStandIn Destructor
+ *
+ * Description : The thread polls with a short timeout, clearing
+ *               fRun is enough to stop it.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+NTPStandIn::~NTPStandIn(void)
+{
+    fRun = false;
+    if (fStarted)
+    {
+	pthread_join(fThread, NULL);
+    }
+    if (fSocket >= 0)
+    {
+	close(fSocket);
+    }
+}
+void *NTPStandIn::Thread(void *arg)
+{
+    NTPStandIn *p = (NTPStandIn *) arg;
+    struct pollfd pfd;
+
+    pfd.fd     = p->fSocket;
+    pfd.events = POLLIN;
+    while (p->fRun)
+    {
+	if (poll(&pfd, 1, 100) > 0)
+	{
+	    p->Answer();
+	}
+    }
+    return NULL;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Answer
+ *
+ * Description : Read one request and reply as a server. Half the
+ *               delay passes before the receive stamp and half after
+ *               the transmit stamp, so it looks like the network.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void NTPStandIn::Answer(void)
+{
+    unsigned char      request[kNTP_LEN], reply[kNTP_LEN];
+    struct sockaddr_in from;
+    socklen_t          len = sizeof(from);
+    uint32_t           disp;
+    ssize_t            n;
+
+    n = recvfrom(fSocket, request, sizeof(request), 0,
+		 (struct sockaddr *) &from, &len);
+    if ((n < (ssize_t) kNTP_LEN) || ((request[0] & 0x7) != 3) || fSilent)
+    {
+	return;
+    }
+    Sleep(fDelay/2.0);
+    memset(reply, 0, sizeof(reply));
+    Stamp(reply+32, fOffset);                     // receive, T2
+    reply[0] = (0 << 6) | (4 << 3) | 4;           // server
+    reply[1] = fStratum;
+    reply[2] = 6;
+    reply[3] = (uint8_t) -20;                     // about 1 us
+    disp     = htonl((uint32_t) (fRootDispersion*65536.0));
+    memcpy(reply+8, &disp, sizeof(disp));
+    memcpy(reply+12, "LOCL", 4);
+    memcpy(reply+24, request+40, 8);              // originate = their T1
+    Stamp(reply+16, fOffset);                     // reference
+    Stamp(reply+40, fOffset);                     // transmit, T3
+    Sleep(fDelay/2.0);
+    if (sendto(fSocket, reply, sizeof(reply), 0,
+	       (struct sockaddr *) &from, len) == (ssize_t) sizeof(reply))
+    {
+	fAnswered++;
+    }
+}
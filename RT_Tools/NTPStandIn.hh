@@ -0,0 +1,79 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : NTPStandIn.hh
+ *
+ * Author/Date : C.B. Lirakis / 17-Oct-26
+ *
+ * Description : A local UDP NTP server for testing the clients
+ * without the network. It answers version 4 client requests from
+ * its own thread with the host clock plus a set offset, after a set
+ * round trip delay split evenly either side of its time stamps, so
+ * the client should measure exactly Offset. It can also be made to
+ * stay silent, or to claim to be unsynchronized.
+ *
+ * Restrictions/Limitations : One request at a time. Binds to
+ * 127.0.0.1.
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References : RFC 5905
+ *
+ *******************************************************************
+ */
+#ifndef __NTPSTANDIN_hh_
+#  define __NTPSTANDIN_hh_
+#  include <stdint.h>
+#  include <pthread.h>
+#  include <CObject.hh>
+
+class NTPStandIn : public CObject
+{
+public:
+    /*!
+     * Description:
+     *   Bind 127.0.0.1:Port and start answering.
+     *
+     * Arguments:
+     *   Port    - UDP port
+     *   Offset  - seconds added to the host clock
+     *   Delay   - round trip seconds to simulate
+     *   Stratum - 0 sends a kiss of death
+     *
+     * Errors:
+     *   NO_SOCKET, ERROR_BIND, NO_THREAD
+     */
+    NTPStandIn(unsigned short Port, double Offset = 0.0,
+	       double Delay = 0.0, int Stratum = 2);
+    /// Stops the thread and closes the socket.
+    ~NTPStandIn(void);
+
+    inline void     SetOffset(double v)  {fOffset = v;};
+    inline void     SetDelay(double v)   {fDelay = v;};
+    /// Receive but never answer.
+    inline void     SetSilent(bool v)    {fSilent = v;};
+    /// Root dispersion claimed, seconds.
+    inline void     SetRootDispersion(double v) {fRootDispersion = v;};
+    /// Requests answered.
+    inline uint32_t Answered(void) const {return fAnswered;};
+
+    enum NTPSTANDIN_ERRORS {NO_SOCKET=1, ERROR_BIND, NO_THREAD};
+
+private:
+    static void *Thread(void *arg);
+    void         Answer(void);
+
+    int               fSocket;
+    pthread_t         fThread;
+    bool              fStarted;
+    volatile bool     fRun;
+    volatile double   fOffset;
+    volatile double   fDelay;
+    volatile double   fRootDispersion;
+    volatile bool     fSilent;
+    int               fStratum;
+    volatile uint32_t fAnswered;
+};
+#endif
@@ -0,0 +1,746 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : Scheduler.cpp
+ *
+ * Author/Date : C.B. Lirakis / 17-Oct-26
+ *
+ * Description : timerfd tasks in one epoll loop, with lateness
+ *               statistics.
+ *
+ * Restrictions/Limitations : NONE
+ *
+ * Change Descriptions :
+ * 17-Oct-26 CBL Add leaves no entry behind when the timer fails.
+ * 17-Oct-26 CBL Thread runs Loop, a Stop right after Start holds.
+ *
+ * Classification : Unclassified
+ *
+ * References : timerfd_create(2), epoll(7)
+ *
+ *******************************************************************
+ */
+// System includes.
+#include <iostream>
+using namespace std;
+#include <iomanip>
+#include <cstring>
+#include <cmath>
+#include <errno.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+// Local Includes.
+#include "debug.h"
+#include "hist1D.hh"
+#include "Scheduler.hh"
+
+static const int      kMAX_EVENTS = 64;
+static const uint64_t kWAKE       = ~0ULL;
+
+static int64_t Monotonic(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (int64_t) t.tv_sec*1000000000LL + t.tv_nsec;
+}
+static void ToTimespec(int64_t ns, struct timespec &t)
+{
+    t.tv_sec  = ns / 1000000000LL;
+    t.tv_nsec = ns % 1000000000LL;
+}
+
+/**
+ ******************************************************************
+ *
+ * Function Name : Scheduler Constructor
+ *
+ * Description : Create the epoll set and the Stop eventfd.
+ *
+ * Inputs : JitterRange - histogram upper edge, seconds
+ *          JitterBins  - histogram bins
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NO_EPOLL
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+Scheduler::Scheduler(double JitterRange, uint32_t JitterBins) : CObject()
+{
+    SET_DEBUG_STACK;
+    struct epoll_event ev;
+
+    SetName("Scheduler");
+    ClearError(__LINE__);
+    fJitterRange = (JitterRange > 0.0) ? JitterRange : 1.0e-3;
+    fJitterBins  = (JitterBins > 0) ? JitterBins : 100;
+    fRun         = false;
+    fStarted     = false;
+    fCPU         = -1;
+    fPriority    = 0;
+    fWake        = -1;
+
+    fEpoll = epoll_create1(EPOLL_CLOEXEC);
+    if (fEpoll < 0)
+    {
+	SetError(NO_EPOLL, __LINE__);
+	return;
+    }
+    fWake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    memset(&ev, 0, sizeof(ev));
+    ev.events   = EPOLLIN;
+    ev.data.u64 = kWAKE;
+    if ((fWake < 0) || (epoll_ctl(fEpoll, EPOLL_CTL_ADD, fWake, &ev) < 0))
+    {
+	SetError(NO_EPOLL, __LINE__);
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Scheduler Destructor
+ *
+ * Description : Stop and join any thread, close every timer.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+Scheduler::~Scheduler(void)
+{
+    SET_DEBUG_STACK;
+    Stop();
+    Join();
+    for (size_t i=0; i<fTasks.size(); i++)
+    {
+	if (fTasks[i]->FD >= 0)
+	{
+	    close(fTasks[i]->FD);
+	}
+	delete fTasks[i]->Jitter;
+	delete fTasks[i];
+    }
+    if (fWake >= 0)
+    {
+	close(fWake);
+    }
+    if (fEpoll >= 0)
+    {
+	close(fEpoll);
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : AddPeriodic, AddOneShot
+ *
+ * Description : See Add.
+ *
+ * Inputs : Name     - for the statistics
+ *          Period   - seconds between runs
+ *          Delay    - seconds to the one shot
+ *          Function - task
+ *          Arg      - handed to Function
+ *          Phase    - seconds to the first periodic run
+ *
+ * Returns : task id, -1 on failure
+ *
+ * Error Conditions : BAD_PERIOD, NO_TIMER
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+int Scheduler::AddPeriodic(const char *Name, double Period,
+			   TaskFunction Function, void *Arg, double Phase)
+{
+    if (Period <= 0.0)
+    {
+	SetError(BAD_PERIOD, __LINE__);
+	return -1;
+    }
+    return Add(Name, (Phase > 0.0) ? Phase : Period, Period, Function, Arg);
+}
+int Scheduler::AddOneShot(const char *Name, double Delay,
+			  TaskFunction Function, void *Arg)
+{
+    return Add(Name, Delay, 0.0, Function, Arg);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Add
+ *
+ * Description : Arm a timerfd at the absolute deadline now plus
+ *               Delay, repeating every Period, and put it in the
+ *               epoll set under the task id.
+ *
+ * Inputs : Name     - for the statistics
+ *          Delay    - seconds to the first deadline
+ *          Period   - seconds between deadlines, 0 for once
+ *          Function - task
+ *          Arg      - handed to Function
+ *
+ * Returns : task id, -1 on failure
+ *
+ * Error Conditions : BAD_PERIOD, NO_TIMER
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+int Scheduler::Add(const char *Name, double Delay, double Period,
+		   TaskFunction Function, void *Arg)
+{
+    SET_DEBUG_STACK;
+    struct itimerspec  its;
+    struct epoll_event ev;
+    Entry  *t;
+    int     id = fTasks.size();
+    string  hname;
+
+    ClearError(__LINE__);
+    if ((Delay < 0.0) || (Function == NULL))
+    {
+	SetError(BAD_PERIOD, __LINE__);
+	return -1;
+    }
+    t = new Entry;
+    t->Name        = Name ? Name : "task";
+    t->Active      = false;
+    t->OneShot     = (Period <= 0.0);
+    t->Function    = Function;
+    t->Arg         = Arg;
+    t->Period      = (int64_t) llround(Period*1.0e9);
+    t->First       = Monotonic() + (int64_t) llround(Delay*1.0e9);
+    t->Expirations = 0;
+    t->Runs        = 0;
+    t->Overruns    = 0;
+    t->LongRuns    = 0;
+    t->MaxLate     = 0.0;
+    hname          = t->Name + " lateness us";
+    t->Jitter      = new Hist1D(hname.c_str(), fJitterBins, 0.0,
+				fJitterRange*1.0e6);
+
+    /* A zero it_value disarms the timer, a deadline in the past fires. */
+    if (t->First == 0)
+    {
+	t->First = 1;
+    }
+    memset(&its, 0, sizeof(its));
+    ToTimespec(t->First,  its.it_value);
+    ToTimespec(t->Period, its.it_interval);
+    t->FD = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    memset(&ev, 0, sizeof(ev));
+    ev.events   = EPOLLIN;
+    ev.data.u64 = id;
+    if ((t->FD < 0) ||
+	(timerfd_settime(t->FD, TFD_TIMER_ABSTIME, &its, NULL) < 0) ||
+	(epoll_ctl(fEpoll, EPOLL_CTL_ADD, t->FD, &ev) < 0))
+    {
+	if (t->FD >= 0)
+	{
+	    close(t->FD);
+	}
+	delete t->Jitter;
+	delete t;
+	SetError(NO_TIMER, __LINE__);
+	return -1;
+    }
+    /* Only an armed timer gets an id. */
+    fTasks.push_back(t);
+    t->Active = true;
+    return id;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Cancel
+ *
+ * Description : Close the task's timer, which also takes it out of
+ *               the epoll set. The entry stays for its statistics.
+ *
+ * Inputs : Task - id from Add
+ *
+ * Returns : false for a bad id
+ *
+ * Error Conditions : BAD_TASK
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool Scheduler::Cancel(int Task)
+{
+    SET_DEBUG_STACK;
+    struct Entry *t = Find(Task);
+
+    if (t == NULL)
+    {
+	SetError(BAD_TASK, __LINE__);
+	return false;
+    }
+    if (t->FD >= 0)
+    {
+	close(t->FD);
+	t->FD = -1;
+    }
+    t->Active = false;
+    return true;
+}
+Scheduler::Entry* Scheduler::Find(int Task) const
+{
+    if ((Task < 0) || (Task >= (int) fTasks.size()))
+    {
+	return NULL;
+    }
+    return fTasks[Task];
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Dispatch
+ *
+ * Description : A task's timer fired. The expiration count says how
+ *               many deadlines passed since the last read; the most
+ *               recent of them is the one this run is for, the rest
+ *               are overruns. Lateness is measured from that deadline
+ *               to now, and the run is timed against the period.
+ *
+ * Inputs : Task - id from the epoll event
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void Scheduler::Dispatch(int Task)
+{
+    SET_DEBUG_STACK;
+    struct Entry *t = Find(Task);
+    uint64_t     count;
+    int64_t      now, deadline;
+    double       late;
+
+    if ((t == NULL) || !t->Active ||
+	(read(t->FD, &count, sizeof(count)) != (ssize_t) sizeof(count)) ||
+	(count == 0))
+    {
+	return;
+    }
+    now             = Monotonic();
+    t->Expirations += count;
+    t->Overruns    += count - 1;
+    deadline        = t->First + (int64_t) (t->Expirations - 1)*t->Period;
+    late            = (now - deadline)*1.0e-9;
+    if (late > t->MaxLate)
+    {
+	t->MaxLate = late;
+    }
+    t->Jitter->Fill(late*1.0e6);
+    t->Runs++;
+
+    t->Function(this, Task, t->Arg);
+
+    if (t->OneShot)
+    {
+	Cancel(Task);
+    }
+    else if (Monotonic() - now > t->Period)
+    {
+	t->LongRuns++;
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Poll
+ *
+ * Description : Wait for timers and run what is due.
+ *
+ * Inputs : Timeout - seconds, negative to wait forever
+ *
+ * Returns : tasks run, -1 on error
+ *
+ * Error Conditions : NO_EPOLL, WAIT_FAILED
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+int Scheduler::Poll(double Timeout)
+{
+    SET_DEBUG_STACK;
+    struct epoll_event ev[kMAX_EVENTS];
+    int    n, ran = 0;
+    int    ms = (Timeout < 0.0) ? -1 : (int) ceil(Timeout*1000.0);
+
+    if (fEpoll < 0)
+    {
+	SetError(NO_EPOLL, __LINE__);
+	return -1;
+    }
+    n = epoll_wait(fEpoll, ev, kMAX_EVENTS, ms);
+    if (n < 0)
+    {
+	if (errno == EINTR)
+	{
+	    return 0;
+	}
+	SetError(WAIT_FAILED, __LINE__);
+	return -1;
+    }
+    for (int i=0; i<n; i++)
+    {
+	if (ev[i].data.u64 == kWAKE)
+	{
+	    uint64_t count;
+	    if (read(fWake, &count, sizeof(count)) < 0)
+	    {
+		/* Already drained. */
+	    }
+	    continue;
+	}
+	Dispatch((int) ev[i].data.u64);
+	ran++;
+    }
+    return ran;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Run
+ *
+ * Description : Poll until Stop. Run is for a caller that gives 
+ *               up its own thread and raises the run flag itself. 
+ *               The Start thread goes straight to Loop, Start has 
+ *               already raised the flag and a Stop may have lowered
+ *               it again since.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void Scheduler::Run(void)
+{
+    SET_DEBUG_STACK;
+    fRun = true;
+    Loop();
+}
+void Scheduler::Loop(void)
+{
+    while (fRun)
+    {
+	if (Poll(-1.0) < 0)
+	{
+	    break;
+	}
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Stop
+ *
+ * Description : Clear the run flag and kick the epoll wait.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void Scheduler::Stop(void)
+{
+    uint64_t one = 1;
+    fRun = false;
+    if ((fWake >= 0) && (write(fWake, &one, sizeof(one)) < 0))
+    {
+	/* Counter full, a wakeup is pending anyway. */
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Start
+ *
+ * Description : Run in a new thread, pinned and prioritized as asked.
+ *
+ * Inputs : CPU      - CPU to pin to, -1 for none
+ *          Priority - SCHED_FIFO priority, 0 for none
+ *
+ * Returns : true if the thread started
+ *
+ * Error Conditions : NO_THREAD
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool Scheduler::Start(int CPU, int Priority)
+{
+    SET_DEBUG_STACK;
+    ClearError(__LINE__);
+    if (fStarted)
+    {
+	return true;
+    }
+    fCPU      = CPU;
+    fPriority = Priority;
+    fRun      = true;
+    if (pthread_create(&fThread, NULL, Thread, this) != 0)
+    {
+	fRun = false;
+	SetError(NO_THREAD, __LINE__);
+	return false;
+    }
+    fStarted = true;
+    return true;
+}
+void *Scheduler::Thread(void *arg)
+{
+    Scheduler *p = (Scheduler *) arg;
+    p->Pin(p->fCPU, p->fPriority);
+    p->Loop();
+    return NULL;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Join
+ *
+ * Description : Wait for the Start thread, call after Stop.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void Scheduler::Join(void)
+{
+    if (fStarted)
+    {
+	pthread_join(fThread, NULL);
+	fStarted = false;
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Pin
+ *
+ * Description : CPU affinity and SCHED_FIFO for the calling thread.
+ *               Both usually need privileges (CAP_SYS_NICE) for the
+ *               priority, the failure is recorded and ignored.
+ *
+ * Inputs : CPU      - CPU number, -1 to skip
+ *          Priority - SCHED_FIFO priority, 0 to skip
+ *
+ * Returns : true if everything asked for was done
+ *
+ * Error Conditions : NO_AFFINITY, NO_PRIORITY
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool Scheduler::Pin(int CPU, int Priority)
+{
+    SET_DEBUG_STACK;
+    bool rc = true;
+
+    if (CPU >= 0)
+    {
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(CPU, &set);
+	if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+	{
+	    SetError(NO_AFFINITY, __LINE__);
+	    rc = false;
+	}
+    }
+    if (Priority > 0)
+    {
+	struct sched_param sp;
+	memset(&sp, 0, sizeof(sp));
+	sp.sched_priority = Priority;
+	if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp) != 0)
+	{
+	    SetError(NO_PRIORITY, __LINE__);
+	    rc = false;
+	}
+    }
+    return rc;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Name, Active, Runs, Overruns, LongRuns, MaxLate,
+ *                 Jitter
+ *
+ * Description : Per task statistics.
+ *
+ * Inputs : Task - id from Add
+ *
+ * Returns : as named, NULL/false/0 for a bad id
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+const char* Scheduler::Name(int Task) const
+{
+    struct Entry *t = Find(Task);
+    return t ? t->Name.c_str() : NULL;
+}
+bool Scheduler::Active(int Task) const
+{
+    struct Entry *t = Find(Task);
+    return t && t->Active;
+}
+uint64_t Scheduler::Runs(int Task) const
+{
+    struct Entry *t = Find(Task);
+    return t ? t->Runs : 0;
+}
+uint64_t Scheduler::Overruns(int Task) const
+{
+    struct Entry *t = Find(Task);
+    return t ? t->Overruns : 0;
+}
+uint64_t Scheduler::LongRuns(int Task) const
+{
+    struct Entry *t = Find(Task);
+    return t ? t->LongRuns : 0;
+}
+double Scheduler::MaxLate(int Task) const
+{
+    struct Entry *t = Find(Task);
+    return t ? t->MaxLate : 0.0;
+}
+Hist1D* Scheduler::Jitter(int Task) const
+{
+    struct Entry *t = Find(Task);
+    return t ? t->Jitter : NULL;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : operator <<
+ *
+ * Description : One line per task, lateness in microseconds.
+ *
+ * Inputs : output - stream
+ *          n      - scheduler
+ *
+ * Returns : the stream
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+ostream& operator<<(ostream& output, const Scheduler &n)
+{
+    double mean, sigma;
+
+    output << "  task             period ms     runs  overrun  long"
+	   << "   mean us  sigma us    max us" << endl;
+    for (size_t i=0; i<n.fTasks.size(); i++)
+    {
+	Scheduler::Entry *t = n.fTasks[i];
+	sigma = t->Runs ? t->Jitter->Sigma(&mean) : 0.0;
+	if (!t->Runs)
+	{
+	    mean = 0.0;
+	}
+	output << "  " << left << setw(16) << t->Name << right << fixed
+	       << setprecision(3) << setw(10) << t->Period*1.0e-6
+	       << setw(9) << t->Runs
+	       << setw(9) << t->Overruns
+	       << setw(6) << t->LongRuns
+	       << setprecision(1)
+	       << setw(10) << mean
+	       << setw(10) << sigma
+	       << setw(10) << t->MaxLate*1.0e6
+	       << (t->Active ? "" : "  done") << endl;
+    }
+    output.unsetf(ios::fixed);
+    return output;
+}
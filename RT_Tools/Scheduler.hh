@@ -0,0 +1,202 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : Scheduler.hh
+ *
+ * Author/Date : C.B. Lirakis / 17-Oct-26
+ *
+ * Description : Periodic and one shot tasks from one thread.
+ *
+ * A loop that sleeps its period with Timeout or polls IsOver slips
+ * by however long its own work took each time round, and every such
+ * loop wants its own thread. Here each task is a timerfd armed on
+ * CLOCK_MONOTONIC at an absolute first deadline with the period as
+ * its interval, so the kernel keeps the schedule and nothing slips.
+ * All the timers sit in one epoll set and the task functions are
+ * called from the thread that runs Poll or Run, or from the thread
+ * Start makes, which can be pinned to a CPU and given a real time
+ * priority.
+ *
+ * Every wake up is compared with the deadline it was for and the
+ * lateness goes into a Hist1D per task, in microseconds. Deadlines
+ * that passed while the thread was busy elsewhere are counted as
+ * overruns, as are task functions that took longer than a period.
+ *
+ * Restrictions/Limitations : Add and Cancel from the scheduling
+ * thread (a task may cancel itself) or before Start. Stop is safe
+ * from anywhere. The statistics are only steady once Join returns.
+ * Linux only.
+ *
+ * Change Descriptions :
+ * 17-Oct-26 CBL The Start thread no longer sets the run flag, a
+ *               Stop before it got going was lost. 
+ *
+ * Classification : Unclassified
+ *
+ * References : timerfd_create(2), epoll(7)
+ *
+ *******************************************************************
+ */
+#ifndef __SCHEDULER_hh_
+#  define __SCHEDULER_hh_
+#  include <stdint.h>
+#  include <vector>
+#  include <string>
+#  include <pthread.h>
+#  include <CObject.hh>
+
+class Hist1D;
+class Scheduler;
+
+/**
+ * Called at each deadline. Task is the id Add returned, good for
+ * Cancel and the statistics.
+ */
+typedef void (*TaskFunction)(Scheduler *S, int Task, void *Arg);
+
+class Scheduler : public CObject
+{
+public:
+    /*!
+     * Description:
+     *   Make the epoll set, no tasks yet.
+     *
+     * Arguments:
+     *   JitterRange - upper edge of the lateness histograms, seconds
+     *   JitterBins  - bins in each
+     *
+     * Errors:
+     *   NO_EPOLL
+     */
+    Scheduler(double JitterRange = 1.0e-3, uint32_t JitterBins = 100);
+    /// Stops and joins the thread, closes the timers.
+    ~Scheduler(void);
+
+    /*!
+     * Description:
+     *   Run Function every Period seconds, the first time Phase
+     *   seconds from now.
+     *
+     * Arguments:
+     *   Name     - for the statistics
+     *   Period   - seconds
+     *   Function - task
+     *   Arg      - handed to Function
+     *   Phase    - delay to the first run, seconds, 0 is one Period
+     *
+     * Returns:
+     *   task id, -1 on failure
+     *
+     * Errors:
+     *   BAD_PERIOD, NO_TIMER
+     */
+    int  AddPeriodic(const char *Name, double Period, TaskFunction Function,
+		     void *Arg = NULL, double Phase = 0.0);
+    /*!
+     * Description:
+     *   Run Function once, Delay seconds from now. The task is
+     *   cancelled after it runs.
+     *
+     * Returns:
+     *   task id, -1 on failure
+     *
+     * Errors:
+     *   BAD_PERIOD, NO_TIMER
+     */
+    int  AddOneShot(const char *Name, double Delay, TaskFunction Function,
+		    void *Arg = NULL);
+    /// Disarm a task, its statistics are kept. false for a bad id.
+    bool Cancel(int Task);
+
+    /**
+     * Wait up to Timeout seconds (negative forever) and run what is
+     * due. Returns the number of tasks run, -1 on error.
+     */
+    int  Poll(double Timeout);
+    /// Poll until Stop, in the calling thread. Not with Start.
+    void Run(void);
+    /// Make Run return. Safe from another thread or a signal handler.
+    void Stop(void);
+
+    /*!
+     * Description:
+     *   Run in a thread of its own.
+     *
+     * Arguments:
+     *   CPU      - pin the thread to this CPU, -1 leaves it free
+     *   Priority - SCHED_FIFO priority, 0 leaves it SCHED_OTHER
+     *
+     * Returns:
+     *   true if the thread started. A pinning or priority failure
+     *   is recorded but the thread still runs.
+     *
+     * Errors:
+     *   NO_THREAD, NO_AFFINITY, NO_PRIORITY
+     */
+    bool Start(int CPU = -1, int Priority = 0);
+    /// Wait for the Start thread to return after Stop.
+    void Join(void);
+    /**
+     * Pin the calling thread to CPU (-1 skips) and set its SCHED_FIFO
+     * Priority (0 skips). For use before Run. SetError on failure.
+     */
+    bool Pin(int CPU, int Priority);
+
+    /* Per task statistics, by the id Add returned. -------------- */
+    inline size_t Tasks(void) const {return fTasks.size();};
+    const char*   Name(int Task)     const;
+    bool          Active(int Task)   const;
+    uint64_t      Runs(int Task)     const;
+    /// Deadlines that passed while the thread was busy.
+    uint64_t      Overruns(int Task) const;
+    /// Runs that took longer than the period.
+    uint64_t      LongRuns(int Task) const;
+    /// Worst lateness, seconds.
+    double        MaxLate(int Task)  const;
+    /// Lateness histogram in microseconds, NULL for a bad id.
+    Hist1D*       Jitter(int Task)   const;
+
+    friend std::ostream& operator<<(std::ostream& output,
+				    const Scheduler &n);
+
+    enum SCHEDULER_ERRORS {NO_EPOLL=1, NO_TIMER, BAD_PERIOD, BAD_TASK,
+			   WAIT_FAILED, NO_THREAD, NO_AFFINITY, NO_PRIORITY};
+
+private:
+    struct Entry {
+	std::string  Name;
+	int          FD;
+	bool         Active;
+	bool         OneShot;
+	TaskFunction Function;
+	void        *Arg;
+	int64_t      First;       // CLOCK_MONOTONIC ns of the first deadline
+	int64_t      Period;      // ns, 0 for a one shot
+	uint64_t     Expirations; // deadlines passed so far
+	uint64_t     Runs;
+	uint64_t     Overruns;
+	uint64_t     LongRuns;
+	double       MaxLate;
+	Hist1D      *Jitter;
+    };
+
+    int          Add(const char *Name, double Delay, double Period,
+		     TaskFunction Function, void *Arg);
+    Entry*       Find(int Task) const;
+    void         Dispatch(int Task);
+    /// Poll while fRun, never sets it.
+    void         Loop(void);
+    static void *Thread(void *arg);
+
+    std::vector<Entry*> fTasks;
+    int                fEpoll;
+    int                fWake;       // eventfd for Stop
+    volatile bool      fRun;
+    double             fJitterRange;
+    uint32_t           fJitterBins;
+    pthread_t          fThread;
+    bool               fStarted;
+    int                fCPU;
+    int                fPriority;
+};
+#endif
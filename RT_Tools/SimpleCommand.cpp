@@ -9,6 +9,7 @@
  * Restrictions/Limitations :
  *
  * Change Descriptions :
+ * 17-Oct-26 CBL Added Wait. 
  *
  * Classification : Unclassified
  *
@@ -142,6 +143,38 @@ struct CommandStructure *SimpleCommand::Command(const char *Name,
     SET_DEBUG_STACK;
     return &fMyCommand;
 }
+/**
+ ******************************************************************
+ *
+ * Function Name : Wait
+ *
+ * Description : Sleep on the shared memory update rather than 
+ *               polling, commands are picked up as soon as they 
+ *               are posted. 
+ *
+ * Inputs : Timeout - seconds, negative forever
+ *
+ * Returns : pointer to the command, kINVALID if none for us
+ *
+ * Error Conditions : None
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+struct CommandStructure *SimpleCommand::Wait(double Timeout)
+{
+    SET_DEBUG_STACK;
+    if (!fSource && WaitForUpdate(Timeout))
+    {
+	return Command(NULL, kNONE);
+    }
+    fMyCommand.Command = kINVALID;
+    return &fMyCommand;
+}
 /**
  ******************************************************************
  *
@@ -10,6 +10,11 @@
  * Restrictions/Limitations :
  *
  * Change Descriptions :
+ * 17-Oct-26 CBL Wait, block until a command arrives rather than 
+ *               polling Command in a sleep loop. 
+ * 17-Oct-26 CBL kDUMP_LOG, ask for the CLogger flight recorder. 
+ * 17-Oct-26 CBL kDUMP_LOG is its own bit, 0x0003 was 
+ *               kCHANGE_FILE_NAME|kSHUTDOWN. 
  *
  * Classification : Unclassified
  *
@@ -40,7 +45,7 @@ public:
      * Zero means the message was meant for all. 
      */
     enum COMMANDS{kNONE=0, kCHANGE_FILE_NAME=0x0001, kSHUTDOWN=0x0002, 
-		  kINVALID = 0xFFFF};
+		  kDUMP_LOG=0x0004, kINVALID = 0xFFFF};
 
     /*!
      * Name - Name used for consumer, ignored on Source declaration. 
@@ -69,6 +74,23 @@ public:
      */
     struct CommandStructure *Command(const char *Name, uint32_t Command);
 
+    /*!
+     * Description: 
+     *   Consumer, block until the source posts something or 
+     *   Timeout seconds pass, then decode it as Command does. 
+     *
+     * Arguments:
+     *   Timeout - seconds, negative waits forever. 
+     *
+     * Returns:
+     *   The command, Command field kINVALID on timeout or if the 
+     *   message was meant for someone else. 
+     *
+     * Errors:
+     *   NONE
+     */
+    struct CommandStructure *Wait(double Timeout);
+
     /*!
      * Description: 
      *   Either can reset the request. 
@@ -10,6 +10,8 @@
  * Restrictions/Limitations :
  *
  * Change Descriptions :
+ * 17-Oct-26 CBL For periodic work use Scheduler, which keeps an 
+ *               absolute schedule and runs many tasks per thread. 
  *
  * Classification : Unclassified
  *
@@ -9,6 +9,11 @@
  * Restrictions/Limitations :
  *
  * Change Descriptions :
+ * 17-Oct-26 CBL Dump the CLogger flight recorder on a fault and
+ *               on SIGUSR1. Log the shadow call stack if built 
+ *               with DEBUG_CALL_STACK. 
+ * 17-Oct-26 CBL SIGUSR1 only sets a flag, the dump is done by 
+ *               UserSignalService from the main loop. 
  *
  * Classification : Unclassified
  *
@@ -31,6 +36,8 @@ using namespace std;
 #include "debug.h"
 #include "CLogger.hh"
 
+/* Set by SIGUSR1, cleared by UserSignalService. */
+static volatile sig_atomic_t DumpRequested = 0;
 
 /**
  ******************************************************************
@@ -130,10 +137,16 @@ void Terminate (int sig)
     }
     if (sig!=0)
     {
+	logger->DumpFlightRecorder(msg, true);
         sprintf ( tmp, " %s %d", LastFile, LastLine);
         strncat ( msg, tmp, sizeof(msg)-strlen(tmp));
 	logger->LogCommentTimestamp(msg);
 	//logger->Log("# %s\n",msg);
+	char stack[4096];
+	if (DebugStackDump(stack, sizeof(stack)) > 0)
+	{
+	    logger->Log("# Call stack:\n%s", stack);
+	}
     }
 
     // User termination here
@@ -175,12 +188,48 @@ void UserSignal(int sig)
     switch (sig)
     {
     case SIGUSR1:   // 10
+	DumpRequested = 1;
+	break;
     case SIGUSR2:   // 12
 	logger->Log("# SIGUSR: %d\n", sig);
 	// User code here. 
 	break;
     }
 }
+/**
+ ******************************************************************
+ *
+ * Function Name : UserSignalService
+ *
+ * Description : Do what the user signals asked for, outside the
+ *               handler. The flight recorder dump takes the log
+ *               lock and allocates, it is not safe in a handler.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void UserSignalService(void)
+{
+    CLogger *logger = CLogger::GetThis();
+    if (DumpRequested)
+    {
+	DumpRequested = 0;
+	if (logger)
+	{
+	    logger->DumpFlightRecorder("SIGUSR1");
+	}
+    }
+}
 /**
  ******************************************************************
  *
@@ -11,6 +11,8 @@
  * Restrictions/Limitations : none
  *
  * Change Descriptions :
+ * 17-Oct-26 CBL UserSignalService, signal requests run from the 
+ *               main loop. 
  *
  * Classification : Unclassified
  *
@@ -30,6 +32,12 @@ void Terminate (int sig);
  * Catch and deal with user signals here. 
  */
 void UserSignal(int sig);
+/**
+ * The user signal handlers only note what was asked for, call this
+ * from the main loop to do it. Dumps the flight recorder after a 
+ * SIGUSR1. 
+ */
+void UserSignalService(void);
 /**
  * Call to setup all signals. 
  */
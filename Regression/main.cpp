@@ -10,6 +10,14 @@
  * Restrictions/Limitations :
  *
  * Change Descriptions :
+ * 17-Oct-26 CBL TestMultiTS, MultiQueryTS against NTPStandIn.
+ * 17-Oct-26 CBL TestTracker, ClockTracker against a drifting stand-in.
+ * 17-Oct-26 CBL TestFastClock, time stamp cost and agreement.
+ * 17-Oct-26 CBL TestScheduler, several tasks on one timerfd thread.
+ * 17-Oct-26 CBL TestNetServer, broadcast to 20 loopback clients.
+ * 17-Oct-26 CBL TestSharedRing, slow consumer in a forked child.
+ * 17-Oct-26 CBL H5Logger compression benchmark built again, -b. 
+ * 17-Oct-26 CBL TestH5Rollover runs on its own and is built, -o. 
  *
  * Classification : Unclassified
  *
@@ -28,11 +36,17 @@ using namespace std;
 #include <fstream>
 #include <cstdlib>
 #include <random>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <vector>
 
 /// Local Includes.
 #include "debug.h"
 #include "tools.h"
-#include "CLogger.hh"
+#include "CLogDeferred.hh"
 #include "UserSignals.hh"
 #include "Version.hh"
 #include "SimpleCommand.hh"
@@ -40,7 +54,16 @@ using namespace std;
 #include "TimeUtil.hh"
 #include "hist1D.hh"
 #include "queryTimeServer.hh"
+#include "MultiQueryTS.hh"
+#include "NTPStandIn.hh"
+#include "ClockTracker.hh"
+#include "FastClock.hh"
+#include "Scheduler.hh"
+#include "NetServer.hh"
+#include "SharedRing.hh"
 #include "RTGraph.hh"
+#include "H5Logger.hh"
+#include "filename.hh"
 
 /** Control the verbosity of the program output via the bits shown. */
 static unsigned int VerboseLevel = 0;
@@ -49,6 +72,14 @@ static unsigned int VerboseLevel = 0;
 static CLogger   *logger;
 static bool      Server = true;
 static bool      run;
+static bool      TimeServers = false;
+static bool      Tracker     = false;
+static bool      Stamps      = false;
+static bool      Tasks       = false;
+static bool      Net         = false;
+static bool      Ring        = false;
+static bool      H5Compression = false;
+static bool      H5Rollover    = false;
 /**
  ******************************************************************
  *
@@ -72,6 +103,14 @@ static void Help(void)
     cout << "* Built on "<< __DATE__ << " " << __TIME__ << "*" << endl;
     cout << "* Available options are :                  *" << endl;
     cout << "*     -C client                            *" << endl;
+    cout << "*     -t NTP selection against stand-ins   *" << endl;
+    cout << "*     -d drift tracking against a stand-in *" << endl;
+    cout << "*     -f FastClock against clock_gettime   *" << endl;
+    cout << "*     -n NetServer broadcast, 20 clients   *" << endl;
+    cout << "*     -r SharedRing with a slow consumer   *" << endl;
+    cout << "*     -s periodic tasks on one Scheduler   *" << endl;
+    cout << "*     -b H5Logger compression benchmark    *" << endl;
+    cout << "*     -o H5Logger rollover, 256kB files    *" << endl;
     cout << "*                                          *" << endl;
     cout << "********************************************" << endl;
 }
@@ -103,9 +142,12 @@ ProcessCommandLineArgs(int argc, char **argv)
     SET_DEBUG_STACK;
     do
     {
-        option = getopt( argc, argv, "CchHnv");
+        option = getopt( argc, argv, "bCcdfhHnorstv");
         switch(option)
         {
+	case 'b':
+	    H5Compression = true;
+	    break;
 	case 'c':
 	case 'C':
 	    Server = false;
@@ -115,6 +157,27 @@ ProcessCommandLineArgs(int argc, char **argv)
             Help();
         Terminate(0);
         break;
+	case 'd':
+	    Tracker = true;
+	    break;
+	case 'f':
+	    Stamps = true;
+	    break;
+	case 'n':
+	    Net = true;
+	    break;
+	case 'o':
+	    H5Rollover = true;
+	    break;
+	case 'r':
+	    Ring = true;
+	    break;
+	case 's':
+	    Tasks = true;
+	    break;
+	case 't':
+	    TimeServers = true;
+	    break;
 	case 'v':
 	    VerboseLevel = atoi(optarg);
             break;
@@ -157,6 +220,7 @@ static bool Initialize(void)
     version = atof( msg);
     logger = new CLogger("xxx.log", "xxx", version);
     logger->SetVerbose(VerboseLevel);
+    logger->SetFlightRecorder();
 
     return true;
 }
@@ -177,7 +241,6 @@ static void TimeoutTest(void)
 }
 static void TestSimpleCommand(void)
 {
-    struct timespec sleeptime={0L, 100000000L};
     struct CommandStructure *cs;
     SimpleCommand *sc;
     time_t now;
@@ -194,6 +257,9 @@ static void TestSimpleCommand(void)
 	cout << "ALL Change file." << endl;
 	sc->Command("ALL", SimpleCommand::kCHANGE_FILE_NAME);
 	sleep(10);
+	cout << "TEST Dump log." << endl;
+	sc->Command("TEST", SimpleCommand::kDUMP_LOG);
+	sleep(10);
 	cout << "OTHER SHUTDOWN" << endl;
 	sc->Command("OTHER", SimpleCommand::kSHUTDOWN);
 	sleep(10);
@@ -204,7 +270,7 @@ static void TestSimpleCommand(void)
     {
 	sc = new SimpleCommand(false,"TEST");
 	do {
-	    cs = sc->Command(NULL, SimpleCommand::kNONE); // doesn't really matter
+	    cs = sc->Wait(1.0);
 	    time(&now);
 
 	    if (cs->Command != SimpleCommand::kINVALID)
@@ -212,9 +278,16 @@ static void TestSimpleCommand(void)
 		cout << " Command = 0x" << hex << cs->Command << ctime(&now);
 		sc->Reset();
 	    }
+	    if (cs->Command == SimpleCommand::kDUMP_LOG)
+	    {
+		logger->DumpFlightRecorder("SimpleCommand");
+	    }
+	    else
+	    {
+		logger->LogVerbose(2, "Wait, command 0x%x\n", cs->Command);
+	    }
+	    UserSignalService();
 	    run = !(cs->Command == SimpleCommand::kSHUTDOWN);
-
-	    nanosleep(&sleeptime, NULL);
 	} while (run);
     }
 }
@@ -357,6 +430,590 @@ static void Testntp(void)
   
 }
 #endif
+/**
+ ******************************************************************
+ *
+ * Function Name : TestMultiTS
+ *
+ * Description : MultiQueryTS against loopback stand-in servers:
+ *               three agree on +10 ms, one is 500 ms out and one
+ *               never answers. The round should take the silent
+ *               server's timeout, not the sum of the round trips,
+ *               and the falseticker should be left out.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+static void TestMultiTS(void)
+{
+    NTPStandIn a(12301, 0.010, 0.002);
+    NTPStandIn b(12302, 0.011, 0.004);
+    NTPStandIn c(12303, 0.009, 0.001);
+    NTPStandIn d(12304, 0.500, 0.001);
+    NTPStandIn e(12305, 0.010, 0.001);
+    struct timespec t0, t1;
+    MultiQueryTS mq;
+
+    e.SetSilent(true);
+    mq.AddServer("127.0.0.1", 0.5, 12301);
+    mq.AddServer("127.0.0.1", 0.5, 12302);
+    mq.AddServer("127.0.0.1", 0.5, 12303);
+    mq.AddServer("127.0.0.1", 0.5, 12304);
+    mq.AddServer("127.0.0.1", 0.2, 12305);
+    for (int i=0; i<4; i++)
+    {
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	bool ok = mq.Sample();
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	cout << "Round " << i << (ok ? " ok " : " failed ")
+	     << (t1.tv_sec - t0.tv_sec) + 1.0e-9*(t1.tv_nsec - t0.tv_nsec)
+	     << " s" << endl << mq;
+    }
+    cout << "Expect 10 ms, falseticker "
+	 << (mq.Truechimer(3) ? "ACCEPTED" : "rejected") << endl;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : TestTracker
+ *
+ * Description : ClockTracker polling a stand-in whose offset runs
+ *               away at 100 ppm. A client attached to the same
+ *               segment should see the same model, and CorrectedNow
+ *               should cost little more than the clock read.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+static void TestTracker(void)
+{
+    const double    kDRIFT = 100.0e-6;
+    NTPStandIn      ntp(12311, 0.005, 0.001);
+    ClockTracker    server(true, "ClockTrackerTest", 0.1, 16);
+    ClockTracker    client(false, "ClockTrackerTest");
+    struct ClockModel m;
+    struct timespec t0, t1, t;
+    double          dt;
+    int64_t         sum = 0;
+    const int       N = 1000000;
+
+    server.AddServer("127.0.0.1", 0.5, 12311);
+    server.Start();
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    do
+    {
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	dt = (t1.tv_sec - t0.tv_sec) + 1.0e-9*(t1.tv_nsec - t0.tv_nsec);
+	ntp.SetOffset(0.005 + kDRIFT*dt);
+	usleep(10000);
+    } while (dt < 3.0);
+    server.Stop();
+
+    client.Model(m);
+    cout << "Samples " << m.NSamples
+	 << " offset " << m.Offset*1.0e-6 << " ms"
+	 << " drift " << client.DriftPPM() << " ppm (expect 100)"
+	 << " residual " << m.Residual*1.0e6 << " us" << endl;
+    cout << "Stand-in ended at " << (0.005 + kDRIFT*dt)*1.0e3
+	 << " ms, client extrapolates " << client.Offset()*1.0e3 << " ms" << endl;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i=0; i<N; i++)
+    {
+	clock_gettime(CLOCK_REALTIME, &t);
+	sum += client.CorrectedNow(t) & 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    dt = (t1.tv_sec - t0.tv_sec) + 1.0e-9*(t1.tv_nsec - t0.tv_nsec);
+    cout << "clock_gettime + CorrectedNow " << dt/N*1.0e9 << " ns" << endl;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i=0; i<N; i++)
+    {
+	clock_gettime(CLOCK_REALTIME, &t);
+	sum += t.tv_nsec & 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    dt = (t1.tv_sec - t0.tv_sec) + 1.0e-9*(t1.tv_nsec - t0.tv_nsec);
+    cout << "clock_gettime alone          " << dt/N*1.0e9 << " ns "
+	 << (sum & 1) << endl;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : TestFastClock
+ *
+ * Description : Per call cost of clock_gettime against the FastClock
+ *               stamp, with and without conversion, and how far the
+ *               converted time wanders from the system clock over a
+ *               few re-anchors. Finishes with the fallback cost.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+static double PerCall(const struct timespec &t0, const struct timespec &t1,
+		      int N)
+{
+    return ((t1.tv_sec - t0.tv_sec)*1.0e9 + (t1.tv_nsec - t0.tv_nsec))/N;
+}
+static void TestFastClock(void)
+{
+    const int       N = 1000000;
+    struct timespec t0, t1, t, f;
+    uint64_t        sum = 0;
+    int64_t         diff, worst = 0;
+    TimeUtil        tu;
+
+    cout << "Source " << (FastClock::Init() == FastClock::kTSC ?
+			  "TSC " : "clock_gettime ")
+	 << FastClock::Frequency()*1.0e-6 << " MHz" << endl;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i=0; i<N; i++)
+    {
+	clock_gettime(CLOCK_REALTIME, &t);
+	sum += t.tv_nsec;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    cout << "clock_gettime         " << PerCall(t0, t1, N) << " ns" << endl;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i=0; i<N; i++)
+    {
+	sum += FastClock::Ticks();
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    cout << "FastClock::Ticks      " << PerCall(t0, t1, N) << " ns" << endl;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i=0; i<N; i++)
+    {
+	FastClock::Now(t);
+	sum += t.tv_nsec;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    cout << "FastClock::Now        " << PerCall(t0, t1, N) << " ns" << endl;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i=0; i<N; i++)
+    {
+	tu.Now(&t);
+	sum += t.tv_nsec;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    cout << "TimeUtil::Now         " << PerCall(t0, t1, N) << " ns" << endl;
+
+    for (int i=0; i<30; i++)
+    {
+	clock_gettime(CLOCK_REALTIME, &t);
+	FastClock::Now(f);
+	diff = (f.tv_sec - t.tv_sec)*1000000000LL + (f.tv_nsec - t.tv_nsec);
+	if (llabs(diff) > llabs(worst))
+	{
+	    worst = diff;
+	}
+	usleep(100000);
+    }
+    cout << "Worst difference over 3 s " << worst << " ns, suspect "
+	 << FastClock::Suspect() << endl;
+
+    FastClock::Disable();
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i=0; i<N; i++)
+    {
+	FastClock::Now(t);
+	sum += t.tv_nsec;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    cout << "Fallback FastClock::Now " << PerCall(t0, t1, N) << " ns "
+	 << (sum & 1) << endl;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : TestScheduler
+ *
+ * Description : Stand-ins for GPS polling, scope reads and log
+ *               flushes sharing one Scheduler thread for 3 s, plus a
+ *               task that sometimes runs past its period and a one
+ *               shot that cancels the scope read half way.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+static void Work(Scheduler *, int, void *Arg)
+{
+    struct timespec t = {0, (long) (intptr_t) Arg};
+    nanosleep(&t, NULL);
+}
+static void Slow(Scheduler *, int, void *)
+{
+    static int n = 0;
+    struct timespec t = {0, (++n % 5) ? 1000000L : 30000000L};
+    nanosleep(&t, NULL);
+}
+static void StopScope(Scheduler *S, int, void *Arg)
+{
+    S->Cancel((int) (intptr_t) Arg);
+}
+static void TestScheduler(void)
+{
+    Scheduler s(2.0e-3, 40);
+    int       scope;
+
+    s.AddPeriodic("gps",   0.100, Work, (void *) 1000000L);
+    scope = s.AddPeriodic("scope", 0.020, Work, (void *) 200000L, 0.005);
+    s.AddPeriodic("flush", 1.000, Work, (void *) 5000000L);
+    s.AddPeriodic("slow",  0.025, Slow);
+    s.AddOneShot("stop scope", 1.5, StopScope, (void *) (intptr_t) scope);
+    if (!s.Start(0))
+    {
+	cout << "Scheduler did not start" << endl;
+	return;
+    }
+    sleep(3);
+    s.Stop();
+    s.Join();
+    cout << s;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : TestNetServer
+ *
+ * Description : 20 loopback clients on a NetServer limited to 20,
+ *               a 21st is turned away. 20000 broadcasts of 1 kB,
+ *               client 1 never reads. The other 19 should get every
+ *               byte, the slow one should sit at the 64 kB queue 
+ *               limit with its losses counted.
+ *               Then 10 MB sent to one client that isn't reading, 
+ *               far more than 64 messages have to queue. Once it 
+ *               reads it should get all of it and the queue empty.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+static void NetCount(NetServer *, int Client, NetEvent Event, Buffered *,
+		     void *Arg)
+{
+    vector<int> *ids = (vector<int> *) Arg;
+    if (Event == kNET_OPEN)
+    {
+	ids->push_back(Client);
+    }
+}
+static size_t NetDrain(int fd)
+{
+    char    buffer[65536];
+    ssize_t n;
+    size_t  total = 0;
+    while ((n = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0)
+    {
+	total += n;
+    }
+    return total;
+}
+static void TestNetServer(void)
+{
+    const int          kCLIENTS = 20;
+    const int          kSLOW    = 1;
+    const int          kCOUNT   = 20000;
+    const size_t       kLIMIT   = 65536;
+    const int          kSMALL   = 4096;
+    vector<int>        ids;
+    int                fds[kCLIENTS+1];
+    char               msg[1000];
+    struct sockaddr_in a;
+    uint64_t           got = 0, expect;
+    size_t             taken = 0;
+
+    NetServer server(12321, NetCount, &ids, kCLIENTS, kLIMIT);
+    if (server.Error())
+    {
+	cout << "NetServer error " << server.Error() << endl;
+	return;
+    }
+    memset(&a, 0, sizeof(a));
+    a.sin_family = AF_INET;
+    a.sin_port   = htons(12321);
+    inet_pton(AF_INET, "127.0.0.1", &a.sin_addr);
+    for (int i=0; i<=kCLIENTS; i++)
+    {
+	fds[i] = socket(AF_INET, SOCK_STREAM, 0);
+	setsockopt(fds[i], SOL_SOCKET, SO_RCVBUF, &kSMALL, sizeof(kSMALL));
+	if (connect(fds[i], (struct sockaddr *) &a, sizeof(a)) < 0)
+	{
+	    perror("connect");
+	    return;
+	}
+	server.Poll(0.01);
+    }
+    while (server.Poll(0.05) > 0);
+    cout << "Clients " << server.Clients() << " rejected "
+	 << server.Rejected() << " expect 20 and 1" << endl;
+
+    memset(msg, 'x', sizeof(msg));
+    for (int k=0; k<kCOUNT; k++)
+    {
+	taken += server.Broadcast(msg, sizeof(msg));
+	server.Poll(0);
+	for (int i=0; i<kCLIENTS; i++)
+	{
+	    if (i != kSLOW) got += NetDrain(fds[i]);
+	}
+    }
+    for (int j=0; j<20; j++)
+    {
+	server.Poll(0.01);
+	for (int i=0; i<kCLIENTS; i++)
+	{
+	    if (i != kSLOW) got += NetDrain(fds[i]);
+	}
+    }
+    expect = (uint64_t) (kCLIENTS-1)*kCOUNT*sizeof(msg);
+    cout << "Readers got " << got << " of " << expect
+	 << ((got == expect) ? " ok" : " FAILED") << endl;
+    if ((int) ids.size() > kSLOW)
+    {
+	size_t   queued  = server.Queued(ids[kSLOW]);
+	uint64_t dropped = server.Dropped(ids[kSLOW]);
+	cout << "Slow client queued " << queued << " dropped " << dropped
+	     << (((queued <= kLIMIT) && (dropped > 0)) ? " ok" : " FAILED")
+	     << endl;
+    }
+    cout << "Broadcasts taken " << taken << endl;
+    for (int i=0; i<=kCLIENTS; i++)
+    {
+	close(fds[i]);
+    }
+
+    const int       kDEEP = 40000;
+    struct timespec t0, t1;
+    vector<int>     deep;
+    size_t          queued;
+    int             fd;
+
+    NetServer backlog(12322, NetCount, &deep, 1, 16<<20);
+    a.sin_port = htons(12322);
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (connect(fd, (struct sockaddr *) &a, sizeof(a)) < 0)
+    {
+	perror("connect");
+	return;
+    }
+    while (deep.empty() && (backlog.Poll(1.0) > 0));
+    if (deep.empty())
+    {
+	cout << "Backlog client not accepted" << endl;
+	close(fd);
+	return;
+    }
+    for (int k=0; k<kDEEP; k++)
+    {
+	backlog.Send(deep[0], msg, 256);
+    }
+    queued = backlog.Queued(deep[0]);
+    got    = 0;
+    expect = (uint64_t) kDEEP*256;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    do
+    {
+	backlog.Poll(0.001);
+	got += NetDrain(fd);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+    } while ((got < expect) && (t1.tv_sec - t0.tv_sec < 5));
+    cout << "Backlog of " << queued << " bytes, client got " << got
+	 << " of " << expect << " left " << backlog.Queued(deep[0])
+	 << (((queued > 64*256) && (got == expect) &&
+	      (backlog.Queued(deep[0]) == 0)) ? " ok" : " FAILED") << endl;
+    close(fd);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : TestSharedRing
+ *
+ * Description : Producer here, one consumer in a forked child that
+ *               stops for 2 ms every 1000 records, the producer for
+ *               1 ms, so the consumer falls behind a 1024 slot ring.
+ *               The consumer attaches before the first record, so 
+ *               the records it never saw, counted from the record 
+ *               numbers, must match its overrun count and the ring 
+ *               total, and with what it read make everything written.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+struct RingRecord {
+    uint64_t N;
+    uint32_t Last;
+    uint32_t Check;
+    double   Fill[12];
+};
+static void RingReader(int Ready, int Result)
+{
+    struct timespec pause = {0, 2000000L};
+    RingRecord      r;
+    uint64_t        out[4] = {0, 0, 0, 0};  // first, got, gaps, overruns
+    uint64_t        next = 0;
+    char            c = 1;
+
+    SharedRing ring("RegressionRing");
+    if (ring.Error())
+    {
+	_exit(1);
+    }
+    if (write(Ready, &c, 1) != 1)
+    {
+	_exit(1);
+    }
+    while (ring.Get(&r, NULL, 2.0))
+    {
+	if (out[1] == 0)
+	{
+	    out[0] = r.N;
+	}
+	else
+	{
+	    out[2] += r.N - next;
+	}
+	next = r.N + 1;
+	out[1]++;
+	if (r.Last)
+	{
+	    break;
+	}
+	if ((out[1] % 1000) == 0)
+	{
+	    nanosleep(&pause, NULL);
+	}
+    }
+    out[3] = ring.Overruns();
+    if (write(Result, out, sizeof(out)) != sizeof(out))
+    {
+	_exit(1);
+    }
+    _exit(0);
+}
+static void TestSharedRing(void)
+{
+    const uint64_t  kCOUNT = 200000;
+    struct timespec pause  = {0, 1000000L};
+    int             ready[2], result[2], status;
+    uint64_t        in[4];
+    RingRecord      r;
+    pid_t           pid;
+    char            c;
+
+    SharedRing ring("RegressionRing", 1024, sizeof(RingRecord), true);
+    if (ring.Error())
+    {
+	cout << "SharedRing error " << ring.Error() << endl;
+	return;
+    }
+    if ((pipe(ready) < 0) || (pipe(result) < 0))
+    {
+	perror("pipe");
+	return;
+    }
+    pid = fork();
+    if (pid == 0)
+    {
+	RingReader(ready[1], result[1]);
+    }
+    if ((pid < 0) || (read(ready[0], &c, 1) != 1))
+    {
+	cout << "Consumer did not start" << endl;
+	return;
+    }
+    memset(&r, 0, sizeof(r));
+    for (uint64_t i=0; i<kCOUNT; i++)
+    {
+	r.N    = i;
+	r.Last = (i == kCOUNT-1);
+	ring.Put(&r);
+	if ((i % 1000) == 999)
+	{
+	    nanosleep(&pause, NULL);
+	}
+    }
+    if ((read(result[0], in, sizeof(in)) != sizeof(in)))
+    {
+	cout << "No result from the consumer" << endl;
+	waitpid(pid, &status, 0);
+	return;
+    }
+    waitpid(pid, &status, 0);
+    cout << "Written " << ring.NWritten() << " read " << in[1]
+	 << " missed " << in[0] + in[2] << endl;
+    cout << "Consumer overruns " << in[3] << " ring total "
+	 << ring.TotalOverruns() << endl;
+    cout << "Accounting "
+	 << (((in[0] + in[2] == in[3]) && (in[3] == ring.TotalOverruns()) &&
+	      (in[1] + in[3] == ring.NWritten()) && (in[3] > 0))
+	     ? "ok" : "FAILED") << endl;
+    close(ready[0]);  close(ready[1]);
+    close(result[0]); close(result[1]);
+}
 static void TestGraph(void)
 {
     double x,y;
@@ -373,6 +1030,215 @@ static void TestGraph(void)
     cout << rtg;
     rtg.WriteJSON("sine.json");
 }
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Bench
+ *
+ * Description : Write NRows of simulated data with the given 
+ *               compression settings and report the write rate 
+ *               and compression ratio. 
+ *
+ * Inputs : Tags    - colon separated column names
+ *          NVar    - number of columns
+ *          IMU     - true for IMU like data, false for GPS like data
+ *          Level   - deflate level
+ *          Shuffle - shuffle filter
+ *          Digits  - scale-offset digits, -1 off
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+static void H5Bench(const char *Tags, size_t NVar, bool IMU, 
+		    unsigned int Level, bool Shuffle, int Digits)
+{
+    const char     *Filename = "H5Bench.h5";
+    const size_t   NRows     = 500000;
+    struct timespec start, stop;
+    struct stat    st;
+    double         *row = new double[NVar];
+    std::mt19937   gen(42);
+    std::normal_distribution<double> noise(0.0, 1.0);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    H5Logger *h5 = new H5Logger(Filename, "Bench", NVar, false);
+    h5->WriteDataTags(Tags);
+    h5->SetBuffering(1024);
+    h5->SetCompression(Level, Shuffle, Digits);
+    for (size_t i=0; i<NRows; i++)
+    {
+	double t = 1.7e9 + 0.01*i;
+	row[0] = t;
+	if (IMU)
+	{
+	    // Accelerations, rates and field, noisy around a bias. 
+	    for (size_t j=1; j<NVar; j++)
+	    {
+		row[j] = (j<4 ? 9.8*(j==3) : 0.01*j) + 0.02*noise(gen);
+	    }
+	}
+	else
+	{
+	    // Slowly moving position, speed, heading, counters. 
+	    row[1] = 41.0  + 1.0e-7*i;
+	    row[2] = -71.0 - 1.0e-7*i;
+	    row[3] = 12.0  + 0.5*sin(0.001*i);
+	    row[4] = 2.5   + 0.1*noise(gen);
+	    row[5] = 90.0  + noise(gen);
+	    for (size_t j=6; j<NVar; j++)
+	    {
+		row[j] = (double)((i/1000)%12 + j);
+	    }
+	}
+	h5->Fill(row);
+    }
+    delete h5;
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+
+    double dt  = (stop.tv_sec-start.tv_sec) + 1.0e-9*(stop.tv_nsec-start.tv_nsec);
+    double raw = (double)(NRows*NVar*sizeof(double));
+    stat(Filename, &st);
+    cout << (IMU ? "IMU" : "GPS")
+	 << " deflate: "  << Level
+	 << " shuffle: "  << Shuffle
+	 << " digits: "   << Digits
+	 << " rows/s: "   << NRows/dt
+	 << " MB/s: "     << raw/dt/1.0e6
+	 << " ratio: "    << raw/(double)st.st_size
+	 << endl;
+    unlink(Filename);
+    delete[] row;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : TestH5Compression
+ *
+ * Description : Throughput and compression ratio for GPS and IMU 
+ *               column sets over a range of filter settings. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+static void TestH5Compression(void)
+{
+    const char *GPS = "Time:Lat:Lon:Alt:Speed:Heading:NSV:Fix:HDOP:VDOP";
+    const char *IMU = "Time:AX:AY:AZ:GX:GY:GZ:MX:MY:MZ";
+
+    H5Bench(GPS, 10, false, 0, false, -1);
+    H5Bench(GPS, 10, false, 4, false, -1);
+    H5Bench(GPS, 10, false, 4, true,  -1);
+    H5Bench(GPS, 10, false, 4, true,   7);
+    H5Bench(IMU, 10, true,  0, false, -1);
+    H5Bench(IMU, 10, true,  4, true,  -1);
+    H5Bench(IMU, 10, true,  4, true,   4);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : TestH5Rollover
+ *
+ * Description : Log NRows as fast as the writer thread takes them
+ *               into 256kB files, asking for an extra rollover every
+ *               NRows/4 rows the way a kCHANGE_FILE_NAME command 
+ *               would. The file names are picked up from 
+ *               CurrentFile while the writer thread rolls over. 
+ *               Every file is read back, the rows must add up to 
+ *               NRows. Files go to DATAPATH and are removed. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+static void TestH5Rollover(void)
+{
+    const size_t NRows = 200000;
+    FileName namer("H5Test", "h5");
+    std::vector<std::string> files;
+    char   name[FILELEN];
+    double v[3];
+
+    H5Logger *pLog = new H5Logger(namer.GetUniqueName(), "Rollover test", 
+				  3, false, "Rollover");
+    pLog->WriteDataTags("Time:A:B");
+    pLog->SetBuffering(100);
+    pLog->SetTimeColumn(0);
+    pLog->SetRollover(&namer, 256*1024, One_Hour.tv_sec);
+    pLog->StartWriter(1000);
+
+    for (size_t i=0; i<NRows; i++)
+    {
+	v[0] = 1.7e9 + 0.1*i;
+	v[1] = sin(v[0]);
+	v[2] = cos(v[0]);
+	pLog->Fill(v);
+	if ((i > 0) && (i % (NRows/4) == 0))
+	{
+	    /*
+	     * Let the writer catch up first, or the file ends before
+	     * its name is seen here. 
+	     */
+	    pLog->Flush();
+	    pLog->Rollover();
+	}
+	pLog->CurrentFile(name, sizeof(name));
+	if (files.empty() || (files.back() != name))
+	{
+	    files.push_back(name);
+	}
+    }
+    pLog->Flush();
+    pLog->CurrentFile(name, sizeof(name));
+    if (files.back() != name)
+    {
+	files.push_back(name);
+    }
+    uint32_t NRollovers = pLog->NRollovers();
+    delete pLog;
+
+    size_t total = 0;
+    for (size_t i=0; i<files.size(); i++)
+    {
+	H5Logger *pRead = new H5Logger(files[i].c_str(), "Rollover test", 
+				       0, true);
+	total += pRead->NEntries();
+	delete pRead;
+	unlink(files[i].c_str());
+    }
+    cout << "Rollovers: " << NRollovers 
+	 << " files: "    << files.size()
+	 << " rows: "     << total << " of " << NRows
+	 << ((total == NRows) && (files.size() == NRollovers+1) ? 
+	     " PASS" : " FAIL")
+	 << endl;
+}
 /**
  ******************************************************************
  *
@@ -408,7 +1274,42 @@ int main(int argc, char **argv)
 	//TestH1D();
 	//TestTS();
 	//Testntp();
-	TestGraph();
+	if (TimeServers)
+	{
+	    TestMultiTS();
+	}
+	else if (Tracker)
+	{
+	    TestTracker();
+	}
+	else if (Stamps)
+	{
+	    TestFastClock();
+	}
+	else if (Tasks)
+	{
+	    TestScheduler();
+	}
+	else if (Net)
+	{
+	    TestNetServer();
+	}
+	else if (Ring)
+	{
+	    TestSharedRing();
+	}
+	else if (H5Compression)
+	{
+	    TestH5Compression();
+	}
+	else if (H5Rollover)
+	{
+	    TestH5Rollover();
+	}
+	else
+	{
+	    TestGraph();
+	}
     }
     Terminate(0);
 }
@@ -0,0 +1,681 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : main.cpp
+ *
+ * Author/Date : C.B. Lirakis / 17-Oct-26
+ *
+ * Description : Serial throughput and latency without hardware.
+ *
+ * A pseudo terminal pair stands in for the cable. A writer thread
+ * plays canned NMEA or TSIP messages into the master side, paced
+ * at the rate the baud would allow (10 bits per byte). The slave
+ * side is opened with SerialIO, raw or canonical, and read through
+ * an IOReactor the way a real program would. Every message is
+ * checked and timed from just before its write to the handler that
+ * completes it.
+ *
+ *     serialbench [-b baud] [-n messages] [-m r|c|b] [-s n|t|b]
+ *        -b  baud to emulate, 0 for as fast as the pty will go
+ *        -n  messages per run
+ *        -m  raw, canonical or both
+ *        -s  NMEA, TSIP or both
+ *
+ * Reported per run: bytes/s, latency mean, median, 99% and
+ * maximum, receive thread CPU per message and errors.
+ *
+ * Restrictions/Limitations : TSIP is binary, canonical mode would
+ * edit it, so it only runs raw. The pty ignores the baud, the
+ * pacing is done by the writer.
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ *******************************************************************
+ */
+// System includes.
+#include <iostream>
+using namespace std;
+#include <iomanip>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <termios.h>
+#include <time.h>
+#include <sys/resource.h>
+
+/// Local Includes.
+#include "debug.h"
+#include "SerialIO.h"
+#include "IOReactor.hh"
+
+static const unsigned char DLE = 0x10;
+static const unsigned char ETX = 0x03;
+
+static long         Baud      = 115200;
+static size_t       NMessages = 2000;
+static char         Modes     = 'b';
+static char         Streams   = 'b';
+
+/**
+ * One run: the canned messages, what the writer did and what the
+ * receiver found.
+ */
+struct Run {
+    bool                      TSIP;
+    vector<string>            Canned;    // on the wire
+    vector<string>            Payload;   // TSIP unstuffed id + data
+    int                       Master;
+    size_t                    NSend;
+    uint64_t                 *SendTime;  // monotonic ns, just before write
+    /* Receiver. */
+    size_t                    NGot;
+    size_t                    NBad;
+    string                    Partial;
+    bool                      InPacket;
+    bool                      SawDLE;
+    vector<double>            Latency;
+    double                    LastTime;
+};
+
+/**
+ ******************************************************************
+ *
+ * Function Name : Help
+ *
+ * Description : provides user with help if needed.
+ *
+ * Inputs : none
+ *
+ * Returns : none
+ *
+ * Error Conditions : none
+ *
+ *******************************************************************
+ */
+static void Help(void)
+{
+    SET_DEBUG_STACK;
+    cout << "********************************************" << endl;
+    cout << "* Serial benchmark over a pty pair.        *" << endl;
+    cout << "* Built on "<< __DATE__ << " " << __TIME__ << "*" << endl;
+    cout << "* serialbench [options]                    *" << endl;
+    cout << "* Available options are :                  *" << endl;
+    cout << "*     -b baud, 0 unthrottled (115200)      *" << endl;
+    cout << "*     -n messages per run (2000)           *" << endl;
+    cout << "*     -m r raw, c canonical, b both        *" << endl;
+    cout << "*     -s n NMEA, t TSIP, b both            *" << endl;
+    cout << "*                                          *" << endl;
+    cout << "********************************************" << endl;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name :  ProcessCommandLineArgs
+ *
+ * Description : Loop over all command line arguments
+ *               and parse them into useful data.
+ *
+ * Inputs : command line arguments.
+ *
+ * Returns : none
+ *
+ * Error Conditions : none
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+static void ProcessCommandLineArgs(int argc, char **argv)
+{
+    int option;
+    SET_DEBUG_STACK;
+    do
+    {
+        option = getopt( argc, argv, "b:hHm:n:s:");
+        switch(option)
+        {
+	case 'b':
+	    Baud = atol(optarg);
+	    break;
+        case 'h':
+        case 'H':
+            Help();
+	    exit(0);
+	    break;
+	case 'm':
+	    Modes = optarg[0];
+	    break;
+	case 'n':
+	    NMessages = atol(optarg);
+	    break;
+	case 's':
+	    Streams = optarg[0];
+	    break;
+        }
+    } while(option != -1);
+}
+static double Now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + 1.0e-9*t.tv_nsec;
+}
+static uint64_t NowNS(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec*1000000000ULL + t.tv_nsec;
+}
+static double CPUTime(void)
+{
+    struct rusage ru;
+    getrusage(RUSAGE_THREAD, &ru);
+    return ru.ru_utime.tv_sec + 1.0e-6*ru.ru_utime.tv_usec +
+	ru.ru_stime.tv_sec + 1.0e-6*ru.ru_stime.tv_usec;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : NMEAChecksum
+ *
+ * Description : XOR of everything between $ and *.
+ *
+ * Inputs : Body - sentence without $ and *
+ *
+ * Returns : checksum
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+static unsigned NMEAChecksum(const char *Body, size_t n)
+{
+    unsigned char sum = 0;
+    for (size_t i=0; i<n; i++)
+    {
+	sum ^= (unsigned char) Body[i];
+    }
+    return sum;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : BuildNMEA
+ *
+ * Description : A one second GPS epoch, GGA RMC GSA VTG.
+ *
+ * Inputs : R - run to fill
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+static void BuildNMEA(Run &R)
+{
+    const char *Body[] = {
+	"GPGGA,123519.00,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,",
+	"GPRMC,123519.00,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W",
+	"GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1",
+	"GPVTG,054.7,T,034.4,M,005.5,N,010.2,K"};
+    char line[128];
+    for (size_t i=0; i<sizeof(Body)/sizeof(Body[0]); i++)
+    {
+	snprintf(line, sizeof(line), "$%s*%02X\r\n", Body[i],
+		 NMEAChecksum(Body[i], strlen(Body[i])));
+	R.Canned.push_back(line);
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : TSIPPacket
+ *
+ * Description : Frame id + big endian values as DLE id data DLE ETX
+ *               with DLE stuffing.
+ *
+ * Inputs : R     - run to add to
+ *          ID    - packet id
+ *          Value - values
+ *          N     - number of values
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+template<typename T>
+static void TSIPPacket(Run &R, unsigned char ID, const T *Value, size_t N)
+{
+    string payload(1, (char) ID);
+    for (size_t i=0; i<N; i++)
+    {
+	unsigned char b[sizeof(T)];
+	memcpy(b, &Value[i], sizeof(T));
+	for (size_t j=0; j<sizeof(T); j++)
+	{
+	    payload += (char) b[sizeof(T)-1-j];
+	}
+    }
+    string wire(1, (char) DLE);
+    for (size_t i=0; i<payload.size(); i++)
+    {
+	wire += payload[i];
+	if ((unsigned char) payload[i] == DLE)
+	{
+	    wire += (char) DLE;
+	}
+    }
+    wire += (char) DLE;
+    wire += (char) ETX;
+    R.Payload.push_back(payload);
+    R.Canned.push_back(wire);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : BuildTSIP
+ *
+ * Description : Position, velocity and double position reports.
+ *               The clock bias is chosen to need DLE stuffing.
+ *
+ * Inputs : R - run to fill
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+static void BuildTSIP(Run &R)
+{
+    uint32_t bias = 0x10101010;
+    float    pos[5] = {0.7250f, -1.2392f, 45.5f, 0.0f, 388800.0f};
+    float    vel[5] = {0.12f, -0.05f, 0.01f, 2.5e-3f, 388800.0f};
+    double   dpos[4] = {0.72500123, -1.23920456, 45.5, 0.0};
+    memcpy(&pos[3], &bias, sizeof(bias));
+    TSIPPacket(R, 0x4A, pos, 5);
+    TSIPPacket(R, 0x56, vel, 5);
+    TSIPPacket(R, 0x84, dpos, 4);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Writer
+ *
+ * Description : Thread, play the canned messages in order into the
+ *               master, each one written when the baud would have
+ *               finished sending it.
+ *
+ * Inputs : arg - Run
+ *
+ * Returns : NULL
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+static void *Writer(void *arg)
+{
+    Run   *R     = (Run *) arg;
+    double rate  = Baud/10.0;
+    double bytes = 0.0;
+    struct timespec start, due;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t i=0; i<R->NSend; i++)
+    {
+	const string &m = R->Canned[i % R->Canned.size()];
+	bytes += m.size();
+	if (Baud > 0)
+	{
+	    double t = start.tv_sec + 1.0e-9*start.tv_nsec + bytes/rate;
+	    due.tv_sec  = (time_t) t;
+	    due.tv_nsec = (long) ((t - due.tv_sec)*1.0e9);
+	    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL);
+	}
+	__atomic_store_n(&R->SendTime[i], NowNS(), __ATOMIC_RELEASE);
+	if (write(R->Master, m.data(), m.size()) != (ssize_t) m.size())
+	{
+	    break;
+	}
+    }
+    return NULL;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Complete
+ *
+ * Description : A message has been framed, check it and time it.
+ *
+ * Inputs : R    - run
+ *          Text - the message, NMEA line or TSIP payload
+ *          When - monotonic time now
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+static void Complete(Run &R, const string &Text, double When)
+{
+    size_t k = R.NGot % R.Canned.size();
+    bool   ok;
+
+    if (R.NGot >= R.NSend)
+    {
+	R.NBad++;
+	return;
+    }
+    if (R.TSIP)
+    {
+	ok = (Text == R.Payload[k]);
+    }
+    else
+    {
+	/* Canonical mode hands over the \r\n, raw does too. */
+	size_t star = Text.find('*');
+	ok = (Text == R.Canned[k]) && (star != string::npos) &&
+	    (strtoul(Text.c_str()+star+1, NULL, 16) ==
+	     NMEAChecksum(Text.c_str()+1, star-1));
+    }
+    if (!ok)
+    {
+	R.NBad++;
+    }
+    R.Latency.push_back(When - 1.0e-9*
+	__atomic_load_n(&R.SendTime[R.NGot], __ATOMIC_ACQUIRE));
+    R.LastTime = When;
+    R.NGot++;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Handler
+ *
+ * Description : IOReactor callback, frame messages out of the ring.
+ *               NMEA ends at \n. TSIP starts at DLE id and ends at
+ *               an unstuffed DLE ETX.
+ *
+ * Inputs : per IOHandler
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+static void Handler(IOReactor *Reactor, int Handle, Buffered *Data,
+		    const IOStamp &Stamp, void *Arg)
+{
+    Run   &R    = *(Run *) Arg;
+    double when = Now();
+    unsigned char c;
+
+    while (Data->Remaining() > 0)
+    {
+	c = Data->GetChar();
+	if (!R.TSIP)
+	{
+	    R.Partial += (char) c;
+	    if (c == '\n')
+	    {
+		Complete(R, R.Partial, when);
+		R.Partial.clear();
+	    }
+	}
+	else if (!R.InPacket)
+	{
+	    /* Hunt for DLE followed by an id. */
+	    if (R.SawDLE && (c != DLE) && (c != ETX))
+	    {
+		R.InPacket = true;
+		R.Partial.assign(1, (char) c);
+		R.SawDLE   = false;
+	    }
+	    else
+	    {
+		R.SawDLE = (c == DLE) && !R.SawDLE;
+	    }
+	}
+	else if (R.SawDLE)
+	{
+	    R.SawDLE = false;
+	    if (c == ETX)
+	    {
+		Complete(R, R.Partial, when);
+		R.InPacket = false;
+	    }
+	    else if (c == DLE)
+	    {
+		R.Partial += (char) DLE;
+	    }
+	    else
+	    {
+		/* Lost sync, this DLE starts a new packet. */
+		R.NBad++;
+		R.Partial.assign(1, (char) c);
+	    }
+	}
+	else if (c == DLE)
+	{
+	    R.SawDLE = true;
+	}
+	else
+	{
+	    R.Partial += (char) c;
+	}
+    }
+    if (R.NGot >= R.NSend)
+    {
+	Reactor->Stop();
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Bench
+ *
+ * Description : One run, print one line of results.
+ *
+ * Inputs : Canonical - open the slave canonical, else raw
+ *          TSIP      - TSIP stream, else NMEA
+ *
+ * Returns : true if every message arrived intact
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+static bool Bench(bool Canonical, bool TSIP)
+{
+    SET_DEBUG_STACK;
+    Run            R;
+    struct termios t;
+    pthread_t      writer;
+    double         start, cpu;
+    size_t         bytes = 0;
+
+    R.TSIP     = TSIP;
+    R.NSend    = NMessages;
+    R.NGot     = 0;
+    R.NBad     = 0;
+    R.InPacket = false;
+    R.SawDLE   = false;
+    R.LastTime = 0.0;
+    R.SendTime = new uint64_t[NMessages];
+    memset(R.SendTime, 0, NMessages*sizeof(uint64_t));
+    if (TSIP)
+    {
+	BuildTSIP(R);
+    }
+    else
+    {
+	BuildNMEA(R);
+    }
+    for (size_t i=0; i<NMessages; i++)
+    {
+	bytes += R.Canned[i % R.Canned.size()].size();
+    }
+
+    R.Master = posix_openpt(O_RDWR | O_NOCTTY);
+    if ((R.Master < 0) || (grantpt(R.Master) < 0) || (unlockpt(R.Master) < 0))
+    {
+	cerr << "serialbench: no pty" << endl;
+	return false;
+    }
+    tcgetattr(R.Master, &t);
+    cfmakeraw(&t);
+    tcsetattr(R.Master, TCSANOW, &t);
+
+    SerialIO *port = Canonical ?
+	new SerialIO(ptsname(R.Master), B115200, SerialIO::NONE,
+		     SerialIO::ModeCanonical, '\n') :
+	new SerialIO(ptsname(R.Master), B115200, SerialIO::NONE,
+		     SerialIO::ModeRaw, 1, 0);
+    IOReactor reactor;
+    if ((port->Error() != CObject::ENONE) ||
+	(reactor.Add(port, Handler, &R) < 0))
+    {
+	cerr << "serialbench: can't open " << ptsname(R.Master) << endl;
+	delete port;
+	close(R.Master);
+	return false;
+    }
+
+    cpu   = CPUTime();
+    start = Now();
+    pthread_create(&writer, NULL, Writer, &R);
+    while (R.NGot < R.NSend)
+    {
+	size_t before = R.NGot;
+	if ((reactor.Poll(2.0) <= 0) && (R.NGot == before))
+	{
+	    break;   // 2 s with nothing, the rest are lost
+	}
+    }
+    cpu = CPUTime() - cpu;
+    pthread_join(writer, NULL);
+
+    double elapsed = R.LastTime - start;
+    vector<double> &L = R.Latency;
+    sort(L.begin(), L.end());
+    double mean = 0.0;
+    for (size_t i=0; i<L.size(); i++)
+    {
+	mean += L[i];
+    }
+    if (!L.empty())
+    {
+	mean /= L.size();
+    }
+    size_t lost = R.NSend - R.NGot;
+    cout << setw(9)  << (Canonical ? "canonical" : "raw")
+	 << setw(6)  << (TSIP ? "TSIP" : "NMEA")
+	 << setw(8)  << Baud
+	 << setw(7)  << R.NGot
+	 << setw(11) << fixed << setprecision(0)
+	 << ((elapsed > 0.0) ? bytes/elapsed : 0.0)
+	 << setprecision(1)
+	 << setw(9)  << 1.0e6*mean
+	 << setw(9)  << (L.empty() ? 0.0 : 1.0e6*L[L.size()/2])
+	 << setw(9)  << (L.empty() ? 0.0 : 1.0e6*L[(L.size()*99)/100])
+	 << setw(9)  << (L.empty() ? 0.0 : 1.0e6*L.back())
+	 << setprecision(2)
+	 << setw(9)  << (R.NGot ? 1.0e6*cpu/R.NGot : 0.0)
+	 << setw(6)  << R.NBad + lost
+	 << endl;
+
+    delete port;
+    close(R.Master);
+    delete [] R.SendTime;
+    return (R.NBad == 0) && (lost == 0);
+}
+int main(int argc, char **argv)
+{
+    bool ok = true;
+    ProcessCommandLineArgs(argc, argv);
+
+    cout << "     mode stream    baud   msgs    bytes/s"
+	 << "  mean us   p50 us   p99 us   max us  cpu/msg errors" << endl;
+    for (int m=0; m<2; m++)
+    {
+	bool canonical = (m == 1);
+	if ((Modes != 'b') && (Modes != (canonical ? 'c' : 'r')))
+	{
+	    continue;
+	}
+	for (int s=0; s<2; s++)
+	{
+	    bool tsip = (s == 1);
+	    if ((Streams != 'b') && (Streams != (tsip ? 't' : 'n')))
+	    {
+		continue;
+	    }
+	    if (canonical && tsip)
+	    {
+		// Binary through the line discipline, not meaningful.
+		continue;
+	    }
+	    ok = Bench(canonical, tsip) && ok;
+	}
+    }
+    return ok ? 0 : 1;
+}
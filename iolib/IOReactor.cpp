@@ -0,0 +1,587 @@
+/********************************************************************
+ *
+ * Module Name : IOReactor.cpp
+ *
+ * Author/Date : C.B. Lirakis / 17-Oct-26
+ *
+ * Description : epoll loop over serial ports and sockets.
+ *
+ * The set is level triggered and each ready port gets one read per
+ * wakeup, so a busy port can't starve the others. If that read used
+ * all the free space in the ring the kernel queue is checked with
+ * FIONREAD for the backlog, otherwise the read emptied it.
+ *
+ * Restrictions/Limitations : Linux only.
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References : epoll(7)
+ *
+ ********************************************************************/
+// System includes.
+#include <iostream>
+using namespace std;
+#include <cstring>
+#include <cmath>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+
+// Local Includes.
+#include "debug.h"
+#include "CLogger.hh"
+#include "SerialIO.h"
+#include "IOReactor.hh"
+
+/* epoll data for the Stop eventfd, handles are small. */
+static const uint64_t kWAKE     = ~(uint64_t)0;
+/* Ready descriptors taken per epoll_wait. */
+static const int      kMAX_EVENTS = 32;
+
+/********************************************************************
+ *
+ * Function Name : IOReactor Constructor
+ *
+ * Description : Make the epoll set and the Stop eventfd.
+ *
+ * Inputs : BufferSize - ring size for each port
+ *
+ * Returns : constructed class
+ *
+ * Error Conditions : NO_EPOLL
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+IOReactor::IOReactor(unsigned short BufferSize) : CObject()
+{
+    SET_DEBUG_STACK;
+    struct epoll_event ev;
+
+    SetName("IOReactor");
+    ClearError(__LINE__);
+    fBufferSize = BufferSize;
+    fRun        = false;
+    fEpoll      = epoll_create1(EPOLL_CLOEXEC);
+    fWake       = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if ((fEpoll < 0) || (fWake < 0))
+    {
+	SetError(NO_EPOLL, __LINE__);
+	return;
+    }
+    memset(&ev, 0, sizeof(ev));
+    ev.events   = EPOLLIN;
+    ev.data.u64 = kWAKE;
+    if (epoll_ctl(fEpoll, EPOLL_CTL_ADD, fWake, &ev) < 0)
+    {
+	SetError(NO_EPOLL, __LINE__);
+    }
+}
+/********************************************************************
+ *
+ * Function Name : IOReactor Destructor
+ *
+ * Description : Free the rings and close the epoll set. The port
+ *               descriptors belong to the caller.
+ *
+ * Inputs : None
+ *
+ * Returns : None
+ *
+ * Error Conditions : None
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+IOReactor::~IOReactor(void)
+{
+    SET_DEBUG_STACK;
+    for (size_t i=0; i<fPorts.size(); i++)
+    {
+	if (fPorts[i])
+	{
+	    delete fPorts[i]->Data;
+	    delete fPorts[i];
+	}
+    }
+    fPorts.clear();
+    if (fWake >= 0)
+    {
+	close(fWake);
+    }
+    if (fEpoll >= 0)
+    {
+	close(fEpoll);
+    }
+}
+/********************************************************************
+ *
+ * Function Name : Add
+ *
+ * Description : Register an open SerialIO port.
+ *
+ * Inputs : Port    - open port
+ *          Handler - called with each batch
+ *          Arg     - passed to Handler
+ *
+ * Returns : handle, -1 on error
+ *
+ * Error Conditions : BAD_FD if the port isn't open
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+int IOReactor::Add(SerialIO *Port, IOHandler Handler, void *Arg)
+{
+    SET_DEBUG_STACK;
+    if ((Port == NULL) || (Port->Error() != ENONE))
+    {
+	SetError(BAD_FD, __LINE__);
+	return -1;
+    }
+    return Add(Port->GetFD(), Handler, Arg, false);
+}
+/********************************************************************
+ *
+ * Function Name : Add
+ *
+ * Description : Register a descriptor. It is made non-blocking so
+ *               the single read per wakeup can't stall the loop.
+ *
+ * Inputs : fd      - open for read
+ *          Handler - called with each batch
+ *          Arg     - passed to Handler
+ *          Socket  - use recvmsg and kernel time stamps
+ *
+ * Returns : handle, -1 on error
+ *
+ * Error Conditions : BAD_FD
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+int IOReactor::Add(int fd, IOHandler Handler, void *Arg, bool Socket)
+{
+    SET_DEBUG_STACK;
+    struct epoll_event ev;
+    int    flags;
+    int    on = 1;
+    int    type;
+    socklen_t len = sizeof(type);
+    Port  *p;
+
+    ClearError(__LINE__);
+    if ((fd < 0) || (Handler == NULL) || (fEpoll < 0) ||
+	((flags = fcntl(fd, F_GETFL)) < 0) ||
+	(fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0))
+    {
+	SetError(BAD_FD, __LINE__);
+	return -1;
+    }
+    if (Socket)
+    {
+	/* Not fatal, the wakeup time is used without it. */
+	setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on));
+    }
+
+    p = new Port;
+    memset(p, 0, sizeof(Port));
+    p->FD      = fd;
+    p->Socket  = Socket;
+    p->Datagram = (getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &len) == 0) &&
+	((type == SOCK_DGRAM) || (type == SOCK_RAW));
+    p->Handler = Handler;
+    p->Arg     = Arg;
+    p->Data    = new Buffered(fBufferSize);
+    p->Data->Reset();
+
+    fPorts.push_back(p);
+    p->Handle   = fPorts.size()-1;
+    memset(&ev, 0, sizeof(ev));
+    ev.events   = EPOLLIN;
+    ev.data.u64 = fPorts.size()-1;
+    if (epoll_ctl(fEpoll, EPOLL_CTL_ADD, fd, &ev) < 0)
+    {
+	fPorts.back() = NULL;
+	delete p->Data;
+	delete p;
+	SetError(BAD_FD, __LINE__);
+	return -1;
+    }
+    return fPorts.size()-1;
+}
+/********************************************************************
+ *
+ * Function Name : Remove
+ *
+ * Description : Stop watching a handle, the handle is not reused.
+ *
+ * Inputs : Handle - from Add
+ *
+ * Returns : true if it was registered
+ *
+ * Error Conditions : BAD_HANDLE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool IOReactor::Remove(int Handle)
+{
+    SET_DEBUG_STACK;
+    Port *p = Find(Handle);
+
+    if (p == NULL)
+    {
+	SetError(BAD_HANDLE, __LINE__);
+	return false;
+    }
+    if (!p->Closed)
+    {
+	epoll_ctl(fEpoll, EPOLL_CTL_DEL, p->FD, NULL);
+    }
+    fPorts[Handle] = NULL;
+    delete p->Data;
+    delete p;
+    return true;
+}
+/********************************************************************
+ *
+ * Function Name : Poll
+ *
+ * Description : Wait for input and service every ready port. The
+ *               clocks are read once per wakeup, before any read.
+ *
+ * Inputs : Timeout - seconds, negative to wait forever
+ *
+ * Returns : number of handler calls, -1 on error
+ *
+ * Error Conditions : WAIT_FAILED
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+int IOReactor::Poll(double Timeout)
+{
+    SET_DEBUG_STACK;
+    struct epoll_event ev[kMAX_EVENTS];
+    IOStamp wakeup;
+    int     n, calls = 0;
+    int     ms = (Timeout < 0.0) ? -1 : (int) ceil(Timeout*1000.0);
+
+    n = epoll_wait(fEpoll, ev, kMAX_EVENTS, ms);
+    if (n < 0)
+    {
+	if (errno == EINTR)
+	{
+	    return 0;
+	}
+	SetError(WAIT_FAILED, __LINE__);
+	return -1;
+    }
+    if (n == 0)
+    {
+	return 0;
+    }
+    clock_gettime(CLOCK_REALTIME,  &wakeup.Realtime);
+    clock_gettime(CLOCK_MONOTONIC, &wakeup.Monotonic);
+    wakeup.Kernel = false;
+
+    for (int i=0; i<n; i++)
+    {
+	if (ev[i].data.u64 == kWAKE)
+	{
+	    uint64_t count;
+	    if (read(fWake, &count, sizeof(count)) < 0)
+	    {
+		/* Already drained. */
+	    }
+	    continue;
+	}
+	Port *p = Find((int) ev[i].data.u64);
+	if ((p != NULL) && !p->Closed && Service(p, wakeup))
+	{
+	    calls++;
+	}
+    }
+    return calls;
+}
+/********************************************************************
+ *
+ * Function Name : Run
+ *
+ * Description : Poll until Stop is called.
+ *
+ * Inputs : None
+ *
+ * Returns : None
+ *
+ * Error Conditions : returns on WAIT_FAILED
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void IOReactor::Run(void)
+{
+    SET_DEBUG_STACK;
+    fRun = true;
+    while (fRun)
+    {
+	if (Poll(-1.0) < 0)
+	{
+	    break;
+	}
+    }
+}
+/********************************************************************
+ *
+ * Function Name : Stop
+ *
+ * Description : Clear the run flag and wake epoll_wait. Only a
+ *               write(2), so safe in a signal handler.
+ *
+ * Inputs : None
+ *
+ * Returns : None
+ *
+ * Error Conditions : None
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void IOReactor::Stop(void)
+{
+    uint64_t one = 1;
+    fRun = false;
+    if (write(fWake, &one, sizeof(one)) < 0)
+    {
+	/* Counter full, a wakeup is pending anyway. */
+    }
+}
+/********************************************************************
+ *
+ * Function Name : Fill
+ *
+ * Description : One read into the free space of the ring. Sockets
+ *               use recvmsg to pick up the kernel time stamp.
+ *
+ * Inputs : P       - port
+ *          Offered - returned, bytes of free space offered
+ *
+ * Returns : bytes read, 0 at end of file, -1 with errno set
+ *
+ * Error Conditions : None
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+ssize_t IOReactor::Fill(Port *P, size_t &Offered)
+{
+    struct iovec seg[2];
+    int          nseg = P->Data->WriteSegments(seg);
+    ssize_t      rc;
+
+    Offered = 0;
+    for (int i=0; i<nseg; i++)
+    {
+	Offered += seg[i].iov_len;
+    }
+    if (!P->Socket)
+    {
+	rc = readv(P->FD, seg, nseg);
+    }
+    else
+    {
+	struct msghdr   msg;
+	struct cmsghdr *cm;
+	char   control[CMSG_SPACE(sizeof(struct timespec))];
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov        = seg;
+	msg.msg_iovlen     = nseg;
+	msg.msg_control    = control;
+	msg.msg_controllen = sizeof(control);
+	rc = recvmsg(P->FD, &msg, 0);
+	for (cm = CMSG_FIRSTHDR(&msg); (rc > 0) && cm;
+	     cm = CMSG_NXTHDR(&msg, cm))
+	{
+	    if ((cm->cmsg_level == SOL_SOCKET) &&
+		(cm->cmsg_type  == SCM_TIMESTAMPNS))
+	    {
+		memcpy(&P->Stamp.Realtime, CMSG_DATA(cm),
+		       sizeof(struct timespec));
+		P->Stamp.Kernel = true;
+	    }
+	}
+    }
+    if (rc > 0)
+    {
+	P->Data->Commit(rc);
+    }
+    return rc;
+}
+/********************************************************************
+ *
+ * Function Name : Service
+ *
+ * Description : Read once, update the statistics and call the
+ *               handler. A ring left full by its handler is emptied
+ *               rather than letting a level triggered port spin.
+ *               A read of 0 closes a stream, pty or serial port, 
+ *               on a datagram socket it is an empty datagram. 
+ *
+ * Inputs : P      - ready port
+ *          Wakeup - clocks at the return of epoll_wait
+ *
+ * Returns : true if the handler was called
+ *
+ * Error Conditions : None
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool IOReactor::Service(Port *P, const IOStamp &Wakeup)
+{
+    SET_DEBUG_STACK;
+    size_t  offered;
+    ssize_t rc;
+    int     queued;
+
+    if (P->Data->IsFull())
+    {
+	CLogger *pLogger = CLogger::GetThis();
+	if (pLogger && (P->NOverflows == 0))
+	{
+	    pLogger->LogError(__FILE__, __LINE__, 'W',
+			      "IOReactor - ring full, discarding.");
+	}
+	P->NOverflows++;
+	P->Data->Reset();
+    }
+
+    P->Stamp = Wakeup;
+    rc = Fill(P, offered);
+    if ((rc < 0) && ((errno == EAGAIN) || (errno == EINTR)))
+    {
+	/* Spurious, someone else read it. */
+	return false;
+    }
+    if ((rc == 0) && P->Datagram)
+    {
+	/* Empty datagram, nothing for the handler. */
+	return false;
+    }
+    if (rc <= 0)
+    {
+	/* End of file, or a pty/serial hang up (EIO). */
+	epoll_ctl(fEpoll, EPOLL_CTL_DEL, P->FD, NULL);
+	P->Closed        = true;
+	P->KernelBacklog = 0;
+	P->Handler(this, P->Handle, P->Data, P->Stamp, P->Arg);
+	return true;
+    }
+
+    P->NBytes += rc;
+    P->NBatches++;
+    P->KernelBacklog = 0;
+    if (((size_t) rc == offered) && (ioctl(P->FD, FIONREAD, &queued) == 0))
+    {
+	P->KernelBacklog = queued;
+    }
+    P->Handler(this, P->Handle, P->Data, P->Stamp, P->Arg);
+    return true;
+}
+/********************************************************************
+ *
+ * Function Name : Backlog, Bytes, Batches, Overflows, LastStamp, Closed
+ *
+ * Description : Per port statistics.
+ *
+ * Inputs : Handle - from Add
+ *
+ * Returns : as named, 0 or NULL for an unknown handle
+ *
+ * Error Conditions : None
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+size_t IOReactor::Backlog(int Handle) const
+{
+    Port *p = Find(Handle);
+    return p ? p->KernelBacklog + p->Data->Remaining() : 0;
+}
+uint64_t IOReactor::Bytes(int Handle) const
+{
+    Port *p = Find(Handle);
+    return p ? p->NBytes : 0;
+}
+uint64_t IOReactor::Batches(int Handle) const
+{
+    Port *p = Find(Handle);
+    return p ? p->NBatches : 0;
+}
+uint64_t IOReactor::Overflows(int Handle) const
+{
+    Port *p = Find(Handle);
+    return p ? p->NOverflows : 0;
+}
+const IOStamp *IOReactor::LastStamp(int Handle) const
+{
+    Port *p = Find(Handle);
+    return p ? &p->Stamp : NULL;
+}
+bool IOReactor::Closed(int Handle) const
+{
+    Port *p = Find(Handle);
+    return p ? p->Closed : true;
+}
@@ -0,0 +1,151 @@
+/********************************************************************
+ *
+ * Module Name : IOReactor.hh
+ *
+ * Author/Date : C.B. Lirakis / 17-Oct-26
+ *
+ * Description : One epoll loop servicing several serial ports and
+ * sockets, so one thread can run the GPS, IMU and instruments
+ * without a sleep in a polling loop deciding the latency.
+ *
+ * Each registered descriptor gets a Buffered ring. When it is
+ * readable the reactor reads straight into the free space of the
+ * ring (one readv, no copy) and calls the handler for that port with
+ * the ring and a time stamp. The handler takes what it can use and
+ * leaves a partial message in the ring for next time.
+ *
+ * The stamp is CLOCK_REALTIME and CLOCK_MONOTONIC taken once when
+ * epoll_wait returns, i.e. close to the arrival of the first byte of
+ * the batch. For sockets added with Socket true, SO_TIMESTAMPNS is
+ * turned on and Realtime is the kernel receive time instead.
+ *
+ * Restrictions/Limitations : Add, Remove and Poll from one thread,
+ * Stop from anywhere. Registered descriptors are made non-blocking.
+ *
+ * Change Descriptions :
+ * 17-Oct-26 CBL An empty datagram is not end of file. 
+ *
+ * Classification : Unclassified
+ *
+ * References : epoll(7), socket(7) SO_TIMESTAMPNS
+ *
+ ********************************************************************/
+#ifndef __IOREACTOR_hh_
+#define __IOREACTOR_hh_
+#include <stdint.h>
+#include <time.h>
+#include <vector>
+#include "CObject.hh"
+#include "Buffered.hh"
+
+class SerialIO;
+class IOReactor;
+
+/**
+ * When a batch of bytes arrived.
+ */
+struct IOStamp {
+    struct timespec Realtime;   // wakeup, or kernel receive time
+    struct timespec Monotonic;  // wakeup
+    bool            Kernel;     // Realtime came from the kernel
+};
+
+/**
+ * Called with the port's ring after each read. Handle is what Add
+ * returned. Also called once, with Closed(Handle) true, when the
+ * far end goes away.
+ */
+typedef void (*IOHandler)(IOReactor *Reactor, int Handle, Buffered *Data,
+			  const IOStamp &Stamp, void *Arg);
+
+class IOReactor : public CObject
+{
+public:
+    /**
+     * BufferSize is the ring size given to each port.
+     */
+    IOReactor(unsigned short BufferSize = 4096);
+    /**
+     * Closes the epoll set, not the registered descriptors.
+     */
+    ~IOReactor(void);
+
+    /**
+     * Register a port. Returns a handle, -1 on error.
+     */
+    int  Add(SerialIO *Port, IOHandler Handler, void *Arg = NULL);
+    /**
+     * Register any readable descriptor. Socket true uses recvmsg and
+     * kernel receive time stamps.
+     */
+    int  Add(int fd, IOHandler Handler, void *Arg = NULL, bool Socket = false);
+    /**
+     * Stop watching a handle. The descriptor is left open.
+     */
+    bool Remove(int Handle);
+
+    /**
+     * Wait up to Timeout seconds (negative forever) and service
+     * whatever is ready. Returns the number of handler calls, -1 on
+     * error.
+     */
+    int  Poll(double Timeout);
+    /**
+     * Poll until Stop.
+     */
+    void Run(void);
+    /**
+     * Make Run return. Safe from another thread or a signal handler.
+     */
+    void Stop(void);
+
+    /**
+     * Bytes waiting for this port: still in the kernel at the last
+     * read plus not yet taken from the ring.
+     */
+    size_t   Backlog(int Handle) const;
+    /*! Bytes read on this port. */
+    uint64_t Bytes(int Handle) const;
+    /*! Reads (handler calls) on this port. */
+    uint64_t Batches(int Handle) const;
+    /*! Times the ring was full and had to be emptied. */
+    uint64_t Overflows(int Handle) const;
+    /*! Stamp of the last batch. */
+    const IOStamp *LastStamp(int Handle) const;
+    /*! The far end closed or the read failed. */
+    bool     Closed(int Handle) const;
+
+    enum IOREACTOR_ERRORS {NO_EPOLL=1, BAD_FD, BAD_HANDLE, WAIT_FAILED};
+
+private:
+    struct Port {
+	int       Handle;
+	int       FD;
+	bool      Socket;
+	bool      Datagram;   // SOCK_DGRAM or SOCK_RAW, a 0 read is data
+	bool      Closed;
+	IOHandler Handler;
+	void     *Arg;
+	Buffered *Data;
+	IOStamp   Stamp;
+	size_t    KernelBacklog;
+	uint64_t  NBytes;
+	uint64_t  NBatches;
+	uint64_t  NOverflows;
+    };
+
+    /*! Read what is ready on one port and call its handler. */
+    bool Service(Port *P, const IOStamp &Wakeup);
+    /*! One read, recvmsg for sockets. Returns bytes, 0 EOF, -1. */
+    ssize_t Fill(Port *P, size_t &Offered);
+    inline Port *Find(int Handle) const {
+	return ((Handle>=0) && (Handle<(int)fPorts.size())) ?
+	    fPorts[Handle] : NULL;};
+
+    std::vector<Port *> fPorts;   // index is the handle
+    unsigned short      fBufferSize;
+    int                 fEpoll;
+    int                 fWake;    // eventfd for Stop
+    volatile bool       fRun;
+};
+#endif
@@ -0,0 +1,499 @@
+/********************************************************************
+ *
+ * Module Name : NavCast.cpp
+ *
+ * Author/Date : C.B. Lirakis / 17-Oct-26
+ *
+ * Description : UDP multicast publisher and subscriber for
+ * navigation fix records.
+ *
+ * Restrictions/Limitations : IPv4 only.
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References : ip(7), socket(7) SO_TIMESTAMPNS
+ *
+ ********************************************************************/
+// System includes.
+#include <iostream>
+using namespace std;
+#include <cstring>
+#include <cmath>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+
+// Local Includes.
+#include "debug.h"
+#include "NavCast.hh"
+
+static const uint16_t kMAGIC   = 0x4E43;   // 'NC'
+static const uint8_t  kVERSION = 1;
+
+/* Big endian field access for the header. */
+static inline void Put16(unsigned char *p, uint16_t v)
+{
+    v = htons(v);
+    memcpy(p, &v, sizeof(v));
+}
+static inline void Put32(unsigned char *p, uint32_t v)
+{
+    v = htonl(v);
+    memcpy(p, &v, sizeof(v));
+}
+static inline uint16_t Get16(const unsigned char *p)
+{
+    uint16_t v;
+    memcpy(&v, p, sizeof(v));
+    return ntohs(v);
+}
+static inline uint32_t Get32(const unsigned char *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return ntohl(v);
+}
+
+/********************************************************************
+ *
+ * Function Name : NavCastPublisher Constructor
+ *
+ * Description : Make a UDP socket that sends to Group:Port from
+ *               Interface. Multicast loop is on so subscribers on
+ *               this host hear it.
+ *
+ * Inputs : Group     - multicast address, dot format
+ *          Port      - UDP port
+ *          Interface - local address to send from
+ *          TTL       - hops, 0 stays on the host
+ *          Source    - publisher id, 0 for the pid
+ *
+ * Returns : constructed class
+ *
+ * Error Conditions : NO_SOCKET, BAD_GROUP, ERROR_INTERFACE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+NavCastPublisher::NavCastPublisher(const char *Group, unsigned short Port,
+				   const char *Interface, int TTL,
+				   uint16_t Source) : CObject()
+{
+    SET_DEBUG_STACK;
+    struct in_addr iface;
+    unsigned char  ttl  = TTL;
+    unsigned char  loop = 1;
+
+    SetName("NavCastPublisher");
+    ClearError(__LINE__);
+    fSource   = (Source != 0) ? Source : (uint16_t) getpid();
+    fSequence = 0;
+    memset(&fGroup, 0, sizeof(fGroup));
+    fGroup.sin_family = AF_INET;
+    fGroup.sin_port   = htons(Port);
+
+    fSocket = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fSocket < 0)
+    {
+	SetError(NO_SOCKET, __LINE__);
+	return;
+    }
+    if ((inet_pton(AF_INET, Group, &fGroup.sin_addr) != 1) ||
+	!IN_MULTICAST(ntohl(fGroup.sin_addr.s_addr)))
+    {
+	SetError(BAD_GROUP, __LINE__);
+	return;
+    }
+    if ((inet_pton(AF_INET, Interface, &iface) != 1) ||
+	(setsockopt(fSocket, IPPROTO_IP, IP_MULTICAST_IF,
+		    &iface, sizeof(iface)) < 0) ||
+	(setsockopt(fSocket, IPPROTO_IP, IP_MULTICAST_TTL,
+		    &ttl, sizeof(ttl)) < 0) ||
+	(setsockopt(fSocket, IPPROTO_IP, IP_MULTICAST_LOOP,
+		    &loop, sizeof(loop)) < 0))
+    {
+	SetError(ERROR_INTERFACE, __LINE__);
+    }
+}
+/********************************************************************
+ *
+ * Function Name : NavCastPublisher Destructor
+ *
+ * Description :
+ *
+ * Inputs : None
+ *
+ * Returns : None
+ *
+ * Error Conditions : None
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+NavCastPublisher::~NavCastPublisher(void)
+{
+    if (fSocket >= 0)
+    {
+	close(fSocket);
+    }
+}
+/********************************************************************
+ *
+ * Function Name : Publish
+ *
+ * Description : Header from the stack, payload from the caller, one
+ *               sendmsg. The sequence number is used up even if the
+ *               send fails, so subscribers see the gap.
+ *
+ * Inputs : Type  - NavCastType
+ *          Data  - payload, e.g. GGA::DataPointer()
+ *          Bytes - payload size, e.g. GGA::DataSize()
+ *
+ * Returns : true if sent
+ *
+ * Error Conditions : TOO_BIG, SEND_FAILED
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool NavCastPublisher::Publish(uint8_t Type, const void *Data, size_t Bytes)
+{
+    unsigned char   header[kNAVCAST_HEADER];
+    struct iovec    iov[2];
+    struct msghdr   msg;
+    struct timespec now;
+    uint64_t        ns;
+    ssize_t         rc;
+
+    if (Bytes > kNAVCAST_MAX_PAYLOAD)
+    {
+	SetError(TOO_BIG, __LINE__);
+	return false;
+    }
+    clock_gettime(CLOCK_REALTIME, &now);
+    ns = (uint64_t) now.tv_sec*1000000000ULL + now.tv_nsec;
+
+    Put16(header,    kMAGIC);
+    header[2] = kVERSION;
+    header[3] = Type;
+    Put16(header+4,  Bytes);
+    Put16(header+6,  fSource);
+    Put32(header+8,  fSequence++);
+    Put32(header+12, ns >> 32);
+    Put32(header+16, ns & 0xFFFFFFFF);
+
+    iov[0].iov_base = header;
+    iov[0].iov_len  = sizeof(header);
+    iov[1].iov_base = (void *) Data;
+    iov[1].iov_len  = Bytes;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name    = &fGroup;
+    msg.msg_namelen = sizeof(fGroup);
+    msg.msg_iov     = iov;
+    msg.msg_iovlen  = (Bytes > 0) ? 2 : 1;
+    do
+    {
+	rc = sendmsg(fSocket, &msg, 0);
+    } while ((rc < 0) && (errno == EINTR));
+    if (rc < 0)
+    {
+	SetError(SEND_FAILED, __LINE__);
+	return false;
+    }
+    return true;
+}
+/********************************************************************
+ *
+ * Function Name : NavCastSubscriber Constructor
+ *
+ * Description : Bind Port with SO_REUSEADDR so several subscribers
+ *               on the host each get every record, join the group,
+ *               ask for kernel receive time stamps.
+ *
+ * Inputs : Group     - multicast address, dot format
+ *          Port      - UDP port
+ *          Interface - local address of the interface to join on
+ *
+ * Returns : constructed class
+ *
+ * Error Conditions : NO_SOCKET, BAD_GROUP, ERROR_BIND, ERROR_JOIN
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+NavCastSubscriber::NavCastSubscriber(const char *Group, unsigned short Port,
+				     const char *Interface) : CObject()
+{
+    SET_DEBUG_STACK;
+    struct sockaddr_in local;
+    struct ip_mreq     mreq;
+    int    on     = 1;
+    int    rcvbuf = 1<<20;
+
+    SetName("NavCastSubscriber");
+    ClearError(__LINE__);
+    fBuffer   = new unsigned char[kNAVCAST_HEADER + kNAVCAST_MAX_PAYLOAD];
+    fReceived = 0;
+    fLost     = 0;
+    fStale    = 0;
+    fBad      = 0;
+
+    fSocket = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if ((fSocket < 0) ||
+	(setsockopt(fSocket, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) < 0))
+    {
+	SetError(NO_SOCKET, __LINE__);
+	return;
+    }
+    /* Not fatal, the time of the read is used without it. */
+    setsockopt(fSocket, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on));
+    /* Room for bursts, the kernel caps it at rmem_max. */
+    setsockopt(fSocket, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    memset(&mreq, 0, sizeof(mreq));
+    if ((inet_pton(AF_INET, Group, &mreq.imr_multiaddr) != 1) ||
+	!IN_MULTICAST(ntohl(mreq.imr_multiaddr.s_addr)) ||
+	(inet_pton(AF_INET, Interface, &mreq.imr_interface) != 1))
+    {
+	SetError(BAD_GROUP, __LINE__);
+	return;
+    }
+    /* Bound to the group, not INADDR_ANY, so other groups on the
+     * same port aren't delivered here. */
+    memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_port   = htons(Port);
+    local.sin_addr   = mreq.imr_multiaddr;
+    if (bind(fSocket, (struct sockaddr *) &local, sizeof(local)) < 0)
+    {
+	SetError(ERROR_BIND, __LINE__);
+	return;
+    }
+    if (setsockopt(fSocket, IPPROTO_IP, IP_ADD_MEMBERSHIP,
+		   &mreq, sizeof(mreq)) < 0)
+    {
+	SetError(ERROR_JOIN, __LINE__);
+    }
+}
+/********************************************************************
+ *
+ * Function Name : NavCastSubscriber Destructor
+ *
+ * Description : Closing the socket leaves the group.
+ *
+ * Inputs : None
+ *
+ * Returns : None
+ *
+ * Error Conditions : None
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+NavCastSubscriber::~NavCastSubscriber(void)
+{
+    if (fSocket >= 0)
+    {
+	close(fSocket);
+    }
+    delete [] fBuffer;
+}
+/********************************************************************
+ *
+ * Function Name : Track
+ *
+ * Description : Sequence bookkeeping per source. A jump forward is
+ *               lost records. A step back is a restarted publisher
+ *               if the record was published after the last one, or
+ *               if it is a long way back. Otherwise it is stale, a
+ *               late or repeated datagram.
+ *
+ * Inputs : Id       - source
+ *          Sequence - of the record just received
+ *          SendTime - its publish time
+ *
+ * Returns : None
+ *
+ * Error Conditions : None
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void NavCastSubscriber::Track(uint16_t Id, uint32_t Sequence,
+			      uint64_t SendTime)
+{
+    Source s;
+    for (size_t i=0; i<fSources.size(); i++)
+    {
+	if (fSources[i].Id == Id)
+	{
+	    int32_t step = (int32_t) (Sequence - fSources[i].Last);
+	    if (step > 0)
+	    {
+		fLost += step - 1;
+	    }
+	    else if ((step >= -65536) && (SendTime <= fSources[i].Time))
+	    {
+		fStale++;
+		return;
+	    }
+	    fSources[i].Last = Sequence;
+	    fSources[i].Time = SendTime;
+	    return;
+	}
+    }
+    s.Id   = Id;
+    s.Last = Sequence;
+    s.Time = SendTime;
+    fSources.push_back(s);
+}
+/********************************************************************
+ *
+ * Function Name : Receive
+ *
+ * Description : Wait for a datagram, check the header and fill in
+ *               Record. Bad datagrams and wakeups with nothing to
+ *               read go back to waiting for what is left of Timeout.
+ *
+ * Inputs : Record  - returned
+ *          Timeout - seconds, negative to wait forever
+ *
+ * Returns : true if Record was filled
+ *
+ * Error Conditions : RECV_FAILED
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool NavCastSubscriber::Receive(NavCastRecord &Record, double Timeout)
+{
+    struct pollfd   pfd;
+    struct iovec    iov;
+    struct msghdr   msg;
+    struct cmsghdr *cm;
+    char    control[CMSG_SPACE(sizeof(struct timespec))];
+    struct timespec now;
+    double  deadline = 0.0, left;
+    int     ms = -1;
+    ssize_t rc;
+
+    if (fSocket < 0)
+    {
+	return false;
+    }
+    if (Timeout >= 0.0)
+    {
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	deadline = now.tv_sec + now.tv_nsec*1.0e-9 + Timeout;
+    }
+    while (true)
+    {
+	iov.iov_base = fBuffer;
+	iov.iov_len  = kNAVCAST_HEADER + kNAVCAST_MAX_PAYLOAD;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov        = &iov;
+	msg.msg_iovlen     = 1;
+	msg.msg_control    = control;
+	msg.msg_controllen = sizeof(control);
+	rc = recvmsg(fSocket, &msg, 0);
+	if (rc < 0)
+	{
+	    if (errno == EINTR)
+	    {
+		continue;
+	    }
+	    if (errno != EAGAIN)
+	    {
+		SetError(RECV_FAILED, __LINE__);
+		return false;
+	    }
+	    /* Nothing queued, wait for what is left of Timeout. */
+	    if (Timeout >= 0.0)
+	    {
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		left = deadline - (now.tv_sec + now.tv_nsec*1.0e-9);
+		if (left <= 0.0)
+		{
+		    return false;
+		}
+		ms = (int) ceil(left*1000.0);
+	    }
+	    pfd.fd     = fSocket;
+	    pfd.events = POLLIN;
+	    rc = poll(&pfd, 1, ms);
+	    if ((rc < 0) && (errno == EINTR))
+	    {
+		continue;
+	    }
+	    if (rc <= 0)
+	    {
+		return false;
+	    }
+	    continue;
+	}
+	if ((rc < (ssize_t) kNAVCAST_HEADER) ||
+	    (Get16(fBuffer) != kMAGIC) || (fBuffer[2] != kVERSION) ||
+	    (Get16(fBuffer+4) != (size_t) rc - kNAVCAST_HEADER))
+	{
+	    fBad++;
+	    continue;
+	}
+	break;
+    }
+
+    Record.Received.tv_sec  = 0;
+    Record.Received.tv_nsec = 0;
+    for (cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm))
+    {
+	if ((cm->cmsg_level == SOL_SOCKET) && (cm->cmsg_type == SCM_TIMESTAMPNS))
+	{
+	    memcpy(&Record.Received, CMSG_DATA(cm), sizeof(struct timespec));
+	}
+    }
+    if (Record.Received.tv_sec == 0)
+    {
+	clock_gettime(CLOCK_REALTIME, &Record.Received);
+    }
+    Record.Type     = fBuffer[3];
+    Record.Length   = Get16(fBuffer+4);
+    Record.Source   = Get16(fBuffer+6);
+    Record.Sequence = Get32(fBuffer+8);
+    Record.SendTime = ((uint64_t) Get32(fBuffer+12) << 32) | Get32(fBuffer+16);
+    Record.Data     = fBuffer + kNAVCAST_HEADER;
+    fReceived++;
+    Track(Record.Source, Record.Sequence, Record.SendTime);
+    return true;
+}
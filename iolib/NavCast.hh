@@ -0,0 +1,155 @@
+/********************************************************************
+ *
+ * Module Name : NavCast.hh
+ *
+ * Author/Date : C.B. Lirakis / 17-Oct-26
+ *
+ * Description : UDP multicast of navigation fixes. One publisher
+ * send reaches every subscriber that joined the group, however many
+ * there are, with no connection state on either side.
+ *
+ * Each datagram is a small header and an opaque payload, normally
+ * the DataPointer()/DataSize() block of a decoded GGA, RMC or TSIP
+ * class, the same bytes relayed through shared memory. The header
+ * carries the record type, the publisher's source id, a sequence
+ * number and the publish time, so a subscriber can count what it
+ * lost and how old each fix is.
+ *
+ *    0  uint16 magic 'NC'     2  uint8  version  3  uint8 type
+ *    4  uint16 payload bytes  6  uint16 source
+ *    8  uint32 sequence      12  uint64 publish time, ns CLOCK_REALTIME
+ *
+ * The header is big endian. The payload is the host's struct layout,
+ * subscribers are expected to be on the same host or same kind of
+ * host.
+ *
+ * Restrictions/Limitations : Defaults keep the traffic on the
+ * loopback interface (TTL 0). One payload per datagram, at most
+ * kNAVCAST_MAX_PAYLOAD bytes.
+ *
+ * Change Descriptions :
+ * 17-Oct-26 CBL Receive waits out the whole timeout past bad 
+ *               datagrams. A source that goes back in sequence but
+ *               forward in publish time has restarted, not stale. 
+ *
+ * Classification : Unclassified
+ *
+ * References : ip(7) IP_ADD_MEMBERSHIP, IP_MULTICAST_IF
+ *
+ ********************************************************************/
+#ifndef __NAVCAST_hh_
+#define __NAVCAST_hh_
+#include <stdint.h>
+#include <time.h>
+#include <vector>
+#include <netinet/in.h>
+#include "CObject.hh"
+
+/*! Record types. */
+enum NavCastType {kNAVCAST_GGA = 1, kNAVCAST_RMC, kNAVCAST_VTG, kNAVCAST_GSA,
+		  kNAVCAST_TSIP_POSITION, kNAVCAST_TSIP_VELOCITY,
+		  kNAVCAST_TSIP_STATUS, kNAVCAST_USER = 128};
+
+const char           kNAVCAST_GROUP[]     = "239.255.76.1";
+const unsigned short kNAVCAST_PORT        = 17600;
+const size_t         kNAVCAST_HEADER      = 20;
+const size_t         kNAVCAST_MAX_PAYLOAD = 65507 - kNAVCAST_HEADER;
+
+/**
+ * One received record. Data points into the subscriber and is good
+ * until the next Receive.
+ */
+struct NavCastRecord {
+    uint8_t         Type;
+    uint16_t        Source;
+    uint32_t        Sequence;
+    uint64_t        SendTime;   // ns CLOCK_REALTIME at the publisher
+    struct timespec Received;   // kernel receive time
+    uint16_t        Length;
+    const void     *Data;
+};
+
+class NavCastPublisher : public CObject
+{
+public:
+    /**
+     * Interface is the local address to send from, TTL 0 stays on
+     * the host. Source tells publishers apart, 0 uses the pid.
+     */
+    NavCastPublisher(const char *Group = kNAVCAST_GROUP,
+		     unsigned short Port = kNAVCAST_PORT,
+		     const char *Interface = "127.0.0.1",
+		     int TTL = 0, uint16_t Source = 0);
+    ~NavCastPublisher(void);
+
+    /**
+     * Send one record, header and payload in one datagram without
+     * copying the payload.
+     */
+    bool Publish(uint8_t Type, const void *Data, size_t Bytes);
+
+    /*! Records sent, the next sequence number. */
+    inline uint32_t Sent(void)   const {return fSequence;};
+    inline uint16_t Source(void) const {return fSource;};
+
+    enum NAVCAST_ERRORS {NO_SOCKET=1, BAD_GROUP, ERROR_INTERFACE,
+			 SEND_FAILED, TOO_BIG};
+
+private:
+    int                fSocket;
+    struct sockaddr_in fGroup;
+    uint16_t           fSource;
+    uint32_t           fSequence;
+};
+
+class NavCastSubscriber : public CObject
+{
+public:
+    /**
+     * Join Group on the interface with address Interface. Any
+     * number of subscribers on a host can share a port.
+     */
+    NavCastSubscriber(const char *Group = kNAVCAST_GROUP,
+		      unsigned short Port = kNAVCAST_PORT,
+		      const char *Interface = "127.0.0.1");
+    ~NavCastSubscriber(void);
+
+    /**
+     * Wait up to Timeout seconds (negative forever) for a record.
+     * False on timeout or error. Malformed datagrams are counted
+     * and skipped; stale records are counted and still returned.
+     */
+    bool Receive(NavCastRecord &Record, double Timeout);
+
+    /*! Non-blocking descriptor, for poll or an IOReactor. */
+    inline int      GetFD(void)    const {return fSocket;};
+    inline uint64_t Received(void) const {return fReceived;};
+    /*! Records missing from the sequence of each source. */
+    inline uint64_t Lost(void)     const {return fLost;};
+    /*! Records that arrived behind a later one, or twice. */
+    inline uint64_t Stale(void)    const {return fStale;};
+    /*! Datagrams that weren't records. */
+    inline uint64_t Bad(void)      const {return fBad;};
+
+    enum NAVCAST_ERRORS {NO_SOCKET=1, BAD_GROUP, ERROR_BIND, ERROR_JOIN,
+			 RECV_FAILED};
+
+private:
+    /*! Last sequence and publish time seen from each publisher. */
+    struct Source {
+	uint16_t Id;
+	uint32_t Last;
+	uint64_t Time;
+    };
+    /*! Update the loss and stale counts. */
+    void Track(uint16_t Id, uint32_t Sequence, uint64_t SendTime);
+
+    int                 fSocket;
+    unsigned char      *fBuffer;
+    std::vector<Source> fSources;
+    uint64_t            fReceived;
+    uint64_t            fLost;
+    uint64_t            fStale;
+    uint64_t            fBad;
+};
+#endif
@@ -0,0 +1,832 @@
+/********************************************************************
+ *
+ * Module Name : NetServer.cpp
+ *
+ * Author/Date : C.B. Lirakis / 17-Oct-26
+ *
+ * Description : Edge triggered epoll TCP server.
+ *
+ * With edge triggering each event is only reported once, so input
+ * is read and output written until the kernel says EAGAIN. A client
+ * is registered for EPOLLOUT from the start; the edge only comes
+ * when its send buffer goes from full to not full, which is exactly
+ * when a queue needs flushing.
+ *
+ * Restrictions/Limitations : Linux only.
+ *
+ * Change Descriptions :
+ * 17-Oct-26 CBL Flush keeps going after a full sendmsg, Post holds
+ *               a first message that found the socket full to the 
+ *               queue limit. 
+ *
+ * Classification : Unclassified
+ *
+ * References : epoll(7)
+ *
+ ********************************************************************/
+// System includes.
+#include <iostream>
+using namespace std;
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+// Local Includes.
+#include "debug.h"
+#include "CLogger.hh"
+#include "NetServer.hh"
+
+/* epoll data for the Stop eventfd and the listening socket. */
+static const uint64_t kWAKE       = ~(uint64_t)0;
+static const uint64_t kLISTEN     = ~(uint64_t)1;
+/* Ready descriptors taken per epoll_wait. */
+static const int      kMAX_EVENTS = 64;
+/* Queued messages given to one writev. */
+static const int      kMAX_IOV    = 64;
+
+/********************************************************************
+ *
+ * Function Name : NetServer Constructor
+ *
+ * Description : Bind and listen on Port, make the epoll set.
+ *
+ * Inputs : Port       - TCP port, all interfaces
+ *          Handler    - called for every client event
+ *          Arg        - passed to Handler
+ *          MaxClients - connections allowed at once
+ *          QueueLimit - output bytes held per client
+ *          BufferSize - input ring per client
+ *
+ * Returns : constructed class
+ *
+ * Error Conditions : NO_EPOLL, NO_SOCKET, ERROR_BIND, ERROR_LISTEN
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+NetServer::NetServer(unsigned short Port, NetHandler Handler, void *Arg,
+		     size_t MaxClients, size_t QueueLimit,
+		     unsigned short BufferSize) : CObject()
+{
+    SET_DEBUG_STACK;
+    struct epoll_event ev;
+    struct sockaddr_in server;
+    int    on = 1;
+
+    SetName("NetServer");
+    ClearError(__LINE__);
+    fHandler    = Handler;
+    fArg        = Arg;
+    fMaxClients = MaxClients;
+    fQueueLimit = QueueLimit;
+    fBufferSize = BufferSize;
+    fDisconnect = false;
+    fNClients   = 0;
+    fRejected   = 0;
+    fRun        = false;
+    fSpare      = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    fListen     = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    fEpoll      = epoll_create1(EPOLL_CLOEXEC);
+    fWake       = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if ((fEpoll < 0) || (fWake < 0))
+    {
+	SetError(NO_EPOLL, __LINE__);
+	return;
+    }
+    if ((fListen < 0) ||
+	(setsockopt(fListen, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) < 0))
+    {
+	SetError(NO_SOCKET, __LINE__);
+	return;
+    }
+
+    memset(&server, 0, sizeof(server));
+    server.sin_family      = AF_INET;
+    server.sin_addr.s_addr = htonl(INADDR_ANY);
+    server.sin_port        = htons(Port);
+    if (bind(fListen, (struct sockaddr *) &server, sizeof(server)) < 0)
+    {
+	SetError(ERROR_BIND, __LINE__);
+	return;
+    }
+    if (listen(fListen, SOMAXCONN) < 0)
+    {
+	SetError(ERROR_LISTEN, __LINE__);
+	return;
+    }
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events   = EPOLLIN;
+    ev.data.u64 = kWAKE;
+    if (epoll_ctl(fEpoll, EPOLL_CTL_ADD, fWake, &ev) < 0)
+    {
+	SetError(NO_EPOLL, __LINE__);
+	return;
+    }
+    ev.events   = EPOLLIN | EPOLLET;
+    ev.data.u64 = kLISTEN;
+    if (epoll_ctl(fEpoll, EPOLL_CTL_ADD, fListen, &ev) < 0)
+    {
+	SetError(NO_EPOLL, __LINE__);
+    }
+}
+/********************************************************************
+ *
+ * Function Name : NetServer Destructor
+ *
+ * Description : Close every client, each gets its kNET_CLOSE, then
+ *               the listening socket.
+ *
+ * Inputs : None
+ *
+ * Returns : None
+ *
+ * Error Conditions : None
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+NetServer::~NetServer(void)
+{
+    SET_DEBUG_STACK;
+    for (size_t i=0; i<fClients.size(); i++)
+    {
+	if (fClients[i])
+	{
+	    Drop(fClients[i]);
+	}
+    }
+    fClients.clear();
+    if (fListen >= 0) close(fListen);
+    if (fWake   >= 0) close(fWake);
+    if (fEpoll  >= 0) close(fEpoll);
+    if (fSpare  >= 0) close(fSpare);
+}
+/********************************************************************
+ *
+ * Function Name : Release
+ *
+ * Description : One queue is done with B, free it after the last.
+ *
+ * Inputs : B - shared output
+ *
+ * Returns : None
+ *
+ * Error Conditions : None
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void NetServer::Release(Block *B)
+{
+    if (--B->Refs == 0)
+    {
+	free(B);
+    }
+}
+/********************************************************************
+ *
+ * Function Name : Accept
+ *
+ * Description : Take every pending connection. Past MaxClients, or
+ *               out of descriptors, the connection is accepted and
+ *               closed at once; left in the backlog it would never
+ *               raise another edge. Running out of descriptors uses
+ *               the spare one held for the purpose.
+ *
+ * Inputs : None
+ *
+ * Returns : None
+ *
+ * Error Conditions : None
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void NetServer::Accept(void)
+{
+    SET_DEBUG_STACK;
+    struct epoll_event ev;
+    Connection *c;
+    int    fd;
+    int    on = 1;
+
+    while (true)
+    {
+	fd = accept4(fListen, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+	if (fd < 0)
+	{
+	    if (errno == EINTR)
+	    {
+		continue;
+	    }
+	    if (((errno == EMFILE) || (errno == ENFILE)) && (fSpare >= 0))
+	    {
+		close(fSpare);
+		if ((fd = accept(fListen, NULL, NULL)) >= 0)
+		{
+		    close(fd);
+		    fRejected++;
+		}
+		fSpare = open("/dev/null", O_RDONLY | O_CLOEXEC);
+		if (fd >= 0)
+		{
+		    continue;
+		}
+	    }
+	    /* EAGAIN, the backlog is empty. */
+	    return;
+	}
+	if (fNClients >= fMaxClients)
+	{
+	    close(fd);
+	    fRejected++;
+	    continue;
+	}
+	/* Writes are already batched, don't let Nagle hold them. */
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+	c = new Connection;
+	c->FD          = fd;
+	c->Closing     = false;
+	c->Data        = new Buffered(fBufferSize);
+	c->Data->Reset();
+	c->QueuedBytes = 0;
+	c->NDropped    = 0;
+	c->NOverflows  = 0;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events   = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+	ev.data.u64 = fd;
+	if (epoll_ctl(fEpoll, EPOLL_CTL_ADD, fd, &ev) < 0)
+	{
+	    delete c->Data;
+	    delete c;
+	    close(fd);
+	    continue;
+	}
+	if ((size_t) fd >= fClients.size())
+	{
+	    fClients.resize(fd+1, NULL);
+	}
+	fClients[fd] = c;
+	fNClients++;
+	fHandler(this, fd, kNET_OPEN, c->Data, fArg);
+	if (c->Closing)
+	{
+	    Drop(c);
+	}
+    }
+}
+/********************************************************************
+ *
+ * Function Name : Receive
+ *
+ * Description : Read until EAGAIN, calling the handler after each
+ *               read. A ring its handler left full is emptied.
+ *
+ * Inputs : C - readable client
+ *
+ * Returns : None
+ *
+ * Error Conditions : None, end of file or a read error mark the
+ *                    client Closing.
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void NetServer::Receive(Connection *C)
+{
+    SET_DEBUG_STACK;
+    ssize_t rc;
+
+    while (!C->Closing)
+    {
+	if (C->Data->IsFull())
+	{
+	    CLogger *pLogger = CLogger::GetThis();
+	    if (pLogger && (C->NOverflows == 0))
+	    {
+		pLogger->LogError(__FILE__, __LINE__, 'W',
+				  "NetServer - input ring full, discarding.");
+	    }
+	    C->NOverflows++;
+	    C->Data->Reset();
+	}
+	rc = C->Data->ReadFrom(C->FD);
+	if (rc > 0)
+	{
+	    fHandler(this, C->FD, kNET_DATA, C->Data, fArg);
+	}
+	else if ((rc < 0) && (errno == EINTR))
+	{
+	    continue;
+	}
+	else if ((rc < 0) && (errno == EAGAIN))
+	{
+	    return;
+	}
+	else
+	{
+	    C->Closing = true;
+	}
+    }
+}
+/********************************************************************
+ *
+ * Function Name : Flush
+ *
+ * Description : writev the queue, up to kMAX_IOV messages a call,
+ *               until it is empty or the socket is full.
+ *
+ * Inputs : C - client
+ *
+ * Returns : false if the client has gone
+ *
+ * Error Conditions : None
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool NetServer::Flush(Connection *C)
+{
+    SET_DEBUG_STACK;
+    struct iovec  iov[kMAX_IOV];
+    struct msghdr msg;
+    ssize_t rc;
+    size_t  offered, sent;
+    int     n;
+
+    while (!C->Queue.empty())
+    {
+	offered = 0;
+	for (n=0; (n<kMAX_IOV) && ((size_t) n<C->Queue.size()); n++)
+	{
+	    Chunk &k = C->Queue[n];
+	    iov[n].iov_base = k.Out->Data + k.Offset;
+	    iov[n].iov_len  = k.Out->Size - k.Offset;
+	    offered        += iov[n].iov_len;
+	}
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov    = iov;
+	msg.msg_iovlen = n;
+	/* sendmsg rather than writev, for MSG_NOSIGNAL. */
+	rc = sendmsg(C->FD, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+	if (rc < 0)
+	{
+	    if (errno == EINTR)
+	    {
+		continue;
+	    }
+	    if (errno == EAGAIN)
+	    {
+		return true;
+	    }
+	    C->Closing = true;
+	    return false;
+	}
+	sent = rc;
+	C->QueuedBytes -= sent;
+	while (rc > 0)
+	{
+	    Chunk &k = C->Queue.front();
+	    size_t left = k.Out->Size - k.Offset;
+	    if ((size_t) rc < left)
+	    {
+		k.Offset += rc;
+		break;
+	    }
+	    rc -= left;
+	    Release(k.Out);
+	    C->Queue.pop_front();
+	}
+	if (sent < offered)
+	{
+	    /* Short write, the send buffer is full. EPOLLOUT resumes. */
+	    return true;
+	}
+    }
+    return true;
+}
+/********************************************************************
+ *
+ * Function Name : Post
+ *
+ * Description : If nothing is queued, write directly and queue only
+ *               what didn't fit. Otherwise queue the message behind
+ *               the rest, if it is within the limit. A message that
+ *               is partly on the wire is always finished, so the
+ *               stream never has half a message in it. One that 
+ *               didn't start is held to the limit like any other.
+ *
+ * Inputs : C      - client
+ *          Data   - message
+ *          Bytes  - its length
+ *          Shared - copy of Data to queue, made here if NULL
+ *
+ * Returns : true if the message was sent or queued
+ *
+ * Error Conditions : None
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool NetServer::Post(Connection *C, const void *Data, size_t Bytes,
+		     Block *&Shared)
+{
+    ssize_t rc;
+    size_t  sent = 0;
+    Chunk   k;
+
+    if (C->Closing)
+    {
+	return false;
+    }
+    if (C->Queue.empty())
+    {
+	do
+	{
+	    rc = send(C->FD, Data, Bytes, MSG_NOSIGNAL | MSG_DONTWAIT);
+	} while ((rc < 0) && (errno == EINTR));
+	if (rc >= 0)
+	{
+	    sent = rc;
+	}
+	else if (errno != EAGAIN)
+	{
+	    Close(C->FD);
+	    return false;
+	}
+	if (sent == Bytes)
+	{
+	    return true;
+	}
+    }
+    if ((sent == 0) && (C->QueuedBytes + Bytes > fQueueLimit))
+    {
+	C->NDropped++;
+	if (fDisconnect)
+	{
+	    Close(C->FD);
+	}
+	return false;
+    }
+
+    if (Shared == NULL)
+    {
+	Shared = (Block *) malloc(sizeof(Block) + Bytes);
+	Shared->Refs = 0;
+	Shared->Size = Bytes;
+	memcpy(Shared->Data, Data, Bytes);
+    }
+    Shared->Refs++;
+    k.Out    = Shared;
+    k.Offset = sent;
+    C->Queue.push_back(k);
+    C->QueuedBytes += Bytes - sent;
+    return true;
+}
+/********************************************************************
+ *
+ * Function Name : Send
+ *
+ * Description : Send one message to one client.
+ *
+ * Inputs : Client - from the handler
+ *          Data   - message
+ *          Bytes  - its length
+ *
+ * Returns : true if sent or queued
+ *
+ * Error Conditions : None
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool NetServer::Send(int Client, const void *Data, size_t Bytes)
+{
+    SET_DEBUG_STACK;
+    Connection *c = Find(Client);
+    Block      *shared = NULL;
+
+    return c && Post(c, Data, Bytes, shared);
+}
+/********************************************************************
+ *
+ * Function Name : Broadcast
+ *
+ * Description : Send one message to every client. At most one copy
+ *               is made, shared by the clients that have to queue it.
+ *
+ * Inputs : Data  - message
+ *          Bytes - its length
+ *
+ * Returns : clients that took it
+ *
+ * Error Conditions : None
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+size_t NetServer::Broadcast(const void *Data, size_t Bytes)
+{
+    SET_DEBUG_STACK;
+    Block  *shared = NULL;
+    size_t  n = 0;
+
+    for (size_t i=0; i<fClients.size(); i++)
+    {
+	if (fClients[i] && Post(fClients[i], Data, Bytes, shared))
+	{
+	    n++;
+	}
+    }
+    return n;
+}
+/********************************************************************
+ *
+ * Function Name : Close
+ *
+ * Description : Shut the socket down now. The epoll set reports the
+ *               hang up and the client is dropped there, after any
+ *               handler that is running has returned.
+ *
+ * Inputs : Client - from the handler
+ *
+ * Returns : None
+ *
+ * Error Conditions : None
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void NetServer::Close(int Client)
+{
+    Connection *c = Find(Client);
+    if (c && !c->Closing)
+    {
+	c->Closing = true;
+	shutdown(c->FD, SHUT_RDWR);
+    }
+}
+/********************************************************************
+ *
+ * Function Name : Drop
+ *
+ * Description : Tell the handler, close and free a client.
+ *
+ * Inputs : C - client
+ *
+ * Returns : None
+ *
+ * Error Conditions : None
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void NetServer::Drop(Connection *C)
+{
+    SET_DEBUG_STACK;
+    C->Closing = true;
+    epoll_ctl(fEpoll, EPOLL_CTL_DEL, C->FD, NULL);
+    fHandler(this, C->FD, kNET_CLOSE, C->Data, fArg);
+    while (!C->Queue.empty())
+    {
+	Release(C->Queue.front().Out);
+	C->Queue.pop_front();
+    }
+    close(C->FD);
+    fClients[C->FD] = NULL;
+    fNClients--;
+    delete C->Data;
+    delete C;
+}
+/********************************************************************
+ *
+ * Function Name : Poll
+ *
+ * Description : Wait and service every ready socket. Input is read
+ *               before a hang up is acted on, so the last data from
+ *               a client isn't lost.
+ *
+ * Inputs : Timeout - seconds, negative to wait forever
+ *
+ * Returns : number of events, -1 on error
+ *
+ * Error Conditions : WAIT_FAILED
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+int NetServer::Poll(double Timeout)
+{
+    SET_DEBUG_STACK;
+    struct epoll_event ev[kMAX_EVENTS];
+    Connection *c;
+    int    n;
+    int    ms = (Timeout < 0.0) ? -1 : (int) ceil(Timeout*1000.0);
+
+    if (fEpoll < 0)
+    {
+	SetError(NO_EPOLL, __LINE__);
+	return -1;
+    }
+    n = epoll_wait(fEpoll, ev, kMAX_EVENTS, ms);
+    if (n < 0)
+    {
+	if (errno == EINTR)
+	{
+	    return 0;
+	}
+	SetError(WAIT_FAILED, __LINE__);
+	return -1;
+    }
+
+    for (int i=0; i<n; i++)
+    {
+	if (ev[i].data.u64 == kWAKE)
+	{
+	    uint64_t count;
+	    if (read(fWake, &count, sizeof(count)) < 0)
+	    {
+		/* Already drained. */
+	    }
+	    continue;
+	}
+	if (ev[i].data.u64 == kLISTEN)
+	{
+	    Accept();
+	    continue;
+	}
+	if ((c = Find((int) ev[i].data.u64)) == NULL)
+	{
+	    continue;
+	}
+	if (ev[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+	{
+	    Receive(c);
+	}
+	if (!c->Closing && (ev[i].events & EPOLLOUT))
+	{
+	    Flush(c);
+	}
+	if (ev[i].events & (EPOLLHUP | EPOLLERR))
+	{
+	    c->Closing = true;
+	}
+	if (c->Closing)
+	{
+	    Drop(c);
+	}
+    }
+    return n;
+}
+/********************************************************************
+ *
+ * Function Name : Run
+ *
+ * Description : Poll until Stop is called.
+ *
+ * Inputs : None
+ *
+ * Returns : None
+ *
+ * Error Conditions : returns on WAIT_FAILED
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void NetServer::Run(void)
+{
+    SET_DEBUG_STACK;
+    fRun = true;
+    while (fRun)
+    {
+	if (Poll(-1.0) < 0)
+	{
+	    break;
+	}
+    }
+}
+/********************************************************************
+ *
+ * Function Name : Stop
+ *
+ * Description : Clear the run flag and wake epoll_wait.
+ *
+ * Inputs : None
+ *
+ * Returns : None
+ *
+ * Error Conditions : None
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void NetServer::Stop(void)
+{
+    uint64_t one = 1;
+    fRun = false;
+    if (write(fWake, &one, sizeof(one)) < 0)
+    {
+	/* Counter full, a wakeup is pending anyway. */
+    }
+}
+/********************************************************************
+ *
+ * Function Name : Queued, Dropped, Overflows
+ *
+ * Description : Per client statistics.
+ *
+ * Inputs : Client - from the handler
+ *
+ * Returns : as named, 0 for an unknown client
+ *
+ * Error Conditions : None
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+size_t NetServer::Queued(int Client) const
+{
+    Connection *c = Find(Client);
+    return c ? c->QueuedBytes : 0;
+}
+uint64_t NetServer::Dropped(int Client) const
+{
+    Connection *c = Find(Client);
+    return c ? c->NDropped : 0;
+}
+uint64_t NetServer::Overflows(int Client) const
+{
+    Connection *c = Find(Client);
+    return c ? c->NOverflows : 0;
+}
@@ -0,0 +1,166 @@
+/********************************************************************
+ *
+ * Module Name : NetServer.hh
+ *
+ * Author/Date : C.B. Lirakis / 17-Oct-26
+ *
+ * Description : Event driven TCP server for distributing data to
+ * many clients from one thread. NetIO::Server/Accept serve a handful
+ * of clients with blocking reads, and one slow reader holds up
+ * everybody else.
+ *
+ * Every socket is non-blocking and edge triggered in one epoll set.
+ * Input is read into a Buffered ring per client and handed to the
+ * handler. Output goes straight to the socket if the client is
+ * keeping up; otherwise it waits in that client's queue and is
+ * written with writev, many messages per call, when the socket
+ * drains. Broadcast data is stored once and shared by every queue
+ * that holds it.
+ *
+ * A client whose queue would pass the limit either loses the
+ * message (counted) or is disconnected, by configuration. Either
+ * way the other clients are not affected.
+ *
+ * Restrictions/Limitations : Everything from the thread that calls
+ * Poll, except Stop. Linux only. The client limit is also bounded
+ * by RLIMIT_NOFILE.
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References : epoll(7), accept4(2)
+ *
+ ********************************************************************/
+#ifndef __NETSERVER_hh_
+#define __NETSERVER_hh_
+#include <stdint.h>
+#include <deque>
+#include <vector>
+#include "CObject.hh"
+#include "Buffered.hh"
+
+class NetServer;
+
+/*! Why the handler was called. */
+enum NetEvent {kNET_OPEN, kNET_DATA, kNET_CLOSE};
+
+/**
+ * Called once with kNET_OPEN when a client connects, with kNET_DATA
+ * and the client's ring after each read, and once with kNET_CLOSE.
+ * Client identifies the connection until kNET_CLOSE returns.
+ */
+typedef void (*NetHandler)(NetServer *Server, int Client, NetEvent Event,
+			   Buffered *Data, void *Arg);
+
+class NetServer : public CObject
+{
+public:
+    /**
+     * Listen on Port. MaxClients connections are accepted, more are
+     * closed as they arrive. QueueLimit is the most output bytes
+     * held for one client.
+     */
+    NetServer(unsigned short Port, NetHandler Handler, void *Arg = NULL,
+	      size_t MaxClients = 1024, size_t QueueLimit = 1<<20,
+	      unsigned short BufferSize = 4096);
+    /**
+     * Closes every client and the listening socket.
+     */
+    ~NetServer(void);
+
+    /**
+     * Disconnect a client whose queue is full instead of dropping
+     * what doesn't fit.
+     */
+    inline void SetDisconnectSlow(bool Disconnect) {fDisconnect = Disconnect;};
+
+    /**
+     * Send to one client. False if it was dropped or the client is
+     * gone.
+     */
+    bool   Send(int Client, const void *Data, size_t Bytes);
+    /**
+     * Send to every client. Returns how many took it.
+     */
+    size_t Broadcast(const void *Data, size_t Bytes);
+    /**
+     * Disconnect a client once its handler returns. Queued output
+     * is discarded.
+     */
+    void   Close(int Client);
+
+    /**
+     * Wait up to Timeout seconds (negative forever) and service
+     * what is ready. Returns the number of events, -1 on error.
+     */
+    int    Poll(double Timeout);
+    /*! Poll until Stop. */
+    void   Run(void);
+    /*! Make Run return. Safe from another thread or a signal handler. */
+    void   Stop(void);
+
+    /*! Connected clients. */
+    inline size_t   Clients(void)  const {return fNClients;};
+    /*! Connections closed at once because MaxClients were connected. */
+    inline uint64_t Rejected(void) const {return fRejected;};
+    /*! Output bytes waiting for this client. */
+    size_t   Queued(int Client) const;
+    /*! Messages this client lost to the queue limit. */
+    uint64_t Dropped(int Client) const;
+    /*! Times this client's input ring was full and emptied. */
+    uint64_t Overflows(int Client) const;
+
+    enum NETSERVER_ERRORS {NO_EPOLL=1, NO_SOCKET, ERROR_BIND, ERROR_LISTEN,
+			   WAIT_FAILED};
+
+private:
+    /*! Output shared by the queues that hold it. */
+    struct Block {
+	uint32_t      Refs;
+	size_t        Size;
+	unsigned char Data[1];
+    };
+    /*! Part of a Block still to go. */
+    struct Chunk {
+	Block  *Out;
+	size_t  Offset;
+    };
+    struct Connection {
+	int               FD;
+	bool              Closing;
+	Buffered         *Data;
+	std::deque<Chunk> Queue;
+	size_t            QueuedBytes;
+	uint64_t          NDropped;
+	uint64_t          NOverflows;
+    };
+
+    void    Accept(void);
+    void    Receive(Connection *C);
+    /*! Write queued output until it is gone or the socket is full. */
+    bool    Flush(Connection *C);
+    /*! Queue or write one message. Block may be NULL, made if needed. */
+    bool    Post(Connection *C, const void *Data, size_t Bytes, Block *&Shared);
+    void    Drop(Connection *C);
+    static  void Release(Block *B);
+    inline Connection *Find(int Client) const {
+	return ((Client>=0) && (Client<(int)fClients.size())) ?
+	    fClients[Client] : NULL;};
+
+    std::vector<Connection *> fClients;   // index is the descriptor
+    NetHandler          fHandler;
+    void               *fArg;
+    size_t              fMaxClients;
+    size_t              fQueueLimit;
+    unsigned short      fBufferSize;
+    bool                fDisconnect;
+    size_t              fNClients;
+    uint64_t            fRejected;
+    int                 fListen;
+    int                 fEpoll;
+    int                 fWake;     // eventfd for Stop
+    int                 fSpare;    // given up to accept when out of fds
+    volatile bool       fRun;
+};
+#endif
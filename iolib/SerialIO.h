@@ -14,6 +14,7 @@
  *                       termination character. 
  * 09-May-20 CBL         Accidentially deleted header, recovering. 
  * 17-Feb-24 CBL         commenting and neating up. 
+ * 17-Oct-26 CBL         GetFD for IOReactor. 
  *
  * Classification : Unclassified
  *
@@ -136,6 +137,11 @@ public:
      */
     inline const char * GetPortName(void) {return fPortName;};
 
+    /*!
+     * The open descriptor, for epoll etc. -1 if not open. 
+     */
+    inline int GetFD(void) const {return fPort;};
+
     /*!
      * Get access  to errno!
      */
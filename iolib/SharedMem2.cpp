@@ -28,6 +28,10 @@
  * Change Descriptions :
  * 19-Feb-24 Changed permissions from 644 to ? If i do this it may present 
  *           a security leak. 
+ * 17-Oct-26 CBL Seqlock mode and generation counter. PutData(double)
+ *           was unlocking a semaphore it did not hold, fixed. Client 
+ *           now maps the payload as well as the header. 
+ *           Futex wait and wake helpers. WaitForUpdate, EventFD. 
  *
  * Classification : Unclassified
  *
@@ -65,6 +69,11 @@ using namespace std;
 #include <errno.h>
 #include <fstream>
 #include <csignal>
+#include <sched.h>
+#include <climits>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <sys/eventfd.h>
 
 // Local Includes.
 #include "SharedMem2.hh"
@@ -74,6 +83,10 @@ using namespace std;
 //static const int kPERM  = 0600;
 static const int kPERM    = 0644;
 static const size_t kSHM_Size = 4096; // Size of shared memory at initial 
+// Spins on an odd sequence before a reader gives up its time slice. 
+static const unsigned kSPIN_LIMIT = 128;
+// How often the EventFD thread looks to see if it should stop. 
+static const double kNOTIFY_POLL = 0.25;
 
 
 /********************************************************************
@@ -99,6 +112,12 @@ SharedMem2::SharedMem2 (void) : CObject()
     fNumberUserBytes = 0;
     fSM_Name         = NULL;
     fHead            = NULL;
+    fSeqlock         = false;
+    fWriting         = false;
+    fLastGeneration  = 0;
+    fRetries         = 0;
+    fEventFD         = -1;
+    fNotifyRun       = false;
 
     SetName("SharedMem2");
     ClearError(__LINE__);
@@ -119,6 +138,8 @@ SharedMem2::SharedMem2 (void) : CObject()
  *                      bytes allocated by user.
  *           Server   - if this is true, then this will create the shared 
  *                      memory, otherwise it 
+ *           DebugLevel - 
+ *           Seqlock  - Server only, readers don't take the semaphore. 
  *
  * Returns : constructed class. 
  *
@@ -129,7 +150,8 @@ SharedMem2::SharedMem2 (void) : CObject()
  * Unit Tested by: CBL
  *
  ********************************************************************/
-SharedMem2::SharedMem2( const char *Name, size_t UserSize, bool Server, int DebugLevel) : CObject()
+SharedMem2::SharedMem2( const char *Name, size_t UserSize, bool Server, 
+			int DebugLevel, bool Seqlock) : CObject()
 {
     CLogger *pLogger = CLogger::GetThis();
     bool     rc;
@@ -143,6 +165,12 @@ SharedMem2::SharedMem2( const char *Name, size_t UserSize, bool Server, int Debu
     fSM_Name         = NULL;
     fSemaphoreHandle = NULL;
     fHead            = NULL;
+    fSeqlock         = false;
+    fWriting         = false;
+    fLastGeneration  = 0;
+    fRetries         = 0;
+    fEventFD         = -1;
+    fNotifyRun       = false;
 
     if (!Name)
     {
@@ -224,10 +252,17 @@ SharedMem2::SharedMem2( const char *Name, size_t UserSize, bool Server, int Debu
 #endif
 
 	fHeader->DoubleData = 0.0;
+	fHeader->Sequence   = 0;
+	fHeader->Generation = 0;
+	fHeader->Waiters    = 0;
+	fHeader->Seqlock    = Seqlock;
+	fSeqlock            = Seqlock;
     }
     else
     {
 	fNumberUserBytes = fHeader->Length - sizeof(struct MyMemoryHeader);
+	fSeqlock         = fHeader->Seqlock;
+	fLastGeneration  = Generation();
     }
     fLastTime = fHeader->LastUpdateTime;
 
@@ -258,6 +293,7 @@ SharedMem2::~SharedMem2 ()
     SET_DEBUG_STACK;
     ClearError(__LINE__);
 
+    StopNotifier();
     if (fServer)
     {
 	CloseSpace();
@@ -513,6 +549,28 @@ bool SharedMem2::AttachSpace( void )
             }
             else 
 	    {
+		/*
+		 * Now that we know the size the server allocated, 
+		 * map the whole thing, header and user payload. 
+		 */
+		AllocSize = ((struct MyMemoryHeader *)fHead)->Length;
+		munmap( fHead, sizeof(struct MyMemoryHeader));
+		fHead = mmap((void *)0, AllocSize, 
+			     PROT_READ | PROT_WRITE, MAP_SHARED, 
+			     fSMHandle, 0);
+		if (fHead == MAP_FAILED) 
+		{
+		    fHead = NULL;
+		    SetError( NO_ATTACH, __LINE__);
+		    if(pLogger)
+		    {
+			pLogger->LogError(__FILE__, __LINE__, 'F',
+					  "SharedMem2 - failed payload mmap.");
+			pLogger->Log("# %s\n", strerror(errno));
+		    } 
+		    SET_DEBUG_STACK;
+		    return false;
+		}
 		if ((fDebug>0)&& pLogger)
 		{
 		    pLogger->LogError(__FILE__, __LINE__, 'I', 
@@ -803,7 +861,7 @@ void SharedMem2::DetachSpace(void)
 double SharedMem2::TimeSinceLastUpdate(void)
 {
     SET_DEBUG_STACK;
-    struct timespec CurrentTime, NewTime;
+    struct timespec CurrentTime, NewTime, Last;
     double rc = 0.0;
     CLogger *pLogger = CLogger::GetThis();
     ClearError(__LINE__);
@@ -816,7 +874,7 @@ double SharedMem2::TimeSinceLastUpdate(void)
 
     if (fHeader)
     {
-	if (Lock(__LINE__))
+	if (LastUpdate(Last))
 	{
 #ifdef MAC
 	    struct timeval tv;
@@ -830,21 +888,11 @@ double SharedMem2::TimeSinceLastUpdate(void)
 	    clock_gettime(CLOCK_REALTIME, &CurrentTime);
 #endif
         
-	    NewTime.tv_sec   = CurrentTime.tv_sec - 
-		fHeader->LastUpdateTime.tv_sec;
-	    NewTime.tv_nsec  = CurrentTime.tv_nsec - 
-		fHeader->LastUpdateTime.tv_nsec;
+	    NewTime.tv_sec   = CurrentTime.tv_sec  - Last.tv_sec;
+	    NewTime.tv_nsec  = CurrentTime.tv_nsec - Last.tv_nsec;
 
-	    if (Unlock(__LINE__))
-	    {
-		rc  = (double) (NewTime.tv_nsec)/1.0E9;
-		rc += (double) (NewTime.tv_sec);
-		ClearError(__LINE__);
-	    }
-	    else
-	    {
-		rc = -1.0;
-	    }
+	    rc  = (double) (NewTime.tv_nsec)/1.0E9;
+	    rc += (double) (NewTime.tv_sec);
 	}
 	else
 	{
@@ -875,7 +923,7 @@ double SharedMem2::TimeSinceLastUpdate(void)
 double SharedMem2::DeltaCheck(void)
 {
     SET_DEBUG_STACK;
-    struct timespec NewTime;
+    struct timespec NewTime, Last;
     CLogger *pLogger = CLogger::GetThis();
     double rc = 0.0;
 
@@ -888,24 +936,17 @@ double SharedMem2::DeltaCheck(void)
 
     if (fHeader)
     {
-	if (Lock(__LINE__))
+	if (LastUpdate(Last))
 	{
-
-	    NewTime.tv_sec   = fHeader->LastUpdateTime.tv_sec - 
-		fLastTime.tv_sec;
-	    NewTime.tv_nsec  = fHeader->LastUpdateTime.tv_nsec - 
-		fLastTime.tv_nsec;
-	    if(Unlock(__LINE__))
-	    {
-		rc  = (double) (NewTime.tv_nsec)/1.0E9;
-		rc += (double) (NewTime.tv_sec);
-		fLastTime = fHeader->LastUpdateTime;
-		ClearError(__LINE__);
-	    }
-	    else
-	    {
-		rc = -1.0;
-	    }
+	    NewTime.tv_sec   = Last.tv_sec  - fLastTime.tv_sec;
+	    NewTime.tv_nsec  = Last.tv_nsec - fLastTime.tv_nsec;
+	    rc  = (double) (NewTime.tv_nsec)/1.0E9;
+	    rc += (double) (NewTime.tv_sec);
+	    fLastTime = Last;
+	}
+	else
+	{
+	    rc = -1.0;
 	}
     }
     SET_DEBUG_STACK;
@@ -949,6 +990,7 @@ bool SharedMem2::UpdateTime(bool KeepLocked)
 
     if (Lock(__LINE__))
     {
+	WriteBegin();
 #ifdef MAC
 	struct timeval tv;
 	struct timezone tz;
@@ -1008,7 +1050,7 @@ bool SharedMem2::PutData(double Val)
         return false;
     }
     /* Update time will check the semaphores etc. */
-    if (UpdateTime())
+    if (UpdateTime(true))
     {
 	fHeader->DoubleData = Val;
 	fHeader->LAM = true;
@@ -1062,7 +1104,16 @@ double SharedMem2::GetData(void)
         return rc;
     }
 
-    if (Lock())
+    if (fSeqlock)
+    {
+	uint32_t seq;
+	do
+	{
+	    seq = ReadBegin();
+	    rc  = fHeader->DoubleData;
+	} while (ReadRetry(seq));
+    }
+    else if (Lock())
     {
 	rc = fHeader->DoubleData ;
 	//fHeader->LAM = false; // We picked it up. leave this to the user
@@ -1182,6 +1233,27 @@ bool SharedMem2::GetData( void *data)
 	pLogger->LogError(__FILE__, __LINE__,'I',"GetData." );
     }
 
+    if (fSeqlock)
+    {
+	/*
+	 * No semaphore, copy and check that the writer didn't 
+	 * touch the segment while we were at it. 
+	 */
+	if ((data) && ( fNumberUserBytes>0) && (fUserSM_Segment != NULL))
+	{
+	    uint32_t seq, gen;
+	    do
+	    {
+		seq = ReadBegin();
+		gen = fHeader->Generation;
+		memcpy ( data,  fUserSM_Segment, fNumberUserBytes);
+	    } while (ReadRetry(seq));
+	    fLastGeneration = gen;
+	}
+	SET_DEBUG_STACK;
+	return true;
+    }
+
     rv = sem_wait( fSemaphoreHandle);
     if (rv) 
     {
@@ -1205,6 +1277,7 @@ bool SharedMem2::GetData( void *data)
     if ((data) && ( fNumberUserBytes>0) && (fUserSM_Segment != NULL))
     {
         memcpy ( data,  fUserSM_Segment, fNumberUserBytes);
+	fLastGeneration = fHeader->Generation;
 	ClearError(__LINE__);
     }
 
@@ -1314,7 +1387,15 @@ bool SharedMem2::Unlock(unsigned int Line)
 	pLogger->LogError(__FILE__, Line, 'I', 
 			  "SharedMem2 - Unlock");
     }
+    /* Publish anything written since UpdateTime. */
+    bool Published = fWriting;
+    WriteEnd();
     rv = sem_post( fSemaphoreHandle);
+    if (Published)
+    {
+	/* Wake waiters after the post so they don't block on us. */
+	Notify();
+    }
     if (rv) 
     {
 	if (pLogger)
@@ -1367,11 +1448,21 @@ void SharedMem2::LAM(bool val)
 			  "SharedMem2 - SetLAM");
     }
     
-    if(Lock(__LINE__))
+    if (fSeqlock)
+    {
+	__atomic_store_n(&fHeader->LAM, val, __ATOMIC_RELEASE);
+    }
+    else if(Lock(__LINE__))
     {
 	fHeader->LAM = val;
 	Unlock(__LINE__);
     }
+    if (val)
+    {
+	/* Setting LAM is an update as far as waiters are concerned. */
+	__atomic_add_fetch(&fHeader->Generation, 1, __ATOMIC_SEQ_CST);
+	Notify();
+    }
     
     SET_DEBUG_STACK;
 }
@@ -1410,7 +1501,11 @@ bool SharedMem2::GetLAM(void)
 	pLogger->LogError(__FILE__, __LINE__, 'I', 
 			  "SharedMem2 - GetLAM");
     }
-    if(Lock(__LINE__))
+    if (fSeqlock)
+    {
+	rc = __atomic_load_n(&fHeader->LAM, __ATOMIC_ACQUIRE);
+    }
+    else if(Lock(__LINE__))
     {
 	rc = fHeader->LAM;
 	Unlock(__LINE__);
@@ -1420,3 +1515,603 @@ bool SharedMem2::GetLAM(void)
     return rc;
 }
 
+/**
+ ******************************************************************
+ *
+ * Function Name : WriteBegin
+ *
+ * Description : Open a write section. The caller holds the semaphore
+ *               so there is only ever one writer. In seqlock mode 
+ *               the sequence goes odd which tells readers to wait. 
+ *
+ * Inputs : None
+ *
+ * Returns : None
+ *
+ * Error Conditions : None
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void SharedMem2::WriteBegin(void)
+{
+    if (fWriting)
+    {
+	return;
+    }
+    fWriting = true;
+    if (fSeqlock)
+    {
+	uint32_t seq = __atomic_load_n(&fHeader->Sequence, __ATOMIC_RELAXED);
+	__atomic_store_n(&fHeader->Sequence, seq+1, __ATOMIC_RELAXED);
+	/* Keep the data stores below from moving above the odd store. */
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : WriteEnd
+ *
+ * Description : Close the write section opened by WriteBegin. 
+ *               Bump the generation and in seqlock mode return the 
+ *               sequence to even, releasing the data to the readers.
+ *               Does nothing if no write section is open. 
+ *
+ * Inputs : None
+ *
+ * Returns : None
+ *
+ * Error Conditions : None
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void SharedMem2::WriteEnd(void)
+{
+    if (!fWriting)
+    {
+	return;
+    }
+    __atomic_add_fetch(&fHeader->Generation, 1, __ATOMIC_SEQ_CST);
+    if (fSeqlock)
+    {
+	uint32_t seq = __atomic_load_n(&fHeader->Sequence, __ATOMIC_RELAXED);
+	__atomic_store_n(&fHeader->Sequence, seq+1, __ATOMIC_RELEASE);
+    }
+    fWriting = false;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : ReadBegin
+ *
+ * Description : Seqlock read side. Wait for the sequence to be even,
+ *               no writer active, and return it. Spin for a short
+ *               while then yield, the writer may have been preempted.
+ *
+ * Inputs : None
+ *
+ * Returns : sequence value to hand to ReadRetry
+ *
+ * Error Conditions : None
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+uint32_t SharedMem2::ReadBegin(void) const
+{
+    uint32_t seq;
+    unsigned spin = 0;
+
+    while ((seq = __atomic_load_n(&fHeader->Sequence, __ATOMIC_ACQUIRE)) & 1)
+    {
+	if (++spin > kSPIN_LIMIT)
+	{
+	    sched_yield();
+	    spin = 0;
+	}
+    }
+    return seq;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : ReadRetry
+ *
+ * Description : Seqlock read side. After copying the data check 
+ *               that the sequence didn't move. 
+ *
+ * Inputs : Sequence - value returned by ReadBegin
+ *
+ * Returns : true if the copy was torn and must be done again. 
+ *
+ * Error Conditions : None
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool SharedMem2::ReadRetry(uint32_t Sequence) const
+{
+    /* Keep the data loads above from moving below the check. */
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&fHeader->Sequence, __ATOMIC_RELAXED) != Sequence)
+    {
+	fRetries++;
+	return true;
+    }
+    return false;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : LastUpdate
+ *
+ * Description : Fetch the last update time from the header, under 
+ *               the semaphore or the seqlock depending on the mode. 
+ *
+ * Inputs : Last - filled with the header time
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : When acquiring the semaphore fails. 
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool SharedMem2::LastUpdate(struct timespec &Last)
+{
+    SET_DEBUG_STACK;
+    if (fSeqlock)
+    {
+	uint32_t seq;
+	do
+	{
+	    seq  = ReadBegin();
+	    Last = fHeader->LastUpdateTime;
+	} while (ReadRetry(seq));
+	return true;
+    }
+    if (Lock(__LINE__))
+    {
+	Last = fHeader->LastUpdateTime;
+	return Unlock(__LINE__);
+    }
+    return false;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Generation
+ *
+ * Description : Return the generation counter of the segment. 
+ *               A single atomic load, safe in either mode. 
+ *
+ * Inputs : None
+ *
+ * Returns : generation, zero if not attached
+ *
+ * Error Conditions : None
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+uint32_t SharedMem2::Generation(void) const
+{
+    if (!fHeader)
+    {
+	return 0;
+    }
+    return __atomic_load_n(&fHeader->Generation, __ATOMIC_ACQUIRE);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : NewData
+ *
+ * Description : Cheap check for new data, replaces polling of 
+ *               TimeSinceLastUpdate. 
+ *
+ * Inputs : None
+ *
+ * Returns : true if the generation moved since the last call to 
+ *           NewData or GetData
+ *
+ * Error Conditions : None
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool SharedMem2::NewData(void)
+{
+    uint32_t gen = Generation();
+    if (gen != fLastGeneration)
+    {
+	fLastGeneration = gen;
+	return true;
+    }
+    return false;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : FutexWait
+ *
+ * Description : Sleep in the kernel until the word changes or is 
+ *               woken. The futex is not private since the word is 
+ *               shared between processes. 
+ *
+ * Inputs : Address - word in the shared segment
+ *          Value   - value we expect the word to hold
+ *          Timeout - seconds, negative waits forever
+ *
+ * Returns : false if the timeout expired
+ *
+ * Error Conditions : None
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool SharedMem2::FutexWait(uint32_t *Address, uint32_t Value, double Timeout)
+{
+    struct timespec ts, *pts = NULL;
+    long rc;
+
+    if (Timeout >= 0.0)
+    {
+	ts.tv_sec  = (time_t) Timeout;
+	ts.tv_nsec = (long) ((Timeout - (double) ts.tv_sec) * 1.0e9);
+	pts = &ts;
+    }
+    rc = syscall(SYS_futex, Address, FUTEX_WAIT, Value, pts, NULL, 0);
+    if ((rc == -1) && (errno == ETIMEDOUT))
+    {
+	return false;
+    }
+    /* Woken, value already changed (EAGAIN) or a signal (EINTR). */
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : FutexWake
+ *
+ * Description : Wake all the waiters on the word. 
+ *
+ * Inputs : Address - word in the shared segment
+ *
+ * Returns : None
+ *
+ * Error Conditions : None
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void SharedMem2::FutexWake(uint32_t *Address)
+{
+    syscall(SYS_futex, Address, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : WaitChange
+ *
+ * Description : Sleep on the generation futex until it differs from
+ *               Seen. Register as a waiter before sampling the word 
+ *               so that a writer either sees us or we see its bump. 
+ *
+ * Inputs : Seen    - generation already seen, updated on return
+ *          Timeout - seconds, negative waits forever
+ *
+ * Returns : true if the generation moved, false on timeout
+ *
+ * Error Conditions : None
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool SharedMem2::WaitChange(uint32_t &Seen, double Timeout)
+{
+    struct timespec start, now;
+    uint32_t gen;
+    double   left = Timeout;
+
+    if (!fHeader)
+    {
+	return false;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (true)
+    {
+	__atomic_add_fetch(&fHeader->Waiters, 1, __ATOMIC_SEQ_CST);
+	gen = __atomic_load_n(&fHeader->Generation, __ATOMIC_SEQ_CST);
+	if (gen == Seen)
+	{
+	    FutexWait(&fHeader->Generation, gen, left);
+	    gen = __atomic_load_n(&fHeader->Generation, __ATOMIC_SEQ_CST);
+	}
+	__atomic_sub_fetch(&fHeader->Waiters, 1, __ATOMIC_SEQ_CST);
+
+	if (gen != Seen)
+	{
+	    Seen = gen;
+	    return true;
+	}
+	if (Timeout >= 0.0)
+	{
+	    clock_gettime(CLOCK_MONOTONIC, &now);
+	    left = Timeout - (double)(now.tv_sec - start.tv_sec) - 
+		1.0e-9 * (double)(now.tv_nsec - start.tv_nsec);
+	    if (left <= 0.0)
+	    {
+		return false;
+	    }
+	}
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : WaitForUpdate
+ *
+ * Description : Block until the segment is updated. Replaces 
+ *               polling GetLAM or TimeSinceLastUpdate in a sleep 
+ *               loop. 
+ *
+ * Inputs : Timeout - seconds, negative waits forever
+ *
+ * Returns : true if there is new data, false on timeout
+ *
+ * Error Conditions : NO_OBJECT if not attached
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool SharedMem2::WaitForUpdate(double Timeout)
+{
+    SET_DEBUG_STACK;
+    ClearError(__LINE__);
+    if (!fHeader)
+    {
+	SetError( NO_OBJECT, __LINE__);
+	return false;
+    }
+    return WaitChange(fLastGeneration, Timeout);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Notify
+ *
+ * Description : Wake everyone in WaitChange, skip the system call 
+ *               if nobody is waiting. 
+ *
+ * Inputs : None
+ *
+ * Returns : None
+ *
+ * Error Conditions : None
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void SharedMem2::Notify(void)
+{
+    if (__atomic_load_n(&fHeader->Waiters, __ATOMIC_SEQ_CST) > 0)
+    {
+	FutexWake(&fHeader->Generation);
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : EventFD
+ *
+ * Description : An eventfd can't be shared between processes that 
+ *               didn't fork from one another, so each client gets 
+ *               its own and a thread waits on the shared futex and 
+ *               signals it. 
+ *
+ * Inputs : None
+ *
+ * Returns : descriptor, -1 on failure
+ *
+ * Error Conditions : NO_OBJECT
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+int SharedMem2::EventFD(void)
+{
+    SET_DEBUG_STACK;
+    CLogger *pLogger = CLogger::GetThis();
+
+    if (fEventFD >= 0)
+    {
+	return fEventFD;
+    }
+    if (!fHeader)
+    {
+	SetError( NO_OBJECT, __LINE__);
+	return -1;
+    }
+    fEventFD = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fEventFD < 0)
+    {
+	if (pLogger)
+	{
+	    pLogger->LogError(__FILE__, __LINE__, 'W', 
+			      "SharedMem2 - eventfd failed.");
+	    pLogger->Log("# %s\n", strerror(errno));
+	}
+	SetError( NO_OBJECT, __LINE__);
+	return -1;
+    }
+    __atomic_store_n(&fNotifyRun, true, __ATOMIC_RELEASE);
+    if (pthread_create(&fNotifyThread, NULL, Notifier, this) != 0)
+    {
+	fNotifyRun = false;
+	close(fEventFD);
+	fEventFD = -1;
+	SetError( NO_OBJECT, __LINE__);
+	return -1;
+    }
+    return fEventFD;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : ClearEvent
+ *
+ * Description : Read the eventfd counter back to zero. 
+ *
+ * Inputs : None
+ *
+ * Returns : None
+ *
+ * Error Conditions : None
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void SharedMem2::ClearEvent(void)
+{
+    uint64_t count;
+    if (fEventFD >= 0)
+    {
+	if (read(fEventFD, &count, sizeof(count)) < 0)
+	{
+	    // EAGAIN, nothing pending. 
+	}
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Notifier
+ *
+ * Description : Thread behind EventFD. Keeps its own idea of the 
+ *               generation so it doesn't disturb NewData or 
+ *               WaitForUpdate in the owner. 
+ *
+ * Inputs : pointer to the owning SharedMem2
+ *
+ * Returns : NULL
+ *
+ * Error Conditions : None
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void* SharedMem2::Notifier(void *arg)
+{
+    SharedMem2 *pSM = (SharedMem2 *) arg;
+    uint32_t    Seen = pSM->Generation();
+    uint64_t    one  = 1;
+
+    while (__atomic_load_n(&pSM->fNotifyRun, __ATOMIC_ACQUIRE))
+    {
+	if (pSM->WaitChange(Seen, kNOTIFY_POLL))
+	{
+	    if (write(pSM->fEventFD, &one, sizeof(one)) < 0)
+	    {
+		// Counter saturated, the reader is well behind. 
+	    }
+	}
+    }
+    return NULL;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : StopNotifier
+ *
+ * Description : Stop the EventFD thread, it notices within 
+ *               kNOTIFY_POLL seconds, then close the descriptor. 
+ *
+ * Inputs : None
+ *
+ * Returns : None
+ *
+ * Error Conditions : None
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void SharedMem2::StopNotifier(void)
+{
+    if (fEventFD < 0)
+    {
+	return;
+    }
+    __atomic_store_n(&fNotifyRun, false, __ATOMIC_RELEASE);
+    /* Usually gets it out of the futex at once, others just recheck. */
+    FutexWake(&fHeader->Generation);
+    pthread_join(fNotifyThread, NULL);
+    close(fEventFD);
+    fEventFD = -1;
+}
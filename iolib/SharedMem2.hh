@@ -17,6 +17,15 @@
  * 22-Feb-26   CBL    changed PutData to a const input since it is 
  *                    technically only copied into the SM segment 
  *                    and the memcpy is const
+ * 17-Oct-26   CBL    Optional seqlock mode. The server publishes with 
+ *                    a sequence counter and readers copy out without 
+ *                    touching the semaphore, retrying on a torn read. 
+ *                    Generation counter added to the header. 
+ *                    Futex helpers for derived classes. 
+ *                    WaitForUpdate and EventFD so clients can block 
+ *                    on new data instead of polling LAM. 
+ * 17-Oct-26   CBL    ReadBegin and ReadRetry protected and const so 
+ *                    derived classes can read in place. 
  *
  * Classification : Unclassified
  *
@@ -26,7 +35,9 @@
 #ifndef __SHAREDMEM2_h_
 #define __SHAREDMEM2_h_
 #include <time.h>
+#include <stdint.h>
 #include <semaphore.h>
+#include <pthread.h>
 #include <CObject.hh>  // parent class
 
 /**
@@ -38,6 +49,10 @@ struct MyMemoryHeader {
     struct timespec LastUpdateTime; // Last time SM was updated
     double DoubleData;              // Default Double Data.
     bool   LAM;     // Look at me. Set when we want client to take notice.
+    bool   Seqlock; // Set by server, readers use Sequence not semaphore
+    uint32_t Sequence;   // Seqlock counter, odd while a write is underway
+    uint32_t Generation; // Incremented on every update, also a futex word
+    uint32_t Waiters;    // Processes asleep on Generation
 };
 /**
  * Class to share data between applications. 
@@ -46,7 +61,12 @@ struct MyMemoryHeader {
  *     1) size_t   - length of allocated shared memory.
  *     2) timespec - time of last access, automatically updated on PutData 
  *     3) double   - Default user space, there even if 0 user bytes allocated. 
+ *     4) LAM, seqlock flag, sequence and generation counters. 
  *
+ * In seqlock mode the writer still takes the semaphore (so that 
+ * multiple writers are serialized) but readers never do. A reader 
+ * copies the data out and retries if the sequence counter was odd
+ * or changed while it was copying. 
  */
 class SharedMem2 : public CObject
 {
@@ -68,8 +88,12 @@ public:
      * UserSize - number of bytes requested by user for their payload
      * Server - Set to true if I am creating the user space, false for
      *          attaching to existing user space. 
+     * Seqlock - Server only, publish with a sequence counter so readers
+     *           never take the semaphore. Clients pick the mode up 
+     *           from the header. 
      */
-    SharedMem2(const char *Name, size_t UserSize=0, bool Server=false, int DebugLevel = 0);
+    SharedMem2(const char *Name, size_t UserSize=0, bool Server=false, 
+	       int DebugLevel = 0, bool Seqlock=false);
 
     /**
      * Updates the access time of the shared memory
@@ -77,6 +101,8 @@ public:
      * area where we should start writing. 
      * Set KeepLocked to true if we want to write stuff after 
      * updating time. The user will be responsible for Unlock.
+     * In seqlock mode the write is not visible to readers until 
+     * Unlock is called. 
      */
     bool UpdateTime(bool KeepLocked = false);
 
@@ -152,6 +178,44 @@ public:
      */
     bool GetLAM(void);
 
+    /**
+     * Generation counter of the segment, bumped on every update. 
+     * This is a single load, no semaphore. 
+     */
+    uint32_t Generation(void) const;
+    /**
+     * true if the generation has changed since the last call to 
+     * NewData or GetData. 
+     */
+    bool NewData(void);
+    /**
+     * Block until the segment is updated (PutData, UpdateTime or 
+     * SetLAM) or Timeout seconds pass. A negative Timeout waits 
+     * forever. Returns true at once if there was an update since the 
+     * last NewData, GetData or WaitForUpdate. false on timeout. 
+     */
+    bool WaitForUpdate(double Timeout = -1.0);
+    /**
+     * A descriptor that polls readable when the segment is updated, 
+     * so it can sit in a poll/select with sockets and serial ports. 
+     * Call ClearEvent after it fires. The first call starts a small 
+     * notifier thread, returns -1 on failure. 
+     */
+    int  EventFD(void);
+    /**
+     * Drain the EventFD so that it can fire again. 
+     */
+    void ClearEvent(void);
+
+    /**
+     * true if the segment is published in seqlock mode. 
+     */
+    inline bool Seqlock(void) const {return fSeqlock;};
+    /**
+     * Number of times a seqlock read had to be repeated because 
+     * the writer was active. 
+     */
+    inline uint64_t NRetries(void) const {return fRetries;};
 
     inline void*  GetROSharedMemoryAddress() const { return fUserSM_Segment;};
     inline size_t GetLength() const {return fHeader->Length;};
@@ -160,6 +224,29 @@ public:
 		   NO_VIEW, NO_MAP,
 		   NO_SEMAPHORE, NO_SEMAPHORE_MAP, NO_CONNECT, NO_ATTACH,
 		   NO_SEM_RELEASE, NO_MEMUNMAP, NO_CLOSE, NO_UNLINK};
+protected:
+    /**
+     * Block until the 32 bit word at Address no longer holds Value,
+     * someone calls FutexWake on it, or Timeout seconds pass. 
+     * A negative Timeout waits forever. The word must live in the 
+     * shared segment. Returns false on timeout. 
+     */
+    static bool FutexWait(uint32_t *Address, uint32_t Value, double Timeout);
+    /**
+     * Wake every process waiting on the word at Address. 
+     */
+    static void FutexWake(uint32_t *Address);
+    /**
+     * Seqlock read side, wait for an even sequence and return it. 
+     * For derived classes that read the segment in place, the 
+     * server must have been created with Seqlock true. 
+     */
+    uint32_t ReadBegin(void) const;
+    /**
+     * Seqlock read side, true if the copy must be repeated. 
+     */
+    bool ReadRetry(uint32_t Sequence) const;
+
 private:
     /**
      * Name of shared memory. 
@@ -204,6 +291,33 @@ private:
     // Semaphore data
     sem_t*         fSemaphoreHandle;
 
+    /**
+     * Seqlock mode, copied from the header for clients. 
+     */
+    bool     fSeqlock;
+    /**
+     * true between WriteBegin and WriteEnd. 
+     */
+    bool     fWriting;
+    /**
+     * Generation the last time we looked. 
+     */
+    uint32_t fLastGeneration;
+    /**
+     * Count of torn seqlock reads. 
+     */
+    mutable uint64_t fRetries;
+
+    /**
+     * eventfd handed out by EventFD, -1 if not in use. 
+     */
+    int       fEventFD;
+    /**
+     * Thread that turns futex wakeups into eventfd writes. 
+     */
+    pthread_t fNotifyThread;
+    bool      fNotifyRun;
+
     /*
      * Helper functions.
      */
@@ -225,5 +339,33 @@ private:
      * Client side clean up. 
      */
     void DetachSpace(void);
+    /**
+     * Open a write section, call with the semaphore held. 
+     */
+    void WriteBegin(void);
+    /**
+     * Close the write section, bump the generation. 
+     */
+    void WriteEnd(void);
+    /**
+     * Fetch the last update time in either mode. 
+     */
+    bool LastUpdate(struct timespec &Last);
+    /**
+     * Wait for Generation to move past Seen, update Seen. 
+     */
+    bool WaitChange(uint32_t &Seen, double Timeout);
+    /**
+     * Wake anyone in WaitChange. 
+     */
+    void Notify(void);
+    /**
+     * EventFD thread. 
+     */
+    static void* Notifier(void *);
+    /**
+     * Stop the EventFD thread and close the descriptor. 
+     */
+    void StopNotifier(void);
 };
 #endif
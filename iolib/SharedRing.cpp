@@ -0,0 +1,599 @@
+/********************************************************************
+ *
+ * Module Name : SharedRing.cpp
+ *
+ * Author/Date : C.B. Lirakis / 17-Oct-26
+ *
+ * Description : Multi-slot ring buffer in shared memory.
+ *
+ * Layout of the SharedMem2 user payload:
+ *     RingHeader      - padded to a cache line
+ *     RingConsumer[]  - MaxConsumers entries, one cache line each
+ *     Slots           - NSlots of RingSlot + SlotSize, cache line stride
+ *
+ * The producer marks a slot busy, copies the record in, stamps the
+ * slot with the record sequence and then advances Head. A consumer
+ * checks the slot sequence before and after its copy, if either
+ * doesn't match its cursor the producer lapped it and the record
+ * is counted as an overrun.
+ *
+ * Restrictions/Limitations : One producer per ring.
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *   futex(2)
+ *
+ ********************************************************************/
+// System includes.
+#include <iostream>
+using namespace std;
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <time.h>
+
+// Local Includes.
+#include "SharedRing.hh"
+#include "debug.h"
+#include "CLogger.hh"
+
+static const uint32_t kRING_MAGIC = 0x474E4952; // "RING"
+static const uint64_t kSLOT_BUSY  = ~(uint64_t)0;
+static const size_t   kLINE       = 64;
+
+/* Round n up to a multiple of the cache line. */
+static inline size_t LineUp(size_t n) {return (n + kLINE - 1) & ~(kLINE-1);}
+
+/********************************************************************
+ *
+ * Function Name : SharedRing Constructor
+ *
+ * Description : Create (producer) or attach to (consumer) the ring.
+ *
+ * Inputs : Name         - shared memory name
+ *          NSlots       - producer, number of slots, rounded to 2^n
+ *          SlotSize     - producer, maximum bytes per record
+ *          Producer     - true to create the ring
+ *          MaxConsumers - producer, size of the consumer table
+ *          DebugLevel   -
+ *
+ * Returns : constructed class
+ *
+ * Error Conditions : NO_RING if the segment isn't a ring,
+ *                    NO_CONSUMER if the consumer table is full.
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+SharedRing::SharedRing(const char *Name, uint32_t NSlots, uint32_t SlotSize,
+		       bool Producer, uint32_t MaxConsumers, int DebugLevel) :
+    SharedMem2(Name,
+	       Producer ? RingBytes(PowerOf2(NSlots), SlotSize, MaxConsumers):0,
+	       Producer, DebugLevel)
+{
+    SET_DEBUG_STACK;
+    CLogger *pLogger = CLogger::GetThis();
+    unsigned char *p;
+
+    SetName("SharedRing");
+    fRing      = NULL;
+    fConsumers = NULL;
+    fSlots     = NULL;
+    fMe        = NULL;
+    fCursor    = 0;
+    fMask      = 0;
+    fProducer  = Producer;
+
+    if (Error() != NO_ERROR)
+    {
+	// SharedMem2 already logged it.
+	return;
+    }
+
+    p     = (unsigned char *) GetROSharedMemoryAddress();
+    fRing = (struct RingHeader *) p;
+
+    if (fProducer)
+    {
+	memset( fRing, 0, sizeof(struct RingHeader));
+	fRing->NSlots       = PowerOf2(NSlots);
+	fRing->SlotSize     = SlotSize;
+	fRing->SlotStride   = LineUp(sizeof(struct RingSlot) + SlotSize);
+	fRing->MaxConsumers = MaxConsumers;
+    }
+    else if ((GetLength() < sizeof(struct MyMemoryHeader) +
+	      sizeof(struct RingHeader)) ||
+	     (__atomic_load_n(&fRing->Magic, __ATOMIC_ACQUIRE) != kRING_MAGIC))
+    {
+	fRing = NULL;
+	if (pLogger)
+	{
+	    pLogger->LogError(__FILE__, __LINE__, 'F',
+			      "SharedRing - segment is not a ring.");
+	}
+	SetError( NO_RING, __LINE__);
+	return;
+    }
+
+    p         += LineUp(sizeof(struct RingHeader));
+    fConsumers = (struct RingConsumer *) p;
+    p         += fRing->MaxConsumers * sizeof(struct RingConsumer);
+    fSlots     = p;
+    fMask      = fRing->NSlots - 1;
+
+    if (fProducer)
+    {
+	memset( fConsumers, 0,
+		fRing->MaxConsumers * sizeof(struct RingConsumer));
+	for (uint64_t i=0; i<fRing->NSlots; i++)
+	{
+	    /* Nothing has been written, make sure no slot matches. */
+	    Slot(i)->Sequence = kSLOT_BUSY;
+	}
+	/* Publish, consumers check this on attach. */
+	__atomic_store_n(&fRing->Magic, kRING_MAGIC, __ATOMIC_RELEASE);
+    }
+    else
+    {
+	Register();
+    }
+    SET_DEBUG_STACK;
+}
+/********************************************************************
+ *
+ * Function Name : SharedRing Destructor
+ *
+ * Description : Give back the consumer entry, SharedMem2 does the
+ *               rest.
+ *
+ * Inputs : None
+ *
+ * Returns : None
+ *
+ * Error Conditions : None
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+SharedRing::~SharedRing(void)
+{
+    SET_DEBUG_STACK;
+    if (fMe)
+    {
+	__atomic_store_n(&fMe->Pid, 0, __ATOMIC_RELEASE);
+	fMe = NULL;
+    }
+}
+/********************************************************************
+ *
+ * Function Name : RingBytes
+ *
+ * Description : How much user payload to ask SharedMem2 for.
+ *
+ * Inputs : NSlots, SlotSize, MaxConsumers
+ *
+ * Returns : bytes
+ *
+ * Error Conditions : None
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+size_t SharedRing::RingBytes(uint32_t NSlots, uint32_t SlotSize,
+			     uint32_t MaxConsumers)
+{
+    return LineUp(sizeof(struct RingHeader)) +
+	MaxConsumers * sizeof(struct RingConsumer) +
+	(size_t) NSlots * LineUp(sizeof(struct RingSlot) + SlotSize);
+}
+/********************************************************************
+ *
+ * Function Name : PowerOf2
+ *
+ * Description : Round up to the next power of two, at least 2.
+ *
+ * Inputs : n
+ *
+ * Returns : power of two >= n
+ *
+ * Error Conditions : None
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+uint32_t SharedRing::PowerOf2(uint32_t n)
+{
+    uint32_t rc = 2;
+    while (rc < n)
+    {
+	rc <<= 1;
+    }
+    return rc;
+}
+/********************************************************************
+ *
+ * Function Name : Register
+ *
+ * Description : Claim a free entry in the consumer table. An entry
+ *               whose process has died is reclaimed. The cursor
+ *               starts at the current head, we only see records
+ *               written after we attached.
+ *
+ * Inputs : None
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : NO_CONSUMER if the table is full.
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool SharedRing::Register(void)
+{
+    SET_DEBUG_STACK;
+    CLogger *pLogger = CLogger::GetThis();
+    int32_t  me = getpid();
+    int32_t  pid;
+    struct RingConsumer *c;
+
+    for (uint32_t i=0; i<fRing->MaxConsumers; i++)
+    {
+	c   = &fConsumers[i];
+	pid = __atomic_load_n(&c->Pid, __ATOMIC_ACQUIRE);
+	if ((pid != 0) &&
+	    ((kill(pid, 0) == 0) || (errno != ESRCH)))
+	{
+	    continue;   // In use by a live process.
+	}
+	if (__atomic_compare_exchange_n(&c->Pid, &pid, me, false,
+					__ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+	{
+	    fMe         = c;
+	    fCursor     = __atomic_load_n(&fRing->Head, __ATOMIC_ACQUIRE);
+	    fMe->Overruns = 0;
+	    __atomic_store_n(&fMe->Cursor, fCursor, __ATOMIC_RELEASE);
+	    return true;
+	}
+    }
+    if (pLogger)
+    {
+	pLogger->LogError(__FILE__, __LINE__, 'W',
+			  "SharedRing - consumer table full.");
+    }
+    SetError( NO_CONSUMER, __LINE__);
+    return false;
+}
+/********************************************************************
+ *
+ * Function Name : Put
+ *
+ * Description : Producer, write one record. Never blocks, a consumer
+ *               that has fallen NSlots behind loses the oldest.
+ *
+ * Inputs : Data   - record
+ *          Length - bytes, 0 for SlotSize
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : NOT_PRODUCER, TOO_BIG
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool SharedRing::Put(const void *Data, uint32_t Length)
+{
+    struct RingSlot *slot;
+    uint64_t head;
+
+    if (!fProducer || !fRing)
+    {
+	SetError( NOT_PRODUCER, __LINE__);
+	return false;
+    }
+    if (Length == 0)
+    {
+	Length = fRing->SlotSize;
+    }
+    if (Length > fRing->SlotSize)
+    {
+	SetError( TOO_BIG, __LINE__);
+	return false;
+    }
+
+    head = __atomic_load_n(&fRing->Head, __ATOMIC_RELAXED);
+    slot = Slot(head);
+
+    /* Anyone still copying the previous occupant will see this. */
+    __atomic_store_n(&slot->Sequence, kSLOT_BUSY, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy( slot+1, Data, Length);
+    slot->Length = Length;
+    __atomic_store_n(&slot->Sequence, head, __ATOMIC_RELEASE);
+
+    __atomic_store_n(&fRing->Head, head+1, __ATOMIC_RELEASE);
+    __atomic_store_n(&fRing->Futex, (uint32_t)(head+1), __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&fRing->Waiters, __ATOMIC_SEQ_CST) > 0)
+    {
+	FutexWake(&fRing->Futex);
+    }
+    return true;
+}
+/********************************************************************
+ *
+ * Function Name : Get
+ *
+ * Description : Consumer, copy out the next record. If the producer
+ *               lapped us, skip ahead to the oldest record still in
+ *               the ring and count what we lost.
+ *
+ * Inputs : Data    - where to put the record, SlotSize bytes
+ *          Length  - if not NULL, record size
+ *          Timeout - seconds to wait, 0 none, negative forever
+ *
+ * Returns : true if a record was copied
+ *
+ * Error Conditions : NOT_CONSUMER
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool SharedRing::Get(void *Data, uint32_t *Length, double Timeout)
+{
+    struct RingSlot *slot;
+    uint64_t head, lost;
+    uint32_t len;
+
+    if (!fMe)
+    {
+	SetError( NOT_CONSUMER, __LINE__);
+	return false;
+    }
+
+    while (true)
+    {
+	head = __atomic_load_n(&fRing->Head, __ATOMIC_ACQUIRE);
+	if (head == fCursor)
+	{
+	    if ((Timeout == 0.0) || !Wait(Timeout))
+	    {
+		return false;
+	    }
+	    /* Only wait once, Wait handles spurious wakeups. */
+	    Timeout = 0.0;
+	    continue;
+	}
+
+	lost = 0;
+	if (head - fCursor > fRing->NSlots)
+	{
+	    lost    = head - fCursor - fRing->NSlots;
+	    fCursor = head - fRing->NSlots;
+	}
+
+	slot = Slot(fCursor);
+	if (__atomic_load_n(&slot->Sequence, __ATOMIC_ACQUIRE) == fCursor)
+	{
+	    len = slot->Length;
+	    if (len > fRing->SlotSize)
+	    {
+		len = fRing->SlotSize;  // Torn, caught below.
+	    }
+	    memcpy( Data, slot+1, len);
+	    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+	    if (__atomic_load_n(&slot->Sequence, __ATOMIC_RELAXED) == fCursor)
+	    {
+		fCursor++;
+		__atomic_store_n(&fMe->Cursor, fCursor, __ATOMIC_RELEASE);
+		if (lost)
+		{
+		    fMe->Overruns += lost;
+		    __atomic_add_fetch(&fRing->Overruns, lost,
+				       __ATOMIC_RELAXED);
+		}
+		if (Length)
+		{
+		    *Length = len;
+		}
+		return true;
+	    }
+	}
+	/* Overwritten under us. */
+	lost++;
+	fCursor++;
+	fMe->Overruns += lost;
+	__atomic_add_fetch(&fRing->Overruns, lost, __ATOMIC_RELAXED);
+	__atomic_store_n(&fMe->Cursor, fCursor, __ATOMIC_RELEASE);
+    }
+    return false;
+}
+/********************************************************************
+ *
+ * Function Name : Wait
+ *
+ * Description : Consumer, sleep on the ring futex until there is
+ *               something to read.
+ *
+ * Inputs : Timeout - seconds, negative forever
+ *
+ * Returns : true if a record is available
+ *
+ * Error Conditions : None
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool SharedRing::Wait(double Timeout)
+{
+    struct timespec now, end;
+    uint32_t value;
+    double   left = Timeout;
+
+    if (!fMe)
+    {
+	SetError( NOT_CONSUMER, __LINE__);
+	return false;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    while (__atomic_load_n(&fRing->Head, __ATOMIC_ACQUIRE) == fCursor)
+    {
+	/*
+	 * Announce ourselves before sampling the futex word, then
+	 * look at Head once more. Either Put sees the waiter or we
+	 * see the new Head, no wakeup is lost.
+	 */
+	__atomic_add_fetch(&fRing->Waiters, 1, __ATOMIC_SEQ_CST);
+	value = __atomic_load_n(&fRing->Futex, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&fRing->Head, __ATOMIC_ACQUIRE) == fCursor)
+	{
+	    FutexWait(&fRing->Futex, value, left);
+	}
+	__atomic_sub_fetch(&fRing->Waiters, 1, __ATOMIC_SEQ_CST);
+
+	if (Timeout >= 0.0)
+	{
+	    clock_gettime(CLOCK_MONOTONIC, &now);
+	    left = Timeout - (double)(now.tv_sec - end.tv_sec) -
+		1.0e-9 * (double)(now.tv_nsec - end.tv_nsec);
+	    if (left <= 0.0)
+	    {
+		break;
+	    }
+	}
+    }
+    return (__atomic_load_n(&fRing->Head, __ATOMIC_ACQUIRE) != fCursor);
+}
+/********************************************************************
+ *
+ * Function Name : Available
+ *
+ * Description : Records waiting for this consumer.
+ *
+ * Inputs : None
+ *
+ * Returns : count, at most NSlots
+ *
+ * Error Conditions : None
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+uint64_t SharedRing::Available(void) const
+{
+    uint64_t n;
+    if (!fMe)
+    {
+	return 0;
+    }
+    n = __atomic_load_n(&fRing->Head, __ATOMIC_ACQUIRE) - fCursor;
+    return (n > fRing->NSlots) ? fRing->NSlots : n;
+}
+/********************************************************************
+ *
+ * Function Name : Overruns
+ *
+ * Description : Records this consumer lost.
+ *
+ * Inputs : None
+ *
+ * Returns : count
+ *
+ * Error Conditions : None
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+uint64_t SharedRing::Overruns(void) const
+{
+    return fMe ? fMe->Overruns : 0;
+}
+/********************************************************************
+ *
+ * Function Name : TotalOverruns
+ *
+ * Description : Records lost, all consumers.
+ *
+ * Inputs : None
+ *
+ * Returns : count
+ *
+ * Error Conditions : None
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+uint64_t SharedRing::TotalOverruns(void) const
+{
+    return fRing ? __atomic_load_n(&fRing->Overruns, __ATOMIC_RELAXED) : 0;
+}
+/********************************************************************
+ *
+ * Function Name : NWritten
+ *
+ * Description : Records written by the producer.
+ *
+ * Inputs : None
+ *
+ * Returns : count
+ *
+ * Error Conditions : None
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+uint64_t SharedRing::NWritten(void) const
+{
+    return fRing ? __atomic_load_n(&fRing->Head, __ATOMIC_ACQUIRE) : 0;
+}
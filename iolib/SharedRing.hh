@@ -0,0 +1,162 @@
+/********************************************************************
+ *
+ * Module Name : SharedRing.hh
+ *
+ * Author/Date : C.B. Lirakis / 17-Oct-26
+ *
+ * Description : Multi-slot ring buffer in shared memory.
+ * Built on SharedMem2, the ring lives in the user payload. One
+ * producer writes fixed size slots, any number of consumers (up to
+ * the number given at creation) each keep their own read cursor so
+ * a slow reader doesn't steal data from a fast one.
+ *
+ * The producer never blocks. If a consumer falls more than NSlots
+ * behind, the records it missed are added to its overrun counter
+ * and it picks up at the oldest record still in the ring.
+ *
+ * Consumers sleep on a futex in the ring header rather than polling.
+ *
+ * Restrictions/Limitations :
+ *    Linux only (futex).
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ ********************************************************************/
+#ifndef __SHAREDRING_hh_
+#define __SHAREDRING_hh_
+#include <stdint.h>
+#include "SharedMem2.hh"
+
+/**
+ * Fixed header at the start of the user payload.
+ */
+struct RingHeader {
+    uint32_t Magic;        // kRING_MAGIC once the producer is ready
+    uint32_t NSlots;       // Power of 2
+    uint32_t SlotSize;     // Maximum user bytes per slot
+    uint32_t SlotStride;   // Bytes between slots
+    uint32_t MaxConsumers; // Size of the consumer table
+    uint32_t Pad;
+    uint64_t Head;         // Sequence of the next record to be written
+    uint64_t Overruns;     // Sum of all consumer overruns
+    uint32_t Futex;        // Low 32 bits of Head, consumers wait on this
+    uint32_t Waiters;      // Number of consumers asleep on Futex
+};
+
+/**
+ * One per consumer, lets the producer or a monitor see who is
+ * attached and how far behind they are.
+ */
+struct RingConsumer {
+    int32_t  Pid;          // Owning process, 0 if free
+    uint32_t Pad;
+    uint64_t Cursor;       // Sequence of the next record to read
+    uint64_t Overruns;     // Records this consumer missed
+    uint64_t Fill[5];      // Pad to a cache line, cursors move a lot
+};
+
+/**
+ * Each slot carries its own sequence so a reader can tell if the
+ * producer lapped it during the copy.
+ */
+struct RingSlot {
+    uint64_t Sequence;     // Record in this slot, kSLOT_BUSY while writing
+    uint32_t Length;       // User bytes in this slot
+    uint32_t Pad;
+};
+
+class SharedRing : public SharedMem2
+{
+public:
+    /**
+     * Producer: Producer true, NSlots rounded up to a power of 2,
+     *           SlotSize maximum bytes per record.
+     * Consumer: only the name is needed, the geometry comes from
+     *           the segment.
+     */
+    SharedRing(const char *Name, uint32_t NSlots=0, uint32_t SlotSize=0,
+	       bool Producer=false, uint32_t MaxConsumers=8,
+	       int DebugLevel=0);
+    /**
+     * Release the consumer entry.
+     */
+    ~SharedRing(void);
+
+    /**
+     * Producer. Copy one record into the next slot and wake any
+     * sleeping consumers. Length 0 means SlotSize.
+     */
+    bool Put(const void *Data, uint32_t Length=0);
+
+    /**
+     * Consumer. Copy the next record out, Data must hold SlotSize
+     * bytes. Timeout in seconds, 0 returns at once, negative waits
+     * forever. Returns false if nothing arrived in time.
+     * Length, if given, is filled with the record size.
+     */
+    bool Get(void *Data, uint32_t *Length=NULL, double Timeout=0.0);
+
+    /**
+     * Consumer. Sleep until a record is available or Timeout
+     * seconds pass. true if a record is available.
+     */
+    bool Wait(double Timeout);
+
+    /**
+     * Consumer. Records waiting to be read, at most NSlots.
+     */
+    uint64_t Available(void) const;
+
+    /**
+     * Consumer. Records this consumer has lost to overruns.
+     */
+    uint64_t Overruns(void) const;
+    /**
+     * Records lost over all consumers.
+     */
+    uint64_t TotalOverruns(void) const;
+    /**
+     * Total records written by the producer.
+     */
+    uint64_t NWritten(void) const;
+
+    inline uint32_t NSlots(void)   const {return fRing ? fRing->NSlots : 0;};
+    inline uint32_t SlotSize(void) const {return fRing ? fRing->SlotSize:0;};
+    inline bool     Producer(void) const {return fProducer;};
+
+    enum RING_Errors{NO_RING=NO_UNLINK+1, NO_CONSUMER, NOT_PRODUCER,
+		     NOT_CONSUMER, TOO_BIG};
+
+private:
+    /**
+     * Bytes of user payload needed for the ring.
+     */
+    static size_t RingBytes(uint32_t NSlots, uint32_t SlotSize,
+			    uint32_t MaxConsumers);
+    /**
+     * Round up to a power of two.
+     */
+    static uint32_t PowerOf2(uint32_t n);
+
+    /**
+     * Claim an entry in the consumer table.
+     */
+    bool Register(void);
+
+    inline struct RingSlot *Slot(uint64_t Sequence) const
+    { return (struct RingSlot *)(fSlots +
+			(Sequence & fMask) * (size_t)fRing->SlotStride);};
+
+    struct RingHeader   *fRing;      // Ring header in the payload
+    struct RingConsumer *fConsumers; // Consumer table
+    unsigned char       *fSlots;     // First slot
+    struct RingConsumer *fMe;        // Our entry, consumers only
+    uint64_t             fCursor;    // Local copy of fMe->Cursor
+    uint64_t             fMask;      // NSlots-1
+    bool                 fProducer;
+};
+#endif
@@ -9,6 +9,7 @@
  * Restrictions/Limitations :
  *
  * Change Descriptions :
+ * 17-Oct-26 CBL Point at NetServer for many clients.
  *
  * Classification : Unclassified
  *
@@ -31,6 +32,7 @@
 #define __NETIO_hh_
 
 // Allow no more than 5 simultaneous connections. 
+// NetServer.hh serves many clients without blocking.
 const int MAX_CONNECTIONS = 5;
 
 class NetIO {
@@ -30,6 +30,8 @@
  * Change Descriptions :
  * 03-Mar-24 CBL Changed buffered and removed hex dump in favor of << 
  *               operator overload
+ * 17-Oct-26 CBL Position, velocity and DOPs decoded with one
+ *               Buffered::GetArray each.
  *
  * Classification : Unclassified
  *
@@ -533,10 +535,12 @@ int Lassen::DecodeFixData ()
     fSStatus->Solution(FixMode);
     NSV    = (FixMode >> 4) & 0x0F;
     fSStatus->NSV(NSV);
-    fSStatus->PDOP(fBuffer->GetSingle());
-    fSStatus->HDOP(fBuffer->GetSingle());
-    fSStatus->VDOP(fBuffer->GetSingle());
-    fSStatus->TDOP(fBuffer->GetSingle());
+    float dop[4] = {0.0, 0.0, 0.0, 0.0};
+    fBuffer->GetArray(dop, 4);
+    fSStatus->PDOP(dop[0]);
+    fSStatus->HDOP(dop[1]);
+    fSStatus->VDOP(dop[2]);
+    fSStatus->TDOP(dop[3]);
     SET_DEBUG_STACK;
 
     // NSV should be limited between
@@ -912,13 +916,15 @@ int Lassen::Decode_PositionSingle (void)
 
     fLLPosition->Stamp();
     fLLPosition->Valid(true);
-    fLLPosition->Latitude(fBuffer->GetSingle());
-    fLLPosition->Longitude(fBuffer->GetSingle());
-    fLLPosition->Altitude(fBuffer->GetSingle());
-    fLLPosition->ClockBias(fBuffer->GetSingle());
+    float val[5] = {0.0, 0.0, 0.0, 0.0, 0.0};
+    fBuffer->GetArray(val, 5);
+    fLLPosition->Latitude(val[0]);
+    fLLPosition->Longitude(val[1]);
+    fLLPosition->Altitude(val[2]);
+    fLLPosition->ClockBias(val[3]);
     // 01-Jan-06 This could be double depending on how this is setup. 
     // Unlikely for our version of firmware.
-    fLLPosition->Seconds(fBuffer->GetSingle());
+    fLLPosition->Seconds(val[4]);
 
     SET_DEBUG_STACK;
     return ExpectedBytes; 
@@ -949,10 +955,12 @@ int Lassen::Decode_PositionDouble (void)
     fError = NO_DECODE_ERROR;
     fLLPosition->Stamp();
     fLLPosition->Valid(true);
-    fLLPosition->Latitude(fBuffer->GetDouble());
-    fLLPosition->Longitude(fBuffer->GetDouble());
-    fLLPosition->Altitude(fBuffer->GetDouble());
-    fLLPosition->ClockBias(fBuffer->GetDouble()); // Clock bias
+    double val[4] = {0.0, 0.0, 0.0, 0.0};
+    fBuffer->GetArray(val, 4);
+    fLLPosition->Latitude(val[0]);
+    fLLPosition->Longitude(val[1]);
+    fLLPosition->Altitude(val[2]);
+    fLLPosition->ClockBias(val[3]); // Clock bias
     // 01-Jan-06 This could be double depending on how this is setup. 
     // Unlikely for our version of firmware.
     fLLPosition->Seconds(fBuffer->GetSingle());  // time of fix.
@@ -985,13 +993,15 @@ int Lassen::Decode_VelocityENU ()
     fError = NO_DECODE_ERROR;
 
     fENUVelocity->Stamp();
-    fENUVelocity->East(fBuffer->GetSingle());
-    fENUVelocity->North(fBuffer->GetSingle());
-    fENUVelocity->Up(fBuffer->GetSingle());
-    fENUVelocity->ClockBiasRate(fBuffer->GetSingle());
+    float val[5] = {0.0, 0.0, 0.0, 0.0, 0.0};
+    fBuffer->GetArray(val, 5);
+    fENUVelocity->East(val[0]);
+    fENUVelocity->North(val[1]);
+    fENUVelocity->Up(val[2]);
+    fENUVelocity->ClockBiasRate(val[3]);
     // 01-Jan-06 This could be double depending on hos this is setup. 
     // Unlikely for our version of firmware.
-    fENUVelocity->Seconds(fBuffer->GetSingle());
+    fENUVelocity->Seconds(val[4]);
     
     SET_DEBUG_STACK;
     return ExpectedBytes;
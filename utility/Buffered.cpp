@@ -9,6 +9,7 @@
  * Restrictions/Limitations :
  *
  * Change Descriptions :
+ * 17-Oct-26 CBL Ring buffer, see Buffered.hh.
  *
  * Classification : Unclassified
  *
@@ -24,6 +25,7 @@
 #include <cstring>
 #include <cstdlib>
 #include <iomanip>
+#include <algorithm>
 using namespace std;
 #ifdef __APPLE__
 #  include <sys/time.h>
@@ -56,10 +58,20 @@ using namespace std;
 Buffered::Buffered (unsigned short N)
 {
     SET_DEBUG_STACK;
-    fdata           = new unsigned char[N];
-    fdrain          = fdata;
-    fFillIndex      = 0;
+    // Storage is the next power of 2, holds at most N.
+    fMask           = 1;
+    while (fMask < N)
+    {
+	fMask <<= 1;
+    }
+    fdata           = new unsigned char[fMask];
+    fMask          -= 1;
     fSize           = N;
+    fHead           = 0;
+    fTail           = 0;
+    fBusy           = false;
+    fError          = kERROR_NONE;
+    fTimeStamp      = 0;
     UpdateNow();
     SET_DEBUG_STACK;
 }
@@ -87,7 +99,7 @@ Buffered::Buffered (unsigned short N)
 Buffered::~Buffered (void)
 {
     SET_DEBUG_STACK;
-    delete fdata;
+    delete [] fdata;
 }
 
 /**
@@ -99,9 +111,9 @@ Buffered::~Buffered (void)
  *
  * Inputs : val - byte to store. 
  *
- * Returns : current buffer pointer
+ * Returns : number of bytes in the buffer
  *
- * Error Conditions :
+ * Error Conditions : kBUFFER_OVERFLOW if full, the byte is dropped
  * 
  * Unit Tested on: 
  *
@@ -115,21 +127,18 @@ int32_t Buffered::Put(unsigned char val)
     SET_DEBUG_STACK;
     fError = kERROR_NONE;
 
-    // First character put, timestamp on this sentance. 
-    if (fFillIndex == 0)
-	UpdateNow();
-
-    // Last time buffer was touched. 
-    fTimeStamp = clock();
-    
-    fdata[fFillIndex] = val;
-    fFillIndex        = (fFillIndex+1)%fSize;
-    if (fFillIndex == 0)
+    if (Count() >= fSize)
     {
 	fError = kBUFFER_OVERFLOW;
+	return Count();
     }
-    SET_DEBUG_STACK;
-    return fFillIndex;
+    // First character put, timestamp on this sentance. 
+    if (fHead == fTail)
+    {
+	UpdateNow();
+    }
+    fdata[fHead++ & fMask] = val;
+    return Count();
 }
 /**
  ******************************************************************
@@ -138,11 +147,12 @@ int32_t Buffered::Put(unsigned char val)
  *
  * Description : put one big buffer into this format. 
  *
- * Inputs :
+ * Inputs : b - data
+ *          s - number of bytes
  *
- * Returns :
+ * Returns : number of bytes in the buffer
  *
- * Error Conditions :
+ * Error Conditions : kBUFFER_OVERFLOW if it didn't all fit
  * 
  * Unit Tested on: 
  *
@@ -154,13 +164,183 @@ int32_t Buffered::Put(unsigned char val)
 int Buffered::PutBuffer(unsigned char *b, size_t s)
 {
     SET_DEBUG_STACK;
+    struct iovec seg[2];
+    int          nseg = WriteSegments(seg);
+    size_t       n;
+
     fError = kERROR_NONE;
-    UpdateNow();
-    memcpy(fdata, b, s);
-    fdrain = fdata;
-    fFillIndex += s;
+    for (int i=0; (i<nseg) && (s>0); i++)
+    {
+	n = std::min(s, seg[i].iov_len);
+	memcpy(seg[i].iov_base, b, n);
+	Commit(n);
+	b += n;
+	s -= n;
+    }
+    if (s > 0)
+    {
+	fError = kBUFFER_OVERFLOW;
+    }
+    return Count();
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : WriteSegments
+ *
+ * Description : Describe the free space after the head, wrapping
+ *               once at the end of storage. 
+ *
+ * Inputs : Segment - filled with up to two iovecs
+ *
+ * Returns : number of segments, 0 if the buffer is full
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+int Buffered::WriteSegments(struct iovec Segment[2])
+{
+    uint32_t space = fSize - Count();
+    uint32_t first = std::min(space, (fMask+1) - (fHead & fMask));
+
+    if (space == 0)
+    {
+	return 0;
+    }
+    Segment[0].iov_base = fdata + (fHead & fMask);
+    Segment[0].iov_len  = first;
+    if (first == space)
+    {
+	return 1;
+    }
+    Segment[1].iov_base = fdata;
+    Segment[1].iov_len  = space - first;
+    return 2;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : ReadSegments
+ *
+ * Description : Describe the unread data from the tail, wrapping
+ *               once at the end of storage. 
+ *
+ * Inputs : Segment - filled with up to two iovecs
+ *
+ * Returns : number of segments, 0 if the buffer is empty
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+int Buffered::ReadSegments(struct iovec Segment[2]) const
+{
+    uint32_t count = Count();
+    uint32_t first = std::min(count, (fMask+1) - (fTail & fMask));
+
+    if (count == 0)
+    {
+	return 0;
+    }
+    Segment[0].iov_base = fdata + (fTail & fMask);
+    Segment[0].iov_len  = first;
+    if (first == count)
+    {
+	return 1;
+    }
+    Segment[1].iov_base = fdata;
+    Segment[1].iov_len  = count - first;
+    return 2;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Commit
+ *
+ * Description : Account for data written into the WriteSegments
+ *               space. The first data into an empty buffer sets
+ *               its time. 
+ *
+ * Inputs : n - bytes written
+ *
+ * Returns : number of bytes in the buffer
+ *
+ * Error Conditions : kBUFFER_OVERFLOW if n is more than the free
+ *                    space, the excess is ignored. 
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+int32_t Buffered::Commit(size_t n)
+{
+    fError = kERROR_NONE;
+    if (n > (size_t) (fSize - Count()))
+    {
+	fError = kBUFFER_OVERFLOW;
+	n = fSize - Count();
+    }
+    if ((fHead == fTail) && (n > 0))
+    {
+	UpdateNow();
+    }
+    fHead += n;
+    return Count();
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : ReadFrom
+ *
+ * Description : Read from a file descriptor straight into the free
+ *               space, one readv. 
+ *
+ * Inputs : fd - open for read
+ *
+ * Returns : bytes read, 0 at end of file, -1 on error or no room
+ *
+ * Error Conditions : kBUFFER_OVERFLOW if the buffer is full,
+ *                    errno from readv otherwise
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+ssize_t Buffered::ReadFrom(int fd)
+{
     SET_DEBUG_STACK;
-    return fFillIndex;
+    struct iovec seg[2];
+    int          nseg = WriteSegments(seg);
+    ssize_t      rc;
+
+    if (nseg == 0)
+    {
+	fError = kBUFFER_OVERFLOW;
+	return -1;
+    }
+    rc = readv(fd, seg, nseg);
+    if (rc > 0)
+    {
+	Commit(rc);
+    }
+    return rc;
 }
 /**
  ******************************************************************
@@ -212,32 +392,8 @@ void Buffered::SetTime(void)
 float Buffered::GetSingle(void)
 {
     SET_DEBUG_STACK;
-    float rv;
-    unsigned char *d  = (unsigned char *) &rv;
-
-    fError = kERROR_NONE;
-    if (!Check())
-    {
-	fError = kBUFFER_BUGGERED;
-	rv = 0.0;
-    }
-    else if (Remaining() < sizeof(float))
-    {
-	rv = 0.0;
-	fError = kBUFFER_EMPTY;
-    }
-    else
-    {
-	d[0] = fdrain[3];
-	d[1] = fdrain[2];
-	d[2] = fdrain[1];
-	d[3] = fdrain[0];
-	SET_DEBUG_STACK;
-	fdrain += sizeof (float);
-    }
-    SET_DEBUG_STACK;
-    return rv;
-};
+    return GetBE<float>();
+}
 /**
  ******************************************************************
  *
@@ -261,30 +417,8 @@ float Buffered::GetSingle(void)
 short Buffered::GetInt (void)
 {
     SET_DEBUG_STACK;
-    short rv;
-    unsigned char *d = (unsigned char *) &rv;
-
-    fError = kERROR_NONE;
-    if (!Check())
-    {
-	fError = kBUFFER_BUGGERED;
-	rv = 0;
-    }
-    else if (Remaining() < sizeof(short))
-    {
-	rv = 0;
-	fError = kBUFFER_EMPTY;
-    }
-    else
-    {
-	d[0] = fdrain[1];
-	d[1] = fdrain[0];
-	SET_DEBUG_STACK;
-	fdrain += sizeof (short);
-    }
-    SET_DEBUG_STACK;
-    return rv;
-};
+    return GetBE<short>();
+}
 /**
  ******************************************************************
  *
@@ -308,31 +442,7 @@ short Buffered::GetInt (void)
 int Buffered::GetLongInt (void)
 {
     SET_DEBUG_STACK;
-    int rv;
-    unsigned char *d = (unsigned char *) &rv;
-
-    fError = kERROR_NONE;
-    if (!Check())
-    {
-	fError = kBUFFER_BUGGERED;
-	rv = 0;
-    }
-    else if (Remaining() < sizeof(int))
-    {
-	rv = 0;
-	fError = kBUFFER_EMPTY;
-    }
-    else
-    {
-	d[0] = fdrain[3];
-	d[1] = fdrain[2];
-	d[2] = fdrain[1];
-	d[3] = fdrain[0];
-	SET_DEBUG_STACK;
-	fdrain += sizeof (int);
-    }
-    SET_DEBUG_STACK;
-    return rv;
+    return GetBE<int>();
 }
 /**
  ******************************************************************
@@ -357,35 +467,7 @@ int Buffered::GetLongInt (void)
 double Buffered::GetDouble (void)
 {
     SET_DEBUG_STACK;
-    double rv;
-    unsigned char *d  = (unsigned char *) &rv;
-
-    fError = kERROR_NONE;
-    if (!Check())
-    {
-	fError = kBUFFER_BUGGERED;
-	rv = 0.0;
-    }
-    else if (Remaining() < sizeof(double))
-    {
-	rv = 0.0;
-	fError = kBUFFER_EMPTY;
-    }
-    else
-    {
-	d[0] = fdrain[7];
-	d[1] = fdrain[6];
-	d[2] = fdrain[5];
-	d[3] = fdrain[4];
-	d[4] = fdrain[3];
-	d[5] = fdrain[2];
-	d[6] = fdrain[1];
-	d[7] = fdrain[0];
-	SET_DEBUG_STACK;
-	fdrain += sizeof (double);
-    }
-    SET_DEBUG_STACK;
-    return rv;
+    return GetBE<double>();
 }
 /**
  ******************************************************************
@@ -411,7 +493,7 @@ double Buffered::GetDouble (void)
 unsigned char Buffered::GetChar (void)
 {
     SET_DEBUG_STACK;
-    char rv;
+    unsigned char rv;
 
     fError = kERROR_NONE;
     if (!Check())
@@ -419,18 +501,15 @@ unsigned char Buffered::GetChar (void)
 	fError = kBUFFER_BUGGERED;
 	rv = 0;
     }
-    else if (Remaining() < sizeof(char))
+    else if (fHead == fTail)
     {
 	rv = 0;
 	fError = kBUFFER_EMPTY;
     }
     else
     {
-	SET_DEBUG_STACK;
-	rv     = *fdrain;
-	fdrain += sizeof (char);
+	rv = fdata[fTail++ & fMask];
     }
-    SET_DEBUG_STACK;
     return rv;
 }
 /**
@@ -470,7 +549,7 @@ int Buffered::Skip(unsigned i)
     }
     else
     {
-	fdrain += i;
+	fTail += i;
     }
     return rv;
 }
@@ -501,18 +580,19 @@ ostream& operator<<(ostream& output, const Buffered &n)
     output << "# Buffered ----------------------------------------" 
 	   << dec << endl;
     output << "#         Size: " << n.fSize 
-	   << "    FillIndex: " << n.fFillIndex
+	   << "    FillIndex: " << n.Count()
 	   << "         Busy: " << n.fBusy
 	   << "        Error: " << n.fError
 	   << std::right << std::setw(2) << hex << endl;
-    for (i=0;i<n.fFillIndex;i++)
+    for (i=0;i<n.Count();i++)
     {
         if (i%10 == 0)
         {
 	    if (i>0) output << endl;
             output << "# " << dec << std::setw(2) << i << ") " << hex;
         }
-	output << hex << std::setw(2) << (int) n.fdata[i] << " ";
+	output << hex << std::setw(2) 
+	       << (int) n.fdata[(n.fTail+i) & n.fMask] << " ";
     }
 
     output << endl << dec 
@@ -526,10 +606,9 @@ ostream& operator<<(ostream& output, const Buffered &n)
 void Buffered::Reset()
 { 
     fError     = kERROR_NONE;
-    fFillIndex = 0;          // Nothing has been put into the buffer.
-    fdrain     = fdata;      // drain starts at beginning of buffer. 
+    fHead      = 0;          // Nothing has been put into the buffer.
+    fTail      = 0;          // drain starts at beginning of buffer. 
     fBusy      = false;      // buffer is not busy.
-    memset(fdata, 0, fSize); // Zero buffer.
     UpdateNow();
 }
 
@@ -542,9 +621,9 @@ unsigned char Buffered::Char(unsigned i)
 	fError = kBUFFER_BUGGERED;
 	rc = 0;
     }
-    else if (i<fSize)
+    else if (i<Count())
     {
-	rc = fdata[i];
+	rc = fdata[(fTail+i) & fMask];
     }
     return rc;
 } 
@@ -559,7 +638,7 @@ const char *Buffered::StatusBuf(void) const
 {
     static char StatusB[256];
     sprintf(StatusB, " Fill index: %d Drain: %d ",
-	    fFillIndex, Remaining());
+	    fHead & fMask, fTail & fMask);
     return StatusB;
 }
 /**
@@ -610,3 +689,120 @@ void Buffered::UpdateNow(void)
     clock_gettime(CLOCK_REALTIME, &fnow);
 #endif
 }
+/**
+ ******************************************************************
+ *
+ * Function Name : Peek
+ *
+ * Description : Copy unread bytes out, across the wrap if need be,
+ *               without draining. 
+ *
+ * Inputs : out - destination
+ *          n   - bytes, no more than Count()
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void Buffered::Peek(unsigned char *out, size_t n) const
+{
+    size_t first = std::min(n, (size_t) ((fMask+1) - (fTail & fMask)));
+    memcpy(out, fdata + (fTail & fMask), first);
+    memcpy(out + first, fdata, n - first);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : GetData
+ *
+ * Description : Rotate the storage if the unread data wraps, so it
+ *               can be handled as one block. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : start of the unread data, GetFill() bytes long
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+unsigned char* Buffered::GetData(void)
+{
+    uint32_t count = Count();
+    if ((fTail & fMask) + count > fMask+1)
+    {
+	std::rotate(fdata, fdata + (fTail & fMask), fdata + fMask+1);
+	fTail = 0;
+	fHead = count;
+    }
+    return fdata + (fTail & fMask);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : SetFillIndex
+ *
+ * Description : Declare the f bytes starting at GetData() to be 
+ *               the unread data, for use after writing there 
+ *               directly. Whatever was unread before is replaced. 
+ *               f is cut to what fits between GetData() and the 
+ *               end of storage, and to the buffer size. After a 
+ *               Reset, GetData() is the start of storage. 
+ *
+ * Inputs : f - number of bytes
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void Buffered::SetFillIndex(unsigned short f)
+{
+    uint32_t room = std::min<uint32_t>(fSize, fMask+1 - (fTail & fMask));
+    fHead  = fTail + std::min<uint32_t>(f, room);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : DecrementFillCount
+ *
+ * Description : Drop the last byte put. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void Buffered::DecrementFillCount(void)
+{
+    if (fHead != fTail)
+    {
+	fHead--;
+    }
+}
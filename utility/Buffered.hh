@@ -5,12 +5,25 @@
  *
  * Author/Date : C.B. Lirakis / 28-June-08
  *
- * Description : Permit the construction and manipulation of a series 
- * of data buffers. 
+ * Description : Permit the construction and manipulation of a series
+ * of data buffers.
  *
- * Restrictions/Limitations :
+ * The buffer is a ring. Data goes in at the head, either a byte at a
+ * time with Put, a block with PutBuffer, or straight from a file
+ * descriptor: WriteSegments gives the free space as at most two
+ * iovecs ready for readv, Commit accounts for what was read into
+ * them. ReadFrom does both.
+ *
+ * Data comes out at the tail, big endian (network, TSIP) order. The
+ * typed readers byte swap a whole word at a time, GetArray decodes N
+ * values in one pass.
+ *
+ * Restrictions/Limitations : Not thread safe, one writer and one
+ * reader in the same thread.
  *
  * Change Descriptions :
+ * 17-Oct-26 CBL Ring buffer, zero copy fill, word at a time and bulk
+ *               big endian extraction.
  *
  * Classification : Unclassified
  *
@@ -23,6 +36,90 @@
 # include <time.h>
 # include <ostream>
 # include <stdint.h>
+# include <cstring>
+# include <sys/uio.h>
+
+/*!
+ * Unsigned word the size of a value and its byte swap from big
+ * endian to host order.
+ */
+template<size_t S> struct BufferedWord;
+template<> struct BufferedWord<1> {
+    typedef uint8_t Type;
+    static inline Type Swap(Type v) {return v;};
+};
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+template<> struct BufferedWord<2> {
+    typedef uint16_t Type;
+    static inline Type Swap(Type v) {return v;};
+};
+template<> struct BufferedWord<4> {
+    typedef uint32_t Type;
+    static inline Type Swap(Type v) {return v;};
+};
+template<> struct BufferedWord<8> {
+    typedef uint64_t Type;
+    static inline Type Swap(Type v) {return v;};
+};
+#else
+template<> struct BufferedWord<2> {
+    typedef uint16_t Type;
+    static inline Type Swap(Type v) {return __builtin_bswap16(v);};
+};
+template<> struct BufferedWord<4> {
+    typedef uint32_t Type;
+    static inline Type Swap(Type v) {return __builtin_bswap32(v);};
+};
+template<> struct BufferedWord<8> {
+    typedef uint64_t Type;
+    static inline Type Swap(Type v) {return __builtin_bswap64(v);};
+};
+#endif
+
+/*!
+ * Decode N big endian values of type T from In to Out. When
+ * optimizing, 16 bytes at a time are swapped as eight 16 bit lanes
+ * (byte swap each lane, then reorder the lanes), which needs
+ * nothing past SSE2 or NEON. Unoptimized builds are faster with
+ * the plain loop.
+ */
+template<typename T>
+inline void BufferedDecode(T *Out, const unsigned char *In, size_t N)
+{
+    typedef BufferedWord<sizeof(T)> W;
+    size_t i = 0;
+#if defined(__OPTIMIZE__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    typedef uint16_t Lanes __attribute__((vector_size(16)));
+    const size_t PerVector = 16/sizeof(T);
+    if (sizeof(T) > 1)
+    {
+	for (; i+PerVector <= N; i += PerVector)
+	{
+	    Lanes v;
+	    memcpy(&v, In + i*sizeof(T), sizeof(v));
+	    v = (v << 8) | (v >> 8);
+	    if (sizeof(T) == 4)
+	    {
+		const Lanes m = {1,0,3,2,5,4,7,6};
+		v = __builtin_shuffle(v, m);
+	    }
+	    else if (sizeof(T) == 8)
+	    {
+		const Lanes m = {3,2,1,0,7,6,5,4};
+		v = __builtin_shuffle(v, m);
+	    }
+	    memcpy(Out + i, &v, sizeof(v));
+	}
+    }
+#endif
+    for (; i<N; i++)
+    {
+	typename W::Type w;
+	memcpy(&w, In + i*sizeof(T), sizeof(w));
+	w = W::Swap(w);
+	memcpy(Out + i, &w, sizeof(w));
+    }
+}
 
 class Buffered {
 public:
@@ -37,24 +134,49 @@ public:
     /// Put a batch of data in
     int32_t                PutBuffer(unsigned char *b, size_t s);
 
+    /**
+     * Free space as at most two segments, in order, for readv.
+     * Returns the number of segments filled, 0 if full.
+     */
+    int                    WriteSegments(struct iovec Segment[2]);
+
+    /**
+     * Unread data as at most two segments, in order, without
+     * draining. Returns the number of segments filled.
+     */
+    int                    ReadSegments(struct iovec Segment[2]) const;
+
+    /**
+     * Account for n bytes placed in the WriteSegments space.
+     * Returns the number of bytes now in the buffer.
+     */
+    int32_t                Commit(size_t n);
+
+    /**
+     * readv from fd directly into the free space. Returns what
+     * read returned: bytes read, 0 at end of file, -1 with errno
+     * set. kBUFFER_OVERFLOW if there was no room.
+     */
+    ssize_t                ReadFrom(int fd);
+
     /// Set the time on the buffer to NOW
     void                   SetTime(void);
 
-    /// Get the declared size of the buffer. 
+    /// Get the declared size of the buffer.
     inline unsigned short  GetSize(void)  const {return fSize;};
 
-    /// Get the last timestamp on the buffer. 
+    /// Get the last timestamp on the buffer.
     inline struct timespec GetTime(void)  const {return fnow;};
     /**
      *  Get the fill index. Usually used to see how many characters
      * there are in the buffer.
      */
-    inline unsigned short  GetFill(void)  const {return fFillIndex;};
+    inline unsigned short  GetFill(void)  const {return Count();};
 
     /// Return the error from the last operation.
     inline int             GetError(void) const {return fError;};
 
-    /// Check to see if the buffer is in use. 
+    /// Check to see if the buffer is in use.
     inline bool            Busy(void) const {return fBusy;};
 
     /// Set the in use flag for this buffer.
@@ -65,24 +187,23 @@ public:
 
     /**
      * How many bytes are left in the buffer? Typically
-     * when doing a drain on the buffer, the difference between
-     * the read pointer and the beginning of the buffer.
+     * when doing a drain on the buffer, the number of bytes
+     * not yet read out.
      */
-    inline uint32_t Remaining(void) const 
-	{return (fFillIndex - (unsigned)(fdrain-fdata));};
+    inline uint32_t Remaining(void) const {return Count();};
 
 
     /**
      * Reset all flags, clear the buffer. Clear CLEAR
      */
-    void Reset(void); 
+    void Reset(void);
 
-    /// Advance the drain pointer by i bytes in the buffer. 
+    /// Advance the drain pointer by i bytes in the buffer.
     int Skip(unsigned i);
 
     /* Data extraction from the buffer. */
     /// Private Methods, used in decoding data.
-    /// Get a character at location i, no change to drain pointer. 
+    /// Get the i'th unread character, no change to drain pointer.
     unsigned char Char(unsigned i);
     /// Get a character from the buffer and advance drain by 1
     unsigned char GetChar(void);
@@ -96,17 +217,29 @@ public:
     double        GetDouble(void);
     int           GetLine(char *p, size_t n);
 
-    /// Use the next carefully.
-    inline unsigned char* GetData(void) {return fdata;};
-    inline void           SetFillIndex(unsigned short f) {fFillIndex = f;};
-    inline unsigned short GetFillIndex(void) {return fFillIndex;};
+    /**
+     * Get N big endian values of type T into Out and advance drain
+     * by N*sizeof(T). Returns the number decoded, 0 and
+     * kBUFFER_EMPTY if fewer than N are available.
+     */
+    template<typename T> size_t GetArray(T *Out, size_t N);
+
+    /**
+     * Use the next carefully. GetData makes the unread data
+     * contiguous and returns its start, GetFill() bytes long.
+     * SetFillIndex makes the f bytes from GetData() on the unread
+     * data, after writing them there directly.
+     */
+    unsigned char*        GetData(void);
+    void                  SetFillIndex(unsigned short f);
+    inline unsigned short GetFillIndex(void) {return Count();};
 
-    /// and this one too.
-    inline void    DecrementFillCount(void) { fFillIndex--;};
+    /// and this one too. Drops the last byte put.
+    void           DecrementFillCount(void);
     inline clock_t TimeStamp (void) const {return fTimeStamp;};
     const  char    *StatusBuf(void) const;
 
-    inline bool    IsFull(void) {return (fFillIndex>fSize-1);};
+    inline bool    IsFull(void) {return (Count()>=fSize);};
 
 
     friend ostream& operator<<(ostream& output, const Buffered &n);
@@ -115,26 +248,110 @@ public:
 
 private:
     /// Check to see if Fill index is buggered.
-    inline bool Check(void) const {return (fFillIndex<fSize);};
+    inline bool Check(void) const {return ((fHead - fTail)<=fSize);};
+
+    /// Bytes held, the offsets run free and wrap at 2^32.
+    inline uint32_t Count(void) const {return fHead - fTail;};
+
+    /**
+     * Check and get one big endian value, advance the drain. Inlined
+     * even without optimization, it is the whole of GetSingle etc.
+     */
+    template<typename T> inline T GetBE(void) __attribute__((always_inline));
+
+    /// Copy n unread bytes out without draining, n <= Count().
+    void Peek(unsigned char *out, size_t n) const;
+
 
     /// update fnow.
     void UpdateNow(void);
 
     /// Buffer is in use flag.
     bool            fBusy;
-    /// The current pointer on write. The number of bytes on read. 
-    unsigned short  fFillIndex;
+    /// Total bytes put, the write offset is fHead & fMask.
+    uint32_t        fHead;
+    /// Total bytes drained, the read offset is fTail & fMask.
+    uint32_t        fTail;
+    /// Storage is fMask+1 bytes, a power of 2 at least fSize.
+    uint32_t        fMask;
     /// Declared size of buffer
     unsigned short  fSize;
     /// Time the buffer was last touched.
     struct timespec fnow;
     /// actual data buffer.
     unsigned char   *fdata;
-    /// Pointer for use on read (drain) of buffer. 
-    unsigned char   *fdrain;
     /// Last error
     int             fError;
-    /// timestamp on when this buffer was filled. 
+    /// CPU time of the last SetTime.
     clock_t         fTimeStamp;
 };
+
+template<typename T> inline T Buffered::GetBE(void)
+{
+    typedef typename BufferedWord<sizeof(T)>::Type Word;
+    typedef Word __attribute__((aligned(1), may_alias)) Unaligned;
+    union {Word w; T v;} rv;
+    uint32_t off = fTail & fMask;
+
+    fError = kERROR_NONE;
+    if (!Check())
+    {
+	fError = kBUFFER_BUGGERED;
+	return 0;
+    }
+    else if (fHead - fTail < sizeof(T))
+    {
+	fError = kBUFFER_EMPTY;
+	return 0;
+    }
+    if (off + sizeof(T) <= fMask+1)
+    {
+	rv.w = *(const Unaligned *) (fdata + off);
+    }
+    else
+    {
+	Peek((unsigned char *) &rv.w, sizeof(T));
+    }
+    fTail += sizeof(T);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if constexpr (sizeof(T) == 2) rv.w = __builtin_bswap16(rv.w);
+    if constexpr (sizeof(T) == 4) rv.w = __builtin_bswap32(rv.w);
+    if constexpr (sizeof(T) == 8) rv.w = __builtin_bswap64(rv.w);
+#endif
+    return rv.v;
+}
+
+template<typename T> size_t Buffered::GetArray(T *Out, size_t N)
+{
+    fError = kERROR_NONE;
+    if (!Check())
+    {
+	fError = kBUFFER_BUGGERED;
+	return 0;
+    }
+    else if (Count() < N*sizeof(T))
+    {
+	fError = kBUFFER_EMPTY;
+	return 0;
+    }
+    size_t done = 0;
+    while (done < N)
+    {
+	/* Whole values before the end of storage. */
+	size_t run = ((fMask+1) - (fTail & fMask))/sizeof(T);
+	if (run > N-done) run = N-done;
+	if (run > 0)
+	{
+	    BufferedDecode(Out+done, fdata + (fTail & fMask), run);
+	    fTail += run*sizeof(T);
+	    done  += run;
+	}
+	else
+	{
+	    /* This one straddles the end. */
+	    Out[done++] = GetBE<T>();
+	}
+    }
+    return N;
+}
 #endif
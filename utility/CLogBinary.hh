@@ -0,0 +1,91 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : CLogBinary.hh
+ *
+ * Author/Date : C.B. Lirakis / 17-Oct-26
+ *
+ * Description : On disk layout of a binary CLogger stream, shared
+ * by the writer (CLogger) and the reader (CLogReader).
+ *
+ * The file starts with the 8 byte magic kCLOG_MAGIC, then records,
+ * each starting with a type byte:
+ *
+ *   kCLOG_TEXT     dt, length, text
+ *   kCLOG_DEFINE   id, signature length, signature,
+ *                  format length, format
+ *   kCLOG_DATA     id, dt, arguments
+ *   kCLOG_DATA_TIME same as kCLOG_DATA, rendered with the LogTime
+ *                  "# %F %T " prefix
+ *
+ * Lengths and ids are unsigned varints. dt is the zigzag varint
+ * of the record time in ns less the time of the record before it,
+ * the first record is relative to 0. A format is defined once,
+ * before its first use. The signature has one character per
+ * argument:
+ *
+ *   i  signed integer, zigzag varint
+ *   u  unsigned integer, varint
+ *   f  float, 4 bytes host order
+ *   d  double, 8 bytes host order
+ *
+ * Restrictions/Limitations : host byte order for floating point.
+ *
+ * Change Descriptions :
+ * 17-Oct-26 CBL CLogSignature and CLogPutArg moved to CLogDeferred.hh.
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ *******************************************************************
+ */
+#ifndef __CLOGBINARY_hh_
+#define __CLOGBINARY_hh_
+#include <stdint.h>
+
+const char    kCLOG_MAGIC[8] = {'C','L','O','G','B','I','N','1'};
+const uint8_t kCLOG_TEXT      = 'T';
+const uint8_t kCLOG_DEFINE    = 'F';
+const uint8_t kCLOG_DATA      = 'D';
+const uint8_t kCLOG_DATA_TIME = 'S';
+
+/*! Largest encoded argument, a 64 bit varint. */
+const size_t  kCLOG_MAX_ARG   = 10;
+
+/*! Formats a deferred record, Args points to the argument tuple. */
+typedef int    (*CLogFormatter)(char *Buffer, size_t Size,
+				const char *fmt, const void *Args);
+/*! Encodes the argument tuple, returns bytes written. */
+typedef size_t (*CLogEncoder)(unsigned char *Out, const void *Args);
+
+/*!
+ * One per argument type list, made by CLogger::Describe.
+ */
+struct CLogArgs {
+    CLogFormatter Format;
+    CLogEncoder   Encode;
+    const char   *Signature;
+};
+
+inline size_t CLogPutVarint(unsigned char *Out, uint64_t v)
+{
+    size_t n = 0;
+    while (v >= 0x80)
+    {
+	Out[n++] = (unsigned char) (v | 0x80);
+	v >>= 7;
+    }
+    Out[n++] = (unsigned char) v;
+    return n;
+}
+inline uint64_t CLogZigzag(int64_t v)
+{
+    return ((uint64_t) v << 1) ^ (uint64_t) (v >> 63);
+}
+inline int64_t CLogUnzigzag(uint64_t v)
+{
+    return (int64_t) (v >> 1) ^ -(int64_t) (v & 1);
+}
+
+#endif
@@ -0,0 +1,156 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : CLogDeferred.hh
+ *
+ * Author/Date : C.B. Lirakis / 17-Oct-26
+ *
+ * Description : The CLogger member templates behind LogDeferred,
+ * LogTimeDeferred and LogVerbose, and the per argument binary
+ * encoding. They keep the arguments as a tuple and need C++17
+ * (if constexpr, std::apply, fold expressions), so they are kept
+ * out of CLogger.hh for the code that still builds with C++11.
+ * Include this instead of CLogger.hh to use them.
+ *
+ * Restrictions/Limitations : C++17
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References : CLogBinary.hh for the encoding
+ *
+ *******************************************************************
+ */
+#ifndef __CLOGDEFERRED_hh_
+#define __CLOGDEFERRED_hh_
+#if __cplusplus < 201703L
+#  error "CLogDeferred.hh needs -std=c++17 or later"
+#endif
+#include <cstring>
+#include <tuple>
+#include <new>
+#include <type_traits>
+#include "CLogger.hh"
+
+/*! Signature character and encoding for one argument. */
+template<typename T> constexpr char CLogSignature(void)
+{
+    if constexpr (std::is_same<T, float>::value) return 'f';
+    else if constexpr (std::is_floating_point<T>::value) return 'd';
+    else if constexpr (std::is_signed<T>::value) return 'i';
+    else return 'u';
+}
+template<typename T> inline size_t CLogPutArg(unsigned char *Out, T v)
+{
+    if constexpr (std::is_same<T, float>::value)
+    {
+	memcpy(Out, &v, sizeof(v));
+	return sizeof(v);
+    }
+    else if constexpr (std::is_floating_point<T>::value)
+    {
+	double d = v;
+	memcpy(Out, &d, sizeof(d));
+	return sizeof(d);
+    }
+    else if constexpr (std::is_signed<T>::value)
+    {
+	return CLogPutVarint(Out, CLogZigzag(v));
+    }
+    else
+    {
+	return CLogPutVarint(Out, (uint64_t) v);
+    }
+}
+
+template<typename... A>
+void CLogger::LogDeferred(const char *fmt, A... args)
+{
+    Defer(false, fmt, args...);
+}
+template<typename... A>
+void CLogger::LogTimeDeferred(const char *fmt, A... args)
+{
+    Defer(true, fmt, args...);
+}
+
+template<typename... A>
+void CLogger::LogVerbose(int Level, const char *fmt, A... args)
+{
+    static_assert(sizeof(std::tuple<A...>) <= kFR_ARGS,
+		  "too many flight recorder arguments");
+    if (CheckVerbose(Level)) Defer(false, fmt, args...);
+    if (fRingSlots > 0)
+    {
+	void *p = Capture(Level, Describe<A...>(), fmt);
+	if (p)
+	{
+	    new (p) std::tuple<A...>(args...);
+	    Captured();
+	}
+    }
+}
+
+template<typename... A>
+int CLogger::FormatDeferred(char *Buffer, size_t Size, const char *fmt,
+			    const void *Args)
+{
+    if constexpr (sizeof...(A) == 0)
+    {
+	return snprintf(Buffer, Size, "%s", fmt);
+    }
+    else
+    {
+	return std::apply([&](const A&... a)
+			  {return snprintf(Buffer, Size, fmt, a...);},
+			  *(const std::tuple<A...> *) Args);
+    }
+}
+
+template<typename... A>
+size_t CLogger::EncodeDeferred(unsigned char *Out, const void *Args)
+{
+    return std::apply([&](const A&... a)
+		      {size_t n = 0; ((n += CLogPutArg(Out+n, a)), ...);
+			  return n;},
+		      *(const std::tuple<A...> *) Args);
+}
+
+template<typename... A>
+const CLogArgs *CLogger::Describe(void)
+{
+    static const char     Signature[] = {CLogSignature<A>()..., 0};
+    static const CLogArgs Info = {&FormatDeferred<A...>,
+				  &EncodeDeferred<A...>, Signature};
+    return &Info;
+}
+
+template<typename... A>
+void CLogger::Defer(bool Time, const char *fmt, A... args)
+{
+    static_assert((std::is_arithmetic<A>::value && ...),
+		  "deferred log arguments must be numbers");
+    static_assert(sizeof...(A)*kCLOG_MAX_ARG < BUFSIZ/2,
+		  "too many deferred log arguments");
+    typedef std::tuple<A...> T;
+    if (!fOnOff) return;
+    if (!fAsync)
+    {
+	if (fBinary)
+	{
+	    T t(args...);
+	    Record(Time, Describe<A...>(), fmt, &t);
+	}
+	else if (Time) LogTime(fmt, args...);
+	else Log(fmt, args...);
+	return;
+    }
+    void *p = Reserve(sizeof(T), Time, Describe<A...>(), fmt);
+    if (p)
+    {
+	new (p) T(args...);
+	Commit();
+    }
+}
+#endif
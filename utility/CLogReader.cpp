@@ -0,0 +1,446 @@
+/********************************************************************
+ *
+ * Module Name : CLogReader.cpp
+ *
+ * Author/Date : C.B. Lirakis / 17-Oct-26
+ *
+ * Description : Render a binary CLogger stream back to text.
+ *
+ * Restrictions/Limitations : NONE
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References : CLogBinary.hh
+ *
+ ********************************************************************/
+// System includes.
+#include <iostream>
+using namespace std;
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <ctime>
+#include <cctype>
+
+// Local Includes.
+#include "debug.h"
+#include "CLogBinary.hh"
+#include "CLogReader.hh"
+
+/**
+ ******************************************************************
+ *
+ * Function Name : CLogReader constructor
+ *
+ * Description : Open the file and check the magic.
+ *
+ * Inputs : Filename - binary log
+ *
+ * Returns : constructed CLogReader
+ *
+ * Error Conditions : NO_FILE, BAD_MAGIC
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+CLogReader::CLogReader(const char *Filename) : CObject()
+{
+    SET_DEBUG_STACK;
+    char magic[sizeof(kCLOG_MAGIC)];
+
+    SetName("CLogReader");
+    ClearError(__LINE__);
+    fTime     = 0;
+    fNRecords = 0;
+
+    fIn.open(Filename, ios::in | ios::binary);
+    if (!fIn.is_open())
+    {
+	SetError(NO_FILE, __LINE__);
+	return;
+    }
+    if (!fIn.read(magic, sizeof(magic)) ||
+	(memcmp(magic, kCLOG_MAGIC, sizeof(magic)) != 0))
+    {
+	SetError(BAD_MAGIC, __LINE__);
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : CLogReader destructor
+ *
+ * Description :
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+CLogReader::~CLogReader(void)
+{
+    fIn.close();
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : CLogReader::ReadVarint
+ *
+ * Description :
+ *
+ * Inputs : v - returned value
+ *
+ * Returns : false at end of file or on an overlong varint
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool CLogReader::ReadVarint(uint64_t &v)
+{
+    int c;
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+	if ((c = fIn.get()) == EOF)
+	{
+	    return false;
+	}
+	v |= (uint64_t) (c & 0x7F) << shift;
+	if ((c & 0x80) == 0)
+	{
+	    return true;
+	}
+    }
+    return false;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : CLogReader::ReadBytes
+ *
+ * Description :
+ *
+ * Inputs : s - returned bytes
+ *          n - number to read
+ *
+ * Returns : false on a short read
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool CLogReader::ReadBytes(std::string &s, size_t n)
+{
+    s.resize(n);
+    return (n == 0) || fIn.read(&s[0], n);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : CLogReader::ReadArgs
+ *
+ * Description : Decode the arguments of a data record.
+ *
+ * Inputs : Signature - one character per argument
+ *          Args      - returned values
+ *
+ * Returns : false on a short read or unknown type
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool CLogReader::ReadArgs(const std::string &Signature, std::vector<Arg> &Args)
+{
+    uint64_t v;
+    float    f;
+    Args.resize(Signature.size());
+    for (size_t i=0; i<Signature.size(); i++)
+    {
+	Arg &a = Args[i];
+	a.Type = Signature[i];
+	switch (a.Type)
+	{
+	case 'i':
+	    if (!ReadVarint(v)) return false;
+	    a.I = CLogUnzigzag(v);
+	    a.U = a.I;
+	    a.D = a.I;
+	    break;
+	case 'u':
+	    if (!ReadVarint(v)) return false;
+	    a.U = v;
+	    a.I = v;
+	    a.D = v;
+	    break;
+	case 'f':
+	    if (!fIn.read((char *) &f, sizeof(f))) return false;
+	    a.D = f;
+	    a.I = (int64_t) f;
+	    a.U = a.I;
+	    break;
+	case 'd':
+	    if (!fIn.read((char *) &a.D, sizeof(a.D))) return false;
+	    a.I = (int64_t) a.D;
+	    a.U = a.I;
+	    break;
+	default:
+	    return false;
+	}
+    }
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : CLogReader::Render
+ *
+ * Description : Apply fmt to the decoded arguments. Each conversion
+ *               is rebuilt without its length modifier and given
+ *               the widest type of its class, so the argument size
+ *               recorded doesn't matter.
+ *
+ * Inputs : fmt  - printf format
+ *          Args - decoded arguments
+ *          Text - appended to
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void CLogReader::Render(const std::string &fmt, const std::vector<Arg> &Args,
+			std::string &Text)
+{
+    char   out[512];
+    size_t next = 0;
+    size_t i    = 0;
+    while (i < fmt.size())
+    {
+	if (fmt[i] != '%')
+	{
+	    Text += fmt[i++];
+	    continue;
+	}
+	i++;
+	if ((i < fmt.size()) && (fmt[i] == '%'))
+	{
+	    Text += '%';
+	    i++;
+	    continue;
+	}
+	std::string spec("%");
+	while ((i < fmt.size()) && strchr("-+ #0'", fmt[i]))
+	{
+	    spec += fmt[i++];
+	}
+	/* Width and precision, a * takes the next argument. */
+	for (int part=0; part<2; part++)
+	{
+	    if (part == 1)
+	    {
+		if ((i >= fmt.size()) || (fmt[i] != '.')) break;
+		spec += fmt[i++];
+	    }
+	    if ((i < fmt.size()) && (fmt[i] == '*'))
+	    {
+		i++;
+		spec += std::to_string((next < Args.size()) ? Args[next++].I : 0);
+	    }
+	    while ((i < fmt.size()) && isdigit(fmt[i]))
+	    {
+		spec += fmt[i++];
+	    }
+	}
+	while ((i < fmt.size()) && strchr("hlLqjzt", fmt[i]))
+	{
+	    i++;
+	}
+	if (i >= fmt.size())
+	{
+	    break;
+	}
+	char conv = fmt[i++];
+	if (conv == 'n')
+	{
+	    continue;
+	}
+	if ((conv == 's') || (next >= Args.size()))
+	{
+	    Text += "(?)";
+	    continue;
+	}
+	const Arg &a = Args[next++];
+	switch (conv)
+	{
+	case 'd':
+	case 'i':
+	    spec += "lld";
+	    snprintf(out, sizeof(out), spec.c_str(), (long long) a.I);
+	    break;
+	case 'u':
+	case 'o':
+	case 'x':
+	case 'X':
+	    spec += "ll";
+	    spec += conv;
+	    snprintf(out, sizeof(out), spec.c_str(), (unsigned long long) a.U);
+	    break;
+	case 'c':
+	    spec += 'c';
+	    snprintf(out, sizeof(out), spec.c_str(), (int) a.I);
+	    break;
+	case 'p':
+	    spec += 'p';
+	    snprintf(out, sizeof(out), spec.c_str(), (void *) (uintptr_t) a.U);
+	    break;
+	case 'f':
+	case 'F':
+	case 'e':
+	case 'E':
+	case 'g':
+	case 'G':
+	case 'a':
+	case 'A':
+	    spec += conv;
+	    snprintf(out, sizeof(out), spec.c_str(), a.D);
+	    break;
+	default:
+	    out[0] = 0;
+	    break;
+	}
+	Text += out;
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : CLogReader::Next
+ *
+ * Description : Read records until one produces text.
+ *
+ * Inputs : Text - returned text
+ *
+ * Returns : true if Text was filled
+ *
+ * Error Conditions : BAD_RECORD - short read or unknown type
+ *                    BAD_FORMAT - data record with an unknown id
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool CLogReader::Next(std::string &Text)
+{
+    SET_DEBUG_STACK;
+    uint64_t id, dt, n;
+    int      type;
+    std::vector<Arg> Args;
+
+    Text.clear();
+    if (Error() != ENONE)
+    {
+	return false;
+    }
+    while ((type = fIn.get()) != EOF)
+    {
+	switch (type)
+	{
+	case kCLOG_TEXT:
+	    if (!ReadVarint(dt) || !ReadVarint(n) || !ReadBytes(Text, n))
+	    {
+		SetError(BAD_RECORD, __LINE__);
+		return false;
+	    }
+	    fTime += CLogUnzigzag(dt);
+	    fNRecords++;
+	    return true;
+	case kCLOG_DEFINE:
+	{
+	    Format f;
+	    if (!ReadVarint(id) || (id != fFormats.size()) ||
+		!ReadVarint(n) || !ReadBytes(f.Signature, n) ||
+		!ReadVarint(n) || !ReadBytes(f.Text, n))
+	    {
+		SetError(BAD_RECORD, __LINE__);
+		return false;
+	    }
+	    fFormats.push_back(f);
+	}
+	break;
+	case kCLOG_DATA:
+	case kCLOG_DATA_TIME:
+	    if (!ReadVarint(id) || !ReadVarint(dt))
+	    {
+		SetError(BAD_RECORD, __LINE__);
+		return false;
+	    }
+	    if (id >= fFormats.size())
+	    {
+		SetError(BAD_FORMAT, __LINE__);
+		return false;
+	    }
+	    if (!ReadArgs(fFormats[id].Signature, Args))
+	    {
+		SetError(BAD_RECORD, __LINE__);
+		return false;
+	    }
+	    fTime += CLogUnzigzag(dt);
+	    if (type == kCLOG_DATA_TIME)
+	    {
+		char      tmsg[64];
+		struct tm tm;
+		time_t    when = fTime/1000000000;
+		gmtime_r(&when, &tm);
+		strftime(tmsg, sizeof(tmsg), "# %F %T ", &tm);
+		Text = tmsg;
+	    }
+	    Render(fFormats[id].Text, Args, Text);
+	    fNRecords++;
+	    return true;
+	default:
+	    SetError(BAD_RECORD, __LINE__);
+	    return false;
+	}
+    }
+    return false;
+}
@@ -0,0 +1,82 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : CLogReader.hh
+ *
+ * Author/Date : C.B. Lirakis / 17-Oct-26
+ *
+ * Description : Read a binary CLogger stream and render it back to
+ * the text CLogger would have written. The format of each record
+ * is applied one conversion at a time using the argument types
+ * stored with the format, so the result matches the original
+ * printf to within the conversion.
+ *
+ * Restrictions/Limitations : %s and %n have no argument in a
+ * binary record and are rendered as "(?)" and nothing.
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References : CLogBinary.hh
+ *
+ *******************************************************************
+ */
+#ifndef __CLOGREADER_hh_
+#define __CLOGREADER_hh_
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include "CObject.hh"
+
+class CLogReader : public CObject
+{
+public:
+    /*!
+     * Open Filename and check the magic. Error() is set on failure.
+     */
+    CLogReader(const char *Filename);
+    ~CLogReader(void);
+
+    /*!
+     * Render the next record into Text, replacing its contents.
+     * Format definitions are absorbed. Returns false at the end
+     * of the file or on a damaged record, see Error().
+     */
+    bool Next(std::string &Text);
+
+    /*! Time of the record just rendered, ns since the epoch. */
+    inline int64_t Time(void)     const {return fTime;};
+    /*! Number of distinct formats seen so far. */
+    inline size_t  NFormats(void) const {return fFormats.size();};
+    /*! Records rendered so far. */
+    inline size_t  NRecords(void) const {return fNRecords;};
+
+    enum CLOGREADER_Errors {NO_FILE=1, BAD_MAGIC, BAD_RECORD, BAD_FORMAT};
+
+private:
+    /*! One stored argument. */
+    struct Arg {
+	char     Type;   // signature character
+	int64_t  I;
+	uint64_t U;
+	double   D;
+    };
+    struct Format {
+	std::string Signature;
+	std::string Text;
+    };
+
+    bool ReadVarint(uint64_t &v);
+    bool ReadBytes(std::string &s, size_t n);
+    bool ReadArgs(const std::string &Signature, std::vector<Arg> &Args);
+    void Render(const std::string &fmt, const std::vector<Arg> &Args,
+		std::string &Text);
+
+    std::ifstream        fIn;
+    std::vector<Format>  fFormats;
+    int64_t              fTime;
+    size_t               fNRecords;
+};
+#endif
@@ -10,6 +10,11 @@
  * Restrictions/Limitations : NONE
  *
  * Change Descriptions :
+ * 17-Oct-26 CBL Asynchronous mode. Everything goes through Emit, 
+ *               which either writes or queues. 
+ * 17-Oct-26 CBL Binary mode. 
+ * 17-Oct-26 CBL Flight recorder. 
+ * 17-Oct-26 CBL Fault dump with write(2) and no lock or heap. 
  *
  * Classification : Unclassified
  *
@@ -24,12 +29,103 @@ using namespace std;
 #include <cmath>
 #include <ctime>
 #include <cstdarg>
+#include <algorithm>
+#include <vector>
+#include <sys/time.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 // Local Includes.
 #include "CLogger.hh"
 
 CLogger* CLogger::fLogger;
 
+/*
+ * Record header in a queue. Payload follows, text is NUL terminated,
+ * a deferred record holds the argument tuple. Sizes are multiples
+ * of kRecordAlign so the next header and any tuple stay aligned. 
+ */
+const size_t kRecordAlign = 16;
+enum {kPAD_RECORD, kTEXT_RECORD, kDEFERRED_RECORD, kDEFERRED_TIME_RECORD};
+struct alignas(16) LogRecord {
+    uint32_t                Size;     // bytes including this header
+    uint16_t                Type;
+    uint16_t                Pad;
+    uint64_t                Sequence;
+    int64_t                 When;     // ns, deferred time or binary
+    const CLogArgs         *Info;     // deferred only
+    const char             *Fmt;
+};
+
+/*
+ * Single producer (the owning thread), single consumer (whoever holds
+ * the drain mutex). Head and Tail count bytes and never wrap. 
+ */
+struct CLogQueue {
+    std::atomic<uint64_t> Head;
+    std::atomic<uint64_t> Tail;
+    std::atomic<bool>     InUse;    // cleared when the owning thread exits
+    uint64_t              Pending;  // Head after the reserved record
+    size_t                Size;
+    unsigned char        *Data;
+    CLogQueue            *Next;
+};
+
+/*
+ * Flight recorder slot. Stamp is 0 while the owner writes it, then
+ * the ring's running count, so a reader can tell if it was 
+ * overwritten during the copy. 
+ */
+struct CLogSlot {
+    std::atomic<uint64_t>   Stamp;
+    int64_t                 When;     // ns
+    const CLogArgs         *Info;
+    const char             *Fmt;
+    int32_t                 Level;
+    alignas(16) unsigned char Args[kFR_ARGS];
+};
+
+/* One per thread, the owner overwrites the oldest slot. */
+struct CLogRing {
+    CLogSlot              *Slots;
+    uint64_t               Mask;
+    uint64_t               Count;    // slots written, owner only
+    std::atomic<uint64_t>  Dumped;   // Stamp of the last slot dumped
+    std::atomic<bool>      InUse;    // cleared when the owning thread exits
+    uint32_t               Index;    // shown in the dump
+    CLogRing              *Next;
+};
+
+/* A slot copied out by FaultDump. */
+struct CLogCopy {
+    int64_t                 When;
+    const CLogArgs         *Info;
+    const char             *Fmt;
+    int32_t                 Level;
+    alignas(16) unsigned char Args[kFR_ARGS];
+};
+
+/*
+ * Bumped by each constructor and destructor, a thread holding a 
+ * queue or ring from another generation must not touch it. 
+ */
+static std::atomic<uint64_t> sGeneration(0);
+
+/* This thread's queue and ring, released when the thread exits. */
+struct QueueHolder {
+    CLogQueue *Queue;
+    CLogRing  *Ring;
+    uint64_t   Generation;
+    ~QueueHolder() {
+	if (Generation == sGeneration.load())
+	{
+	    if (Queue) Queue->InUse.store(false, std::memory_order_release);
+	    if (Ring)  Ring->InUse.store(false, std::memory_order_release);
+	}
+    };
+};
+static thread_local QueueHolder tHolder = {NULL, NULL, 0};
+
 /**
  ******************************************************************
  *
@@ -50,10 +146,11 @@ CLogger* CLogger::fLogger;
  *
  *******************************************************************
  */
-CLogger::CLogger (const char *filename, const char *pgmname, double Version)
+CLogger::CLogger (const char *filename, const char *pgmname, double Version,
+		  bool Binary)
 {
     time_t now;
-    char   msg[128];
+    char   msg[128], buffer[BUFSIZ];
 
     if (fLogger)
     {
@@ -68,17 +165,46 @@ CLogger::CLogger (const char *filename, const char *pgmname, double Version)
     fOnOff   = true;
     fVerbose = 0;
 
+    fAsync         = false;
+    fFlushInterval = 0.1;
+    fQueueBytes    = 0;
+    fGeneration    = ++sGeneration;
+    fQueues.store(NULL);
+    fSequence.store(0);
+    fDropped.store(0);
+    fStop          = false;
+    fRingSlots     = 0;
+    fRings.store(NULL);
+    fFaultCopy     = NULL;
+    snprintf(fFaultName, sizeof(fFaultName), "%s.fault", filename);
+    pthread_mutex_init(&fDrainMutex, NULL);
+    pthread_cond_init(&fWake, NULL);
+
+    fBinary        = Binary;
+    fLastTime      = 0;
+
     time(&now);
     strftime (msg, sizeof(msg), "%F %T", gmtime(&now));
 
-    fLogptr = new ofstream(filename);
+    if (fBinary)
+    {
+	fLogptr = new ofstream(filename, ios::out | ios::binary);
+	fLogptr->write(kCLOG_MAGIC, sizeof(kCLOG_MAGIC));
+    }
+    else
+    {
+	fLogptr = new ofstream(filename);
+    }
 
-    *fLogptr << "# ########################################## " << endl;
-    *fLogptr << "# Program ";
-    if (pgmname != NULL) *fLogptr << pgmname << endl;
-    *fLogptr << "# Version: " << Version << endl;
-    *fLogptr << "# Program Begins: " << msg << endl;
-    *fLogptr << "# ########################################## " << endl;
+    int n = snprintf(buffer, sizeof(buffer), 
+		     "# ########################################## \n"
+		     "# Program %s%s"
+		     "# Version: %g\n"
+		     "# Program Begins: %s\n"
+		     "# ########################################## \n",
+		     pgmname ? pgmname : "", pgmname ? "\n" : "",
+		     Version, msg);
+    Emit(buffer, std::min((size_t) n, sizeof(buffer)-1));
 }
 /**
  ******************************************************************
@@ -104,58 +230,97 @@ CLogger::~CLogger ()
 {
     time_t now;
     char   msg[128];
-    time(&now);
 
+    if (fLogger != this)
+    {
+	/* The constructor refused us, nothing is ours to release. */
+	return;
+    }
+    if (fAsync)
+    {
+	pthread_mutex_lock(&fDrainMutex);
+	fStop = true;
+	pthread_cond_signal(&fWake);
+	pthread_mutex_unlock(&fDrainMutex);
+	pthread_join(fThread, NULL);
+	Flush();
+	fAsync = false;
+	CLogQueue *q = fQueues.load();
+	while (q)
+	{
+	    CLogQueue *next = q->Next;
+	    delete[] q->Data;
+	    delete q;
+	    q = next;
+	}
+    }
+    CLogRing *r = fRings.load();
+    while (r)
+    {
+	CLogRing *next = r->Next;
+	delete[] r->Slots;
+	delete r;
+	r = next;
+    }
+    delete[] fFaultCopy;
+    sGeneration++;
+    fLogger = NULL;
+
+    time(&now);
     strftime (msg, sizeof(msg), "%F %T", gmtime(&now));
-    *fLogptr << "# " << endl;
-    *fLogptr << "# Program Ends: " << msg << endl;
-    *fLogptr << "# ########################################## " << endl;
+    char buffer[256];
+    int n = snprintf(buffer, sizeof(buffer), 
+		     "# \n"
+		     "# Program Ends: %s\n"
+		     "# ########################################## \n", msg);
+    Emit(buffer, std::min((size_t) n, sizeof(buffer)-1));
+    pthread_cond_destroy(&fWake);
+    pthread_mutex_destroy(&fDrainMutex);
     fLogptr->close();
     delete fLogptr;
 }
 void CLogger::LogCommentTimestamp(const char *msg)
 {
     time_t now;
-    char   tmsg[128];
+    char   tmsg[128], buffer[BUFSIZ];
     time(&now);
     strftime (tmsg, sizeof(tmsg), "%F %T", gmtime(&now));
 
-    *fLogptr << "# "
-	     << tmsg << " : "
-	     << msg
-	     << endl;
+    int n = snprintf(buffer, sizeof(buffer), "# %s : %s\n", tmsg, msg);
+    Emit(buffer, std::min((size_t) n, sizeof(buffer)-1));
 }
 
 void CLogger::LogComment(const char *msg)
 {
     if (fOnOff) 
     {
-	*fLogptr << "# "<< msg;
-	fLogptr->flush();
+	Emit("# ", 2);
+	Emit(msg, strlen(msg));
     }
 }
 void CLogger::LogData(const char *msg) 
 {
     if (fOnOff) 
     {
-	*fLogptr << msg;
-	fLogptr->flush();
+	Emit(msg, strlen(msg));
     }
 }
 void CLogger::LogData(double f)
 {
     if(fOnOff)
     {
-	*fLogptr << f;
-	fLogptr->flush();
+	char buffer[64];
+	int n = snprintf(buffer, sizeof(buffer), "%g", f);
+	Emit(buffer, n);
     }
 }
 void CLogger::LogData(float f)
 {
     if(fOnOff)
     {
-	*fLogptr << f;
-	fLogptr->flush();
+	char buffer[64];
+	int n = snprintf(buffer, sizeof(buffer), "%g", f);
+	Emit(buffer, n);
     }
 }
 void CLogger::Log( const char *fmt, ...)
@@ -164,26 +329,23 @@ void CLogger::Log( const char *fmt, ...)
     char buffer[BUFSIZ];
 
     va_start (args, fmt);
-    vsnprintf(buffer, sizeof(buffer), fmt, args);
+    int n = vsnprintf(buffer, sizeof(buffer), fmt, args);
     va_end(args);
-    *fLogptr << buffer;
-    fLogptr->flush();
-
+    Emit(buffer, std::min((size_t) n, sizeof(buffer)-1));
 }
 void CLogger::LogTime(const char *fmt, ...)
 {
     time_t  now;
     va_list args;
-    char    buffer[BUFSIZ], tmsg[128];
+    char    buffer[BUFSIZ];
+
+    time(&now);
+    size_t n = strftime (buffer, sizeof(buffer), "# %F %T ", gmtime(&now));
 
     va_start (args, fmt);
-    vsnprintf(buffer, sizeof(buffer), fmt, args);
+    n += vsnprintf(buffer+n, sizeof(buffer)-n, fmt, args);
     va_end(args);
-
-    time(&now);
-    strftime (tmsg, sizeof(tmsg), "# %F %T", gmtime(&now));
-    *fLogptr << tmsg << " " << buffer;
-    fLogptr->flush();
+    Emit(buffer, std::min(n, sizeof(buffer)-1));
 }
 
 void CLogger::SetVerbose(unsigned int i)
@@ -195,14 +357,1043 @@ void CLogger::LogError( const char *File, int Line, char Level,
 			const char *text)
 {
     time_t now;
-    char   tmsg[128];
+    char   tmsg[128], buffer[BUFSIZ];
     time(&now);
     strftime (tmsg, sizeof(tmsg), "%y%m%d %T", gmtime(&now));
 
-    *fLogptr << "# Error-" << Level
-	     << " " << File
-	     << "," << Line << ","
-	     << tmsg << ","
-	     << text
-	     << endl;
+    int n = snprintf(buffer, sizeof(buffer), "# Error-%c %s,%d,%s,%s\n",
+		     Level, File, Line, tmsg, text);
+    DumpFlightRecorder("LogError");
+    Emit(buffer, std::min((size_t) n, sizeof(buffer)-1));
+    if (fAsync)
+    {
+	Flush();
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : CLogger::Emit
+ *
+ * Description : Single path to the log file. Written and flushed
+ *               at once normally, queued for the writer thread in 
+ *               async mode. 
+ *
+ * Inputs : Text   - text to log, need not be NUL terminated
+ *          Length - number of bytes
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : queue full, counted in Dropped()
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void CLogger::Emit(const char *Text, size_t Length)
+{
+    if (!fAsync)
+    {
+	if (fBinary)
+	{
+	    pthread_mutex_lock(&fDrainMutex);
+	    WriteText(Text, Length, Now());
+	    fLogptr->flush();
+	    pthread_mutex_unlock(&fDrainMutex);
+	    return;
+	}
+	fLogptr->write(Text, Length);
+	fLogptr->flush();
+	return;
+    }
+    char *p = (char *) Reserve(Length+1, false, NULL, NULL);
+    if (p)
+    {
+	memcpy(p, Text, Length);
+	p[Length] = 0;
+	Commit();
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : CLogger::SetAsync
+ *
+ * Description : Start the writer thread and queue from now on. 
+ *
+ * Inputs : FlushInterval - seconds between writes
+ *          QueueBytes    - size of each thread's queue, rounded up
+ *                          to a power of 2
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : already async
+ *                    thread create fails
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool CLogger::SetAsync(double FlushInterval, size_t QueueBytes)
+{
+    if (fAsync)
+    {
+	return false;
+    }
+    fFlushInterval = (FlushInterval > 0.0) ? FlushInterval : 0.1;
+    fQueueBytes    = 1024;
+    while (fQueueBytes < QueueBytes)
+    {
+	fQueueBytes <<= 1;
+    }
+    fStop       = false;
+    /* Anything written so far goes out before the queued records. */
+    fLogptr->flush();
+    if (pthread_create(&fThread, NULL, WriterThread, this) != 0)
+    {
+	return false;
+    }
+    fAsync = true;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : CLogger::ThreadQueue
+ *
+ * Description : Find this thread's queue. On first use claim one 
+ *               left by a thread that has exited, or make a new one
+ *               and push it on the list. No locks are taken. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : queue, NULL if out of memory
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+CLogQueue *CLogger::ThreadQueue(void)
+{
+    if (tHolder.Generation != fGeneration)
+    {
+	tHolder.Queue      = NULL;
+	tHolder.Ring       = NULL;
+	tHolder.Generation = fGeneration;
+    }
+    if (tHolder.Queue)
+    {
+	return tHolder.Queue;
+    }
+    CLogQueue *q;
+    for (q = fQueues.load(std::memory_order_acquire); q; q = q->Next)
+    {
+	bool expected = false;
+	if (q->InUse.compare_exchange_strong(expected, true))
+	{
+	    break;
+	}
+    }
+    if (!q)
+    {
+	q = new (std::nothrow) CLogQueue;
+	if (!q)
+	{
+	    return NULL;
+	}
+	q->Data = new (std::nothrow) unsigned char[fQueueBytes];
+	if (!q->Data)
+	{
+	    delete q;
+	    return NULL;
+	}
+	q->Size    = fQueueBytes;
+	q->Head.store(0);
+	q->Tail.store(0);
+	q->Pending = 0;
+	q->InUse.store(true);
+	q->Next    = fQueues.load();
+	while (!fQueues.compare_exchange_weak(q->Next, q, 
+					      std::memory_order_release))
+	{
+	}
+    }
+    else
+    {
+	/* A previous owner may have left a record reserved. */
+	q->Pending = q->Head.load(std::memory_order_relaxed);
+    }
+    tHolder.Queue      = q;
+    return q;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : CLogger::Reserve
+ *
+ * Description : Make room for one record in this thread's queue 
+ *               and fill in its header. A record never wraps, if 
+ *               it won't fit before the end a pad record takes up
+ *               the rest and it starts at the beginning. 
+ *
+ * Inputs : Bytes  - payload size
+ *          Time   - deferred record wants a timestamp
+ *          Info   - argument description for a deferred record, 
+ *                   NULL for text
+ *          fmt    - format for a deferred record
+ *
+ * Returns : pointer to the payload, NULL if dropped
+ *
+ * Error Conditions : queue full, counted in Dropped()
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void *CLogger::Reserve(size_t Bytes, bool Time, const CLogArgs *Info, 
+		       const char *fmt)
+{
+    CLogQueue *q = ThreadQueue();
+    size_t need  = (sizeof(LogRecord) + Bytes + kRecordAlign - 1) & 
+	~(kRecordAlign - 1);
+    if (!q || (need > q->Size))
+    {
+	fDropped.fetch_add(1, std::memory_order_relaxed);
+	return NULL;
+    }
+    uint64_t head  = q->Head.load(std::memory_order_relaxed);
+    uint64_t tail  = q->Tail.load(std::memory_order_acquire);
+    size_t   off   = head & (q->Size - 1);
+    size_t   room  = q->Size - off;
+    size_t   total = (room < need) ? room + need : need;
+    if (head + total - tail > q->Size)
+    {
+	fDropped.fetch_add(1, std::memory_order_relaxed);
+	return NULL;
+    }
+    if (room < need)
+    {
+	/* Size and Type fit in the smallest possible gap. */
+	LogRecord *pad = (LogRecord *) (q->Data + off);
+	pad->Size = room;
+	pad->Type = kPAD_RECORD;
+	head += room;
+	off   = 0;
+    }
+    LogRecord *rec = (LogRecord *) (q->Data + off);
+    rec->Size     = need;
+    rec->Type     = Info ? (Time ? kDEFERRED_TIME_RECORD : kDEFERRED_RECORD)
+	: kTEXT_RECORD;
+    rec->Sequence = fSequence.fetch_add(1, std::memory_order_relaxed);
+    rec->When     = (Time || fBinary) ? Now() : 0;
+    rec->Info     = Info;
+    rec->Fmt      = fmt;
+    q->Pending    = head + need;
+    return rec + 1;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : CLogger::Commit
+ *
+ * Description : Publish the record made by Reserve.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void CLogger::Commit(void)
+{
+    CLogQueue *q = tHolder.Queue;
+    q->Head.store(q->Pending, std::memory_order_release);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : CLogger::Drain
+ *
+ * Description : Write out the queued records in the order they were
+ *               made, across all threads, then flush the stream 
+ *               once. Only records that existed on entry are taken
+ *               so a busy producer can't keep us here. Caller holds
+ *               fDrainMutex. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void CLogger::Drain(void)
+{
+    uint64_t  Limit = fSequence.load(std::memory_order_acquire);
+    char      buffer[BUFSIZ];
+    struct tm tm;
+    bool      wrote = false;
+
+    while (true)
+    {
+	CLogQueue *best    = NULL;
+	LogRecord *bestrec = NULL;
+	for (CLogQueue *q = fQueues.load(std::memory_order_acquire); q; 
+	     q = q->Next)
+	{
+	    uint64_t tail = q->Tail.load(std::memory_order_relaxed);
+	    uint64_t head = q->Head.load(std::memory_order_acquire);
+	    LogRecord *rec = NULL;
+	    while (tail < head)
+	    {
+		rec = (LogRecord *) (q->Data + (tail & (q->Size - 1)));
+		if (rec->Type != kPAD_RECORD)
+		{
+		    break;
+		}
+		tail += rec->Size;
+		q->Tail.store(tail, std::memory_order_release);
+		rec = NULL;
+	    }
+	    if (rec && (rec->Sequence < Limit) && 
+		(!bestrec || (rec->Sequence < bestrec->Sequence)))
+	    {
+		best    = q;
+		bestrec = rec;
+	    }
+	}
+	if (!best)
+	{
+	    break;
+	}
+
+	const void *payload = bestrec + 1;
+	if (fBinary)
+	{
+	    if (bestrec->Type == kTEXT_RECORD)
+	    {
+		WriteText((const char *) payload, strlen((const char *)payload),
+			  bestrec->When);
+	    }
+	    else
+	    {
+		WriteData(bestrec->Type == kDEFERRED_TIME_RECORD, bestrec->Info,
+			  bestrec->Fmt, bestrec->When, payload);
+	    }
+	}
+	else if (bestrec->Type == kTEXT_RECORD)
+	{
+	    *fLogptr << (const char *) payload;
+	}
+	else
+	{
+	    size_t n = 0;
+	    if (bestrec->Type == kDEFERRED_TIME_RECORD)
+	    {
+		time_t when = bestrec->When/1000000000;
+		gmtime_r(&when, &tm);
+		n = strftime(buffer, sizeof(buffer), "# %F %T ", &tm);
+	    }
+	    bestrec->Info->Format(buffer+n, sizeof(buffer)-n, bestrec->Fmt, 
+				  payload);
+	    *fLogptr << buffer;
+	}
+	wrote = true;
+	best->Tail.fetch_add(bestrec->Size, std::memory_order_release);
+    }
+    if (wrote)
+    {
+	fLogptr->flush();
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : CLogger::Flush
+ *
+ * Description : Write out everything queued so far. Safe to call
+ *               from any thread, the writer thread is held off. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void CLogger::Flush(void)
+{
+    if (!fAsync)
+    {
+	fLogptr->flush();
+	return;
+    }
+    pthread_mutex_lock(&fDrainMutex);
+    Drain();
+    pthread_mutex_unlock(&fDrainMutex);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : CLogger::WriterThread
+ *
+ * Description : Drain the queues every flush interval until told 
+ *               to stop. 
+ *
+ * Inputs : pointer to the logger
+ *
+ * Returns : NULL
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void *CLogger::WriterThread(void *arg)
+{
+    CLogger *pThis = (CLogger *) arg;
+    struct timespec deadline;
+
+    pthread_mutex_lock(&pThis->fDrainMutex);
+    while (!pThis->fStop)
+    {
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	double t = deadline.tv_nsec*1.0e-9 + pThis->fFlushInterval;
+	deadline.tv_sec  += (time_t) t;
+	deadline.tv_nsec  = (long) ((t - floor(t))*1.0e9);
+	pthread_cond_timedwait(&pThis->fWake, &pThis->fDrainMutex, &deadline);
+	pThis->Drain();
+    }
+    pthread_mutex_unlock(&pThis->fDrainMutex);
+    return NULL;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : CLogger::Now
+ *
+ * Description : Record time stamp. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : ns since the epoch
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+int64_t CLogger::Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : CLogger::WriteText
+ *
+ * Description : Binary text record. Caller holds fDrainMutex. 
+ *
+ * Inputs : Text   - text, need not be NUL terminated
+ *          Length - bytes of text
+ *          When   - time in ns
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void CLogger::WriteText(const char *Text, size_t Length, int64_t When)
+{
+    unsigned char head[1+2*kCLOG_MAX_ARG];
+    size_t n = 0;
+    head[n++]  = kCLOG_TEXT;
+    n         += CLogPutVarint(head+n, CLogZigzag(When - fLastTime));
+    n         += CLogPutVarint(head+n, Length);
+    fLastTime  = When;
+    fLogptr->write((const char *) head, n);
+    fLogptr->write(Text, Length);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : CLogger::WriteData
+ *
+ * Description : Binary deferred record, preceded by the definition
+ *               of its format the first time the format and 
+ *               argument types are seen. Caller holds fDrainMutex. 
+ *
+ * Inputs : Time - rendered with a timestamp
+ *          Info - argument description
+ *          fmt  - format
+ *          When - time in ns
+ *          Args - argument tuple
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void CLogger::WriteData(bool Time, const CLogArgs *Info, const char *fmt,
+			int64_t When, const void *Args)
+{
+    unsigned char buffer[BUFSIZ];
+    size_t   n   = 0;
+    uint32_t id;
+    auto     key = std::make_pair(fmt, Info);
+    auto     it  = fFormatID.find(key);
+
+    if (it == fFormatID.end())
+    {
+	id = fFormatID.size();
+	fFormatID[key] = id;
+	size_t slen = strlen(Info->Signature);
+	size_t flen = strlen(fmt);
+	buffer[n++] = kCLOG_DEFINE;
+	n += CLogPutVarint(buffer+n, id);
+	n += CLogPutVarint(buffer+n, slen);
+	fLogptr->write((const char *) buffer, n);
+	fLogptr->write(Info->Signature, slen);
+	n = CLogPutVarint(buffer, flen);
+	fLogptr->write((const char *) buffer, n);
+	fLogptr->write(fmt, flen);
+	n = 0;
+    }
+    else
+    {
+	id = it->second;
+    }
+    buffer[n++] = Time ? kCLOG_DATA_TIME : kCLOG_DATA;
+    n += CLogPutVarint(buffer+n, id);
+    n += CLogPutVarint(buffer+n, CLogZigzag(When - fLastTime));
+    n += Info->Encode(buffer+n, Args);
+    fLastTime = When;
+    fLogptr->write((const char *) buffer, n);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : CLogger::Record
+ *
+ * Description : Binary deferred record written straight from the
+ *               calling thread when not async. 
+ *
+ * Inputs : Time - rendered with a timestamp
+ *          Info - argument description
+ *          fmt  - format
+ *          Args - argument tuple
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void CLogger::Record(bool Time, const CLogArgs *Info, const char *fmt, 
+		     const void *Args)
+{
+    pthread_mutex_lock(&fDrainMutex);
+    WriteData(Time, Info, fmt, Now(), Args);
+    fLogptr->flush();
+    pthread_mutex_unlock(&fDrainMutex);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : CLogger::Put
+ *
+ * Description : Text straight to the file, as a text record in 
+ *               binary mode. Caller holds fDrainMutex. 
+ *
+ * Inputs : Text   - text, need not be NUL terminated
+ *          Length - bytes of text
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void CLogger::Put(const char *Text, size_t Length)
+{
+    if (fBinary)
+    {
+	WriteText(Text, Length, Now());
+    }
+    else
+    {
+	fLogptr->write(Text, Length);
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : CLogger::SetFlightRecorder
+ *
+ * Description : Enable the flight recorder. Each thread gets its 
+ *               ring the first time it calls LogVerbose. The copy
+ *               buffer for FaultDump is allocated here, a signal
+ *               handler can't. 
+ *
+ * Inputs : NRecords - records kept per thread, rounded up to a 
+ *                     power of 2
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : already enabled, out of memory
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool CLogger::SetFlightRecorder(size_t NRecords)
+{
+    if (fRingSlots > 0)
+    {
+	return false;
+    }
+    size_t n = 16;
+    while (n < NRecords)
+    {
+	n <<= 1;
+    }
+    fFaultCopy = new (std::nothrow) CLogCopy[n];
+    if (!fFaultCopy)
+    {
+	return false;
+    }
+    fRingSlots = n;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : CLogger::ThreadRing
+ *
+ * Description : Find this thread's ring. On first use claim one 
+ *               left by a thread that has exited, or make a new one
+ *               and push it on the list. No locks are taken. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : ring, NULL if out of memory
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+CLogRing *CLogger::ThreadRing(void)
+{
+    if (tHolder.Generation != fGeneration)
+    {
+	tHolder.Queue      = NULL;
+	tHolder.Ring       = NULL;
+	tHolder.Generation = fGeneration;
+    }
+    if (tHolder.Ring)
+    {
+	return tHolder.Ring;
+    }
+    CLogRing *r;
+    for (r = fRings.load(std::memory_order_acquire); r; r = r->Next)
+    {
+	bool expected = false;
+	if (r->InUse.compare_exchange_strong(expected, true))
+	{
+	    break;
+	}
+    }
+    if (!r)
+    {
+	r = new (std::nothrow) CLogRing;
+	if (!r)
+	{
+	    return NULL;
+	}
+	r->Slots = new (std::nothrow) CLogSlot[fRingSlots];
+	if (!r->Slots)
+	{
+	    delete r;
+	    return NULL;
+	}
+	for (size_t i=0; i<fRingSlots; i++)
+	{
+	    r->Slots[i].Stamp.store(0);
+	}
+	r->Mask  = fRingSlots - 1;
+	r->Count = 0;
+	r->Dumped.store(0);
+	r->InUse.store(true);
+	r->Next  = fRings.load();
+	do
+	{
+	    r->Index = r->Next ? r->Next->Index + 1 : 0;
+	} while (!fRings.compare_exchange_weak(r->Next, r, 
+					       std::memory_order_release));
+    }
+    tHolder.Ring = r;
+    return r;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : CLogger::Capture
+ *
+ * Description : Take the oldest slot of this thread's ring and fill
+ *               in its header. The slot reads as busy until 
+ *               Captured(). 
+ *
+ * Inputs : Level - verbose level of the record
+ *          Info  - argument description
+ *          fmt   - format
+ *
+ * Returns : where the argument tuple goes, NULL if there is no ring
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void *CLogger::Capture(int Level, const CLogArgs *Info, const char *fmt)
+{
+    CLogRing *r = ThreadRing();
+    if (!r)
+    {
+	return NULL;
+    }
+    CLogSlot *s = &r->Slots[r->Count & r->Mask];
+    s->Stamp.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    s->When  = Now();
+    s->Info  = Info;
+    s->Fmt   = fmt;
+    s->Level = Level;
+    return s->Args;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : CLogger::Captured
+ *
+ * Description : Publish the slot taken by Capture. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void CLogger::Captured(void)
+{
+    CLogRing *r = tHolder.Ring;
+    CLogSlot *s = &r->Slots[r->Count & r->Mask];
+    r->Count++;
+    s->Stamp.store(r->Count, std::memory_order_release);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : CLogger::DumpFlightRecorder
+ *
+ * Description : Copy out every slot not dumped before, skipping any
+ *               being overwritten, sort all threads by time and 
+ *               write them between marker comments. Anything 
+ *               queued in async mode goes out first. 
+ *
+ *               Fault is set from a fatal signal handler, where 
+ *               the faulting thread may hold fDrainMutex or be in
+ *               malloc, FaultDump does the work then. 
+ *
+ * Inputs : Reason - shown in the opening marker, may be NULL
+ *          Fault  - called on the way out from a fatal signal
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void CLogger::DumpFlightRecorder(const char *Reason, bool Fault)
+{
+    struct Copy {
+	int64_t         When;
+	const CLogArgs *Info;
+	const char     *Fmt;
+	int32_t         Level;
+	uint32_t        Index;
+	alignas(16) unsigned char Args[kFR_ARGS];
+    };
+    std::vector<Copy> records;
+    char      buffer[BUFSIZ];
+    struct tm tm;
+
+    if (fRingSlots == 0)
+    {
+	return;
+    }
+    if (Fault)
+    {
+	FaultDump(Reason);
+	return;
+    }
+    pthread_mutex_lock(&fDrainMutex);
+    if (fAsync)
+    {
+	Drain();
+    }
+
+    for (CLogRing *r = fRings.load(std::memory_order_acquire); r; r = r->Next)
+    {
+	uint64_t last   = r->Dumped.load();
+	uint64_t newest = last;
+	for (size_t k=0; k<=r->Mask; k++)
+	{
+	    CLogSlot *s = &r->Slots[k];
+	    uint64_t  a = s->Stamp.load(std::memory_order_acquire);
+	    if (a <= last)
+	    {
+		continue;
+	    }
+	    Copy c;
+	    c.When  = s->When;
+	    c.Info  = s->Info;
+	    c.Fmt   = s->Fmt;
+	    c.Level = s->Level;
+	    c.Index = r->Index;
+	    memcpy(c.Args, s->Args, sizeof(c.Args));
+	    std::atomic_thread_fence(std::memory_order_acquire);
+	    if (s->Stamp.load(std::memory_order_relaxed) != a)
+	    {
+		continue;
+	    }
+	    records.push_back(c);
+	    newest = std::max(newest, a);
+	}
+	r->Dumped.store(newest);
+    }
+    std::sort(records.begin(), records.end(), 
+	      [](const Copy &x, const Copy &y) {return x.When < y.When;});
+    if (records.empty())
+    {
+	pthread_mutex_unlock(&fDrainMutex);
+	return;
+    }
+
+    int n = snprintf(buffer, sizeof(buffer), 
+		     "# Flight recorder %s, %zu records\n", 
+		     Reason ? Reason : "dump", records.size());
+    Put(buffer, std::min((size_t) n, sizeof(buffer)-1));
+    for (size_t i=0; i<records.size(); i++)
+    {
+	const Copy &c = records[i];
+	time_t when = c.When/1000000000;
+	gmtime_r(&when, &tm);
+	size_t m = strftime(buffer, sizeof(buffer), "# FR %T", &tm);
+	m += snprintf(buffer+m, sizeof(buffer)-m, ".%06ld T%u L%d ", 
+		      (long) (c.When % 1000000000)/1000, c.Index, c.Level);
+	m  = std::min(m, sizeof(buffer)-2);
+	m += c.Info->Format(buffer+m, sizeof(buffer)-m, c.Fmt, c.Args);
+	m  = std::min(m, sizeof(buffer)-2);
+	if (buffer[m-1] != '\n')
+	{
+	    buffer[m++] = '\n';
+	}
+	Put(buffer, m);
+    }
+    Put("# Flight recorder end\n", 22);
+    fLogptr->flush();
+    pthread_mutex_unlock(&fDrainMutex);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : CLogger::FaultDump
+ *
+ * Description : DumpFlightRecorder from a fatal signal handler. 
+ *               No lock, no heap, no stdio streams. Each ring is 
+ *               walked by Stamp, oldest first, into fFaultCopy and
+ *               written as text with write(2) to fFaultName. The 
+ *               threads are not merged, the T field tells them 
+ *               apart. Nothing queued in async mode is drained. 
+ *
+ * Inputs : Reason - shown in the opening marker, may be NULL
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : the file can't be opened, nothing is written
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void CLogger::FaultDump(const char *Reason)
+{
+    char buffer[BUFSIZ];
+    int  fd = open(fFaultName, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0)
+    {
+	return;
+    }
+    int n = snprintf(buffer, sizeof(buffer), "# Flight recorder %s\n", 
+		     Reason ? Reason : "dump");
+    if (write(fd, buffer, std::min((size_t) n, sizeof(buffer)-1)) < 0)
+    {
+	close(fd);
+	return;
+    }
+    for (CLogRing *r = fRings.load(std::memory_order_acquire); r; r = r->Next)
+    {
+	/* Newest published stamp, then back at most a ring's worth. */
+	uint64_t newest = r->Dumped.load();
+	for (size_t k=0; k<=r->Mask; k++)
+	{
+	    newest = std::max(newest, 
+			      r->Slots[k].Stamp.load(std::memory_order_acquire));
+	}
+	uint64_t first = r->Dumped.load() + 1;
+	if (newest > r->Mask + first)
+	{
+	    first = newest - r->Mask;
+	}
+	size_t count = 0;
+	for (uint64_t seq=first; seq<=newest; seq++)
+	{
+	    CLogSlot *s = &r->Slots[(seq-1) & r->Mask];
+	    if (s->Stamp.load(std::memory_order_acquire) != seq)
+	    {
+		continue;
+	    }
+	    CLogCopy *c = &fFaultCopy[count];
+	    c->When  = s->When;
+	    c->Info  = s->Info;
+	    c->Fmt   = s->Fmt;
+	    c->Level = s->Level;
+	    memcpy(c->Args, s->Args, sizeof(c->Args));
+	    std::atomic_thread_fence(std::memory_order_acquire);
+	    if (s->Stamp.load(std::memory_order_relaxed) == seq)
+	    {
+		count++;
+	    }
+	}
+	r->Dumped.store(newest);
+	for (size_t i=0; i<count; i++)
+	{
+	    const CLogCopy *c = &fFaultCopy[i];
+	    /* gmtime_r may take the time zone lock, split by hand. */
+	    int64_t day = (c->When / 1000000000) % 86400;
+	    size_t  m   = snprintf(buffer, sizeof(buffer), 
+				   "# FR %02d:%02d:%02d.%06ld T%u L%d ",
+				   (int) (day/3600), (int) (day/60 % 60), 
+				   (int) (day % 60),
+				   (long) (c->When % 1000000000)/1000, 
+				   r->Index, c->Level);
+	    m  = std::min(m, sizeof(buffer)-2);
+	    m += c->Info->Format(buffer+m, sizeof(buffer)-m, c->Fmt, c->Args);
+	    m  = std::min(m, sizeof(buffer)-2);
+	    if (buffer[m-1] != '\n')
+	    {
+		buffer[m++] = '\n';
+	    }
+	    if (write(fd, buffer, m) < 0)
+	    {
+		close(fd);
+		return;
+	    }
+	}
+    }
+    ssize_t rc = write(fd, "# Flight recorder end\n", 22);
+    close(fd);
+    (void) rc;
 }
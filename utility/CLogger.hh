@@ -10,6 +10,16 @@
  * Restrictions/Limitations : none
  *
  * Change Descriptions :
+ * 17-Oct-26 CBL Asynchronous mode, per thread lock free queues 
+ *               drained by a writer thread. 
+ * 17-Oct-26 CBL Binary mode, format id plus raw arguments, rendered
+ *               back to text by CLogReader/logformat. 
+ * 17-Oct-26 CBL Flight recorder, per thread in memory ring of 
+ *               verbose records dumped on error, signal or command. 
+ * 17-Oct-26 CBL Deferred and verbose templates moved to 
+ *               CLogDeferred.hh, this header is C++11 again. 
+ * 17-Oct-26 CBL The fault dump takes no lock and does not allocate,
+ *               it writes with write(2) to a .fault file. 
  *
  * Classification : Unclassified
  *
@@ -21,23 +31,46 @@
 #ifndef __CLOGGER_hh_
 #define __CLOGGER_hh_
 #include <fstream>
+#include <cstdio>
+#include <atomic>
+#include <stdint.h>
+#include <pthread.h>
+#include <map>
 #include "debug.h"
+#include "CLogBinary.hh"
+
+/*! Per thread record queue and flight recorder ring, 
+ * defined in CLogger.cpp */
+struct CLogQueue;
+struct CLogRing;
+struct CLogCopy;
+
+/*! Largest argument tuple the flight recorder keeps. */
+const size_t kFR_ARGS = 80;
 
 class CLogger {
 public:
-    CLogger (const char *logfile, const char *pgmname=NULL, double Version=0.0);
+    /*!
+     * Binary true writes the compact stream described in 
+     * CLogBinary.hh instead of text, see the logformat tool. 
+     */
+    CLogger (const char *logfile, const char *pgmname=NULL, double Version=0.0,
+	     bool Binary=false);
     ~CLogger();
-    /*! Return the pointer assocated with the log stream */
+    /*! Return the pointer assocated with the log stream. In async
+     * mode call Flush() first, writes through this pointer are not 
+     * ordered with the queued records. Don't write through it in 
+     * binary mode. */
     ofstream*   LogPtr(void) {return fLogptr;};
 
     /*! Control logging */
     inline void Toggle(bool onoff=true) {fOnOff = onoff;};
 
     /*! Insert CR/LF */
-    inline void CR(void)     {if(fOnOff) *fLogptr << endl;};
+    inline void CR(void)     {if(fOnOff) Emit("\n", 1);};
 
     /*! Insert space in stream. */
-    inline void Space(void)  {if(fOnOff) *fLogptr << " ";};
+    inline void Space(void)  {if(fOnOff) Emit(" ", 1);};
 
     /*! Set the verbosity level for the logging. */
     void SetVerbose(unsigned int i);
@@ -74,13 +107,125 @@ public:
     /*! Log a variable format with a timestamp, no endl. */
     void LogTime(const char *fmt, ...);
 
-    /*! Full up log error. Includes endl. */
+    /*! Full up log error. Includes endl. Always flushed, even
+     * in async mode. */
     void LogError( const char *File, int Line, char Level, const char *text);
 
+    /*!
+     * Switch to asynchronous logging. Each calling thread gets a 
+     * lock free queue of QueueBytes, the caller only copies its 
+     * record in. A background thread writes everything out every
+     * FlushInterval seconds, oldest record first across threads. 
+     * Records that don't fit are dropped and counted. LogError 
+     * and the destructor always flush. 
+     * Returns false if already async or the thread can't start. 
+     */
+    bool SetAsync(double FlushInterval=0.1, size_t QueueBytes=65536);
+
+    /*! true if records are queued for the writer thread. */
+    inline bool Async(void) const {return fAsync;};
+
+    /*! Write out everything queued so far, in the calling thread. */
+    void Flush(void);
+
+    /*! Records lost because a queue was full. */
+    inline uint64_t Dropped(void) const 
+	{return fDropped.load(std::memory_order_relaxed);};
+
+    /*! true if writing the binary stream. */
+    inline bool Binary(void) const {return fBinary;};
+
+    /*!
+     * Deferred format. Only the format pointer and the arguments are
+     * kept, the writer thread does the formatting. fmt must stay 
+     * valid (a string literal) and the arguments must be numbers. 
+     * Same as Log() when neither async nor binary. In binary mode 
+     * the text is never formatted, the arguments are stored against
+     * a format id. Needs C++17 and CLogDeferred.hh. 
+     */
+    template<typename... A> void LogDeferred(const char *fmt, A... args);
+    /*! Deferred format with a timestamp taken at the call, as LogTime. */
+    template<typename... A> void LogTimeDeferred(const char *fmt, A... args);
+
+    /*!
+     * Keep the last NRecords verbose records of each thread in 
+     * memory. They cost a timestamp and a copy of the arguments, 
+     * nothing is formatted or written unless the ring is dumped. 
+     * Returns false if already enabled. 
+     */
+    bool SetFlightRecorder(size_t NRecords=1024);
+    inline bool FlightRecorder(void) const {return (fRingSlots>0);};
+
+    /*!
+     * Verbose record, same arguments as LogDeferred. Logged if 
+     * CheckVerbose(Level), always kept by the flight recorder. 
+     * Needs C++17 and CLogDeferred.hh. 
+     */
+    template<typename... A> 
+    void LogVerbose(int Level, const char *fmt, A... args);
+
+    /*!
+     * Write the flight recorder records not yet dumped, all threads,
+     * oldest first, between marker comments naming Reason. 
+     * LogError does this itself. Otherwise it waits for the log lock
+     * and is not async signal safe. 
+     * Fault true only from a fatal signal handler: no lock, no heap,
+     * each thread oldest first but not merged by time, and the text
+     * goes with write(2) to the log name plus ".fault", since the 
+     * log stream may be half way through a buffer. 
+     */
+    void DumpFlightRecorder(const char *Reason=NULL, bool Fault=false);
+
     /*! Access the This pointer. */
     static CLogger* GetThis(void) {return fLogger;};
 
 private:
+    /*! Write, or queue, a formatted piece of text. */
+    void  Emit(const char *Text, size_t Length);
+
+    /*! 
+     * Space for Bytes of payload in this thread's queue, NULL if
+     * the record was dropped. Commit() makes it visible. 
+     */
+    void *Reserve(size_t Bytes, bool Time, const CLogArgs *Info, 
+		  const char *fmt);
+    void  Commit(void);
+
+    /*! This thread's queue, claimed or created on first use. */
+    CLogQueue *ThreadQueue(void);
+
+    /*! Write out all queued records, caller holds fDrainMutex. */
+    void  Drain(void);
+    static void *WriterThread(void *);
+
+    /*! Flight recorder slot for this thread, Captured() publishes. */
+    void *Capture(int Level, const CLogArgs *Info, const char *fmt);
+    void  Captured(void);
+    CLogRing *ThreadRing(void);
+    /*! DumpFlightRecorder from a fatal signal handler. */
+    void  FaultDump(const char *Reason);
+
+    /*! Text straight to the file, caller holds fDrainMutex. */
+    void  Put(const char *Text, size_t Length);
+
+    /*! Binary records, caller holds fDrainMutex. */
+    void  WriteText(const char *Text, size_t Length, int64_t When);
+    void  WriteData(bool Time, const CLogArgs *Info, const char *fmt,
+		    int64_t When, const void *Args);
+    /*! Binary record straight from the calling thread. */
+    void  Record(bool Time, const CLogArgs *Info, const char *fmt, 
+		 const void *Args);
+    static int64_t Now(void);
+
+    /* Deferred record plumbing, defined in CLogDeferred.hh. */
+    template<typename... A> 
+    static int FormatDeferred(char *Buffer, size_t Size, const char *fmt,
+			      const void *Args);
+    template<typename... A> 
+    static size_t EncodeDeferred(unsigned char *Out, const void *Args);
+    template<typename... A> static const CLogArgs *Describe(void);
+    template<typename... A> 
+    void Defer(bool Time, const char *fmt, A... args);
 
     /*! Control ther verbosity level of output. */
     int    fVerbose;
@@ -89,6 +234,30 @@ private:
     /*! Maintain a copy of the stream pointer */
     ofstream*       fLogptr;
 
+    /* Binary mode. */
+    bool                    fBinary;
+    int64_t                 fLastTime;       // of the last binary record
+    std::map<std::pair<const char*, const CLogArgs*>, uint32_t> fFormatID;
+
+    /* Asynchronous mode. */
+    bool                    fAsync;
+    double                  fFlushInterval;
+    size_t                  fQueueBytes;     // power of 2
+    uint64_t                fGeneration;     // tells thread state from an old logger
+    std::atomic<CLogQueue*> fQueues;         // list of all queues
+    std::atomic<uint64_t>   fSequence;       // global record order
+    std::atomic<uint64_t>   fDropped;
+
+    /* Flight recorder. */
+    size_t                  fRingSlots;      // per thread, power of 2
+    std::atomic<CLogRing*>  fRings;
+    CLogCopy               *fFaultCopy;      // fRingSlots, for FaultDump
+    char                    fFaultName[256];
+    pthread_t               fThread;
+    pthread_mutex_t         fDrainMutex;
+    pthread_cond_t          fWake;
+    bool                    fStop;
+
     /*! The static 'this' pointer. */
     static CLogger *fLogger;
 };
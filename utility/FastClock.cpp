@@ -0,0 +1,467 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : FastClock.cpp
+ *
+ * Author/Date : C.B. Lirakis / 17-Oct-26
+ *
+ * Description : TSC time stamps, calibration and conversion.
+ *
+ * Restrictions/Limitations : NONE
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References : Intel SDM vol 3, 17.17 Time-Stamp Counter
+ *
+ *******************************************************************
+ */
+// System includes.
+#include <iostream>
+using namespace std;
+#include <cmath>
+#include <pthread.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#  include <cpuid.h>
+#endif
+
+/// Local Includes.
+#include "debug.h"
+#include "FastClock.hh"
+
+volatile bool              FastClock::fReady  = false;
+volatile FastClock::SOURCE FastClock::fSource = FastClock::kCLOCK_GETTIME;
+
+/** Counter to CLOCK_REALTIME, Real + (Ticks - Base)*Scale ns. */
+static struct {
+    uint32_t Sequence;   // odd while Calibrate is writing
+    uint64_t Base;
+    int64_t  Real;
+    double   Scale;      // ns per tick
+} sModel;
+
+static pthread_once_t sOnce       = PTHREAD_ONCE_INIT;
+/* Last CLOCK_MONOTONIC sample, the rate is measured from it. */
+static uint64_t       sMonoTicks  = 0;
+static int64_t        sMonoNS     = 0;
+static uint32_t       sSuspect    = 0;
+
+/* Seconds between re-anchors. */
+static const unsigned kANCHOR      = 1;
+/* Length of the first calibration, ns. */
+static const long     kFIRST_CAL   = 10000000L;
+/* Rate change counted as suspect. */
+static const double   kSUSPECT     = 100.0e-6;
+
+static inline uint64_t ReadTSC(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+/* true if CPUID says the TSC runs at a constant rate in all states. */
+static bool InvariantTSC(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int a, b, c, d;
+    if ((__get_cpuid(0x80000000, &a, &b, &c, &d) == 0) || (a < 0x80000007))
+    {
+	return false;
+    }
+    __get_cpuid(0x80000007, &a, &b, &c, &d);
+    return (d & (1 << 8)) != 0;
+#else
+    return false;
+#endif
+}
+
+/**
+ ******************************************************************
+ *
+ * Function Name : Init
+ *
+ * Description : Run Setup once for the process.
+ *
+ * Inputs : NONE
+ *
+ * Returns : source in use
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+FastClock::SOURCE FastClock::Init(void)
+{
+    pthread_once(&sOnce, Setup);
+    return fSource;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Setup
+ *
+ * Description : Use the TSC if it is invariant and the first
+ *               calibration gives a believable rate, then start the
+ *               re-anchor thread. Otherwise stay on clock_gettime.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void FastClock::Setup(void)
+{
+    SET_DEBUG_STACK;
+    pthread_t      thread;
+    pthread_attr_t attr;
+    double         hz;
+
+    if (InvariantTSC())
+    {
+	Calibrate(true);
+	hz = 1.0e9/sModel.Scale;
+	if ((hz > 1.0e8) && (hz < 1.0e10))
+	{
+	    fSource = kTSC;
+	    pthread_attr_init(&attr);
+	    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	    if (pthread_create(&thread, &attr, Thread, NULL) != 0)
+	    {
+		fSource = kCLOCK_GETTIME;
+	    }
+	    pthread_attr_destroy(&attr);
+	}
+    }
+    fReady = true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Thread
+ *
+ * Description : Re-anchor every kANCHOR seconds while the TSC is
+ *               in use.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NULL
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void *FastClock::Thread(void *)
+{
+    while (fSource == kTSC)
+    {
+	sleep(kANCHOR);
+	Calibrate(false);
+    }
+    return NULL;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Sample
+ *
+ * Description : Pair a counter value with a clock reading. The
+ *               clock read is bracketed by two counter reads and the
+ *               tightest of a few tries is kept, the counter value
+ *               being the middle of the bracket.
+ *
+ * Inputs : Clock - clock to read
+ *          Ticks - counter value returned
+ *          NS    - clock value returned, ns
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void FastClock::Sample(clockid_t Clock, uint64_t &Ticks, int64_t &NS)
+{
+    struct timespec t;
+    uint64_t        t1, t2, best = UINT64_MAX;
+
+    for (int i=0; i<5; i++)
+    {
+	t1 = ReadTSC();
+	clock_gettime(Clock, &t);
+	t2 = ReadTSC();
+	if (t2 - t1 < best)
+	{
+	    best  = t2 - t1;
+	    Ticks = t1 + (t2 - t1)/2;
+	    NS    = (int64_t) t.tv_sec*1000000000LL + t.tv_nsec;
+	}
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Calibrate
+ *
+ * Description : Measure the counter rate against CLOCK_MONOTONIC
+ *               since the last call and anchor the counter to
+ *               CLOCK_REALTIME now. The first call waits kFIRST_CAL
+ *               to have something to measure against.
+ *
+ * Inputs : First - true from Setup
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void FastClock::Calibrate(bool First)
+{
+    struct timespec wait = {0, kFIRST_CAL};
+    uint64_t        monoTicks, realTicks;
+    int64_t         monoNS, realNS;
+    double          scale;
+    uint32_t        seq;
+
+    if (First)
+    {
+	Sample(CLOCK_MONOTONIC, sMonoTicks, sMonoNS);
+	nanosleep(&wait, NULL);
+    }
+    Sample(CLOCK_MONOTONIC, monoTicks, monoNS);
+    Sample(CLOCK_REALTIME,  realTicks, realNS);
+    if (monoTicks == sMonoTicks)
+    {
+	return;
+    }
+    scale = (double) (monoNS - sMonoNS)/(double) (monoTicks - sMonoTicks);
+    sMonoTicks = monoTicks;
+    sMonoNS    = monoNS;
+    if (!First && (fabs(scale/sModel.Scale - 1.0) > kSUSPECT))
+    {
+	__atomic_add_fetch(&sSuspect, 1, __ATOMIC_RELAXED);
+    }
+
+    seq = __atomic_load_n(&sModel.Sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&sModel.Sequence, seq+1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&sModel.Base, realTicks, __ATOMIC_RELAXED);
+    __atomic_store_n(&sModel.Real, realNS,    __ATOMIC_RELAXED);
+    __atomic_store(&sModel.Scale,  &scale,    __ATOMIC_RELAXED);
+    __atomic_store_n(&sModel.Sequence, seq+2, __ATOMIC_RELEASE);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : ToNS
+ *
+ * Description : Stamp to CLOCK_REALTIME ns with the current anchor.
+ *
+ * Inputs : Ticks - from Ticks()
+ *
+ * Returns : ns since the epoch
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+int64_t FastClock::ToNS(uint64_t Ticks)
+{
+    uint64_t base;
+    int64_t  real;
+    double   scale;
+    uint32_t seq;
+
+    if (fSource != kTSC)
+    {
+	return (int64_t) Ticks;
+    }
+    do
+    {
+	seq  = __atomic_load_n(&sModel.Sequence, __ATOMIC_ACQUIRE);
+	base = __atomic_load_n(&sModel.Base, __ATOMIC_RELAXED);
+	real = __atomic_load_n(&sModel.Real, __ATOMIC_RELAXED);
+	__atomic_load(&sModel.Scale, &scale, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) ||
+	     (seq != __atomic_load_n(&sModel.Sequence, __ATOMIC_RELAXED)));
+    return real + (int64_t) llround((double) (int64_t) (Ticks - base)*scale);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : ToTimespec
+ *
+ * Description : Stamp to timespec.
+ *
+ * Inputs : Ticks - from Ticks()
+ *          Out   - filled in
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void FastClock::ToTimespec(uint64_t Ticks, struct timespec &Out)
+{
+    int64_t ns = ToNS(Ticks);
+    Out.tv_sec  = ns / 1000000000LL;
+    Out.tv_nsec = ns % 1000000000LL;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : ToPreciseTime
+ *
+ * Description : Stamp to PreciseTime.
+ *
+ * Inputs : Ticks - from Ticks()
+ *
+ * Returns : the time
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+PreciseTime FastClock::ToPreciseTime(uint64_t Ticks)
+{
+    struct timespec t;
+    ToTimespec(Ticks, t);
+    return PreciseTime(t);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Now
+ *
+ * Description : Stamp and convert at once.
+ *
+ * Inputs : Out - filled in with CLOCK_REALTIME
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void FastClock::Now(struct timespec &Out)
+{
+    ToTimespec(Ticks(), Out);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Source, Frequency, Suspect
+ *
+ * Description : Calibration state.
+ *
+ * Inputs : NONE
+ *
+ * Returns : as named, Frequency 0 in clock_gettime mode
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+FastClock::SOURCE FastClock::Source(void)
+{
+    return Init();
+}
+double FastClock::Frequency(void)
+{
+    double scale;
+    if (Init() != kTSC)
+    {
+	return 0.0;
+    }
+    __atomic_load(&sModel.Scale, &scale, __ATOMIC_RELAXED);
+    return 1.0e9/scale;
+}
+uint32_t FastClock::Suspect(void)
+{
+    return __atomic_load_n(&sSuspect, __ATOMIC_RELAXED);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Disable
+ *
+ * Description : Drop back to clock_gettime, the re-anchor thread
+ *               exits at its next wake up.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void FastClock::Disable(void)
+{
+    Init();
+    fSource = kCLOCK_GETTIME;
+}
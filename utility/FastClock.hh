@@ -0,0 +1,124 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : FastClock.hh
+ *
+ * Author/Date : C.B. Lirakis / 17-Oct-26
+ *
+ * Description : Cheap time stamps from the CPU time stamp counter.
+ *
+ * clock_gettime is only a few tens of ns when the kernel clock
+ * source is the TSC and the vDSO can read it. On older boxes, or
+ * when the kernel has fallen back to hpet or acpi_pm, every call is
+ * a system call and a slow device read. Here the stamp is just the
+ * TSC, a single instruction, and turning it into a time is put off
+ * until someone wants to look at it.
+ *
+ * The first use calibrates the counter against CLOCK_MONOTONIC for
+ * a few ms, then a thread re-anchors it against CLOCK_REALTIME once
+ * a second, so the conversion follows NTP and stays within about
+ * a microsecond of the system clock. If the CPU does not advertise an
+ * invariant TSC, or the first calibration makes no sense, Ticks is
+ * CLOCK_REALTIME in ns and the conversions do nothing.
+ *
+ * Opt in only, nothing in the libraries calls it. Where the vDSO
+ * clock_gettime is fast, Now is no faster and is less accurate, the
+ * win is only in taking Ticks in a hot path and converting later.
+ *
+ * Restrictions/Limitations : x86 only, anything else uses the
+ * clock_gettime fallback. Ticks is not serializing, it may be taken
+ * a few instructions early or late. A re-anchor may move the
+ * converted time back by the accumulated error, about a us. The
+ * first use stalls for the calibration and starts a detached
+ * thread. A child made by fork has no re-anchor thread, call
+ * Disable in it.
+ *
+ * Change Descriptions :
+ * 17-Oct-26 CBL TimeUtil::Now back on clock_gettime, this is opt in.
+ *
+ * Classification : Unclassified
+ *
+ * References : Intel SDM vol 3, 17.17 Time-Stamp Counter
+ *
+ *******************************************************************
+ */
+#ifndef __FASTCLOCK_hh_
+#define __FASTCLOCK_hh_
+#  include <time.h>
+#  include <stdint.h>
+#  if defined(__x86_64__) || defined(__i386__)
+#    include <x86intrin.h>
+#  endif
+#  include "precisetime.hh"
+
+/**
+ * All static, there is one counter and one calibration per process.
+ */
+class FastClock
+{
+public:
+    /// Where Ticks comes from.
+    enum SOURCE {kCLOCK_GETTIME=0, kTSC};
+
+    /**
+     * Pick the source and calibrate, start the re-anchor thread.
+     * Called by the first Ticks, only needed to move the few ms of
+     * calibration out of the way. Safe to call more than once.
+     */
+    static SOURCE Init(void);
+
+    /**
+     * Raw stamp. TSC counts in kTSC mode, CLOCK_REALTIME ns
+     * otherwise. Keep it and convert later with ToNS or ToTimespec.
+     */
+    static inline uint64_t Ticks(void)
+	{
+	    if (!fReady)
+	    {
+		Init();
+	    }
+#  if defined(__x86_64__) || defined(__i386__)
+	    if (fSource == kTSC)
+	    {
+		return __rdtsc();
+	    }
+#  endif
+	    struct timespec t;
+	    clock_gettime(CLOCK_REALTIME, &t);
+	    return (uint64_t) t.tv_sec*1000000000ULL + t.tv_nsec;
+	};
+
+    /// Convert a stamp to CLOCK_REALTIME ns since the epoch.
+    static int64_t     ToNS(uint64_t Ticks);
+    /// Convert a stamp to a timespec.
+    static void        ToTimespec(uint64_t Ticks, struct timespec &Out);
+    /// Convert a stamp to a PreciseTime.
+    static PreciseTime ToPreciseTime(uint64_t Ticks);
+    /// Ticks and ToTimespec in one, a drop in for clock_gettime.
+    static void        Now(struct timespec &Out);
+
+    /// Source in use.
+    static SOURCE      Source(void);
+    /// Counter rate from the last calibration, Hz.
+    static double      Frequency(void);
+    /**
+     * Number of re-anchors where the counter rate moved by more
+     * than 100 ppm. Anything but zero says the TSC can't be trusted.
+     */
+    static uint32_t    Suspect(void);
+    /**
+     * Use clock_gettime from now on. Stamps already taken in kTSC
+     * mode can no longer be converted, call before taking any.
+     */
+    static void        Disable(void);
+
+private:
+    static void  Setup(void);
+    static void *Thread(void *);
+    static void  Calibrate(bool First);
+    static void  Sample(clockid_t Clock, uint64_t &Ticks, int64_t &NS);
+
+    static volatile bool   fReady;
+    static volatile SOURCE fSource;
+};
+#endif
@@ -13,6 +13,19 @@
  * All the catch really needed to be (const whatever &error)
  *
  * 18-Mar-26 Error in limiting namesize
+ * 17-Oct-26 Write-combining buffer. The user dataset is now created 
+ *           on the first Fill so that buffering may be configured. 
+ * 17-Oct-26 Asynchronous writer thread. 
+ * 17-Oct-26 Compression filters, the fill value was an int being 
+ *           read as a double. 
+ * 17-Oct-26 Typed columns stored as a compound dataset, version 1.1
+ * 17-Oct-26 Bulk columnar reads, chunk cache and prefetch. 
+ * 17-Oct-26 Sparse time index, H5_TimeIndex. 
+ * 17-Oct-26 File rollover. 
+ * 17-Oct-26 Asynchronous Flush waits on fFlushDone and returns the
+ *           writer's result instead of polling. 
+ * 17-Oct-26 Size rollover flushes the chunk cache near the limit, 
+ *           files ran about 1MB over. 
  * 
  * Classification : Unclassified
  *
@@ -27,23 +40,67 @@ using namespace std;
 #include <string>
 #include <cstring>
 #include <cmath>
+#include <algorithm>
+#include <ctime>
+#include <cerrno>
 
 /// Local Includes.
 #include "debug.h"
 #include "H5Logger.hh"
 #include "Split.hh"
 #include "YearDay.hh"
+#include "filename.hh"
 
 const H5std_string sLoggerHeader("H5Logger_Header");
 const H5std_string sVariableHeader("H5Variable_Descriptions");
 const H5std_string sDatasetHeader("H5_UserData");
 const H5std_string sVersionHeader("H5_VersionInformation");
 const H5std_string sFinalStateHeader("H5_FinalStateInformation");
+const H5std_string sTimeIndexHeader("H5_TimeIndex");
+const H5std_string sSummaryHeader("H5_Summary");
 
 const size_t kDataRank = 2;
+/* HDF5's default raw data chunk cache, used when writing. */
+const size_t kWriteCacheBytes = 1024*1024;
 
 const unsigned int kMAJOR_VERSION = 1;
-const unsigned int kMINOR_VERSION = 0;
+const unsigned int kMINOR_VERSION = 1;
+
+/*
+ * Size in bytes of each typed column, indexed by ColumnType.
+ */
+static const size_t kColumnBytes[] = {1, 1, 2, 2, 4, 4, 8, 8, 4, 8, 
+				      sizeof(struct timespec)};
+/*
+ * Memory datatype of a typed column. 
+ */
+static DataType ColumnDataType(H5Logger::ColumnType Type)
+{
+    switch(Type)
+    {
+    case H5Logger::kINT8:   return PredType::NATIVE_INT8;
+    case H5Logger::kUINT8:  return PredType::NATIVE_UINT8;
+    case H5Logger::kINT16:  return PredType::NATIVE_INT16;
+    case H5Logger::kUINT16: return PredType::NATIVE_UINT16;
+    case H5Logger::kINT32:  return PredType::NATIVE_INT32;
+    case H5Logger::kUINT32: return PredType::NATIVE_UINT32;
+    case H5Logger::kINT64:  return PredType::NATIVE_INT64;
+    case H5Logger::kUINT64: return PredType::NATIVE_UINT64;
+    case H5Logger::kFLOAT:  return PredType::NATIVE_FLOAT;
+    case H5Logger::kTIMESPEC:
+    {
+	CompType ts(sizeof(struct timespec));
+	ts.insertMember("tv_sec",  HOFFSET(struct timespec, tv_sec), 
+			PredType::NATIVE_LONG);
+	ts.insertMember("tv_nsec", HOFFSET(struct timespec, tv_nsec), 
+			PredType::NATIVE_LONG);
+	return ts;
+    }
+    case H5Logger::kDOUBLE:
+    default:
+	return PredType::NATIVE_DOUBLE;
+    }
+}
 
 /**
  ******************************************************************
@@ -57,6 +114,7 @@ const unsigned int kMINOR_VERSION = 0;
  *    NVariables - Number of variables that the user wants to store. 
  *    ReadOnly   - User specified read (true) or write (false)
  *    Comment    - Optional user comment to be stored in file 
+ *    Live       - SWMR, see H5Logger.hh
  *
  * Returns : constructed class
  *
@@ -79,7 +137,7 @@ const unsigned int kMINOR_VERSION = 0;
  */
 H5Logger::H5Logger (const char *Filename, const char *UserDataName,
 		    size_t NVariables, bool ReadOnly, 
-		    const char*Comment) : CObject()
+		    const char*Comment, bool Live) : CObject()
 {
     SET_DEBUG_STACK;
     
@@ -95,6 +153,57 @@ H5Logger::H5Logger (const char *Filename, const char *UserDataName,
     fNExpand        = 0;
     fNBlocking      = 5; /* Default chunking */
     fMaxSize        = 0;
+    fDatasetCreated = false;
+    fBuffer         = NULL;
+    fChunkRows      = 0;  /* Unbuffered */
+    fNBuffered      = 0;
+    fGrowthFactor   = 2.0;
+    fChunkSize      = 0;
+    fDeflateLevel   = 0;
+    fShuffle        = false;
+    fScaleOffset    = -1;
+    fRecordSize     = 0;
+    fRecord         = NULL;
+    fRecordBuffer   = NULL;
+    memset(&fBlock, 0, sizeof(fBlock));
+    memset(&fNext,  0, sizeof(fNext));
+    fPrefetching    = false;
+    fTimeColumn     = -1;
+    fIndexRows      = 0;
+    fIndexCount     = 0;
+    fTimeIndexOpen  = false;
+    fSummaryOn      = false;
+    fSummaryRows    = 0;
+    fSummaryCount   = 0;
+    fSummaryOpen    = false;
+    fNamer          = NULL;
+    fMaxBytes       = 0;
+    fPeriod         = 0;
+    fNextBoundary   = 0;
+    fTagNames       = NULL;
+    fRolloverRequest = false;
+    fNRollovers     = 0;
+    pthread_mutex_init(&fNameMutex, NULL);
+    fPrefetchOK     = false;
+    fPrefetchRow0   = 0;
+    fPrefetchRows   = 0;
+    fLive           = Live;
+    fFlushPeriod    = 1.0;
+    memset(&fLastFlush, 0, sizeof(fLastFlush));
+    fQueue          = NULL;
+    fSlotSize       = 0;
+    fQueueDepth     = 0;
+    fPolicy         = kBLOCK;
+    fHead           = 0;
+    fTail           = 0;
+    fNDropped       = 0;
+    fHighWater      = 0;
+    fWriterRow      = NULL;
+    fWriterRunning  = false;
+    fWriterStop     = false;
+    fFlushRequest   = false;
+    fWriterOK       = true;
+    fFlushResult    = true;
     fRevision[0]  = kMAJOR_VERSION;
     fRevision[1]  = kMINOR_VERSION;
 
@@ -111,7 +220,15 @@ H5Logger::H5Logger (const char *Filename, const char *UserDataName,
 	 */
 	if (ReadOnly)
 	{
-	    fpFile = new H5File( Filename, H5F_ACC_RDONLY );
+	    if (fLive)
+	    {
+		fpFile = new H5File( Filename, 
+				     H5F_ACC_RDONLY | H5F_ACC_SWMR_READ);
+	    }
+	    else
+	    {
+		fpFile = new H5File( Filename, H5F_ACC_RDONLY );
+	    }
 	    if(!ReadHeader())
 	    {
 		SetError(-1, __LINE__);
@@ -137,13 +254,37 @@ H5Logger::H5Logger (const char *Filename, const char *UserDataName,
 		SetError(-5, __LINE__);
 		return;
 	    }
+	    if (fLive)
+	    {
+		/* 
+		 * The final state is only good once the writer is done,
+		 * a live extent is always exactly the rows written. 
+		 */
+		fNReadWrite = fMaxSize;
+	    }
+	    if (!ReadTimeIndex())
+	    {
+		SetError(-6, __LINE__);
+		return;
+	    }
+	    if (!ReadSummary())
+	    {
+		SetError(-7, __LINE__);
+		return;
+	    }
 	}
 	else
 	{
-	    fpFile = new H5File( Filename, H5F_ACC_TRUNC );
+	    fpFile = new H5File( Filename, H5F_ACC_TRUNC, 
+				 FileCreatPropList::DEFAULT, AccessList());
 	    WriteHeader(Filename, UserDataName,Comment);
 	    WriteVersionInformation();
-	    CreateUserDataSet();
+	    /*
+	     * The user dataset is created on the first Fill, 
+	     * allocate the internal vector now so that it may be filled. 
+	     */
+	    fVariables = new double[fNVariables];
+	    memset(fVariables, 0, fNVariables*sizeof(double));
 	}
     }
     // catch failure caused by the H5File operations
@@ -190,17 +331,40 @@ H5Logger::~H5Logger ()
     /*
      * Finalize any writing
      */
-    if(!fReadOnly)
+    /*
+     * Drain the queue, after this all file access is from this thread.
+     */
+    StopWriter();
+    WaitPrefetch();
+
+    if(!fReadOnly && fpFile)
     {
-	WriteFinalState();
+	CloseFile();
+    }
+    else if (fpFile)
+    {
+	fpFile->close();
+	delete fpFile;
+	fpFile = 0;
     }
-
-    fpFile->close();
-    delete fpFile;
-    fpFile = 0;
     
+    free(fTagNames);
     delete fVariableNames;
-    delete fVariables;
+    delete[] fVariables;
+    delete[] fBuffer;
+    delete[] fQueue;
+    delete[] fWriterRow;
+    delete[] fRecord;
+    delete[] fRecordBuffer;
+    delete[] fBlock.Data;
+    delete[] fBlock.Records;
+    delete[] fNext.Data;
+    delete[] fNext.Records;
+    for (size_t i=0; i<fColumns.size(); i++)
+    {
+	free(fColumns[i].Name);
+    }
+    pthread_mutex_destroy(&fNameMutex);
 }
 
 /**
@@ -236,10 +400,13 @@ void H5Logger::WriteHeader(const char *Name, const char *UserDataName,
         
     time_t now;
 
+    /* CurrentFile may be reading the name from another thread. */
+    pthread_mutex_lock(&fNameMutex);
     memset(fHeader, 0, kSSIZ*kCOLS);
 
     // Store the filename 
     strncpy(fHeader[0],Name,kSSIZ);
+    pthread_mutex_unlock(&fNameMutex);
     time(&now);
     strftime (fHeader[1], kSSIZ, "%F %T", gmtime(&now));
     strncpy(fHeader[2], UserDataName,kSSIZ);
@@ -402,6 +569,12 @@ bool H5Logger::WriteDataTags(const char *TagNames)
     // 18-Mar-26 fix
     char *Names=strdup(TagNames);
 #endif
+    /* Kept to write into each new file on rollover. */
+    if (fTagNames != TagNames)
+    {
+	free(fTagNames);
+	fTagNames = strdup(TagNames);
+    }
     fVariableNames = new Split(TagNames,':');
 
     if (fVariableNames->NTokens()>0)
@@ -570,14 +743,43 @@ bool H5Logger::CreateUserDataSet(void)
      * stuff. 
      */
     /*
-     * Allocate internal buffer for data, may not need this, check back. 
+     * In buffered mode the chunk is the size of the write buffer. 
      */
-    fVariables = new double[fNVariables];
-
-    if (fVariables == NULL)
+    size_t ChunkRows = ChunkSize();
+    size_t Rank      = kDataRank;
+    if ((fTimeColumn >= 0) && (fIndexRows == 0))
     {
-	SetError(-1, __LINE__);
-	return false;
+	fIndexRows = ChunkRows;
+    }
+    if (fSummaryOn && (fSummaryRows == 0))
+    {
+	fSummaryRows = ChunkRows;
+    }
+    if (Typed())
+    {
+	Rank = 1;
+	if (fChunkRows>0)
+	{
+	    fRecordBuffer = new unsigned char[fRecordSize*fChunkRows];
+	}
+	/*
+	 * Name the variables from the columns unless the user 
+	 * already did. 
+	 */
+	if (fVariableNames == NULL)
+	{
+	    string Names;
+	    for (size_t i=0; i<fColumns.size(); i++)
+	    {
+		if (i>0) Names += ":";
+		Names += fColumns[i].Name;
+	    }
+	    WriteDataTags(Names.c_str());
+	}
+    }
+    else if (fChunkRows>0)
+    {
+	fBuffer   = new double[fNVariables*fChunkRows];
     }
 
     try
@@ -591,9 +793,27 @@ bool H5Logger::CreateUserDataSet(void)
 	 */
 	hsize_t     dimsf[kDataRank];              // dataset dimensions
 	dimsf[0] = fNVariables;   // Number of variables (X Dimension)
-	dimsf[1] = fNBlocking;    // Block size.
+	if (fChunkRows>0)
+	{
+	    dimsf[1] = fChunkRows;  // One chunk to start. 
+	}
+	else
+	{
+	    dimsf[1] = fNBlocking;  // Block size.
+	}
+
+	if (fLive)
+	{
+	    /* Live readers take the extent as the number of rows. */
+	    dimsf[1] = 0;
+	}
 
-	fMaxSize = fNBlocking;
+	fMaxSize = dimsf[1];
+	if (Typed())
+	{
+	    // One record per row, rows are the only dimension.
+	    dimsf[0] = fMaxSize;
+	}
 
 	/*
 	 * Define datatype for the data in the file.
@@ -614,8 +834,11 @@ bool H5Logger::CreateUserDataSet(void)
 	 * the actual dataset datatype.
 	 *
 	 */
-	int fill_val = 0;
-	cparms.setFillValue( PredType::NATIVE_DOUBLE, &fill_val);
+	double fill_val = 0.0;
+	if (!Typed())
+	{
+	    cparms.setFillValue( PredType::NATIVE_DOUBLE, &fill_val);
+	}
 
 	/* 
 	 * Unlimited is tied to set chunk dimensions. 
@@ -631,20 +854,78 @@ bool H5Logger::CreateUserDataSet(void)
 	 * Just because it is chunked doesn't require that we use 
 	 * the chunks yet. 
 	 */
-	hsize_t           chunk_dims[2] = {fNVariables, 1};
-	cparms.setChunk( kDataRank, chunk_dims );
+	hsize_t           chunk_dims[2] = {fNVariables, ChunkRows};
+	if (Typed())
+	{
+	    maxdims[0]    = H5S_UNLIMITED;
+	    chunk_dims[0] = ChunkRows;
+	}
+	cparms.setChunk( Rank, chunk_dims );
+
+	/*
+	 * Filters are applied in the order they are set. 
+	 * Scale-offset first to reduce the precision, shuffle to 
+	 * group the bytes of each value together and finally deflate.
+	 * Scale-offset does not apply to compound types. 
+	 */
+	if (fScaleOffset >= 0)
+	{
+	    if (!Typed() && (H5Zfilter_avail(H5Z_FILTER_SCALEOFFSET) > 0))
+	    {
+		H5Pset_scaleoffset(cparms.getId(), H5Z_SO_FLOAT_DSCALE, 
+				   fScaleOffset);
+	    }
+	    else
+	    {
+		SetError(-4,__LINE__);
+	    }
+	}
+	if (fShuffle)
+	{
+	    cparms.setShuffle();
+	}
+	if (fDeflateLevel > 0)
+	{
+	    if (H5Zfilter_avail(H5Z_FILTER_DEFLATE) > 0)
+	    {
+		cparms.setDeflate(fDeflateLevel);
+	    }
+	    else
+	    {
+		SetError(-5,__LINE__);
+	    }
+	}
 
-	DataSpace   dataspace( kDataRank, dimsf, maxdims);
+	DataSpace   dataspace( Rank, dimsf, maxdims);
 
 	/*
 	 * Create a new dataset within the file using defined dataspace and
 	 * datatype and default dataset creation properties.
 	 *
 	 */
-	fUserDataset = fpFile->createDataSet( sDatasetHeader, 
-					      datatype, 
-					      dataspace,
-					      cparms);
+	if (Typed())
+	{
+	    /*
+	     * Records are converted to a packed copy of the memory 
+	     * type on the way to the file, no padding is stored. 
+	     */
+	    BuildRecordType();
+	    CompType filetype;
+	    filetype.copy(fRecordType);
+	    filetype.pack();
+	    fUserDataset = fpFile->createDataSet( sDatasetHeader, 
+						  filetype, 
+						  dataspace,
+						  cparms);
+	}
+	else
+	{
+	    fUserDataset = fpFile->createDataSet( sDatasetHeader, 
+						  datatype, 
+						  dataspace,
+						  cparms);
+	}
+	fDatasetCreated = true;
     }  // end of try block
     // catch failure caused by the DataSet operations
     catch( const DataSetIException &error )
@@ -668,6 +949,10 @@ bool H5Logger::CreateUserDataSet(void)
 	return false;
     }
 
+    if (fLive)
+    {
+	return StartLive();
+    }
     return true;
 }
 /**
@@ -697,6 +982,100 @@ bool H5Logger::Fill(const double *var)
     SET_DEBUG_STACK;
     ClearError(__LINE__);
 
+    if (fReadOnly)
+    {
+	SetError(-3, __LINE__);
+	return false;
+    }
+
+    if (var == NULL)
+    {
+	var = fVariables;
+    }
+
+    if (Typed())
+    {
+	/*
+	 * Convert to a record, fRecord is only used by this thread. 
+	 */
+	if (!fDatasetCreated && !CreateUserDataSet())
+	{
+	    return false;
+	}
+	Pack(var, fRecord);
+	return FillRecord(fRecord);
+    }
+
+    if (fWriterRunning)
+    {
+	return Enqueue(var);
+    }
+    return WriteRow(var);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::WriteRow
+ *
+ * Description : Synchronous part of Fill. Either copy the row into
+ *               the write buffer or write it directly to the file. 
+ *               In asynchronous mode this is only called by the 
+ *               writer thread. 
+ *
+ * Inputs : var - vector to store in dataset.
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : fail in access of dataset
+ *                    fail in access of dataspace
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::WriteRow(const double *var)
+{
+    SET_DEBUG_STACK;
+
+    if (!CheckRollover())
+    {
+	return false;
+    }
+    if (!fDatasetCreated && !CreateUserDataSet())
+    {
+	return false;
+    }
+    LiveFlush(false);
+    if (fTimeColumn >= 0)
+    {
+	IndexRow(var[fTimeColumn]);
+    }
+    if (fSummaryOn)
+    {
+	SummarizeRow(var, NULL);
+    }
+
+    if (fChunkRows>0)
+    {
+	/*
+	 * Buffered, copy the row into its column of the buffer
+	 * and only go to the file when the chunk is full. 
+	 */
+	for (size_t i=0; i<fNVariables; i++)
+	{
+	    fBuffer[i*fChunkRows + fNBuffered] = var[i];
+	}
+	fNBuffered++;
+	if (fNBuffered == fChunkRows)
+	{
+	    return WriteBuffer();
+	}
+	return true;
+    }
+
     try
     {
 	/*
@@ -711,7 +1090,14 @@ bool H5Logger::Fill(const double *var)
 	DataSpace   MVSpace(kDataRank, dims);
 
 
-	if ((fNReadWrite%fNBlocking == 0) && (fNReadWrite>0))
+	if (fLive)
+	{
+	    if (!Grow(fNReadWrite + 1))
+	    {
+		return false;
+	    }
+	}
+	else if ((fNReadWrite%fNBlocking == 0) && (fNReadWrite>0))
 	{
 	    /* This is the size we want for a data set increase in size. */
 	    hsize_t     dime[kDataRank]  = {fNVariables,1};
@@ -741,14 +1127,7 @@ bool H5Logger::Fill(const double *var)
 	 * file_space	- IN: Dataset's dataspace in the file
 	 * xfer_plist	- IN: Transfer property list for this I/O operation
 	 */
-	if (var != NULL)
-	{
-	    fUserDataset.write( var, PredType::NATIVE_DOUBLE, MVSpace, file_space);
-	}
-	else
-	{
-	    fUserDataset.write( fVariables, PredType::NATIVE_DOUBLE, MVSpace, file_space);
-	}
+	fUserDataset.write( var, PredType::NATIVE_DOUBLE, MVSpace, file_space);
 
 	/* Increment the number of writes counter. */
 	fNReadWrite++;
@@ -773,217 +1152,3429 @@ bool H5Logger::Fill(const double *var)
 /**
  ******************************************************************
  *
- * Function Name : H5Logger::WriteFinalState
+ * Function Name : H5Logger::AddColumn
  *
- * Description : Write out any final state variables at close time. 
- *               For the moment this is the number of vectors 
- *               written. 
+ * Description : Declare a typed column. The dataset becomes one 
+ *               compound record per row. 
  *
- * Inputs : NONE
+ * Inputs : Name   - column name
+ *          Type   - storage type
+ *          Offset - byte offset of the field in the user record, 
+ *                   -1 for the next naturally aligned offset. 
  *
- * Returns : true on succee, false on failure. 
+ * Returns : true on success
  *
- * Error Conditions : Dataset open fails. 
- *                    Dataspace open fails.
- *                    Datatype declaration fails.  
+ * Error Conditions : file is read only
+ *                    dataset already created
+ *                    bad type or name
+ *                    column overlaps the record size set by the user
  * 
- * Unit Tested on: 03-May-20
+ * Unit Tested on: 
  *
  * Unit Tested by: CBL
  *
  *
  *******************************************************************
  */
-bool H5Logger::WriteFinalState(void)
+bool H5Logger::AddColumn(const char *Name, ColumnType Type, int Offset)
 {
     SET_DEBUG_STACK;
     ClearError(__LINE__);
-
-    try
+    if (fReadOnly || fDatasetCreated)
     {
-	hsize_t   dims[2];
-	const int RANK = 1;
-
-	/* 
-	 * ---------------------------------------------------
-	 * Setup the dataspace, need dimensions and type
-	 */
-	dims[0] = 1;  // Number of variables
-	dims[1] = 1;  // Max size of string
-
-	// Create a simple dataspace
-	DataSpace    DS_FinalState( RANK, dims);
-	IntType datatype( PredType::NATIVE_LONG );
-
-	/*
-	 * Create the dataset
-	 *  Name of dataset
-	 *  Data type of the dataset
-	 *  Dataspace of the dataset
-	 *  Creation property. 
-	 */
-	DataSet FSDataset = fpFile->createDataSet(sFinalStateHeader,
-						 datatype,
-						 DS_FinalState);
-
-	FSDataset.write( &fNReadWrite, PredType::NATIVE_LONG);
+	SetError(-1, __LINE__);
+	return false;
     }
-    // catch failure caused by the DataSet operations
-    catch( const DataSetIException &error )
+    if ((Name == NULL) || (strlen(Name) == 0) || (Type > kTIMESPEC))
     {
-	error.printErrorStack();
-	SetError(-2,__LINE__);
+	SetError(-2, __LINE__);
 	return false;
     }
-    // catch failure caused by the DataSpace operations
-    catch( const DataSpaceIException &error )
+
+    size_t Bytes = kColumnBytes[Type];
+    size_t Align = (Bytes>8) ? 8 : Bytes;
+    size_t End   = 0;
+    size_t MaxAlign = Align;
+    for (size_t i=0; i<fColumns.size(); i++)
     {
-	error.printErrorStack();
-	SetError(-3,__LINE__);
-	return false;
+	size_t b = kColumnBytes[fColumns[i].Type];
+	if (fColumns[i].Offset + b > End) End = fColumns[i].Offset + b;
+	if (((b>8) ? 8 : b) > MaxAlign) MaxAlign = (b>8) ? 8 : b;
     }
-    // catch failure caused by the DataSpace operations
-    catch( const DataTypeIException &error )
+
+    ColumnInfo col;
+    col.Name   = strdup(Name);
+    col.Type   = Type;
+    if (Offset < 0)
     {
-	SetError(-3,__LINE__);
-	error.printErrorStack();
-	return false;
+	col.Offset = Align * ((End + Align - 1)/Align);
+    }
+    else
+    {
+	col.Offset = Offset;
+    }
+    fColumns.push_back(col);
+
+    /*
+     * Record size follows the end of the columns rounded to the 
+     * largest alignment, the same as sizeof() of the matching struct.
+     */
+    End = col.Offset + Bytes;
+    End = MaxAlign * ((End + MaxAlign - 1)/MaxAlign);
+    if (End > fRecordSize)
+    {
+	fRecordSize = End;
     }
 
+    fNVariables = fColumns.size();
+    delete[] fVariables;
+    fVariables = new double[fNVariables];
+    memset(fVariables, 0, fNVariables*sizeof(double));
     return true;
 }
 /**
  ******************************************************************
  *
- * Function Name : H5Logger::ReadFinalState
+ * Function Name : H5Logger::SetRecordSize
  *
- * Description : Read the final state data in. 
- *               Right now it just initializes the variable
- *               fNReadWrite - the number of records written to the file. 
+ * Description : Set the size of the user record given to FillRecord. 
  *
- * Inputs : NONE
+ * Inputs : Size - bytes, must cover all the declared columns. 
  *
- * Returns : true on success, false on failure. 
+ * Returns : true on success
  *
- * Error Conditions : Dataset open fail
- *                    Dataspace declaration fail
+ * Error Conditions : file is read only
+ *                    dataset already created
+ *                    size smaller than the columns
  * 
- * Unit Tested on: 03-May-20
+ * Unit Tested on: 
  *
  * Unit Tested by: CBL
  *
  *
  *******************************************************************
  */
-bool H5Logger::ReadFinalState(void)
+bool H5Logger::SetRecordSize(size_t Size)
 {
     SET_DEBUG_STACK;
     ClearError(__LINE__);
-
-    try
+    if (fReadOnly || fDatasetCreated)
     {
-	DataSet dataset = fpFile->openDataSet( sFinalStateHeader);
-
-	/*
-	 * Get filespace for rank and dimension
-	 */
-	DataSpace filespace = dataset.getSpace();
-
-	dataset.read( &fNReadWrite, PredType::NATIVE_LONG);
-
+	SetError(-1, __LINE__);
+	return false;
+    }
+    for (size_t i=0; i<fColumns.size(); i++)
+    {
+	if (fColumns[i].Offset + kColumnBytes[fColumns[i].Type] > Size)
+	{
+	    SetError(-2, __LINE__);
+	    return false;
+	}
+    }
+    fRecordSize = Size;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::ColumnTypeOf
+ *
+ * Description : Return the type of a typed column. 
+ *
+ * Inputs : Column - index of the column
+ *
+ * Returns : column type, kDOUBLE for an untyped dataset
+ *
+ * Error Conditions : Column out of range
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+H5Logger::ColumnType H5Logger::ColumnTypeOf(size_t Column) const
+{
+    if (Column < fColumns.size())
+    {
+	return fColumns[Column].Type;
+    }
+    return kDOUBLE;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::BuildRecordType
+ *
+ * Description : Build the memory compound type from the columns. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : throws DataTypeIException, e.g. on duplicate
+ *                    names
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void H5Logger::BuildRecordType(void)
+{
+    SET_DEBUG_STACK;
+    fRecordType = CompType(fRecordSize);
+    for (size_t i=0; i<fColumns.size(); i++)
+    {
+	fRecordType.insertMember(fColumns[i].Name, fColumns[i].Offset, 
+				 ColumnDataType(fColumns[i].Type));
+    }
+    /*
+     * On rollover this is called again by the writer, fRecord may be in 
+     * use by Fill so it is only allocated once. 
+     */
+    if (fRecord == NULL)
+    {
+	fRecord = new unsigned char[fRecordSize];
+	memset(fRecord, 0, fRecordSize);
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::Pack
+ *
+ * Description : Convert a row of doubles to a typed record. 
+ *               A timespec column is seconds with the fraction 
+ *               as nanoseconds. 
+ *
+ * Inputs : var    - fNVariables doubles
+ *          Record - fRecordSize bytes to fill. 
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void H5Logger::Pack(const double *var, unsigned char *Record)
+{
+    for (size_t i=0; i<fColumns.size(); i++)
+    {
+	unsigned char *p = Record + fColumns[i].Offset;
+	double v = var[i];
+	switch(fColumns[i].Type)
+	{
+	case kINT8:   *(int8_t *)   p = (int8_t)   v; break;
+	case kUINT8:  *(uint8_t *)  p = (uint8_t)  v; break;
+	case kINT16:  *(int16_t *)  p = (int16_t)  v; break;
+	case kUINT16: *(uint16_t *) p = (uint16_t) v; break;
+	case kINT32:  *(int32_t *)  p = (int32_t)  v; break;
+	case kUINT32: *(uint32_t *) p = (uint32_t) v; break;
+	case kINT64:  *(int64_t *)  p = (int64_t)  v; break;
+	case kUINT64: *(uint64_t *) p = (uint64_t) v; break;
+	case kFLOAT:  *(float *)    p = (float)    v; break;
+	case kDOUBLE: *(double *)   p = v;            break;
+	case kTIMESPEC:
+	{
+	    struct timespec *ts = (struct timespec *) p;
+	    ts->tv_sec  = (time_t) floor(v);
+	    ts->tv_nsec = (long) ((v - floor(v))*1.0e9);
+	}
+	break;
+	}
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::Unpack
+ *
+ * Description : Convert a typed record to a row of doubles. 
+ *
+ * Inputs : Record - fRecordSize bytes
+ *          var    - fNVariables doubles to fill
+ *          Stride - distance between successive columns in var
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void H5Logger::Unpack(const unsigned char *Record, double *var, size_t Stride)
+{
+    for (size_t i=0; i<fColumns.size(); i++)
+    {
+	var[i*Stride] = RecordValue(Record, i);
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::RecordValue
+ *
+ * Description : Return one column of a typed record as a double. 
+ *
+ * Inputs : Record - fRecordSize bytes
+ *          Column - column index
+ *
+ * Returns : value
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+double H5Logger::RecordValue(const unsigned char *Record, size_t Column) const
+{
+    const unsigned char *p = Record + fColumns[Column].Offset;
+    switch(fColumns[Column].Type)
+    {
+    case kINT8:   return *(const int8_t *)   p;
+    case kUINT8:  return *(const uint8_t *)  p;
+    case kINT16:  return *(const int16_t *)  p;
+    case kUINT16: return *(const uint16_t *) p;
+    case kINT32:  return *(const int32_t *)  p;
+    case kUINT32: return *(const uint32_t *) p;
+    case kINT64:  return *(const int64_t *)  p;
+    case kUINT64: return *(const uint64_t *) p;
+    case kFLOAT:  return *(const float *)    p;
+    case kTIMESPEC:
+    {
+	const struct timespec *ts = (const struct timespec *) p;
+	return (double) ts->tv_sec + 1.0e-9 * (double) ts->tv_nsec;
+    }
+    case kDOUBLE:
+    default:
+	return *(const double *) p;
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::FillRecord
+ *
+ * Description : Log a typed record. 
+ *
+ * Inputs : Record - struct of RecordSize() bytes laid out as 
+ *                   declared with AddColumn. 
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : read only
+ *                    not a typed dataset
+ *                    see WriteRecord and Enqueue
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::FillRecord(const void *Record)
+{
+    SET_DEBUG_STACK;
+    ClearError(__LINE__);
+
+    if (fReadOnly || !Typed() || (Record == NULL))
+    {
+	SetError(-3, __LINE__);
+	return false;
+    }
+    if (fWriterRunning)
+    {
+	return Enqueue(Record);
+    }
+    return WriteRecord(Record);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::WriteRecord
+ *
+ * Description : Synchronous part of FillRecord. Either copy the 
+ *               record into the write buffer or write it directly
+ *               to the file. 
+ *
+ * Inputs : Record - record to store
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : fail in access of dataset
+ *                    fail in access of dataspace
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::WriteRecord(const void *Record)
+{
+    SET_DEBUG_STACK;
+
+    if (!CheckRollover())
+    {
+	return false;
+    }
+    if (!fDatasetCreated && !CreateUserDataSet())
+    {
+	return false;
+    }
+    LiveFlush(false);
+    if (fTimeColumn >= 0)
+    {
+	IndexRow(RecordValue((const unsigned char *) Record, fTimeColumn));
+    }
+    if (fSummaryOn)
+    {
+	SummarizeRow(NULL, (const unsigned char *) Record);
+    }
+
+    if (fChunkRows>0)
+    {
+	memcpy(&fRecordBuffer[fNBuffered*fRecordSize], Record, fRecordSize);
+	fNBuffered++;
+	if (fNBuffered == fChunkRows)
+	{
+	    return WriteBuffer();
+	}
+	return true;
+    }
+
+    if (!Grow(fNReadWrite + 1))
+    {
+	return false;
+    }
+
+    try
+    {
+	hsize_t     dims[1]   = {1};
+	hsize_t     offset[1] = {fNReadWrite};
+	DataSpace   MVSpace(1, dims);
+
+	DataSpace file_space = fUserDataset.getSpace();
+	file_space.selectHyperslab( H5S_SELECT_SET, dims, offset);
+
+	fUserDataset.write( Record, fRecordType, MVSpace, file_space);
+	fNReadWrite++;
     }
     // catch failure caused by the DataSet operations
     catch( const DataSetIException &error )
     {
+	SetError(-1,__LINE__);
 	error.printErrorStack();
-	SetError(-2,__LINE__);
 	return false;
     }
     // catch failure caused by the DataSpace operations
     catch( const DataSpaceIException &error )
     {
-	error.printErrorStack();
-	SetError(-3,__LINE__);
-	return false;
+	SetError(-2,__LINE__);
+	error.printErrorStack();
+	return false;
+    }
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::SetBuffering
+ *
+ * Description : Set the number of rows collected in memory before
+ *               writing to the file. This is also the chunk size
+ *               of the dataset. 
+ *
+ * Inputs : NRows - rows per chunk, zero disables buffering. 
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : file is read only
+ *                    dataset already created
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::SetBuffering(size_t NRows)
+{
+    SET_DEBUG_STACK;
+    ClearError(__LINE__);
+    if (fReadOnly || fDatasetCreated)
+    {
+	SetError(-1, __LINE__);
+	return false;
+    }
+    fChunkRows = NRows;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::SetChunkSize
+ *
+ * Description : Set the number of rows in a dataset chunk. 
+ *
+ * Inputs : NRows - rows per chunk, zero to follow the buffer size. 
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : file is read only
+ *                    dataset already created
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::SetChunkSize(size_t NRows)
+{
+    SET_DEBUG_STACK;
+    ClearError(__LINE__);
+    if (fReadOnly || fDatasetCreated)
+    {
+	SetError(-1, __LINE__);
+	return false;
+    }
+    fChunkSize = NRows;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::SetCompression
+ *
+ * Description : Select the filters applied to the user dataset 
+ *               when it is created. 
+ *
+ * Inputs : Level   - deflate level 0-9, 0 is off
+ *          Shuffle - apply the byte shuffle filter
+ *          Digits  - decimal digits kept by scale-offset, -1 is off
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : file is read only
+ *                    dataset already created
+ *                    level out of range
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::SetCompression(unsigned int Level, bool Shuffle, int Digits)
+{
+    SET_DEBUG_STACK;
+    ClearError(__LINE__);
+    if (fReadOnly || fDatasetCreated)
+    {
+	SetError(-1, __LINE__);
+	return false;
+    }
+    if (Level > 9)
+    {
+	SetError(-2, __LINE__);
+	return false;
+    }
+    fDeflateLevel = Level;
+    fShuffle      = Shuffle;
+    fScaleOffset  = Digits;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::SetGrowthFactor
+ *
+ * Description : Set the multiplier used on the dataset extent 
+ *               when it runs out of room in buffered mode. 
+ *
+ * Inputs : Factor - must be >= 1.0
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : Factor less than 1
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::SetGrowthFactor(double Factor)
+{
+    SET_DEBUG_STACK;
+    ClearError(__LINE__);
+    if (Factor < 1.0)
+    {
+	SetError(-1, __LINE__);
+	return false;
+    }
+    fGrowthFactor = Factor;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::Flush
+ *
+ * Description : Write any rows held in the buffer to the file. 
+ *               In asynchronous mode the writer does it once the 
+ *               queue is empty and posts fFlushDone. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : see WriteBuffer, in asynchronous mode any write
+ *                    by the writer since the last Flush failed. 
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::Flush(void)
+{
+    SET_DEBUG_STACK;
+    ClearError(__LINE__);
+    if (fReadOnly || !fDatasetCreated)
+    {
+	return true;
+    }
+    if (fWriterRunning)
+    {
+	/*
+	 * The writer owns the file, ask it to do the flush once 
+	 * the queue is empty and wait for it. 
+	 */
+	fFlushRequest = true;
+	sem_post(&fWriterSem);
+	while ((sem_wait(&fFlushDone) != 0) && (errno == EINTR))
+	{
+	}
+	if (!fFlushResult)
+	{
+	    SetError(-1, __LINE__);
+	}
+	return fFlushResult;
+    }
+    if (!WriteBuffer())
+    {
+	return false;
+    }
+    fpFile->flush(H5F_SCOPE_LOCAL);
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::StartWriter
+ *
+ * Description : Switch to asynchronous mode. Allocate the queue and
+ *               start the writer thread. From here on only the 
+ *               writer thread touches the file until it is stopped. 
+ *
+ * Inputs : QueueDepth - number of rows the queue will hold
+ *          Policy     - what to do when the queue is full. 
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : file is read only
+ *                    already running
+ *                    can't create dataset
+ *                    thread creation fails
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::StartWriter(size_t QueueDepth, OverflowPolicy Policy)
+{
+    SET_DEBUG_STACK;
+    ClearError(__LINE__);
+
+    if (fReadOnly || fWriterRunning || (QueueDepth == 0))
+    {
+	SetError(-1, __LINE__);
+	return false;
+    }
+    if (!fDatasetCreated && !CreateUserDataSet())
+    {
+	return false;
+    }
+
+    fQueueDepth = QueueDepth;
+    fPolicy     = Policy;
+    if (Typed())
+    {
+	fSlotSize = fRecordSize;
+    }
+    else
+    {
+	fSlotSize = fNVariables*sizeof(double);
+    }
+    fQueue      = new unsigned char[fQueueDepth*fSlotSize];
+    fWriterRow  = new unsigned char[fSlotSize];
+    fHead       = 0;
+    fTail       = 0;
+    fWriterStop = false;
+    fWriterOK   = true;
+    sem_init(&fWriterSem, 0, 0);
+    sem_init(&fFlushDone, 0, 0);
+
+    if (pthread_create(&fWriterThread, NULL, H5Logger::Writer, this) != 0)
+    {
+	sem_destroy(&fWriterSem);
+	sem_destroy(&fFlushDone);
+	SetError(-2, __LINE__);
+	return false;
+    }
+    fWriterRunning = true;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::StopWriter
+ *
+ * Description : Tell the writer thread to stop, it will empty the 
+ *               queue first. Wait for it to finish. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void H5Logger::StopWriter(void)
+{
+    SET_DEBUG_STACK;
+    if (!fWriterRunning)
+    {
+	return;
+    }
+    fWriterStop = true;
+    sem_post(&fWriterSem);
+    pthread_join(fWriterThread, NULL);
+    sem_destroy(&fWriterSem);
+    sem_destroy(&fFlushDone);
+    fWriterRunning = false;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::Enqueue
+ *
+ * Description : Producer side of the queue. Copy the row into the 
+ *               next free slot and wake the writer. No locks are 
+ *               taken. 
+ *
+ * Inputs : var - row or record to store
+ *
+ * Returns : true if the row was queued
+ *
+ * Error Conditions : row dropped on a full queue with kDROP_NEWEST
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::Enqueue(const void *var)
+{
+    size_t head = fHead.load(std::memory_order_relaxed);
+    size_t tail = fTail.load(std::memory_order_acquire);
+
+    if (head - tail >= fQueueDepth)
+    {
+	switch (fPolicy)
+	{
+	case kDROP_NEWEST:
+	    fNDropped++;
+	    SetError(-1, __LINE__);
+	    return false;
+	case kDROP_OLDEST:
+	    /*
+	     * Push the tail along. If the writer got there first 
+	     * there is now room anyway. The writer discards a row it 
+	     * was copying when its own update of the tail fails. 
+	     */
+	    if (fTail.compare_exchange_strong(tail, tail+1, 
+					      std::memory_order_acq_rel))
+	    {
+		fNDropped++;
+	    }
+	    break;
+	case kBLOCK:
+	default:
+	{
+	    struct timespec SleepTime = {0L, 50000L};
+	    while (head - fTail.load(std::memory_order_acquire) >= fQueueDepth)
+	    {
+		sem_post(&fWriterSem);
+		nanosleep(&SleepTime, NULL);
+	    }
+	}
+	break;
+	}
+    }
+
+    memcpy(&fQueue[(head%fQueueDepth)*fSlotSize], var, fSlotSize);
+    fHead.store(head+1, std::memory_order_release);
+
+    size_t used = head + 1 - fTail.load(std::memory_order_relaxed);
+    if (used > fHighWater.load(std::memory_order_relaxed))
+    {
+	fHighWater.store(used, std::memory_order_relaxed);
+    }
+    sem_post(&fWriterSem);
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::Dequeue
+ *
+ * Description : Consumer side of the queue. Copy the oldest row into
+ *               fWriterRow. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : true if a row was taken, false if the queue is empty. 
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::Dequeue(void)
+{
+    size_t tail = fTail.load(std::memory_order_acquire);
+    while (tail != fHead.load(std::memory_order_acquire))
+    {
+	memcpy(fWriterRow, &fQueue[(tail%fQueueDepth)*fSlotSize], fSlotSize);
+	/*
+	 * If Fill dropped this row while we copied it the exchange
+	 * fails, tail is reloaded and we try the next one. 
+	 */
+	if (fTail.compare_exchange_strong(tail, tail+1, 
+					  std::memory_order_acq_rel))
+	{
+	    return true;
+	}
+    }
+    return false;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::Writer
+ *
+ * Description : Writer thread. Sleep until there is work, then 
+ *               empty the queue into the file. Service flush 
+ *               requests once the queue is empty. On stop the 
+ *               queue is emptied before returning. 
+ *
+ * Inputs : arg - this pointer of the H5Logger
+ *
+ * Returns : NULL
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void* H5Logger::Writer(void *arg)
+{
+    H5Logger *p = (H5Logger *) arg;
+
+    while (true)
+    {
+	sem_wait(&p->fWriterSem);
+	while (p->Dequeue())
+	{
+	    if (p->Typed())
+	    {
+		p->fWriterOK &= p->WriteRecord(p->fWriterRow);
+	    }
+	    else
+	    {
+		p->fWriterOK &= p->WriteRow((const double *) p->fWriterRow);
+	    }
+	}
+	if (p->fFlushRequest)
+	{
+	    p->fWriterOK &= p->WriteBuffer();
+	    p->fpFile->flush(H5F_SCOPE_LOCAL);
+	    p->fFlushResult  = p->fWriterOK;
+	    p->fWriterOK     = true;
+	    p->fFlushRequest = false;
+	    sem_post(&p->fFlushDone);
+	}
+	if (p->fWriterStop)
+	{
+	    while (p->Dequeue())
+	    {
+		if (p->Typed())
+		{
+		    p->WriteRecord(p->fWriterRow);
+		}
+		else
+		{
+		    p->WriteRow((const double *) p->fWriterRow);
+		}
+	    }
+	    break;
+	}
+    }
+    return NULL;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::Grow
+ *
+ * Description : Make sure the dataset extent will hold NRows. 
+ *               The extent is grown geometrically by fGrowthFactor
+ *               and rounded up to a whole number of chunks. 
+ *
+ * Inputs : NRows - number of rows needed. 
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : fail in extending the dataset
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::Grow(size_t NRows)
+{
+    SET_DEBUG_STACK;
+    if (NRows <= fMaxSize)
+    {
+	return true;
+    }
+
+    size_t NewSize = (size_t) ceil(fGrowthFactor * (double) fMaxSize);
+    if (NewSize < NRows)
+    {
+	NewSize = NRows;
+    }
+    size_t ChunkRows = ChunkSize();
+    NewSize = ChunkRows * ((NewSize + ChunkRows - 1)/ChunkRows);
+    if (fLive)
+    {
+	/* No spare extent, readers count rows by it. */
+	NewSize = NRows;
+    }
+
+    if (!SetExtent(NewSize))
+    {
+	return false;
+    }
+    fNExpand++;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::SetExtent
+ *
+ * Description : Set the number of rows in the dataset extent. 
+ *               A typed dataset has rank 1, otherwise the rows are
+ *               the second dimension. 
+ *
+ * Inputs : NRows - new number of rows
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : fail in extending the dataset
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::SetExtent(size_t NRows)
+{
+    SET_DEBUG_STACK;
+    try
+    {
+	hsize_t dime[kDataRank] = {fNVariables, NRows};
+	if (Typed())
+	{
+	    dime[0] = NRows;
+	}
+	fUserDataset.extend(dime);
+	fMaxSize = NRows;
+    }
+    catch( const DataSetIException &error )
+    {
+	SetError(-1,__LINE__);
+	error.printErrorStack();
+	return false;
+    }
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::WriteBuffer
+ *
+ * Description : Write the rows held in fBuffer to the dataset
+ *               in a single hyperslab write. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : fail in access of dataset
+ *                    fail in access of dataspace
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::WriteBuffer(void)
+{
+    SET_DEBUG_STACK;
+    if ((fNBuffered == 0) || ((fBuffer == NULL) && (fRecordBuffer == NULL)))
+    {
+	return true;
+    }
+    if (!Grow(fNReadWrite + fNBuffered))
+    {
+	return false;
+    }
+
+    try
+    {
+	/*
+	 * The memory space is the whole buffer, select only the 
+	 * rows that have been filled. 
+	 */
+	hsize_t     mdims[kDataRank]   = {fNVariables, fChunkRows};
+	hsize_t     count[kDataRank]   = {fNVariables, fNBuffered};
+	hsize_t     moffset[kDataRank] = {0, 0};
+	hsize_t     offset[kDataRank]  = {0, fNReadWrite};
+	if (Typed())
+	{
+	    /* Records are contiguous, a single row dimension. */
+	    DataSpace   MVSpace(1, &mdims[1]);
+	    MVSpace.selectHyperslab( H5S_SELECT_SET, &count[1], moffset);
+
+	    DataSpace file_space = fUserDataset.getSpace();
+	    file_space.selectHyperslab( H5S_SELECT_SET, &count[1], &offset[1]);
+
+	    fUserDataset.write( fRecordBuffer, fRecordType, MVSpace, 
+				file_space);
+	}
+	else
+	{
+	    DataSpace   MVSpace(kDataRank, mdims);
+	    MVSpace.selectHyperslab( H5S_SELECT_SET, count, moffset);
+
+	    DataSpace file_space = fUserDataset.getSpace();
+	    file_space.selectHyperslab( H5S_SELECT_SET, count, offset);
+
+	    fUserDataset.write( fBuffer, PredType::NATIVE_DOUBLE, MVSpace, 
+				file_space);
+	}
+
+	fNReadWrite += fNBuffered;
+	fNBuffered   = 0;
+    }
+    // catch failure caused by the DataSet operations
+    catch( const DataSetIException &error )
+    {
+	SetError(-1,__LINE__);
+	error.printErrorStack();
+	return false;
+    }
+    // catch failure caused by the DataSpace operations
+    catch( const DataSpaceIException &error )
+    {
+	SetError(-2,__LINE__);
+	error.printErrorStack();
+	return false;
+    }
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::WriteFinalState
+ *
+ * Description : Write out any final state variables at close time. 
+ *               For the moment this is the number of vectors 
+ *               written. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : true on succee, false on failure. 
+ *
+ * Error Conditions : Dataset open fails. 
+ *                    Dataspace open fails.
+ *                    Datatype declaration fails.  
+ * 
+ * Unit Tested on: 03-May-20
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::WriteFinalState(void)
+{
+    SET_DEBUG_STACK;
+    ClearError(__LINE__);
+
+    try
+    {
+	hsize_t   dims[2];
+	const int RANK = 1;
+
+	/* 
+	 * ---------------------------------------------------
+	 * Setup the dataspace, need dimensions and type
+	 */
+	dims[0] = 1;  // Number of variables
+	dims[1] = 1;  // Max size of string
+
+	// Create a simple dataspace
+	DataSpace    DS_FinalState( RANK, dims);
+	IntType datatype( PredType::NATIVE_LONG );
+
+	/*
+	 * Create the dataset
+	 *  Name of dataset
+	 *  Data type of the dataset
+	 *  Dataspace of the dataset
+	 *  Creation property. 
+	 */
+	DataSet FSDataset;
+	if (fpFile->nameExists(sFinalStateHeader))
+	{
+	    /* Live files create it up front. */
+	    FSDataset = fpFile->openDataSet(sFinalStateHeader);
+	}
+	else
+	{
+	    FSDataset = fpFile->createDataSet(sFinalStateHeader,
+					      datatype,
+					      DS_FinalState);
+	}
+
+	FSDataset.write( &fNReadWrite, PredType::NATIVE_LONG);
+    }
+    // catch failure caused by the DataSet operations
+    catch( const DataSetIException &error )
+    {
+	error.printErrorStack();
+	SetError(-2,__LINE__);
+	return false;
+    }
+    // catch failure caused by the DataSpace operations
+    catch( const DataSpaceIException &error )
+    {
+	error.printErrorStack();
+	SetError(-3,__LINE__);
+	return false;
+    }
+    // catch failure caused by the DataSpace operations
+    catch( const DataTypeIException &error )
+    {
+	SetError(-3,__LINE__);
+	error.printErrorStack();
+	return false;
+    }
+
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::ReadFinalState
+ *
+ * Description : Read the final state data in. 
+ *               Right now it just initializes the variable
+ *               fNReadWrite - the number of records written to the file. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : true on success, false on failure. 
+ *
+ * Error Conditions : Dataset open fail
+ *                    Dataspace declaration fail
+ * 
+ * Unit Tested on: 03-May-20
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::ReadFinalState(void)
+{
+    SET_DEBUG_STACK;
+    ClearError(__LINE__);
+
+    try
+    {
+	DataSet dataset = fpFile->openDataSet( sFinalStateHeader);
+
+	/*
+	 * Get filespace for rank and dimension
+	 */
+	DataSpace filespace = dataset.getSpace();
+
+	dataset.read( &fNReadWrite, PredType::NATIVE_LONG);
+
+    }
+    // catch failure caused by the DataSet operations
+    catch( const DataSetIException &error )
+    {
+	error.printErrorStack();
+	SetError(-2,__LINE__);
+	return false;
+    }
+    // catch failure caused by the DataSpace operations
+    catch( const DataSpaceIException &error )
+    {
+	error.printErrorStack();
+	SetError(-3,__LINE__);
+	return false;
+    }
+
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::OpenUserDatasetRead
+ *
+ * Description : Open the Dataset associated with the user data. 
+ *               Allocate the fNVariables vector. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : true on success, false on failure. 
+ *
+ * Error Conditions : Dataset open fail
+ *                    Dataspace declaration fail
+ * 
+ * Unit Tested on: 03-May-20
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::OpenUserDatasetRead(void)
+{
+    SET_DEBUG_STACK;
+    ClearError(__LINE__);
+
+    try
+    {
+	fUserDataset = fpFile->openDataSet( sDatasetHeader);
+
+	/*
+	 * Get filespace for rank and dimension
+	 */
+	DataSpace filespace = fUserDataset.getSpace();
+
+	if (fUserDataset.getTypeClass() == H5T_COMPOUND)
+	{
+	    return OpenTypedRead();
+	}
+
+	/*
+	 * Get and print the dimension sizes of the file dataspace
+	 */
+	hsize_t dims[2];    // dataset dimensions
+	//int rank = 
+	filespace.getSimpleExtentDims( dims );
+	// Save the dimensions, we will use them over and over 
+	fNVariables = dims[0];
+	fMaxSize    = dims[1];  // This dimension may be bigger than data. 
+
+	/* Chunk size in rows, used to align bulk reads. */
+	DSetCreatPropList cparms = fUserDataset.getCreatePlist();
+	if (cparms.getLayout() == H5D_CHUNKED)
+	{
+	    cparms.getChunk(kDataRank, dims);
+	    fChunkSize = dims[1];
+	}
+
+	/*
+	 * Allocate internal buffer for data, may not need this, check back. 
+	 */
+	fVariables = new double[fNVariables];
+
+	if (fVariables == NULL)
+	{
+	    SetError(-1, __LINE__);
+	    return false;
+	}
+ 
+#ifdef DEBUG
+	cout << "dataset rank = " << rank << ", dimensions ";
+	for (int i=0;i<rank;i++)
+	{
+	    cout << (unsigned long)(dims[i]) << " ";
+	}
+	cout << endl;
+#endif
+    }
+    // catch failure caused by the DataSet operations
+    catch( const DataSetIException &error )
+    {
+	error.printErrorStack();
+	SetError(-2,__LINE__);
+	return false;
+    }
+    // catch failure caused by the DataSpace operations
+    catch( const DataSpaceIException &error )
+    {
+	error.printErrorStack();
+	SetError(-3,__LINE__);
+	return false;
+    }
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::OpenTypedRead
+ *
+ * Description : The user dataset is a compound type. Rebuild the 
+ *               column list from the native version of the file
+ *               type. Records are read with natural alignment in 
+ *               column order. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : true on success, false on failure. 
+ *
+ * Error Conditions : unsupported member type
+ *                    Dataset, Datatype access fail
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::OpenTypedRead(void)
+{
+    SET_DEBUG_STACK;
+    try
+    {
+	CompType filetype = fUserDataset.getCompType();
+	fRecordType  = CompType(H5Tget_native_type(filetype.getId(), 
+						   H5T_DIR_ASCEND));
+	fRecordSize  = fRecordType.getSize();
+
+	int NMembers = fRecordType.getNmembers();
+	for (int i=0; i<NMembers; i++)
+	{
+	    ColumnInfo col;
+	    DataType member = fRecordType.getMemberDataType(i);
+	    size_t   Bytes  = member.getSize();
+
+	    col.Offset = fRecordType.getMemberOffset(i);
+	    switch(fRecordType.getMemberClass(i))
+	    {
+	    case H5T_INTEGER:
+	    {
+		bool Signed = 
+		    (fRecordType.getMemberIntType(i).getSign() != H5T_SGN_NONE);
+		switch(Bytes)
+		{
+		case 1: col.Type = Signed ? kINT8  : kUINT8;  break;
+		case 2: col.Type = Signed ? kINT16 : kUINT16; break;
+		case 4: col.Type = Signed ? kINT32 : kUINT32; break;
+		default: col.Type = Signed ? kINT64 : kUINT64; break;
+		}
+	    }
+	    break;
+	    case H5T_FLOAT:
+		col.Type = (Bytes == 4) ? kFLOAT : kDOUBLE;
+		break;
+	    case H5T_COMPOUND:
+		col.Type = kTIMESPEC;
+		break;
+	    default:
+		SetError(-4, __LINE__);
+		return false;
+	    }
+	    col.Name = strdup(fRecordType.getMemberName(i).c_str());
+	    fColumns.push_back(col);
+	}
+
+	hsize_t dims[1];
+	fUserDataset.getSpace().getSimpleExtentDims( dims );
+	fNVariables = fColumns.size();
+	fMaxSize    = dims[0];
+
+	DSetCreatPropList cparms = fUserDataset.getCreatePlist();
+	if (cparms.getLayout() == H5D_CHUNKED)
+	{
+	    cparms.getChunk(1, dims);
+	    fChunkSize = dims[0];
+	}
+	fVariables  = new double[fNVariables];
+	fRecord     = new unsigned char[fRecordSize];
+    }
+    // catch failure caused by the DataSet operations
+    catch( const DataSetIException &error )
+    {
+	error.printErrorStack();
+	SetError(-2,__LINE__);
+	return false;
+    }
+    // catch failure caused by the DataType operations
+    catch( const DataTypeIException &error )
+    {
+	error.printErrorStack();
+	SetError(-3,__LINE__);
+	return false;
+    }
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::DatasetReadRecord
+ *
+ * Description : read a typed record into a user supplied struct. 
+ * 
+ * Inputs : Row    - index of the record
+ *          Record - RecordSize() bytes to fill. 
+ *
+ * Returns : true on success , false on falure
+ *
+ * Error Conditions : not typed
+ *                    Row >= fNReadWrite
+ *                    Dataset access fails
+ *                    DataSpace fails
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::DatasetReadRecord(size_t Row, void *Record)
+{
+    SET_DEBUG_STACK;
+    ClearError(__LINE__);
+    WaitPrefetch();
+
+    if (!Typed() || (Record == NULL) || (Row>=fNReadWrite))
+    {
+	SetError(-1, __LINE__);
+	return false;
+    }
+
+    try
+    {
+	hsize_t     dims[1]   = {1};
+	hsize_t     offset[1] = {Row};
+	DataSpace   MVSpace(1, dims);
+
+	DataSpace file_space = fUserDataset.getSpace();
+	file_space.selectHyperslab( H5S_SELECT_SET, dims, offset);
+
+	fUserDataset.read( Record, fRecordType, MVSpace, file_space);
+    }
+    // catch failure caused by the DataSet operations
+    catch( const DataSetIException &error )
+    {
+	error.printErrorStack();
+	SetError(-2,__LINE__);
+	return false;
+    }
+    // catch failure caused by the DataSpace operations
+    catch( const DataSpaceIException &error )
+    {
+	error.printErrorStack();
+	SetError(-3,__LINE__);
+	return false;
+    }
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::DatasetReadRow
+ *
+ * Description : read the vector specified by index. 
+ * 
+ * Inputs : index - numerical index into the data slice
+ *
+ * Returns : true on success , false on falure
+ *
+ * Error Conditions : index > fNReadWrite
+ *                    Dataset access fails
+ *                    DataSpace fails
+ * 
+ * Unit Tested on: 03-May-20
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::DatasetReadRow(size_t index)
+{
+    SET_DEBUG_STACK;
+    ClearError(__LINE__);
+    WaitPrefetch();
+
+    if (index>=fNReadWrite)
+    {
+	SetError(-1, __LINE__);
+	return false;
+    }
+
+    if (Typed())
+    {
+	/* Read the record and convert it to doubles. */
+	if (!DatasetReadRecord(index, fRecord))
+	{
+	    return false;
+	}
+	Unpack(fRecord, fVariables);
+	return true;
+    }
+
+    try
+    {
+	/*
+	 * Select a hyperslab. 
+	 */
+	hsize_t     offset[2] = {0,0};
+	/* This is how big is the read vector and of what dimension? */
+	hsize_t     dims[kDataRank] = {fNVariables, 1};
+	/*
+	 * This kind of explains how the memory data layout is done. 
+	 */
+	DataSpace   MVSpace(kDataRank, dims);
+
+	/* Get current file space */
+	DataSpace file_space = fUserDataset.getSpace();
+	/* Where do we want to write in the hyperslab? */
+	offset[1] = index; 
+	file_space.selectHyperslab( H5S_SELECT_SET, dims, offset);
+
+
+	memset (fVariables, 0, fNVariables*sizeof(double));
+	fUserDataset.read( fVariables, PredType::NATIVE_DOUBLE, 
+			   MVSpace, file_space);
+
+    }
+    // catch failure caused by the DataSet operations
+    catch( const DataSetIException &error )
+    {
+	error.printErrorStack();
+	SetError(-2,__LINE__);
+	return false;
+    }
+    // catch failure caused by the DataSpace operations
+    catch( const DataSpaceIException &error )
+    {
+	error.printErrorStack();
+	SetError(-3,__LINE__);
+	return false;
+    }
+    // catch failure caused by the DataSpace operations
+    catch( const DataTypeIException &error )
+    {
+	error.printErrorStack();
+	SetError(-4,__LINE__);
+	return false;
+    }
+    return true;
+}
+
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::RowData
+ *
+ * Description : Access a column of the row. 
+ * 
+ * Inputs : index - numerical index into the data slice
+ *
+ * Returns : true on success , false on falure
+ *
+ * Error Conditions : index > fNReadWrite
+ *                    Dataset access fails
+ *                    DataSpace fails
+ * 
+ * Unit Tested on: 03-May-20
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+double H5Logger::RowData(size_t Column) 
+{
+    SET_DEBUG_STACK;
+    ClearError(__LINE__);
+
+    if (Column < fNVariables)
+    {
+	return fVariables[Column];
+    }
+    SetError(-1, __LINE__);
+    return 0;
+}
+
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::DatasetReadColumn
+ *
+ * Description : read a column of data in NVector elements at a time. 
+ *
+ * 
+ * Inputs : Column - The column of the named data you want to access. 
+ *          Vector - A user supplied vector for reading the data into
+ *          NVector- The size of the user supplied vector for reading data. 
+ *                   ideally NEntries/NVector has no remainder. 
+ *
+ * Returns : true on success , false on falure
+ *
+ * Error Conditions : index > fNReadWrite
+ *                    Dataset access fails
+ *                    DataSpace fails
+ * 
+ * Unit Tested on: 03-May-20
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::DatasetReadColumn(size_t Column, size_t &Row, 
+				 double *Vector, size_t NVector)
+{
+    SET_DEBUG_STACK;
+    ClearError(__LINE__);
+    WaitPrefetch();
+
+    if (Column>=fNVariables)
+    {
+	SetError(-1, __LINE__);
+	return false;
+    }
+    if (Row>=fNReadWrite)
+    {
+	SetError(-2, __LINE__);
+	return false;
+    }
+    if (Vector == NULL)
+    {
+	SetError(-3, __LINE__);
+	return false;
+    }
+    if (NVector == 0)
+    {
+	SetError(-4, __LINE__);
+	return false;
+    }
+
+    if (Typed())
+    {
+	return ReadTypedColumn(Column, Row, Vector, NVector);
+    }
+
+    try
+    {
+	/*
+	 * Select a hyperslab. 
+	 */
+	hsize_t     offset[2] = {Column,Row};
+	/* This is how big a push we want to do for the data we are writing. */
+	hsize_t     dims[kDataRank] = {1, NVector};
+	/*
+	 * This kind of explains how the memory data layout is done. 
+	 */
+	DataSpace   MVSpace(kDataRank, dims);
+
+	/* Get current file space */
+	DataSpace file_space = fUserDataset.getSpace();
+	/* Where do we want to write in the hyperslab? */
+	file_space.selectHyperslab( H5S_SELECT_SET, dims, offset);
+
+
+	memset (Vector, 0, NVector*sizeof(double));
+	fUserDataset.read( Vector, PredType::NATIVE_DOUBLE, 
+			   MVSpace, file_space);
+	Row = NVector;
+
+    }
+    // catch failure caused by the DataSet operations
+    catch( const DataSetIException &error )
+    {
+	error.printErrorStack();
+	SetError(-2,__LINE__);
+	return false;
+    }
+    // catch failure caused by the DataSpace operations
+    catch( const DataSpaceIException &error )
+    {
+	error.printErrorStack();
+	SetError(-3,__LINE__);
+	return false;
+    }
+    // catch failure caused by the DataSpace operations
+    catch( const DataTypeIException &error )
+    {
+	error.printErrorStack();
+	SetError(-4,__LINE__);
+	return false;
+    }
+
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::ReadTypedColumn
+ *
+ * Description : DatasetReadColumn for a typed dataset. Only the one
+ *               member is read and HDF5 converts it to double. 
+ *
+ * Inputs : see DatasetReadColumn
+ *
+ * Returns : true on success , false on falure
+ *
+ * Error Conditions : timespec column
+ *                    Dataset access fails
+ *                    DataSpace fails
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::ReadTypedColumn(size_t Column, size_t &Row, 
+			       double *Vector, size_t NVector)
+{
+    SET_DEBUG_STACK;
+    if (fColumns[Column].Type == kTIMESPEC)
+    {
+	SetError(-5, __LINE__);
+	return false;
+    }
+
+    try
+    {
+	CompType Member(sizeof(double));
+	Member.insertMember(fColumns[Column].Name, 0, PredType::NATIVE_DOUBLE);
+
+	hsize_t     dims[1]   = {NVector};
+	hsize_t     offset[1] = {Row};
+	DataSpace   MVSpace(1, dims);
+
+	DataSpace file_space = fUserDataset.getSpace();
+	file_space.selectHyperslab( H5S_SELECT_SET, dims, offset);
+
+	memset (Vector, 0, NVector*sizeof(double));
+	fUserDataset.read( Vector, Member, MVSpace, file_space);
+	Row = NVector;
+    }
+    // catch failure caused by the DataSet operations
+    catch( const DataSetIException &error )
+    {
+	error.printErrorStack();
+	SetError(-2,__LINE__);
+	return false;
+    }
+    // catch failure caused by the DataSpace operations
+    catch( const DataSpaceIException &error )
+    {
+	error.printErrorStack();
+	SetError(-3,__LINE__);
+	return false;
+    }
+    // catch failure caused by the DataType operations
+    catch( const DataTypeIException &error )
+    {
+	error.printErrorStack();
+	SetError(-4,__LINE__);
+	return false;
+    }
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::SetChunkCache
+ *
+ * Description : Reopen the user dataset with a raw data chunk cache 
+ *               of the given size. 
+ *
+ * Inputs : Bytes  - cache size in bytes
+ *          NSlots - number of hash slots, 0 to choose
+ *          W0     - preemption policy 0.0 to 1.0
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : not read only
+ *                    W0 out of range
+ *                    dataset open fails
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::SetChunkCache(size_t Bytes, size_t NSlots, double W0)
+{
+    SET_DEBUG_STACK;
+    ClearError(__LINE__);
+    if (!fReadOnly)
+    {
+	SetError(-1, __LINE__);
+	return false;
+    }
+    if ((W0 < 0.0) || (W0 > 1.0))
+    {
+	SetError(-2, __LINE__);
+	return false;
+    }
+    WaitPrefetch();
+
+    if (NSlots == 0)
+    {
+	/*
+	 * HDF5 suggests a prime about 100 times the number of chunks
+	 * that fit in the cache. 
+	 */
+	size_t ChunkBytes = ChunkSize() * (Typed() ? fRecordSize : 
+					   fNVariables*sizeof(double));
+	size_t NChunks = (ChunkBytes>0) ? Bytes/ChunkBytes : 1;
+	if (NChunks == 0) NChunks = 1;
+	NSlots = 100*NChunks + 1;
+	bool Prime = false;
+	while (!Prime)
+	{
+	    Prime = true;
+	    for (size_t d=2; d*d<=NSlots; d++)
+	    {
+		if (NSlots%d == 0)
+		{
+		    Prime = false;
+		    NSlots++;
+		    break;
+		}
+	    }
+	}
+    }
+
+    try
+    {
+	DSetAccPropList dapl;
+	dapl.setChunkCache(NSlots, Bytes, W0);
+	fUserDataset.close();
+	fUserDataset = fpFile->openDataSet( sDatasetHeader, dapl);
+    }
+    catch( const DataSetIException &error )
+    {
+	error.printErrorStack();
+	SetError(-3,__LINE__);
+	return false;
+    }
+    catch( const PropListIException &error )
+    {
+	error.printErrorStack();
+	SetError(-4,__LINE__);
+	return false;
+    }
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::ReadRows
+ *
+ * Description : Read a block of rows in one hyperslab read. The 
+ *               range is widened to chunk boundaries and clipped to
+ *               the data. Doubles are read straight into column 
+ *               major order, records are read and then unpacked. 
+ *               Only touches Block and the dataset so that it can 
+ *               run on the prefetch thread. 
+ *
+ * Inputs : Block - where to put the data
+ *          Row0  - first row wanted
+ *          NRows - number of rows wanted
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : Row0 past the data
+ *                    Dataset or Dataspace access fails
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::ReadRows(ReadBlock &Block, size_t Row0, size_t NRows)
+{
+    size_t ChunkRows = ChunkSize();
+    size_t Total     = NEntries();
+
+    if ((Row0 >= Total) || (NRows == 0))
+    {
+	return false;
+    }
+    size_t First = ChunkRows * (Row0/ChunkRows);
+    size_t Last  = ChunkRows * ((Row0 + NRows + ChunkRows - 1)/ChunkRows);
+    if (Last > Total) Last = Total;
+    size_t N = Last - First;
+
+    if (N > Block.Capacity)
+    {
+	delete[] Block.Data;
+	delete[] Block.Records;
+	Block.Data     = new double[N*fNVariables];
+	Block.Records  = NULL;
+	if (Typed())
+	{
+	    Block.Records = new unsigned char[N*fRecordSize];
+	}
+	Block.Capacity = N;
+    }
+
+    try
+    {
+	DataSpace file_space = fUserDataset.getSpace();
+	if (Typed())
+	{
+	    hsize_t count[1]  = {N};
+	    hsize_t offset[1] = {First};
+	    DataSpace MVSpace(1, count);
+	    file_space.selectHyperslab( H5S_SELECT_SET, count, offset);
+	    fUserDataset.read( Block.Records, fRecordType, MVSpace, file_space);
+	    for (size_t i=0; i<N; i++)
+	    {
+		Unpack(&Block.Records[i*fRecordSize], &Block.Data[i], N);
+	    }
+	}
+	else
+	{
+	    hsize_t count[kDataRank]  = {fNVariables, N};
+	    hsize_t offset[kDataRank] = {0, First};
+	    DataSpace MVSpace(kDataRank, count);
+	    file_space.selectHyperslab( H5S_SELECT_SET, count, offset);
+	    fUserDataset.read( Block.Data, PredType::NATIVE_DOUBLE, 
+			       MVSpace, file_space);
+	}
+    }
+    catch( const DataSetIException &error )
+    {
+	error.printErrorStack();
+	return false;
+    }
+    catch( const DataSpaceIException &error )
+    {
+	error.printErrorStack();
+	return false;
+    }
+    Block.Row0  = First;
+    Block.NRows = N;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::LoadRows
+ *
+ * Description : Make rows Row0 to Row0+NRows available to Column. 
+ *               Nothing to do if the current block covers the range,
+ *               otherwise use the prefetched block if it does. 
+ *
+ * Inputs : Row0  - first row
+ *          NRows - number of rows
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : not read only
+ *                    read fails or range past the data
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::LoadRows(size_t Row0, size_t NRows)
+{
+    SET_DEBUG_STACK;
+    ClearError(__LINE__);
+    if (!fReadOnly)
+    {
+	SetError(-1, __LINE__);
+	return false;
+    }
+
+    /* Already in memory, leave any prefetch running. */
+    if ((Row0 >= fBlock.Row0) && (Row0 + NRows <= fBlock.Row0 + fBlock.NRows))
+    {
+	return true;
+    }
+    WaitPrefetch();
+    if (fPrefetchOK && (Row0 >= fNext.Row0) && 
+	(Row0 + NRows <= fNext.Row0 + fNext.NRows))
+    {
+	ReadBlock tmp = fBlock;
+	fBlock = fNext;
+	fNext  = tmp;
+	fPrefetchOK = false;
+	return true;
+    }
+    if (!ReadRows(fBlock, Row0, NRows))
+    {
+	fBlock.NRows = 0;
+	SetError(-2, __LINE__);
+	return false;
+    }
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::Column
+ *
+ * Description : Return a view of a column over a range of rows, 
+ *               loading them if needed. 
+ *
+ * Inputs : Column - column index
+ *          Row0   - first row
+ *          NRows  - number of rows, 0 for the rest of the data
+ *
+ * Returns : view of the data, empty on error
+ *
+ * Error Conditions : Column out of range
+ *                    see LoadRows
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+H5Span H5Logger::Column(size_t Column, size_t Row0, size_t NRows)
+{
+    SET_DEBUG_STACK;
+    if (Column >= fNVariables)
+    {
+	SetError(-1, __LINE__);
+	return H5Span();
+    }
+    if ((NRows == 0) || (Row0 + NRows > NEntries()))
+    {
+	NRows = (Row0 < NEntries()) ? NEntries() - Row0 : 0;
+    }
+    if (!LoadRows(Row0, NRows))
+    {
+	return H5Span();
+    }
+    return H5Span(&fBlock.Data[Column*fBlock.NRows + (Row0 - fBlock.Row0)], 
+		  NRows);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::Prefetch
+ *
+ * Description : Start reading a block of rows on a background 
+ *               thread. Call it after the current block is loaded, 
+ *               LoadRows of a range outside the current block waits 
+ *               for the prefetch to finish. 
+ *
+ * Inputs : Row0  - first row
+ *          NRows - number of rows
+ *
+ * Returns : true if the thread was started
+ *
+ * Error Conditions : not read only
+ *                    range past the data
+ *                    thread creation fails
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::Prefetch(size_t Row0, size_t NRows)
+{
+    SET_DEBUG_STACK;
+    ClearError(__LINE__);
+    if (!fReadOnly || (Row0 >= NEntries()) || (NRows == 0))
+    {
+	SetError(-1, __LINE__);
+	return false;
+    }
+    /*
+     * A block already asked for and not yet used by LoadRows is kept 
+     * if it covers the range, rather than thrown away and read again.
+     */
+    if ((fPrefetching || fPrefetchOK) && (Row0 >= fPrefetchRow0) &&
+	(Row0 + NRows <= fPrefetchRow0 + fPrefetchRows))
+    {
+	return true;
+    }
+    WaitPrefetch();
+    fPrefetchOK    = false;
+    fPrefetchRow0  = Row0;
+    fPrefetchRows  = NRows;
+    fNext.Row0     = Row0;
+    fNext.NRows    = NRows;
+    if (pthread_create(&fPrefetchThread, NULL, H5Logger::Prefetcher, this) != 0)
+    {
+	SetError(-2, __LINE__);
+	return false;
+    }
+    fPrefetching = true;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::WaitPrefetch
+ *
+ * Description : Join the prefetch thread if one is running. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void H5Logger::WaitPrefetch(void)
+{
+    if (fPrefetching)
+    {
+	pthread_join(fPrefetchThread, NULL);
+	fPrefetching = false;
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::Prefetcher
+ *
+ * Description : Prefetch thread, read the block requested in fNext.
+ *
+ * Inputs : arg - this pointer of the H5Logger
+ *
+ * Returns : NULL
+ *
+ * Error Conditions : NONE, the result is left in fPrefetchOK
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void* H5Logger::Prefetcher(void *arg)
+{
+    H5Logger *p = (H5Logger *) arg;
+    p->fPrefetchOK = p->ReadRows(p->fNext, p->fNext.Row0, p->fNext.NRows);
+    return NULL;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::SetTimeColumn
+ *
+ * Description : Select the time stamp column for the sparse index.
+ *
+ * Inputs : Column - column index
+ *          NRows  - rows per index entry, 0 for ChunkSize()
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : Column out of range
+ *                    dataset already created when writing
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::SetTimeColumn(size_t Column, size_t NRows)
+{
+    SET_DEBUG_STACK;
+    ClearError(__LINE__);
+    if (Column >= fNVariables)
+    {
+	SetError(-1, __LINE__);
+	return false;
+    }
+    if (fReadOnly)
+    {
+	/* An index in the file names its own column. */
+	if (fIndex.empty())
+	{
+	    fTimeColumn = Column;
+	}
+	return true;
+    }
+    if (fDatasetCreated || (fTimeColumn >= 0))
+    {
+	SetError(-2, __LINE__);
+	return false;
+    }
+    fTimeColumn = Column;
+    fIndexRows  = NRows;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::IndexType
+ *
+ * Description : Compound type of an index entry. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : CompType
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+CompType H5Logger::IndexType(void) const
+{
+    CompType type(sizeof(TimeIndexEntry));
+    type.insertMember("Row0", HOFFSET(TimeIndexEntry, Row0), 
+		      PredType::NATIVE_UINT64);
+    type.insertMember("TMin", HOFFSET(TimeIndexEntry, TMin), 
+		      PredType::NATIVE_DOUBLE);
+    type.insertMember("TMax", HOFFSET(TimeIndexEntry, TMax), 
+		      PredType::NATIVE_DOUBLE);
+    return type;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::IndexRow
+ *
+ * Description : Account for one row in the index entry being built,
+ *               write the entry when it is complete. Called from 
+ *               WriteRow/WriteRecord before the row is counted.
+ *
+ * Inputs : Time - value of the time column for the row
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void H5Logger::IndexRow(double Time)
+{
+    if (fIndexCount == 0)
+    {
+	fIndexEntry.Row0 = NEntries();
+	fIndexEntry.TMin = Time;
+	fIndexEntry.TMax = Time;
+    }
+    else
+    {
+	if (Time < fIndexEntry.TMin) fIndexEntry.TMin = Time;
+	if (Time > fIndexEntry.TMax) fIndexEntry.TMax = Time;
+    }
+    fIndexCount++;
+    if (fIndexCount >= fIndexRows)
+    {
+	WriteIndexEntry();
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::WriteIndexEntry
+ *
+ * Description : Append the current entry to the H5_TimeIndex 
+ *               dataset, creating it on first use. The time column 
+ *               and rows per entry are stored as attributes. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : Dataset, Dataspace or Attribute fail
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::WriteIndexEntry(void)
+{
+    SET_DEBUG_STACK;
+    CompType type = IndexType();
+    try
+    {
+	hsize_t NEntry = 0;
+	if (!fTimeIndexOpen && !CreateTimeIndex())
+	{
+	    return false;
+	}
+	fTimeIndex.getSpace().getSimpleExtentDims(&NEntry);
+
+	hsize_t dime[1]   = {NEntry+1};
+	hsize_t count[1]  = {1};
+	hsize_t offset[1] = {NEntry};
+	fTimeIndex.extend(dime);
+	DataSpace file_space = fTimeIndex.getSpace();
+	file_space.selectHyperslab(H5S_SELECT_SET, count, offset);
+	DataSpace MVSpace(1, count);
+	fTimeIndex.write(&fIndexEntry, type, MVSpace, file_space);
+    }
+    catch( const DataSetIException &error )
+    {
+	error.printErrorStack();
+	SetError(-1,__LINE__);
+	return false;
+    }
+    catch( const DataSpaceIException &error )
+    {
+	error.printErrorStack();
+	SetError(-2,__LINE__);
+	return false;
+    }
+    catch( const AttributeIException &error )
+    {
+	error.printErrorStack();
+	SetError(-3,__LINE__);
+	return false;
+    }
+    fIndexCount = 0;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::ReadTimeIndex
+ *
+ * Description : Read the time index if the file has one. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : true on success or if there is no index
+ *
+ * Error Conditions : Dataset or Attribute read fail
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::ReadTimeIndex(void)
+{
+    SET_DEBUG_STACK;
+    ClearError(__LINE__);
+    if (!fpFile->nameExists(sTimeIndexHeader))
+    {
+	return true;
+    }
+    try
+    {
+	fTimeIndex = fpFile->openDataSet(sTimeIndexHeader);
+	fTimeIndexOpen = true;
+
+	uint32_t val;
+	Attribute attr = fTimeIndex.openAttribute("TimeColumn");
+	attr.read(PredType::NATIVE_UINT32, &val);
+	fTimeColumn = val;
+	attr = fTimeIndex.openAttribute("RowsPerEntry");
+	attr.read(PredType::NATIVE_UINT32, &val);
+	fIndexRows = val;
+
+	hsize_t NEntry;
+	fTimeIndex.getSpace().getSimpleExtentDims(&NEntry);
+	fIndex.resize(NEntry);
+	if (NEntry > 0)
+	{
+	    fTimeIndex.read(&fIndex[0], IndexType());
+	}
+    }
+    catch( const DataSetIException &error )
+    {
+	error.printErrorStack();
+	SetError(-1,__LINE__);
+	return false;
+    }
+    catch( const AttributeIException &error )
+    {
+	error.printErrorStack();
+	SetError(-2,__LINE__);
+	return false;
+    }
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::RowsInRange
+ *
+ * Description : Find the rows whose time lies in [T0, T1]. 
+ *               Binary search the index for the first entry that 
+ *               ends at or after T0, take entries up to the first 
+ *               that starts after T1, load just those rows and 
+ *               search the time column within them. Without an 
+ *               index the whole time column is searched. 
+ *
+ * Inputs : T0, T1 - time range
+ *          Row0, NRows - returned range of rows
+ *
+ * Returns : true on success, NRows is 0 if no rows match. 
+ *
+ * Error Conditions : not read only
+ *                    no time column
+ *                    read fail
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::RowsInRange(double T0, double T1, size_t &Row0, size_t &NRows)
+{
+    SET_DEBUG_STACK;
+    ClearError(__LINE__);
+    Row0  = 0;
+    NRows = 0;
+    if (!fReadOnly || (fTimeColumn < 0))
+    {
+	SetError(-1, __LINE__);
+	return false;
+    }
+    if ((T1 < T0) || (NEntries() == 0))
+    {
+	return true;
+    }
+
+    size_t First = 0;
+    size_t Last  = NEntries();
+    if (!fIndex.empty())
+    {
+	size_t lo = 0;
+	size_t hi = fIndex.size();
+	while (lo < hi)
+	{
+	    size_t mid = (lo + hi)/2;
+	    if (fIndex[mid].TMax < T0)
+	    {
+		lo = mid + 1;
+	    }
+	    else
+	    {
+		hi = mid;
+	    }
+	}
+	hi = lo;
+	while ((hi < fIndex.size()) && (fIndex[hi].TMin <= T1))
+	{
+	    hi++;
+	}
+	if (hi == lo)
+	{
+	    return true;
+	}
+	First = fIndex[lo].Row0;
+	if (hi < fIndex.size())
+	{
+	    Last = fIndex[hi].Row0;
+	}
+    }
+
+    H5Span Time = Column(fTimeColumn, First, Last - First);
+    if (Time.empty())
+    {
+	SetError(-2, __LINE__);
+	return false;
+    }
+    size_t i = 0;
+    while ((i < Time.size()) && (Time[i] < T0))
+    {
+	i++;
+    }
+    size_t j = i;
+    while ((j < Time.size()) && (Time[j] <= T1))
+    {
+	j++;
+    }
+    Row0  = First + i;
+    NRows = j - i;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Summary::Sigma
+ *
+ * Description : Population standard deviation from the sums. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : sigma, 0 if there are no values
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+double H5Summary::Sigma(void) const
+{
+    if (Count == 0)
+    {
+	return 0.0;
+    }
+    double m = Mean();
+    double v = SumSq/Count - m*m;
+    return (v > 0.0) ? sqrt(v) : 0.0;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::SetSummary
+ *
+ * Description : Enable per block summary statistics. 
+ *
+ * Inputs : NRows - rows per summary entry, 0 for ChunkSize()
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : read only
+ *                    dataset already created or already enabled
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::SetSummary(size_t NRows)
+{
+    SET_DEBUG_STACK;
+    ClearError(__LINE__);
+    if (fReadOnly)
+    {
+	SetError(-1, __LINE__);
+	return false;
+    }
+    if (fDatasetCreated || fSummaryOn)
+    {
+	SetError(-2, __LINE__);
+	return false;
+    }
+    fSummaryOn   = true;
+    fSummaryRows = NRows;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::SummaryType
+ *
+ * Description : Compound type of a summary entry. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : CompType
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+CompType H5Logger::SummaryType(void) const
+{
+    CompType type(sizeof(H5Summary));
+    type.insertMember("Count", HOFFSET(H5Summary, Count), 
+		      PredType::NATIVE_UINT64);
+    type.insertMember("Min", HOFFSET(H5Summary, Min), 
+		      PredType::NATIVE_DOUBLE);
+    type.insertMember("Max", HOFFSET(H5Summary, Max), 
+		      PredType::NATIVE_DOUBLE);
+    type.insertMember("Sum", HOFFSET(H5Summary, Sum), 
+		      PredType::NATIVE_DOUBLE);
+    type.insertMember("SumSq", HOFFSET(H5Summary, SumSq), 
+		      PredType::NATIVE_DOUBLE);
+    return type;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::SummarizeRow
+ *
+ * Description : Add one row to the summary block being built, 
+ *               write the block when it is complete. Exactly one 
+ *               of var and Record is used. 
+ *
+ * Inputs : var    - row of doubles, or NULL
+ *          Record - typed record, or NULL
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void H5Logger::SummarizeRow(const double *var, const unsigned char *Record)
+{
+    if (fSummaryBlock.size() != fNVariables)
+    {
+	fSummaryBlock.resize(fNVariables);
+	fSummaryCount = 0;
+    }
+    if (fSummaryCount == 0)
+    {
+	for (size_t i=0; i<fNVariables; i++)
+	{
+	    fSummaryBlock[i].Clear();
+	}
+    }
+    for (size_t i=0; i<fNVariables; i++)
+    {
+	fSummaryBlock[i].Add(var ? var[i] : RecordValue(Record, i));
+    }
+    fSummaryCount++;
+    if (fSummaryCount >= fSummaryRows)
+    {
+	WriteSummaryEntry();
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::CreateSummary
+ *
+ * Description : Create the H5_Summary dataset, one row per block
+ *               and one column per variable. The block size is 
+ *               stored as an attribute. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : Dataset or Attribute creation fail
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::CreateSummary(void)
+{
+    SET_DEBUG_STACK;
+    const hsize_t kSummaryChunk = 16;
+    try
+    {
+	hsize_t dims[2]    = {0, fNVariables};
+	hsize_t maxdims[2] = {H5S_UNLIMITED, fNVariables};
+	hsize_t chunk[2]   = {kSummaryChunk, fNVariables};
+	DataSpace space(2, dims, maxdims);
+	DSetCreatPropList cparms;
+	cparms.setChunk(2, chunk);
+	fSummary = fpFile->createDataSet(sSummaryHeader, SummaryType(), 
+					 space, cparms);
+
+	DataSpace scalar(H5S_SCALAR);
+	uint32_t  val = fSummaryRows;
+	Attribute attr = fSummary.createAttribute("RowsPerEntry", 
+				  PredType::NATIVE_UINT32, scalar);
+	attr.write(PredType::NATIVE_UINT32, &val);
+	fSummaryOpen = true;
+    }
+    catch( const DataSetIException &error )
+    {
+	error.printErrorStack();
+	SetError(-1,__LINE__);
+	return false;
+    }
+    catch( const AttributeIException &error )
+    {
+	error.printErrorStack();
+	SetError(-3,__LINE__);
+	return false;
+    }
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::WriteSummaryEntry
+ *
+ * Description : Append the block being built to H5_Summary, 
+ *               creating the dataset on first use. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : Dataset or Dataspace fail
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::WriteSummaryEntry(void)
+{
+    SET_DEBUG_STACK;
+    try
+    {
+	hsize_t dims[2];
+	if (!fSummaryOpen && !CreateSummary())
+	{
+	    return false;
+	}
+	fSummary.getSpace().getSimpleExtentDims(dims);
+
+	hsize_t dime[2]   = {dims[0]+1, fNVariables};
+	hsize_t count[2]  = {1, fNVariables};
+	hsize_t offset[2] = {dims[0], 0};
+	fSummary.extend(dime);
+	DataSpace file_space = fSummary.getSpace();
+	file_space.selectHyperslab(H5S_SELECT_SET, count, offset);
+	DataSpace MVSpace(2, count);
+	fSummary.write(&fSummaryBlock[0], SummaryType(), MVSpace, 
+		       file_space);
+    }
+    catch( const DataSetIException &error )
+    {
+	error.printErrorStack();
+	SetError(-1,__LINE__);
+	return false;
+    }
+    catch( const DataSpaceIException &error )
+    {
+	error.printErrorStack();
+	SetError(-2,__LINE__);
+	return false;
+    }
+    fSummaryCount = 0;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::ReadSummary
+ *
+ * Description : Read the block summaries if the file has them. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : true on success or if there are none
+ *
+ * Error Conditions : Dataset or Attribute read fail
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::ReadSummary(void)
+{
+    SET_DEBUG_STACK;
+    ClearError(__LINE__);
+    if (!fpFile->nameExists(sSummaryHeader))
+    {
+	return true;
+    }
+    try
+    {
+	fSummary = fpFile->openDataSet(sSummaryHeader);
+	fSummaryOpen = true;
+	fSummaryOn   = true;
+
+	uint32_t val;
+	Attribute attr = fSummary.openAttribute("RowsPerEntry");
+	attr.read(PredType::NATIVE_UINT32, &val);
+	fSummaryRows = val;
+
+	hsize_t dims[2];
+	fSummary.getSpace().getSimpleExtentDims(dims);
+	if (dims[1] != fNVariables)
+	{
+	    SetError(-3, __LINE__);
+	    return false;
+	}
+	fSummaries.resize(dims[0]*dims[1]);
+	if (dims[0] > 0)
+	{
+	    fSummary.read(&fSummaries[0], SummaryType());
+	}
+    }
+    catch( const DataSetIException &error )
+    {
+	error.printErrorStack();
+	SetError(-1,__LINE__);
+	return false;
+    }
+    catch( const AttributeIException &error )
+    {
+	error.printErrorStack();
+	SetError(-2,__LINE__);
+	return false;
+    }
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::Summary
+ *
+ * Description : Statistics of one column over a range of rows. 
+ *               Summary block k covers rows k*R up to (k+1)*R, the
+ *               last block of a closed file may be short. Blocks 
+ *               that lie wholly in the range are merged, the rows 
+ *               at either end are read and added. 
+ *
+ * Inputs : Column - column index
+ *          Row0   - first row
+ *          NRows  - number of rows, 0 for the rest of the data
+ *          Result - returned statistics
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : not read only
+ *                    Column out of range
+ *                    read fail
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::Summary(size_t Column, size_t Row0, size_t NRows, 
+		       H5Summary &Result)
+{
+    SET_DEBUG_STACK;
+    ClearError(__LINE__);
+    Result.Clear();
+    if (!fReadOnly || (Column >= fNVariables))
+    {
+	SetError(-1, __LINE__);
+	return false;
+    }
+    size_t N = NEntries();
+    if (Row0 >= N)
+    {
+	return true;
+    }
+    if ((NRows == 0) || (Row0 + NRows > N))
+    {
+	NRows = N - Row0;
+    }
+    size_t End     = Row0 + NRows;
+    size_t R       = fSummaryRows;
+    size_t NBlocks = (R > 0) ? fSummaries.size()/fNVariables : 0;
+
+    /* Blocks b0 to b1-1 lie wholly inside [Row0, End). */
+    size_t b0 = (R > 0) ? (Row0 + R - 1)/R : 0;
+    size_t b1 = b0;
+    while ((b1 < NBlocks) && (std::min((b1+1)*R, N) <= End))
+    {
+	b1++;
+    }
+    size_t Head = End;     // end of the rows read at the front
+    size_t Tail = End;     // start of the rows read at the back
+    if (b1 > b0)
+    {
+	Head = b0*R;
+	Tail = std::min(b1*R, N);
+	for (size_t k=b0; k<b1; k++)
+	{
+	    Result.Merge(fSummaries[k*fNVariables + Column]);
+	}
+    }
+
+    size_t Ranges[2][2] = {{Row0, Head}, {Tail, End}};
+    for (size_t r=0; r<2; r++)
+    {
+	if (Ranges[r][1] <= Ranges[r][0])
+	{
+	    continue;
+	}
+	size_t n = Ranges[r][1] - Ranges[r][0];
+	H5Span s = H5Logger::Column(Column, Ranges[r][0], n);
+	if (s.size() != n)
+	{
+	    SetError(-2, __LINE__);
+	    return false;
+	}
+	for (size_t i=0; i<n; i++)
+	{
+	    Result.Add(s[i]);
+	}
+    }
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::SetRollover
+ *
+ * Description : Enable rollover to a new file on size or on a wall
+ *               clock boundary. 
+ *
+ * Inputs : Namer    - FileName used to generate new names
+ *          MaxBytes - size limit, 0 for none
+ *          Period   - boundary interval in seconds, 0 for none
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : read only
+ *                    no namer
+ *                    writer thread already running
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::SetRollover(FileName *Namer, size_t MaxBytes, time_t Period)
+{
+    SET_DEBUG_STACK;
+    ClearError(__LINE__);
+    if (fReadOnly || (Namer == NULL) || fWriterRunning)
+    {
+	SetError(-1, __LINE__);
+	return false;
+    }
+    fNamer    = Namer;
+    fMaxBytes = MaxBytes;
+    fPeriod   = Period;
+    if (fPeriod > 0)
+    {
+	fNextBoundary = (time(NULL)/fPeriod + 1) * fPeriod;
+    }
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::Rollover
+ *
+ * Description : Ask for a new file before the next row. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : ignored if SetRollover has not been called
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void H5Logger::Rollover(void)
+{
+    fRolloverRequest = true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::CurrentFile
+ *
+ * Description : Copy out the name of the file being written. The
+ *               writer thread rewrites it on a rollover, so the
+ *               copy is made under fNameMutex.
+ *
+ * Inputs : Name - filled in, always terminated
+ *          Size - bytes available at Name
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void H5Logger::CurrentFile(char *Name, size_t Size) const
+{
+    if ((Name == NULL) || (Size == 0))
+    {
+	return;
+    }
+    pthread_mutex_lock(&fNameMutex);
+    strncpy(Name, fHeader[0], Size-1);
+    pthread_mutex_unlock(&fNameMutex);
+    Name[Size-1] = 0;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::CheckRollover
+ *
+ * Description : Called before each row is written. Roll over on 
+ *               request, when past the time boundary or when the 
+ *               file size limit is reached. The size is only 
+ *               looked at on chunk boundaries. Chunks still in the
+ *               HDF5 chunk cache have no file space yet, so within 
+ *               a cache's worth of the limit the file is flushed 
+ *               before its size is taken. An empty file is never 
+ *               rolled over. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : true unless a rollover failed
+ *
+ * Error Conditions : see DoRollover
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::CheckRollover(void)
+{
+    if (fNamer == NULL)
+    {
+	return true;
+    }
+    if (fpFile == NULL)
+    {
+	/* The last rollover failed to open a file. */
+	SetError(-1, __LINE__);
+	return false;
+    }
+    bool Due = fRolloverRequest.exchange(false);
+    if (!Due && (fPeriod > 0) && (time(NULL) >= fNextBoundary))
+    {
+	Due = true;
+    }
+    if (!Due && (fMaxBytes > 0) && fDatasetCreated && (NEntries() > 0) && 
+	(NEntries() % ChunkSize() == 0))
+    {
+	hsize_t Size = fpFile->getFileSize();
+	if (Size + kWriteCacheBytes >= (hsize_t) fMaxBytes)
+	{
+	    fpFile->flush(H5F_SCOPE_LOCAL);
+	    Size = fpFile->getFileSize();
+	}
+	Due = (Size >= (hsize_t) fMaxBytes);
+    }
+    if (!Due)
+    {
+	return true;
+    }
+    if (NEntries() == 0)
+    {
+	if (fPeriod > 0)
+	{
+	    fNextBoundary = (time(NULL)/fPeriod + 1) * fPeriod;
+	}
+	return true;
+    }
+    return DoRollover();
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::DoRollover
+ *
+ * Description : Close the current file and open the next. The 
+ *               write state is reset, the dataset is created again 
+ *               on the next row with the same settings. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : new file could not be opened
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::DoRollover(void)
+{
+    SET_DEBUG_STACK;
+    char Name[FILELEN];
+
+    strncpy(Name, fNamer->GetUniqueName(), FILELEN-1);
+    Name[FILELEN-1] = 0;
+
+    CloseFile();
+
+    fNReadWrite     = 0;
+    fNBuffered      = 0;
+    fNExpand        = 0;
+    fMaxSize        = 0;
+    fDatasetCreated = false;
+    delete[] fBuffer;
+    fBuffer         = NULL;
+    delete[] fRecordBuffer;
+    fRecordBuffer   = NULL;
+    fIndexCount     = 0;
+    fTimeIndexOpen  = false;
+    fSummaryCount   = 0;
+    fSummaryOpen    = false;
+    if (fPeriod > 0)
+    {
+	fNextBoundary = (time(NULL)/fPeriod + 1) * fPeriod;
+    }
+
+    if (!OpenFile(Name))
+    {
+	SetError(-1, __LINE__);
+	return false;
+    }
+    fNRollovers++;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::CloseFile
+ *
+ * Description : Finish the file being written. Write out the 
+ *               buffer and last index entry, trim the extent, 
+ *               write the final state and close. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void H5Logger::CloseFile(void)
+{
+    SET_DEBUG_STACK;
+    if (!fDatasetCreated)
+    {
+	CreateUserDataSet();
+    }
+    WriteBuffer();
+    if (fIndexCount > 0)
+    {
+	WriteIndexEntry();
+    }
+    if (fSummaryCount > 0)
+    {
+	WriteSummaryEntry();
+    }
+    /*
+     * Geometric growth can leave a lot of unused extent, 
+     * trim it back to what was written. 
+     */
+    if (fDatasetCreated && ((fChunkRows>0) || Typed()) && 
+	(fMaxSize>fNReadWrite))
+    {
+	SetExtent(fNReadWrite);
+    }
+    WriteFinalState();
+
+    /* Open objects keep the file open, close them first. */
+    if (fDatasetCreated)
+    {
+	fUserDataset.close();
+    }
+    if (fTimeIndexOpen)
+    {
+	fTimeIndex.close();
+    }
+    if (fSummaryOpen)
+    {
+	fSummary.close();
+    }
+    fpFile->close();
+    delete fpFile;
+    fpFile = NULL;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::OpenFile
+ *
+ * Description : Create the next file of a rollover with the same 
+ *               header information and data tags. 
+ *
+ * Inputs : Filename - new file
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : File creation fails
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::OpenFile(const char *Filename)
+{
+    SET_DEBUG_STACK;
+    char UserDataName[kSSIZ+1];
+    char Comment[kSSIZ+1];
+
+    memset(UserDataName, 0, sizeof(UserDataName));
+    memset(Comment, 0, sizeof(Comment));
+    memcpy(UserDataName, fHeader[2], kSSIZ);
+    memcpy(Comment,      fHeader[3], kSSIZ);
+
+    try
+    {
+	fpFile = new H5File( Filename, H5F_ACC_TRUNC, 
+			     FileCreatPropList::DEFAULT, AccessList());
+    }
+    catch( const FileIException &error )
+    {
+	error.printErrorStack();
+	fpFile = NULL;
+	return false;
+    }
+    WriteHeader(Filename, UserDataName, Comment);
+    WriteVersionInformation();
+    if (fTagNames != NULL)
+    {
+	delete fVariableNames;
+	fVariableNames = NULL;
+	WriteDataTags(fTagNames);
+    }
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::AccessList
+ *
+ * Description : File access properties for a new file. Live files 
+ *               need the latest format for SWMR. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : property list
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+FileAccPropList H5Logger::AccessList(void) const
+{
+    FileAccPropList fapl;
+    if (fLive)
+    {
+	fapl.setLibverBounds(H5F_LIBVER_LATEST, H5F_LIBVER_LATEST);
     }
-
-    return true;
+    return fapl;
 }
 /**
  ******************************************************************
  *
- * Function Name : H5Logger::OpenUserDatasetRead
+ * Function Name : H5Logger::CreateTimeIndex
  *
- * Description : Open the Dataset associated with the user data. 
- *               Allocate the fNVariables vector. 
+ * Description : Create the time index dataset and its attributes.
+ *               Normally done with the first entry, a live file 
+ *               does it before going to SWMR. 
  *
  * Inputs : NONE
  *
- * Returns : true on success, false on failure. 
+ * Returns : true on success
  *
- * Error Conditions : Dataset open fail
- *                    Dataspace declaration fail
+ * Error Conditions : Dataset or Attribute creation fail
  * 
- * Unit Tested on: 03-May-20
+ * Unit Tested on: 
  *
  * Unit Tested by: CBL
  *
  *
  *******************************************************************
  */
-bool H5Logger::OpenUserDatasetRead(void)
+bool H5Logger::CreateTimeIndex(void)
 {
     SET_DEBUG_STACK;
-    ClearError(__LINE__);
-
+    const hsize_t kIndexChunk = 256;
     try
     {
-	fUserDataset = fpFile->openDataSet( sDatasetHeader);
-
-	/*
-	 * Get filespace for rank and dimension
-	 */
-	DataSpace filespace = fUserDataset.getSpace();
-
-	/*
-	 * Get and print the dimension sizes of the file dataspace
-	 */
-	hsize_t dims[2];    // dataset dimensions
-	//int rank = 
-	filespace.getSimpleExtentDims( dims );
-	// Save the dimensions, we will use them over and over 
-	fNVariables = dims[0];
-	fMaxSize    = dims[1];  // This dimension may be bigger than data. 
-
-	/*
-	 * Allocate internal buffer for data, may not need this, check back. 
-	 */
-	fVariables = new double[fNVariables];
+	hsize_t dims[1]    = {0};
+	hsize_t maxdims[1] = {H5S_UNLIMITED};
+	hsize_t chunk[1]   = {kIndexChunk};
+	DataSpace space(1, dims, maxdims);
+	DSetCreatPropList cparms;
+	cparms.setChunk(1, chunk);
+	fTimeIndex = fpFile->createDataSet(sTimeIndexHeader, IndexType(), 
+					   space, cparms);
 
-	if (fVariables == NULL)
-	{
-	    SetError(-1, __LINE__);
-	    return false;
-	}
- 
-#ifdef DEBUG
-	cout << "dataset rank = " << rank << ", dimensions ";
-	for (int i=0;i<rank;i++)
-	{
-	    cout << (unsigned long)(dims[i]) << " ";
-	}
-	cout << endl;
-#endif
+	DataSpace scalar(H5S_SCALAR);
+	uint32_t  val = fTimeColumn;
+	Attribute attr = fTimeIndex.createAttribute("TimeColumn", 
+				    PredType::NATIVE_UINT32, scalar);
+	attr.write(PredType::NATIVE_UINT32, &val);
+	val = fIndexRows;
+	attr = fTimeIndex.createAttribute("RowsPerEntry", 
+					  PredType::NATIVE_UINT32, scalar);
+	attr.write(PredType::NATIVE_UINT32, &val);
+	fTimeIndexOpen = true;
     }
-    // catch failure caused by the DataSet operations
     catch( const DataSetIException &error )
     {
 	error.printErrorStack();
-	SetError(-2,__LINE__);
+	SetError(-1,__LINE__);
 	return false;
     }
-    // catch failure caused by the DataSpace operations
-    catch( const DataSpaceIException &error )
+    catch( const AttributeIException &error )
     {
 	error.printErrorStack();
 	SetError(-3,__LINE__);
@@ -994,220 +4585,219 @@ bool H5Logger::OpenUserDatasetRead(void)
 /**
  ******************************************************************
  *
- * Function Name : H5Logger::DatasetReadRow
+ * Function Name : H5Logger::StartLive
  *
- * Description : read the vector specified by index. 
- * 
- * Inputs : index - numerical index into the data slice
+ * Description : Nothing can be created once the file is in SWMR 
+ *               write mode. Create the time index and final state 
+ *               now, the final state is rewritten at close, then 
+ *               switch. Called when the user dataset is created. 
  *
- * Returns : true on success , false on falure
+ * Inputs : NONE
  *
- * Error Conditions : index > fNReadWrite
- *                    Dataset access fails
- *                    DataSpace fails
+ * Returns : true on success
+ *
+ * Error Conditions : dataset creation fail
+ *                    H5Fstart_swmr_write fail
  * 
- * Unit Tested on: 03-May-20
+ * Unit Tested on: 
  *
  * Unit Tested by: CBL
  *
  *
  *******************************************************************
  */
-bool H5Logger::DatasetReadRow(size_t index)
+bool H5Logger::StartLive(void)
 {
     SET_DEBUG_STACK;
-    ClearError(__LINE__);
-
-    if (index>=fNReadWrite)
+    if ((fTimeColumn >= 0) && !fTimeIndexOpen && !CreateTimeIndex())
     {
-	SetError(-1, __LINE__);
 	return false;
     }
-
-    try
-    {
-	/*
-	 * Select a hyperslab. 
-	 */
-	hsize_t     offset[2] = {0,0};
-	/* This is how big is the read vector and of what dimension? */
-	hsize_t     dims[kDataRank] = {fNVariables, 1};
-	/*
-	 * This kind of explains how the memory data layout is done. 
-	 */
-	DataSpace   MVSpace(kDataRank, dims);
-
-	/* Get current file space */
-	DataSpace file_space = fUserDataset.getSpace();
-	/* Where do we want to write in the hyperslab? */
-	offset[1] = index; 
-	file_space.selectHyperslab( H5S_SELECT_SET, dims, offset);
-
-
-	memset (fVariables, 0, fNVariables*sizeof(double));
-	fUserDataset.read( fVariables, PredType::NATIVE_DOUBLE, 
-			   MVSpace, file_space);
-
-    }
-    // catch failure caused by the DataSet operations
-    catch( const DataSetIException &error )
+    if (fSummaryOn && !fSummaryOpen && !CreateSummary())
     {
-	error.printErrorStack();
-	SetError(-2,__LINE__);
 	return false;
     }
-    // catch failure caused by the DataSpace operations
-    catch( const DataSpaceIException &error )
+    if (!WriteFinalState())
     {
-	error.printErrorStack();
-	SetError(-3,__LINE__);
 	return false;
     }
-    // catch failure caused by the DataSpace operations
-    catch( const DataTypeIException &error )
+    if (H5Fstart_swmr_write(fpFile->getId()) < 0)
     {
-	error.printErrorStack();
-	SetError(-4,__LINE__);
+	SetError(-6,__LINE__);
 	return false;
     }
+    clock_gettime(CLOCK_MONOTONIC, &fLastFlush);
     return true;
 }
-
 /**
  ******************************************************************
  *
- * Function Name : H5Logger::RowData
+ * Function Name : H5Logger::LiveFlush
  *
- * Description : Access a column of the row. 
- * 
- * Inputs : index - numerical index into the data slice
+ * Description : Once per flush period write out what is buffered 
+ *               and flush the dataset metadata so readers see the 
+ *               new extent. 
  *
- * Returns : true on success , false on falure
+ * Inputs : Force - flush regardless of the period
  *
- * Error Conditions : index > fNReadWrite
- *                    Dataset access fails
- *                    DataSpace fails
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
  * 
- * Unit Tested on: 03-May-20
+ * Unit Tested on: 
  *
  * Unit Tested by: CBL
  *
  *
  *******************************************************************
  */
-double H5Logger::RowData(size_t Column) 
+void H5Logger::LiveFlush(bool Force)
 {
-    SET_DEBUG_STACK;
-    ClearError(__LINE__);
-
-    if (Column < fNVariables)
+    struct timespec now;
+    if (!fLive || !fDatasetCreated)
     {
-	return fVariables[Column];
+	return;
     }
-    SetError(-1, __LINE__);
-    return 0;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (!Force && ((double)(now.tv_sec - fLastFlush.tv_sec) + 
+		   1.0e-9*(double)(now.tv_nsec - fLastFlush.tv_nsec) 
+		   < fFlushPeriod))
+    {
+	return;
+    }
+    WriteBuffer();
+    H5Dflush(fUserDataset.getId());
+    if (fTimeIndexOpen)
+    {
+	H5Dflush(fTimeIndex.getId());
+    }
+    if (fSummaryOpen)
+    {
+	H5Dflush(fSummary.getId());
+    }
+    fLastFlush = now;
 }
-
 /**
  ******************************************************************
  *
- * Function Name : H5Logger::DatasetReadColumn
+ * Function Name : H5Logger::SetFlushPeriod
  *
- * Description : read a column of data in NVector elements at a time. 
+ * Description : How often a live writer makes rows visible. 
  *
- * 
- * Inputs : Column - The column of the named data you want to access. 
- *          Vector - A user supplied vector for reading the data into
- *          NVector- The size of the user supplied vector for reading data. 
- *                   ideally NEntries/NVector has no remainder. 
+ * Inputs : Seconds - period, must be positive
  *
- * Returns : true on success , false on falure
+ * Returns : true on success
  *
- * Error Conditions : index > fNReadWrite
- *                    Dataset access fails
- *                    DataSpace fails
+ * Error Conditions : read only, not live or bad period
  * 
- * Unit Tested on: 03-May-20
+ * Unit Tested on: 
  *
  * Unit Tested by: CBL
  *
  *
  *******************************************************************
  */
-bool H5Logger::DatasetReadColumn(size_t Column, size_t &Row, 
-				 double *Vector, size_t NVector)
+bool H5Logger::SetFlushPeriod(double Seconds)
 {
     SET_DEBUG_STACK;
     ClearError(__LINE__);
-
-    if (Column>=fNVariables)
+    if (fReadOnly || !fLive || (Seconds <= 0.0))
     {
 	SetError(-1, __LINE__);
 	return false;
     }
-    if (Row>=fNReadWrite)
-    {
-	SetError(-2, __LINE__);
-	return false;
-    }
-    if (Vector == NULL)
-    {
-	SetError(-3, __LINE__);
-	return false;
-    }
-    if (NVector == 0)
+    fFlushPeriod = Seconds;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : H5Logger::Refresh
+ *
+ * Description : Live reader. Refresh the dataset metadata and take 
+ *               the new extent as the number of rows. Only the new 
+ *               time index entries are read. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : not a live reader
+ *                    Dataset access fail
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool H5Logger::Refresh(void)
+{
+    SET_DEBUG_STACK;
+    ClearError(__LINE__);
+    if (!fReadOnly || !fLive)
     {
-	SetError(-4, __LINE__);
+	SetError(-1, __LINE__);
 	return false;
     }
-
     try
     {
-	/*
-	 * Select a hyperslab. 
-	 */
-	hsize_t     offset[2] = {Column,Row};
-	/* This is how big a push we want to do for the data we are writing. */
-	hsize_t     dims[kDataRank] = {1, NVector};
-	/*
-	 * This kind of explains how the memory data layout is done. 
-	 */
-	DataSpace   MVSpace(kDataRank, dims);
-
-	/* Get current file space */
-	DataSpace file_space = fUserDataset.getSpace();
-	/* Where do we want to write in the hyperslab? */
-	file_space.selectHyperslab( H5S_SELECT_SET, dims, offset);
-
-
-	memset (Vector, 0, NVector*sizeof(double));
-	fUserDataset.read( Vector, PredType::NATIVE_DOUBLE, 
-			   MVSpace, file_space);
-	Row = NVector;
+	hsize_t dims[kDataRank];
+	if (H5Drefresh(fUserDataset.getId()) < 0)
+	{
+	    SetError(-2, __LINE__);
+	    return false;
+	}
+	fUserDataset.getSpace().getSimpleExtentDims(dims);
+	fMaxSize    = Typed() ? dims[0] : dims[1];
+	fNReadWrite = fMaxSize;
 
+	if (fTimeIndexOpen && (H5Drefresh(fTimeIndex.getId()) >= 0))
+	{
+	    hsize_t NEntry, Old = fIndex.size();
+	    fTimeIndex.getSpace().getSimpleExtentDims(&NEntry);
+	    if (NEntry > Old)
+	    {
+		hsize_t count[1]  = {NEntry - Old};
+		hsize_t offset[1] = {Old};
+		fIndex.resize(NEntry);
+		DataSpace file_space = fTimeIndex.getSpace();
+		file_space.selectHyperslab(H5S_SELECT_SET, count, offset);
+		DataSpace MVSpace(1, count);
+		fTimeIndex.read(&fIndex[Old], IndexType(), MVSpace, 
+				file_space);
+	    }
+	}
+	if (fSummaryOpen && (H5Drefresh(fSummary.getId()) >= 0))
+	{
+	    hsize_t sdims[2], Old = fSummaries.size()/fNVariables;
+	    fSummary.getSpace().getSimpleExtentDims(sdims);
+	    if (sdims[0] > Old)
+	    {
+		hsize_t count[2]  = {sdims[0] - Old, fNVariables};
+		hsize_t offset[2] = {Old, 0};
+		fSummaries.resize(sdims[0]*fNVariables);
+		DataSpace file_space = fSummary.getSpace();
+		file_space.selectHyperslab(H5S_SELECT_SET, count, offset);
+		DataSpace MVSpace(2, count);
+		fSummary.read(&fSummaries[Old*fNVariables], SummaryType(), 
+			      MVSpace, file_space);
+	    }
+	}
     }
-    // catch failure caused by the DataSet operations
     catch( const DataSetIException &error )
-    {
-	error.printErrorStack();
-	SetError(-2,__LINE__);
-	return false;
-    }
-    // catch failure caused by the DataSpace operations
-    catch( const DataSpaceIException &error )
     {
 	error.printErrorStack();
 	SetError(-3,__LINE__);
 	return false;
     }
-    // catch failure caused by the DataSpace operations
-    catch( const DataTypeIException &error )
+    catch( const DataSpaceIException &error )
     {
 	error.printErrorStack();
 	SetError(-4,__LINE__);
 	return false;
     }
-
     return true;
 }
 /**
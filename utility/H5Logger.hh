@@ -15,6 +15,24 @@
  * Restrictions/Limitations :
  *
  * Change Descriptions :
+ * 17-Oct-26 CBL Added write-combining buffer, rows are collected in 
+ *               memory and written a chunk at a time. 
+ * 17-Oct-26 CBL Added asynchronous mode, Fill places the row on a 
+ *               queue and a writer thread does the file I/O. 
+ * 17-Oct-26 CBL Optional shuffle, deflate and scale-offset filters. 
+ * 17-Oct-26 CBL Typed columns. A schema declared with AddColumn is 
+ *               stored as an HDF5 compound type, one record per row. 
+ * 17-Oct-26 CBL Bulk columnar reads through a chunk cache with an 
+ *               optional background prefetch. 
+ * 17-Oct-26 CBL Sparse time index dataset and RowsInRange. 
+ * 17-Oct-26 CBL Rollover to a new file on size, time or request. 
+ * 17-Oct-26 CBL SWMR live mode, a reader can follow a file while it 
+ *               is being written. 
+ * 17-Oct-26 CBL Per chunk, per column summary statistics. 
+ * 17-Oct-26 CBL NRollovers and CurrentFile safe from the Fill 
+ *               thread while the writer thread rolls over. 
+ * 17-Oct-26 CBL Asynchronous Flush waits on a semaphore and returns
+ *               the writer's result. 
  *
  * Classification : Unclassified
  *
@@ -27,17 +45,87 @@
 #define __H5LOGGER_hh_
 #  include <inttypes.h>
 #  include <stdlib.h>
+#  include <pthread.h>
+#  include <semaphore.h>
+#  include <atomic>
+#  include <vector>
 #  include "CObject.hh"
 #  include "H5Cpp.h"
 #  include "Split.hh"
 
 using namespace H5;
+class FileName;
+
+/*!
+ * Read only view over contiguous doubles, in the manner of 
+ * std::span<const double>. The view does not own the data, it is 
+ * valid until the next load by the H5Logger that returned it. 
+ */
+class H5Span
+{
+public:
+    H5Span(const double *Data=NULL, size_t N=0) {fData = Data; fSize = N;};
+    inline const double* data(void)  const {return fData;};
+    inline size_t        size(void)  const {return fSize;};
+    inline bool          empty(void) const {return (fSize==0);};
+    inline const double* begin(void) const {return fData;};
+    inline const double* end(void)   const {return fData+fSize;};
+    inline const double& operator[](size_t i) const {return fData[i];};
+    /*! View of N elements starting at Offset, clipped to this view. */
+    inline H5Span subspan(size_t Offset, size_t N) const {
+	if (Offset > fSize) Offset = fSize;
+	if (N > fSize-Offset) N = fSize-Offset;
+	return H5Span(fData+Offset, N);};
+private:
+    const double *fData;
+    size_t       fSize;
+};
+
+/*!
+ * Summary statistics of a column over a range of rows. NaN values
+ * are not counted. 
+ */
+struct H5Summary
+{
+    uint64_t Count;
+    double   Min;
+    double   Max;
+    double   Sum;
+    double   SumSq;
+    inline void Clear(void) {Count=0; Min=Max=Sum=SumSq=0.0;};
+    inline void Add(double v) {
+	if (v != v) return;
+	if (Count == 0) {Min = Max = v;}
+	else {if (v < Min) Min = v; if (v > Max) Max = v;}
+	Count++; Sum += v; SumSq += v*v;};
+    inline void Merge(const H5Summary &s) {
+	if (s.Count == 0) return;
+	if (Count == 0) {Min = s.Min; Max = s.Max;}
+	else {if (s.Min < Min) Min = s.Min; if (s.Max > Max) Max = s.Max;}
+	Count += s.Count; Sum += s.Sum; SumSq += s.SumSq;};
+    inline double Mean(void) const {return Count ? Sum/Count : 0.0;};
+    /*! Population standard deviation. */
+    double Sigma(void) const;
+};
 
 /// H5Logger documentation here. 
 class H5Logger : public CObject
 {
 public:
     enum HeaderIndex {kFILENAME=0, kDATE, kDATADESCRIPTOR};
+    /*!
+     * What to do in asynchronous mode when the queue is full. 
+     * kBLOCK       - wait for the writer to make room. 
+     * kDROP_NEWEST - discard the row being filled. 
+     * kDROP_OLDEST - discard the oldest row on the queue. 
+     */
+    enum OverflowPolicy {kBLOCK=0, kDROP_NEWEST, kDROP_OLDEST};
+    /*!
+     * Column types for a typed (compound) dataset. 
+     * kTIMESPEC is a struct timespec stored as {tv_sec, tv_nsec}.
+     */
+    enum ColumnType {kINT8=0, kUINT8, kINT16, kUINT16, kINT32, kUINT32, 
+		     kINT64, kUINT64, kFLOAT, kDOUBLE, kTIMESPEC};
 
     /*! 
      * H5Logger constructor
@@ -46,9 +134,14 @@ public:
      *    NVariables - Number of variables that the user wants to store. 
      *    ReadOnly   - User specified read (true) or write (false)
      *    Comment    - Optional user comment to be stored in file 
+     *    Live       - single writer/multiple reader mode. The writer 
+     *                 creates the file in the latest format and, from 
+     *                 the first Fill on, readers may open it with 
+     *                 Live set and follow it with Refresh. 
      */
     H5Logger(const char *Filename, const char *UserDataName, 
-	     size_t NVariables, bool ReadOnly, const char*Comment=NULL);
+	     size_t NVariables, bool ReadOnly, const char*Comment=NULL,
+	     bool Live=false);
 
     /*!
      * H5Logger destructor. 
@@ -78,6 +171,179 @@ public:
      */
     bool Fill(const double *var = NULL);
 
+    /*!
+     * Enable the write-combining buffer. NRows rows are collected
+     * in memory and written to the file with a single hyperslab 
+     * write. NRows is also used as the chunk size of the dataset. 
+     * Zero (the default) writes each row as it is filled. 
+     * This must be called before the first Fill. 
+     */
+    bool SetBuffering(size_t NRows);
+
+    /*!
+     * Number of rows held in memory before a write. 
+     * Zero if unbuffered. 
+     */
+    inline size_t BufferSize(void) const {return fChunkRows;};
+
+    /*!
+     * Set the number of rows in a dataset chunk. Zero (default) 
+     * uses the buffer size, or 1 row if unbuffered. Filters work on 
+     * whole chunks so this should be a few hundred rows or more 
+     * when compression is on. Must be called before the first Fill. 
+     */
+    bool SetChunkSize(size_t NRows);
+
+    /*!
+     * Number of rows in a dataset chunk. 
+     */
+    inline size_t ChunkSize(void) const 
+	{return (fChunkSize>0) ? fChunkSize : ((fChunkRows>0) ? fChunkRows : 1);};
+
+    /*!
+     * Enable compression of the user dataset. 
+     * Level   - deflate (gzip) level 1-9, 0 turns deflate off. 
+     * Shuffle - byte shuffle ahead of deflate, helps a lot on doubles
+     *           that change slowly. 
+     * Digits  - if >= 0 apply the scale-offset filter keeping this many
+     *           decimal digits. This is LOSSY. 
+     * Must be called before the first Fill. 
+     */
+    bool SetCompression(unsigned int Level, bool Shuffle=true, int Digits=-1);
+
+    /*!
+     * When the dataset runs out of room in buffered mode the 
+     * extent is multiplied by this factor. Must be >= 1.0, 
+     * the default is 2.0
+     */
+    bool SetGrowthFactor(double Factor);
+
+    /*!
+     * Write any rows held in the buffer out to the file. 
+     * This is also done on destruction. In asynchronous mode 
+     * this waits for the writer to empty the queue, and false 
+     * means a write by the writer failed since the last Flush. 
+     */
+    bool Flush(void);
+
+    /*!
+     * Switch to asynchronous mode. Fill copies the row onto a 
+     * queue of QueueDepth rows and returns, a writer thread 
+     * takes the rows off the queue and writes them to the file. 
+     * Fill must only be called from one thread. 
+     * Policy - what to do when the queue is full. 
+     * Configure buffering before calling this. 
+     */
+    bool StartWriter(size_t QueueDepth, OverflowPolicy Policy=kBLOCK);
+
+    /*!
+     * Is the writer thread running? 
+     */
+    inline bool Asynchronous(void) const {return fWriterRunning;};
+
+    /*!
+     * Number of rows discarded because the queue was full. 
+     */
+    inline uint64_t NDropped(void) const {return fNDropped.load();};
+
+    /*!
+     * Largest number of rows that have been waiting on the queue. 
+     */
+    inline size_t QueueHighWater(void) const {return fHighWater.load();};
+
+    /*!
+     * Declare a typed column. Once any column is declared the 
+     * user data is stored as one compound record per row instead 
+     * of rows of doubles. Construct with NVariables = 0 and call 
+     * this once per column before the first Fill. 
+     * Name   - column name, also used for the data tags. 
+     * Type   - storage type of the column. 
+     * Offset - byte offset of the field in the record given to 
+     *          FillRecord. -1 places it at the next offset aligned 
+     *          to the size of the type, as a C struct would. 
+     */
+    bool AddColumn(const char *Name, ColumnType Type, int Offset=-1);
+
+    /*!
+     * Size in bytes of the record given to FillRecord. This defaults 
+     * to the end of the last column. Set it when the record has 
+     * trailing fields that are not logged, for example to 
+     * GGA::DataSize(). 
+     */
+    bool SetRecordSize(size_t Size);
+
+    /*!
+     * Is this a typed (compound) dataset? 
+     */
+    inline bool   Typed(void)      const {return !fColumns.empty();};
+    /*!
+     * Size of a typed record in bytes. 
+     */
+    inline size_t RecordSize(void) const {return fRecordSize;};
+    /*!
+     * Type of a typed column. 
+     */
+    ColumnType    ColumnTypeOf(size_t Column) const;
+
+    /*!
+     * Typed Fill. Record points to a struct laid out as 
+     * declared by AddColumn, for example the DataPointer() of 
+     * GGA, RMC or RawTracking. No conversion is done. 
+     * Fill(double*) may still be used on a typed dataset, the 
+     * values are converted to the column types. 
+     */
+    bool FillRecord(const void *Record);
+
+    /*!
+     * Read a typed record back into a user supplied struct of 
+     * RecordSize() bytes. 
+     */
+    bool DatasetReadRecord(size_t Row, void *Record);
+
+    /*!
+     * Close the current file and continue in a new one when it 
+     * passes a size or a wall clock boundary. 
+     * Namer    - supplies the new names through GetUniqueName(). 
+     *            Not owned, must outlive the logger. 
+     * MaxBytes - file size limit, 0 for none. 
+     * Period   - boundary interval in seconds aligned to UTC 
+     *            midnight, for example One_Hour.tv_sec, 0 for none. 
+     * Each file is complete with header, tags and final state. 
+     * The change is made by whoever writes the rows, with 
+     * StartWriter that is the writer thread and Fill does not wait. 
+     */
+    bool SetRollover(FileName *Namer, size_t MaxBytes, time_t Period=0);
+
+    /*!
+     * Request a rollover before the next row is written. Safe to 
+     * call from any thread, for example on receipt of 
+     * SimpleCommand::kCHANGE_FILE_NAME. 
+     */
+    void Rollover(void);
+    /*! Number of rollovers done, from any thread. */
+    inline uint32_t NRollovers(void) const {return fNRollovers.load();};
+    /*!
+     * Copy the name of the file currently being written into Name,
+     * at most Size bytes with the terminator. Safe from any thread,
+     * the writer thread may be rolling over. 
+     */
+    void CurrentFile(char *Name, size_t Size) const;
+
+    /*!
+     * Live writer, how often buffered rows are written out and the 
+     * dataset metadata flushed so that readers can see them. 
+     * Seconds, default 1. The check is made as rows are written. 
+     */
+    bool SetFlushPeriod(double Seconds);
+    /*!
+     * Live reader, pick up rows appended since the file was opened 
+     * or last refreshed. NEntries() and the time index are updated, 
+     * rows already loaded stay loaded. 
+     */
+    bool Refresh(void);
+    /*! true if the file is open in live (SWMR) mode. */
+    inline bool Live(void) const {return fLive;};
+
     /*!
      * Allow the user to input his data into the internal variable
      * data vector. 
@@ -118,6 +384,83 @@ public:
      */
     bool DatasetReadColumn(size_t Column, size_t &Row, double *Vector, size_t NVector);
 
+    /*!
+     * Set the raw data chunk cache used for reading. 
+     * Bytes  - size of the cache, a few chunks at least. 
+     * NSlots - hash table size, 0 picks a prime about 100 times the 
+     *          number of chunks that fit in the cache. 
+     * W0     - preemption policy, 1.0 evicts fully read chunks first.
+     * The dataset is reopened with the new access properties. 
+     */
+    bool SetChunkCache(size_t Bytes, size_t NSlots=0, double W0=0.75);
+
+    /*!
+     * Bulk read of rows Row0 to Row0+NRows of every column. 
+     * The range is widened to whole chunks and read in a single 
+     * hyperslab read into column major storage. If the range was 
+     * prefetched the prefetched block is used instead. 
+     */
+    bool LoadRows(size_t Row0, size_t NRows);
+
+    /*!
+     * View of a column over rows Row0 to Row0+NRows, NRows=0 is to 
+     * the end of the data. Loads the rows if they are not already
+     * in memory. Returns an empty view on error. 
+     */
+    H5Span Column(size_t Column, size_t Row0=0, size_t NRows=0);
+
+    /*!
+     * Start loading rows Row0 to Row0+NRows in a background thread
+     * while the current block is being processed. Call it after the 
+     * current block has been loaded with LoadRows or Column, the 
+     * next call that leaves the current block picks it up. A pending
+     * block covering the range is not read again. 
+     */
+    bool Prefetch(size_t Row0, size_t NRows);
+
+    /*!
+     * Name the column holding the time stamp. 
+     * Writing - a sparse index is kept with one entry per NRows rows
+     *           holding the first row and the min and max time of 
+     *           those rows. NRows = 0 uses ChunkSize(). Call before 
+     *           the first Fill. 
+     * Reading - only needed for files written without an index, 
+     *           RowsInRange then scans the whole column. 
+     */
+    bool SetTimeColumn(size_t Column, size_t NRows=0);
+    inline int TimeColumn(void) const {return fTimeColumn;};
+
+    /*!
+     * Find the rows with T0 <= time <= T1. The index is binary 
+     * searched and only the matching chunks are read, they are left 
+     * loaded for Column(). Time should be non-decreasing. 
+     * Row0, NRows - the range found, NRows is 0 if there is none. 
+     */
+    bool RowsInRange(double T0, double T1, size_t &Row0, size_t &NRows);
+
+    /*!
+     * Keep count, min, max, sum and sum of squares for every column
+     * over each block of NRows rows in a companion dataset. 
+     * NRows = 0 uses ChunkSize(). Call before the first Fill. 
+     */
+    bool SetSummary(size_t NRows=0);
+    /*! true if summaries are being written or were found on read. */
+    inline bool HasSummary(void) const {return fSummaryOn;};
+    /*!
+     * Statistics of Column over Row0 to Row0+NRows, NRows = 0 for 
+     * the rest of the data. Whole blocks come from the summaries, 
+     * at most the two partial blocks at the ends are read. Without 
+     * summaries the whole range is read. 
+     */
+    bool Summary(size_t Column, size_t Row0, size_t NRows, 
+		 H5Summary &Result);
+
+    /*!
+     * Rows currently held in memory by LoadRows. 
+     */
+    inline size_t LoadedRow0(void)  const {return fBlock.Row0;};
+    inline size_t LoadedRows(void)  const {return fBlock.NRows;};
+
     /*!
      * Manipulate when the data set is increased by. 
      * NOTE: Later we can get more tricky by coding in memory and 
@@ -129,7 +472,7 @@ public:
      * How many times has the vector been stored?
      * Or how many entries total are there on a read. 
      */
-    inline size_t NEntries(void) const {return fNReadWrite;};
+    inline size_t NEntries(void) const {return fNReadWrite+fNBuffered;};
 
     /*!
      * Index from Name, given a name return the index into the 
@@ -223,6 +566,161 @@ private:
      */
     DataSet fUserDataset;
 
+    /*!
+     * Has the user data set been created yet? On write this is 
+     * deferred until the first Fill so that the buffering can be 
+     * configured after construction. 
+     */
+    bool    fDatasetCreated;
+
+    /*!
+     * Write combining buffer. Stored variable major, 
+     * fBuffer[variable*fChunkRows + row] so that it matches the 
+     * layout of the dataset and can be written in one call. 
+     */
+    double* fBuffer;
+    /*!
+     * Number of rows in the buffer, zero is unbuffered. 
+     */
+    size_t  fChunkRows;
+    /*!
+     * Number of rows currently held in the buffer. 
+     */
+    size_t  fNBuffered;
+    /*!
+     * Multiplier on the extent when the dataset needs to grow. 
+     */
+    double  fGrowthFactor;
+    /*!
+     * Rows per chunk if set by the user, zero otherwise. 
+     */
+    size_t  fChunkSize;
+    /*!
+     * Filters, deflate level (0 off), shuffle and the 
+     * number of scale-offset digits (-1 off). 
+     */
+    unsigned int fDeflateLevel;
+    bool    fShuffle;
+    int     fScaleOffset;
+
+    /*!
+     * Typed columns, empty for a dataset of doubles. 
+     */
+    struct ColumnInfo {
+	char       *Name;
+	ColumnType Type;
+	size_t     Offset;
+    };
+    std::vector<ColumnInfo> fColumns;
+    /*! Size of one record in bytes. */
+    size_t  fRecordSize;
+    /*! Memory compound type describing a record. */
+    CompType fRecordType;
+    /*! Scratch record for converting to and from doubles. */
+    unsigned char* fRecord;
+    /*! Write combining buffer for records, fChunkRows records. */
+    unsigned char* fRecordBuffer;
+
+    /*!
+     * Block of rows read by LoadRows, column major, column i 
+     * starts at Data + i*NRows. Records is scratch space for 
+     * typed datasets. 
+     */
+    struct ReadBlock {
+	double        *Data;
+	unsigned char *Records;
+	size_t        Row0;
+	size_t        NRows;
+	size_t        Capacity;  /* rows allocated */
+    };
+    ReadBlock fBlock;
+
+    /*!
+     * Sparse time index, one entry per fIndexRows rows. 
+     */
+    struct TimeIndexEntry {
+	uint64_t Row0;
+	double   TMin;
+	double   TMax;
+    };
+    int            fTimeColumn;   /* -1 no index */
+    size_t         fIndexRows;
+    size_t         fIndexCount;   /* rows in the entry being built */
+    TimeIndexEntry fIndexEntry;
+    DataSet        fTimeIndex;
+    bool           fTimeIndexOpen;
+    std::vector<TimeIndexEntry> fIndex;   /* read back */
+
+    /*!
+     * Block summaries, fNVariables entries per fSummaryRows rows. 
+     */
+    bool           fSummaryOn;
+    size_t         fSummaryRows;
+    size_t         fSummaryCount; /* rows in the block being built */
+    DataSet        fSummary;
+    bool           fSummaryOpen;
+    std::vector<H5Summary> fSummaryBlock; /* being built */
+    std::vector<H5Summary> fSummaries;    /* read back */
+
+    /*!
+     * Rollover, see SetRollover. 
+     */
+    FileName          *fNamer;
+    size_t            fMaxBytes;
+    time_t            fPeriod;
+    time_t            fNextBoundary;
+    char              *fTagNames;      /* to rewrite on each file */
+    std::atomic<bool> fRolloverRequest;
+    std::atomic<uint32_t> fNRollovers;
+    /*! Guards fHeader[0], the file name, against a rollover. */
+    mutable pthread_mutex_t fNameMutex;
+
+    /*!
+     * Live (SWMR) mode. 
+     */
+    bool              fLive;
+    double            fFlushPeriod;
+    struct timespec   fLastFlush;
+
+    /*! Block being loaded by the prefetch thread. */
+    ReadBlock fNext;
+    pthread_t fPrefetchThread;
+    bool      fPrefetching;
+    bool      fPrefetchOK;
+    /*! Range asked of the prefetch, fNext is widened to chunks. */
+    size_t    fPrefetchRow0;
+    size_t    fPrefetchRows;
+
+    /*!
+     * Asynchronous mode. fQueue is a single producer/single consumer 
+     * ring of fQueueDepth slots of fSlotSize bytes, one row of doubles
+     * or one typed record. fHead is only advanced by Fill, 
+     * fTail by the writer, or by Fill when dropping the oldest row. 
+     * Both are free running counters. 
+     */
+    unsigned char*      fQueue;
+    size_t              fSlotSize;
+    size_t              fQueueDepth;
+    OverflowPolicy      fPolicy;
+    std::atomic<size_t> fHead;
+    std::atomic<size_t> fTail;
+    std::atomic<uint64_t> fNDropped;
+    std::atomic<size_t> fHighWater;
+    /*! Row being written by the writer thread. */
+    unsigned char*      fWriterRow;
+    /*! Writer wakes up on this. */
+    sem_t               fWriterSem;
+    pthread_t           fWriterThread;
+    bool                fWriterRunning;
+    std::atomic<bool>   fWriterStop;
+    std::atomic<bool>   fFlushRequest;
+    /*! Writer posts this when a flush request is done. */
+    sem_t               fFlushDone;
+    /*! Writer only, false after a failed write. */
+    bool                fWriterOK;
+    /*! Result of the last flush request, read after fFlushDone. */
+    bool                fFlushResult;
+
     /*!
      * Create the header for the HDF5 file. 
      */
@@ -251,6 +749,119 @@ private:
      */
     bool CreateUserDataSet(void);
 
+    /*!
+     * Write the contents of fBuffer to the dataset. 
+     */
+    bool WriteBuffer(void);
+
+    /*!
+     * Synchronous part of Fill, either buffer the row or 
+     * write it to the file. 
+     */
+    bool WriteRow(const double *var);
+
+    /*!
+     * Synchronous part of FillRecord. 
+     */
+    bool WriteRecord(const void *Record);
+
+    /*!
+     * Set the extent of the dataset to NRows rows. 
+     */
+    bool SetExtent(size_t NRows);
+
+    /*!
+     * Read side of a typed dataset. 
+     */
+    bool OpenTypedRead(void);
+    bool ReadTypedColumn(size_t Column, size_t &Row, double *Vector, 
+			 size_t NVector);
+
+    /*!
+     * Build fRecordType from fColumns. 
+     */
+    void BuildRecordType(void);
+
+    /*!
+     * Convert a row of doubles to a record and back. 
+     * Stride is the distance between the doubles in var. 
+     */
+    void Pack(const double *var, unsigned char *Record);
+    void Unpack(const unsigned char *Record, double *var, size_t Stride=1);
+    double RecordValue(const unsigned char *Record, size_t Column) const;
+
+    /*!
+     * Time index maintenance. 
+     */
+    void IndexRow(double Time);
+    bool WriteIndexEntry(void);
+
+    /*!
+     * Summary maintenance. 
+     */
+    void SummarizeRow(const double *var, const unsigned char *Record);
+    bool CreateSummary(void);
+    bool WriteSummaryEntry(void);
+    bool ReadSummary(void);
+    CompType SummaryType(void) const;
+    bool ReadTimeIndex(void);
+    CompType IndexType(void) const;
+
+    /*!
+     * Read a chunk aligned block of rows, used by LoadRows and 
+     * the prefetch thread. 
+     */
+    bool ReadRows(ReadBlock &Block, size_t Row0, size_t NRows);
+
+    /*!
+     * Rollover. CheckRollover is called before each row is written. 
+     */
+    bool CheckRollover(void);
+    bool DoRollover(void);
+    void CloseFile(void);
+    bool OpenFile(const char *Filename);
+
+    /*!
+     * Live writer. StartLive creates what is left to create and 
+     * switches the file to SWMR, LiveFlush writes out what is 
+     * buffered once per flush period. 
+     */
+    bool StartLive(void);
+    void LiveFlush(bool Force);
+    bool CreateTimeIndex(void);
+    FileAccPropList AccessList(void) const;
+
+    /*!
+     * Wait for a prefetch in progress to finish. 
+     */
+    void WaitPrefetch(void);
+    static void* Prefetcher(void *);
+
+    /*!
+     * Asynchronous part of Fill, put the row or record on the queue. 
+     */
+    bool Enqueue(const void *var);
+
+    /*!
+     * Writer side, take a row off of the queue into fWriterRow. 
+     */
+    bool Dequeue(void);
+
+    /*!
+     * Stop the writer thread once the queue is empty. 
+     */
+    void StopWriter(void);
+
+    /*!
+     * Writer thread. 
+     */
+    static void* Writer(void *arg);
+
+    /*!
+     * Make sure the dataset extent can hold NRows rows. 
+     */
+    bool Grow(size_t NRows);
+
     /*!
      * Open dataset for read. 
      */
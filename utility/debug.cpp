@@ -10,6 +10,7 @@
  * Restrictions/Limitations :
  *
  * Change Descriptions :
+ * 17-Oct-26 CBL Thread local, shadow call stack. 
  *
  * Classification : Unclassified
  *
@@ -25,14 +26,17 @@ using namespace std;
 #include <cmath>
 #include <csignal>
 #include <stdio.h>
+#include <dlfcn.h>
 
 
 /// Local Includes.
 #include "debug.h"
 
 // These are defined here but are set all over. 
-int LastLine;
-char *LastFile;
+__thread int LastLine;
+__thread char *LastFile;
+__thread struct DebugFrame DebugStack[kDEBUG_STACK_DEPTH];
+__thread int               DebugDepth;
 /**
  ******************************************************************
  *
@@ -81,3 +85,118 @@ void log_error(char *message, char *file, int line)
 {
     fprintf(stderr, "%s %d : %s\n", file, line, message);
 }
+/**
+ ******************************************************************
+ *
+ * Function Name : __cyg_profile_func_enter, __cyg_profile_func_exit
+ *
+ * Description : Called by code built with -finstrument-functions on
+ *               every function entry and exit, maintain the shadow 
+ *               stack. Must not be instrumented themselves. 
+ *
+ * Inputs : Function - entry address of the function
+ *          CallSite - return address, not used
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+extern "C" __attribute__((no_instrument_function)) 
+void __cyg_profile_func_enter(void *Function, void *CallSite)
+{
+    if (DebugDepth < kDEBUG_STACK_DEPTH)
+    {
+	DebugStack[DebugDepth].Function = Function;
+	DebugStack[DebugDepth].File     = NULL;
+	DebugStack[DebugDepth].Line     = 0;
+    }
+    DebugDepth++;
+}
+extern "C" __attribute__((no_instrument_function)) 
+void __cyg_profile_func_exit(void *Function, void *CallSite)
+{
+    if (DebugDepth > 0)
+    {
+	DebugDepth--;
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : DebugStackDump
+ *
+ * Description : Format the calling thread's shadow stack, innermost
+ *               stored frame first. Frames deeper than 
+ *               kDEBUG_STACK_DEPTH were not kept and are noted as a
+ *               count. Symbols come from dladdr, mangled. 
+ *
+ * Inputs : Buffer - output
+ *          Size   - bytes available
+ *
+ * Returns : characters written
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+__attribute__((no_instrument_function)) 
+int DebugStackDump(char *Buffer, size_t Size)
+{
+    size_t  n = 0;
+    int     depth = DebugDepth;
+    Dl_info info;
+
+    if ((Size == 0) || (depth <= 0))
+    {
+	return 0;
+    }
+    Buffer[0] = 0;
+    if (depth > kDEBUG_STACK_DEPTH)
+    {
+	n += snprintf(Buffer+n, Size-n, "  (%d inner frames not kept)\n", 
+		      depth - kDEBUG_STACK_DEPTH);
+	depth = kDEBUG_STACK_DEPTH;
+    }
+    for (int i=depth-1; (i>=0) && (n<Size); i--)
+    {
+	const DebugFrame &f = DebugStack[i];
+	const char *name = NULL;
+	if (dladdr(f.Function, &info) && info.dli_sname)
+	{
+	    name = info.dli_sname;
+	}
+	if (f.File)
+	{
+	    n += snprintf(Buffer+n, Size-n, "  %s:%d ", f.File, f.Line);
+	}
+	else
+	{
+	    n += snprintf(Buffer+n, Size-n, "  ? ");
+	}
+	if (n >= Size)
+	{
+	    break;
+	}
+	if (name)
+	{
+	    n += snprintf(Buffer+n, Size-n, "%s\n", name);
+	}
+	else
+	{
+	    n += snprintf(Buffer+n, Size-n, "%p\n", f.Function);
+	}
+    }
+    return (n < Size) ? n : Size-1;
+}
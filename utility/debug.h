@@ -7,9 +7,26 @@
  *
  * Description : 
  *
+ * SET_DEBUG_STACK records the file and line reached in thread local
+ * LastFile/LastLine, so threads don't share (or fight over) a cache
+ * line. Compile time switches, e.g. EXT_CFLAGS=-DNO_DEBUG_STACK:
+ *
+ *   NO_DEBUG_STACK   SET_DEBUG_STACK does nothing at all.
+ *   DEBUG_CALL_STACK per thread shadow call stack. Build with
+ *       EXT_CFLAGS="-DDEBUG_CALL_STACK -finstrument-functions
+ *           -finstrument-functions-exclude-file-list=/usr/include"
+ *     the compiler pushes and pops a frame on every function entry
+ *     and exit, SET_DEBUG_STACK also notes its file and line in the
+ *     top frame. A crash handler prints it with DebugStackDump.
+ *
  * Restrictions/Limitations :
+ *   The shadow stack stores the outermost kDEBUG_STACK_DEPTH frames,
+ *   deeper ones are counted but not stored. Only code built with
+ *   -finstrument-functions makes frames.
  *
  * Change Descriptions :
+ * 17-Oct-26 CBL Thread local LastLine/LastFile, NO_DEBUG_STACK and
+ *               the DEBUG_CALL_STACK shadow stack. 
  *
  * Classification : Unclassified
  *
@@ -22,14 +39,43 @@
 #define __DEBUG_h_
 
 #include <syslog.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 /* CBL 23-Jul-02 Debugging tools. */
-extern int LastLine;
-extern char *LastFile;
-#define SET_DEBUG_STACK LastLine=__LINE__; LastFile=(char *)__FILE__;
+extern __thread int LastLine;
+extern __thread char *LastFile;
+
+/* Shadow call stack, see DEBUG_CALL_STACK. */
+#define kDEBUG_STACK_DEPTH 64
+struct DebugFrame {
+    void       *Function;   /* entry address */
+    const char *File;       /* last SET_DEBUG_STACK in it, or NULL */
+    int         Line;
+};
+extern __thread struct DebugFrame DebugStack[kDEBUG_STACK_DEPTH];
+extern __thread int               DebugDepth;
+
+/*
+ * Format the calling thread's shadow stack, innermost frame first,
+ * one "file:line symbol" per line. Meant for a fault handler, it 
+ * allocates nothing. Returns the number of characters written, 0
+ * if the stack is empty. 
+ */
+int DebugStackDump(char *Buffer, size_t Size);
+
+#if defined(NO_DEBUG_STACK)
+# define SET_DEBUG_STACK
+#elif defined(DEBUG_CALL_STACK)
+# define SET_DEBUG_STACK LastLine=__LINE__; LastFile=(char *)__FILE__; \
+    if ((DebugDepth>0) && (DebugDepth<=kDEBUG_STACK_DEPTH)) { \
+	DebugStack[DebugDepth-1].File = __FILE__; \
+	DebugStack[DebugDepth-1].Line = __LINE__;}
+#else
+# define SET_DEBUG_STACK LastLine=__LINE__; LastFile=(char *)__FILE__;
+#endif
 
 #ifdef DEBUG
 # define DBG(x) printf("%s: %s\n",__FUNCTION__,(x))